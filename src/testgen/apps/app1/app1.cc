@@ -48,3 +48,7 @@ unique_ptr<Function> App1FunctionFactory::getFunction(string fname, vector<Expr*
         throw "Unknown function!";
     }
 }
+
+unique_ptr<FunctionFactory> App1FunctionFactory::snapshot() {
+    return make_unique<App1FunctionFactory>(*this);
+}
@@ -41,4 +41,5 @@ class App1FunctionFactory : public FunctionFactory {
     public:
         App1FunctionFactory() : globalY(0) {}
         unique_ptr<Function> getFunction(string fname, vector<Expr*> args);
+        unique_ptr<FunctionFactory> snapshot();
 };
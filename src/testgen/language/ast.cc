@@ -1,4 +1,5 @@
 #include "ast.hh"
+#include "exprwalk.hh"
 
 TypeExpr::TypeExpr(TypeExprType typeExprType) : typeExprType(typeExprType) {}
 
@@ -75,6 +76,46 @@ FuncCall::FuncCall(string name, vector<unique_ptr<Expr>> args)
       name(std::move(name)), args(std::move(args)) {
 }
 
+// A node whose subexpressions have subexpressions themselves moves them to a
+// work list and frees them from there, each after detaching its own nested
+// subexpressions; so freeing a deep And chain does not recurse once per level
+static void detachNested(Expr& e, vector<unique_ptr<Expr>>& pending) {
+    for (size_t i = 0; i < exprChildCount(e); i++) {
+        unique_ptr<Expr>* slot;
+        switch (e.exprType) {
+            case ExprType::FUNCCALL:
+                slot = &const_cast<unique_ptr<Expr>&>(static_cast<FuncCall&>(e).args[i]);
+                break;
+            case ExprType::SET:
+                slot = &const_cast<unique_ptr<Expr>&>(static_cast<Set&>(e).elements[i]);
+                break;
+            case ExprType::MAP:
+                slot = &const_cast<unique_ptr<Expr>&>(static_cast<Map&>(e).value[i].second);
+                break;
+            default:
+                slot = &const_cast<unique_ptr<Expr>&>(static_cast<Tuple&>(e).exprs[i]);
+                break;
+        }
+        if (*slot && exprChildCount(**slot) > 0) {
+            pending.push_back(std::move(*slot));
+        }
+    }
+}
+
+static void releaseNested(Expr& e) {
+    vector<unique_ptr<Expr>> pending;
+    detachNested(e, pending);
+    while (!pending.empty()) {
+        unique_ptr<Expr> node = std::move(pending.back());
+        pending.pop_back();
+        detachNested(*node, pending);
+    }
+}
+
+FuncCall::~FuncCall() {
+    releaseNested(*this);
+}
+
 Num::Num(int value) : Expr(ExprType::NUM), value(value) {}
 
 String::String(string value) : Expr(ExprType::STRING), value(value) {}
@@ -82,12 +123,24 @@ String::String(string value) : Expr(ExprType::STRING), value(value) {}
 Set::Set(vector<unique_ptr<Expr>> elements)
     : Expr(ExprType::SET), elements(std::move(elements)) {}
 
+Set::~Set() {
+    releaseNested(*this);
+}
+
 Map::Map(vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> v)
     : Expr(ExprType::MAP), value(std::move(v)) {}
 
+Map::~Map() {
+    releaseNested(*this);
+}
+
 Tuple::Tuple(vector<unique_ptr<Expr>> exprs) :
     Expr(ExprType::TUPLE), exprs(std::move(exprs)) {}
 
+Tuple::~Tuple() {
+    releaseNested(*this);
+}
+
 APIFuncDecl::APIFuncDecl(string name,
          vector<unique_ptr<TypeExpr>> params,
          pair<HTTPResponseCode, vector<unique_ptr<TypeExpr>>> returnType)
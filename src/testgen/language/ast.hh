@@ -162,6 +162,7 @@ public:
     const vector<unique_ptr<Expr>> args;
 public:
     FuncCall(string, vector<unique_ptr<Expr>>);
+    ~FuncCall();
 };
 
 class Map : public Expr
@@ -170,6 +171,7 @@ public:
     const vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> value;
 public:
     explicit Map(vector<pair<unique_ptr<Var>, unique_ptr<Expr>>>);
+    ~Map();
 };
 
 class Num : public Expr
@@ -186,6 +188,7 @@ public:
     const vector<unique_ptr<Expr>> elements;
 public:
     explicit Set(vector<unique_ptr<Expr>>);
+    ~Set();
 };
 
 class String : public Expr
@@ -202,6 +205,7 @@ public:
     const vector<unique_ptr<Expr>> exprs;
 public:
     explicit Tuple(vector<unique_ptr<Expr>> exprs);
+    ~Tuple();
 };
 
 class Var : public Expr
@@ -272,10 +276,13 @@ public:
 class Spec
 {
 public:
-    const vector<unique_ptr<Decl>> globals;
-    const vector<unique_ptr<Init>> init;
-    const vector<unique_ptr<APIFuncDecl>> functions;
-    const vector<unique_ptr<API>> blocks;
+    vector<unique_ptr<Decl>> globals;
+    vector<unique_ptr<Init>> init;
+    vector<unique_ptr<APIFuncDecl>> functions;
+    vector<unique_ptr<API>> blocks;
+    // Longest list input the solver considers before falling back to
+    // sequences (0 = always sequences, see Z3Solver::setListBound)
+    size_t maxListLength = 0;
 public:
     Spec(vector<unique_ptr<Decl>>,
          vector<unique_ptr<Init>>,
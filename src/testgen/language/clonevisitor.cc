@@ -1,4 +1,5 @@
 #include "clonevisitor.hh"
+#include "exprwalk.hh"
 #include "symvar.hh"
 
 // Helper methods to clone vectors
@@ -10,14 +11,6 @@ vector<unique_ptr<TypeExpr>> CloneVisitor::cloneTypeExprVector(const vector<uniq
     return result;
 }
 
-vector<unique_ptr<Expr>> CloneVisitor::cloneExprVector(const vector<unique_ptr<Expr>>& vec) {
-    vector<unique_ptr<Expr>> result;
-    for (const auto& elem : vec) {
-        result.push_back(cloneExpr(elem.get()));
-    }
-    return result;
-}
-
 // Main entry points
 unique_ptr<TypeExpr> CloneVisitor::cloneTypeExpr(const TypeExpr* node) {
     if (!node) return nullptr;
@@ -41,25 +34,31 @@ unique_ptr<TypeExpr> CloneVisitor::cloneTypeExpr(const TypeExpr* node) {
 unique_ptr<Expr> CloneVisitor::cloneExpr(const Expr* node) {
     if (!node) return nullptr;
     
-    switch (node->exprType) {
+    return foldExpr<unique_ptr<Expr>>(*node, [this](const Expr& e, vector<unique_ptr<Expr>>& children) {
+        return cloneNode(e, children);
+    });
+}
+
+unique_ptr<Expr> CloneVisitor::cloneNode(const Expr& node, vector<unique_ptr<Expr>>& children) {
+    switch (node.exprType) {
         case ExprType::VAR:
-            return cloneVar(dynamic_cast<const Var&>(*node));
+            return cloneVar(dynamic_cast<const Var&>(node));
         case ExprType::FUNCCALL:
-            return cloneFuncCall(dynamic_cast<const FuncCall&>(*node));
+            return cloneFuncCall(dynamic_cast<const FuncCall&>(node), children);
         case ExprType::NUM:
-            return cloneNum(dynamic_cast<const Num&>(*node));
+            return cloneNum(dynamic_cast<const Num&>(node));
         case ExprType::STRING:
-            return cloneString(dynamic_cast<const String&>(*node));
+            return cloneString(dynamic_cast<const String&>(node));
         case ExprType::SET:
-            return cloneSet(dynamic_cast<const Set&>(*node));
+            return cloneSet(dynamic_cast<const Set&>(node), children);
         case ExprType::MAP:
-            return cloneMap(dynamic_cast<const Map&>(*node));
+            return cloneMap(dynamic_cast<const Map&>(node), children);
         case ExprType::TUPLE:
-            return cloneTuple(dynamic_cast<const Tuple&>(*node));
+            return cloneTuple(dynamic_cast<const Tuple&>(node), children);
         case ExprType::SYMVAR:
-            return cloneSymVar(dynamic_cast<const SymVar&>(*node));
+            return cloneSymVar(dynamic_cast<const SymVar&>(node));
         case ExprType::INPUT:
-            return cloneInput(dynamic_cast<const Input&>(*node));
+            return cloneInput(dynamic_cast<const Input&>(node));
         default:
             throw runtime_error("Unknown Expr type in cloneExpr");
     }
@@ -112,9 +111,8 @@ unique_ptr<Expr> CloneVisitor::cloneVar(const Var &node) {
     return make_unique<Var>(node.name);
 }
 
-unique_ptr<Expr> CloneVisitor::cloneFuncCall(const FuncCall &node) {
-    vector<unique_ptr<Expr>> clonedArgs = cloneExprVector(node.args);
-    return make_unique<FuncCall>(node.name, std::move(clonedArgs));
+unique_ptr<Expr> CloneVisitor::cloneFuncCall(const FuncCall &node, vector<unique_ptr<Expr>>& args) {
+    return make_unique<FuncCall>(node.name, std::move(args));
 }
 
 unique_ptr<Expr> CloneVisitor::cloneNum(const Num &node) {
@@ -125,34 +123,23 @@ unique_ptr<Expr> CloneVisitor::cloneString(const String &node) {
     return make_unique<String>(node.value);
 }
 
-unique_ptr<Expr> CloneVisitor::cloneSet(const Set &node) {
-    vector<unique_ptr<Expr>> clonedElements = cloneExprVector(node.elements);
-    return make_unique<Set>(std::move(clonedElements));
+unique_ptr<Expr> CloneVisitor::cloneSet(const Set &node, vector<unique_ptr<Expr>>& elements) {
+    return make_unique<Set>(std::move(elements));
 }
 
-unique_ptr<Expr> CloneVisitor::cloneMap(const Map &node) {
+unique_ptr<Expr> CloneVisitor::cloneMap(const Map &node, vector<unique_ptr<Expr>>& values) {
     vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> clonedValue;
     
-    for (const auto& element : node.value) {
-        unique_ptr<Expr> clonedKeyExpr = cloneExpr(element.first.get());
-        Var* keyPtr = dynamic_cast<Var*>(clonedKeyExpr.get());
-        
-        if (!keyPtr) {
-            throw runtime_error("Map key is not of type Var");
-        }
-        
-        unique_ptr<Var> clonedKey(static_cast<Var*>(clonedKeyExpr.release()));
-        unique_ptr<Expr> clonedVal = cloneExpr(element.second.get());
-        
-        clonedValue.emplace_back(std::move(clonedKey), std::move(clonedVal));
+    for (size_t i = 0; i < node.value.size(); i++) {
+        unique_ptr<Var> clonedKey = make_unique<Var>(node.value[i].first->name);
+        clonedValue.emplace_back(std::move(clonedKey), std::move(values[i]));
     }
     
     return make_unique<Map>(std::move(clonedValue));
 }
 
-unique_ptr<Expr> CloneVisitor::cloneTuple(const Tuple &node) {
-    vector<unique_ptr<Expr>> clonedExprs = cloneExprVector(node.exprs);
-    return make_unique<Tuple>(std::move(clonedExprs));
+unique_ptr<Expr> CloneVisitor::cloneTuple(const Tuple &node, vector<unique_ptr<Expr>>& exprs) {
+    return make_unique<Tuple>(std::move(exprs));
 }
 
 unique_ptr<Expr> CloneVisitor::cloneSymVar(const SymVar &node) {
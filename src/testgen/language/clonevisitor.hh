@@ -10,6 +10,8 @@ using namespace std;
 
 // CloneVisitor creates deep copies of AST nodes
 // This is a standalone utility class that doesn't inherit from ASTVisitor
+// Expressions are copied with foldExpr (exprwalk.hh), so deep And chains do
+// not recurse once per level
 class CloneVisitor
 {
 public:
@@ -26,14 +28,15 @@ private:
     unique_ptr<TypeExpr> cloneTupleType(const TupleType &node);
     unique_ptr<TypeExpr> cloneSetType(const SetType &node);
 
-    // Expression cloners
+    // Expression cloners; nodes with subexpressions get their cloned children
+    unique_ptr<Expr> cloneNode(const Expr &node, vector<unique_ptr<Expr>>& children);
     unique_ptr<Expr> cloneVar(const Var &node);
-    unique_ptr<Expr> cloneFuncCall(const FuncCall &node);
+    unique_ptr<Expr> cloneFuncCall(const FuncCall &node, vector<unique_ptr<Expr>>& args);
     unique_ptr<Expr> cloneNum(const Num &node);
     unique_ptr<Expr> cloneString(const String &node);
-    unique_ptr<Expr> cloneSet(const Set &node);
-    unique_ptr<Expr> cloneMap(const Map &node);
-    unique_ptr<Expr> cloneTuple(const Tuple &node);
+    unique_ptr<Expr> cloneSet(const Set &node, vector<unique_ptr<Expr>>& elements);
+    unique_ptr<Expr> cloneMap(const Map &node, vector<unique_ptr<Expr>>& values);
+    unique_ptr<Expr> cloneTuple(const Tuple &node, vector<unique_ptr<Expr>>& exprs);
     unique_ptr<Expr> cloneSymVar(const class SymVar &node);
     unique_ptr<Expr> cloneInput(const class Input &node);
 
@@ -44,7 +47,6 @@ private:
 
     // Helper to clone vectors
     vector<unique_ptr<TypeExpr>> cloneTypeExprVector(const vector<unique_ptr<TypeExpr>>& vec);
-    vector<unique_ptr<Expr>> cloneExprVector(const vector<unique_ptr<Expr>>& vec);
 };
 
 #endif // CLONEVISITOR_HH
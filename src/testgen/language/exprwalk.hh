@@ -0,0 +1,218 @@
+#ifndef EXPRWALK_HH
+#define EXPRWALK_HH
+
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast.hh"
+#include "symvar.hh"
+
+using namespace std;
+
+/**
+ * Iterative traversals of Expr trees.
+ *
+ * Path constraints are right-nested And chains as deep as the number of
+ * assumptions, so a walker that recurses once per level overflows the call
+ * stack on long test strings. The walkers below keep their work list on the
+ * heap; their depth is bounded by memory only.
+ *
+ * The children of a node are its subexpressions, left to right: the
+ * arguments of a FuncCall, the elements of a Set or Tuple and the values of
+ * a Map. Map keys are Vars and belong to their node.
+ */
+inline size_t exprChildCount(const Expr& e) {
+    switch (e.exprType) {
+        case ExprType::FUNCCALL:
+            return static_cast<const FuncCall&>(e).args.size();
+        case ExprType::SET:
+            return static_cast<const Set&>(e).elements.size();
+        case ExprType::MAP:
+            return static_cast<const Map&>(e).value.size();
+        case ExprType::TUPLE:
+            return static_cast<const Tuple&>(e).exprs.size();
+        default:
+            return 0;
+    }
+}
+
+inline const Expr& exprChild(const Expr& e, size_t i) {
+    switch (e.exprType) {
+        case ExprType::FUNCCALL:
+            return *static_cast<const FuncCall&>(e).args[i];
+        case ExprType::SET:
+            return *static_cast<const Set&>(e).elements[i];
+        case ExprType::MAP:
+            return *static_cast<const Map&>(e).value[i].second;
+        default:
+            return *static_cast<const Tuple&>(e).exprs[i];
+    }
+}
+
+inline Expr& exprChild(Expr& e, size_t i) {
+    return const_cast<Expr&>(exprChild(static_cast<const Expr&>(e), i));
+}
+
+/**
+ * What walkExpr does after visiting a node
+ */
+enum class WalkAction { DESCEND, SKIP, STOP };
+
+/**
+ * Pre-order walk: visit(node) is called on a node before its children and
+ * decides whether to descend into them, skip them or stop the walk.
+ * Returns true if the walk was stopped. E is Expr or const Expr.
+ */
+template <typename E, typename Visit>
+bool walkExpr(E& root, Visit visit) {
+    vector<E*> pending{ &root };
+    while (!pending.empty()) {
+        E* node = pending.back();
+        pending.pop_back();
+        WalkAction action = visit(*node);
+        if (action == WalkAction::STOP) {
+            return true;
+        }
+        if (action == WalkAction::DESCEND) {
+            for (size_t i = exprChildCount(*node); i-- > 0;) {
+                pending.push_back(&exprChild(*node, i));
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Top-level conjuncts of a formula, left to right: the operands of its
+ * nested binary And nodes. E is Expr or const Expr.
+ */
+template <typename E>
+void flattenAnd(E& formula, vector<E*>& conjuncts) {
+    walkExpr(formula, [&conjuncts](E& node) {
+        if (node.exprType == ExprType::FUNCCALL) {
+            const FuncCall& fc = static_cast<const FuncCall&>(node);
+            if ((fc.name == "And" || fc.name == "and" || fc.name == "&&") && fc.args.size() == 2) {
+                return WalkAction::DESCEND;
+            }
+        }
+        conjuncts.push_back(&node);
+        return WalkAction::SKIP;
+    });
+}
+
+/**
+ * Post-order fold: leave(node, children) is called on a node after all its
+ * children, left to right, with their results, and returns the node's
+ * result. leave may move out of children. E is Expr or const Expr.
+ */
+template <typename R, typename E, typename Leave>
+R foldExpr(E& root, Leave leave) {
+    struct Frame {
+        E* node;
+        size_t next;    // next child to descend into
+        size_t base;    // first result of this node's children
+    };
+    vector<Frame> frames{ Frame{ &root, 0, 0 } };
+    vector<R> results;
+    while (true) {
+        Frame& top = frames.back();
+        if (top.next < exprChildCount(*top.node)) {
+            E* child = &exprChild(*top.node, top.next++);
+            frames.push_back(Frame{ child, 0, results.size() });
+            continue;
+        }
+        vector<R> children(make_move_iterator(results.begin() + top.base),
+                           make_move_iterator(results.end()));
+        results.erase(results.begin() + top.base, results.end());
+        E* node = top.node;
+        frames.pop_back();
+        R result = leave(*node, children);
+        if (frames.empty()) {
+            return result;
+        }
+        results.push_back(std::move(result));
+    }
+}
+
+/**
+ * SymVar numbers occurring in an expression
+ */
+inline void collectSymVars(const Expr& e, set<unsigned int>& nums) {
+    walkExpr(e, [&nums](const Expr& node) {
+        if (node.exprType == ExprType::SYMVAR) {
+            nums.insert(static_cast<const SymVar&>(node).getNum());
+        }
+        return WalkAction::DESCEND;
+    });
+}
+
+/**
+ * Shape of an expression, appended to key: its nodes in post-order, each
+ * with its arity, so distinct trees never share a key. Leaf values are
+ * length-prefixed. With slots, a SymVar is its position in *slots (first
+ * occurrence order; new ones are appended); without, every SymVar is "$".
+ */
+inline void shapeKey(const Expr& e, string& key, vector<unsigned int>* slots = nullptr) {
+    auto text = [&key](const string& s) { key += to_string(s.size()) + ":" + s; };
+    map<unsigned int, size_t> slotOf;
+    if (slots) {
+        for (size_t i = 0; i < slots->size(); i++) {
+            slotOf.emplace((*slots)[i], i);
+        }
+    }
+    foldExpr<int>(e, [&](const Expr& node, vector<int>&) {
+        switch (node.exprType) {
+            case ExprType::SYMVAR: {
+                if (!slots) {
+                    key += "$;";
+                    break;
+                }
+                unsigned int num = static_cast<const SymVar&>(node).getNum();
+                auto slot = slotOf.emplace(num, slots->size());
+                if (slot.second) {
+                    slots->push_back(num);
+                }
+                key += "$" + to_string(slot.first->second) + ";";
+                break;
+            }
+            case ExprType::NUM:
+                key += "n" + to_string(static_cast<const Num&>(node).value) + ";";
+                break;
+            case ExprType::STRING:
+                key += "s";
+                text(static_cast<const String&>(node).value);
+                break;
+            case ExprType::VAR:
+                key += "v";
+                text(static_cast<const Var&>(node).name);
+                break;
+            case ExprType::FUNCCALL: {
+                const FuncCall& fc = static_cast<const FuncCall&>(node);
+                key += "f" + to_string(fc.args.size()) + ";";
+                text(fc.name);
+                break;
+            }
+            case ExprType::SET:
+                key += "{" + to_string(exprChildCount(node)) + ";";
+                break;
+            case ExprType::MAP:
+                key += "[" + to_string(exprChildCount(node)) + ";";
+                for (const auto& kv : static_cast<const Map&>(node).value) {
+                    text(kv.first->name);
+                }
+                break;
+            case ExprType::TUPLE:
+                key += "<" + to_string(exprChildCount(node)) + ";";
+                break;
+            default:
+                key += "?" + to_string((int)node.exprType) + ";";
+                break;
+        }
+        return 0;
+    });
+}
+
+#endif // EXPRWALK_HH
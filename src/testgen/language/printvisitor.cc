@@ -1,146 +1,161 @@
 #include "printvisitor.hh"
 #include "symvar.hh"
+#include <sstream>
 
-PrintVisitor::PrintVisitor() : indentLevel(0) {
+PrintVisitor::PrintVisitor(ostream& out) : indentLevel(0), out(out) {
     updateIndent();
 }
 
+string PrintVisitor::exprToString(const Expr* expr) {
+    ostringstream text;
+    PrintVisitor printer(text);
+    printer.printExpr(expr);
+    return text.str();
+}
+
+string PrintVisitor::stmtToString(const Stmt* stmt) {
+    ostringstream text;
+    PrintVisitor printer(text);
+    printer.printStmt(stmt);
+    return text.str();
+}
+
 // Type Expression visitors
 void PrintVisitor::visitTypeConst(const TypeConst &node) {
-    cout << node.name;
+    out << node.name;
 }
 
 void PrintVisitor::visitFuncType(const FuncType &node) {
-    cout << "(";
+    out << "(";
     for (size_t i = 0; i < node.params.size(); i++) {
-        if (i > 0) cout << ", ";
+        if (i > 0) out << ", ";
         visit(node.params[i].get());
     }
-    cout << ") -> ";
+    out << ") -> ";
     visit(node.returnType.get());
 }
 
 void PrintVisitor::visitMapType(const MapType &node) {
-    cout << "map<";
+    out << "map<";
     visit(node.domain.get());
-    cout << ", ";
+    out << ", ";
     visit(node.range.get());
-    cout << ">";
+    out << ">";
 }
 
 void PrintVisitor::visitTupleType(const TupleType &node) {
-    cout << "(";
+    out << "(";
     for (size_t i = 0; i < node.elements.size(); i++) {
-        if (i > 0) cout << ", ";
+        if (i > 0) out << ", ";
         visit(node.elements[i].get());
     }
-    cout << ")";
+    out << ")";
 }
 
 void PrintVisitor::visitSetType(const SetType &node) {
-    cout << "set<";
+    out << "set<";
     visit(node.elementType.get());
-    cout << ">";
+    out << ">";
 }
 
 // Expression visitors
 void PrintVisitor::visitVar(const Var &node) {
-    cout << node.name;
+    out << node.name;
 }
 
 void PrintVisitor::visitFuncCall(const FuncCall &node) {
-    cout << node.name << "(";
+    out << node.name << "(";
     for (size_t i = 0; i < node.args.size(); i++) {
-        if (i > 0) cout << ", ";
-        visit(node.args[i].get());
+        if (i > 0) out << ", ";
+        printExpr(node.args[i].get());
     }
-    cout << ")";
+    out << ")";
 }
 
 void PrintVisitor::visitNum(const Num &node) {
-    cout << node.value;
+    out << node.value;
 }
 
 void PrintVisitor::visitString(const String &node) {
-    cout << "\"" << node.value << "\"";
+    out << "\"" << node.value << "\"";
 }
 
 void PrintVisitor::visitSet(const Set &node) {
-    cout << "{";
+    out << "{";
     for (size_t i = 0; i < node.elements.size(); i++) {
-        if (i > 0) cout << ", ";
-        visit(node.elements[i].get());
+        if (i > 0) out << ", ";
+        printExpr(node.elements[i].get());
     }
-    cout << "}";
+    out << "}";
 }
 
 void PrintVisitor::visitMap(const Map &node) {
-    cout << "{";
+    out << "{";
     for (size_t i = 0; i < node.value.size(); i++) {
-        if (i > 0) cout << ", ";
-        visit(node.value[i].first.get());
-        cout << " -> ";
-        visit(node.value[i].second.get());
+        if (i > 0) out << ", ";
+        printExpr(node.value[i].first.get());
+        out << " -> ";
+        printExpr(node.value[i].second.get());
     }
-    cout << "}";
+    out << "}";
 }
 
 void PrintVisitor::visitTuple(const Tuple &node) {
-    cout << "(";
+    out << "(";
     for (size_t i = 0; i < node.exprs.size(); i++) {
-        if (i > 0) cout << ", ";
-        visit(node.exprs[i].get());
+        if (i > 0) out << ", ";
+        printExpr(node.exprs[i].get());
     }
-    cout << ")";
+    out << ")";
 }
 
 // Statement visitors
 void PrintVisitor::visitAssign(const Assign &node) {
-    visit(node.left.get());
-    cout << " := ";
-    visit(node.right.get());
+    printExpr(node.left.get());
+    out << " := ";
+    printExpr(node.right.get());
 }
 
 void PrintVisitor::visitAssume(const Assume &node) {
-    cout << "assume(";
-    visit(node.expr.get());
-    cout << ")";
+    out << "assume(";
+    printExpr(node.expr.get());
+    out << ")";
 }
 
 // High-level visitors
 void PrintVisitor::visitDecl(const Decl &node) {
-    cout << node.name << ": ";
+    out << node.name << ": ";
     visit(node.type.get());
 }
 
 void PrintVisitor::visitAPIcall(const APIcall &node) {
     visit(node.call.get());
-    cout << " -> ";
+    out << " -> ";
     visitResponse(node.response);
 }
 
 void PrintVisitor::visitAPI(const API &node) {
-    cout << "API {" << endl;
+    out << "API {" << endl;
     indent();
     
     printIndent();
-    cout << "pre: ";
+    out << "pre: ";
     visit(node.pre.get());
-    cout << endl;
+    out << endl;
     
     printIndent();
-    cout << "call: ";
+    out << "call: ";
     visitAPIcall(*node.call);
-    cout << endl;
+    out << endl;
     
     printIndent();
-    cout << "post: ";
+    out << "post: ";
     visitResponse(node.response);
-    cout << endl;
+    out << endl;
     
     dedent();
     printIndent();
-    cout << "}";
+    out << "}";
 }
 
 void PrintVisitor::visitResponse(const Response &node) {
@@ -162,57 +177,62 @@ void PrintVisitor::visitResponse(const Response &node) {
     // }
     // Print expression if present
     if (node.ResponseExpr) {
-        cout << ", ";
+        out << ", ";
         visit(node.ResponseExpr.get());
     }
-    cout << ")";
+    out << ")";
 }
 
 void PrintVisitor::visitInit(const Init &node) {
-    cout << node.varName << " := ";
+    out << node.varName << " := ";
     visit(node.expr.get());
 }
 
 void PrintVisitor::visitSpec(const Spec &node) {
-    cout << "=== Spec ===" << endl;
+    out << "=== Spec ===" << endl;
     
-    cout << "Globals:" << endl;
+    out << "Globals:" << endl;
     for (const auto& g : node.globals) {
         printIndent();
         visitDecl(*g);
-        cout << endl;
+        out << endl;
     }
     
-    cout << "Init:" << endl;
+    out << "Init:" << endl;
     for (const auto& i : node.init) {
         printIndent();
         visitInit(*i);
-        cout << endl;
+        out << endl;
     }
     
-    cout << "Blocks:" << endl;
+    out << "Blocks:" << endl;
     for (const auto& b : node.blocks) {
         visitAPI(*b);
-        cout << endl;
+        out << endl;
     }
     
-    cout << "=== End Spec ===" << endl;
+    out << "=== End Spec ===" << endl;
 }
 
 void PrintVisitor::visitProgram(const Program &node) {
-    cout << "=== Program ===" << endl;
+    out << "=== Program ===" << endl;
     for (size_t i = 0; i < node.statements.size(); i++) {
-        cout << "Statement " << i << ": ";
+        out << "Statement " << i << ": ";
         printStmt(node.statements[i].get());
-        cout << endl;
+        out << endl;
     }
-    cout << "=== End Program ===" << endl;
+    out << "=== End Program ===" << endl;
 }
 
 // Convenience methods
 void PrintVisitor::printExpr(const Expr* expr) {
     if (!expr) {
-        cout << "null";
+        out << "null";
+        return;
+    }
+    if (expr->exprType == ExprType::SYMVAR) {
+        // Not part of the visitor's dispatch
+        out << "X" << dynamic_cast<const SymVar*>(expr)->getNum();
         return;
     }
     visit(expr);
@@ -220,7 +240,7 @@ void PrintVisitor::printExpr(const Expr* expr) {
 
 void PrintVisitor::printStmt(const Stmt* stmt) {
     if (!stmt) {
-        cout << "null";
+        out << "null";
         return;
     }
     
@@ -228,11 +248,11 @@ void PrintVisitor::printStmt(const Stmt* stmt) {
     // Assert uses ASSUME type but is a different class
     const Assert* assertStmt = dynamic_cast<const Assert*>(stmt);
     if (assertStmt) {
-        cout << "assert(";
+        out << "assert(";
         if (assertStmt->expr) {
-            visit(assertStmt->expr.get());
+            printExpr(assertStmt->expr.get());
         }
-        cout << ")";
+        out << ")";
         return;
     }
     
@@ -240,13 +260,13 @@ void PrintVisitor::printStmt(const Stmt* stmt) {
     try {
         visit(stmt);
     } catch (const std::runtime_error& e) {
-        cout << "UnknownStmt";
+        out << "UnknownStmt";
     }
 }
 
 void PrintVisitor::printTypeExpr(const TypeExpr* type) {
     if (!type) {
-        cout << "null";
+        out << "null";
         return;
     }
     visit(type);
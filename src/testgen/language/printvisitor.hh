@@ -9,13 +9,14 @@
 using namespace std;
 
 /**
- * PrintVisitor: Prints AST nodes in a readable format
- * Useful for debugging and visualizing generated ATCs
+ * PrintVisitor: Prints AST nodes in a readable format to a stream (cout
+ * by default). Useful for debugging and visualizing generated ATCs
  */
 class PrintVisitor : public ASTVisitor {
 private:
     int indentLevel;
     string indentStr;
+    ostream& out;
     
     void indent() {
         indentLevel++;
@@ -32,7 +33,7 @@ private:
     }
     
     void printIndent() {
-        cout << indentStr;
+        out << indentStr;
     }
 
 protected:
@@ -57,7 +58,7 @@ protected:
     void visitAssume(const Assume &node) override;
 
 public:
-    PrintVisitor();
+    PrintVisitor(ostream& out = cout);
     
     // High-level visitors
     void visitDecl(const Decl &node) override;
@@ -72,6 +73,10 @@ public:
     void printExpr(const Expr* expr);
     void printStmt(const Stmt* stmt);
     void printTypeExpr(const TypeExpr* type);
+
+    // One-line form of an expression or statement, e.g. for log messages
+    static string exprToString(const Expr* expr);
+    static string stmtToString(const Stmt* stmt);
 };
 
 #endif // PRINTVISITOR_HH
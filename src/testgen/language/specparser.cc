@@ -0,0 +1,711 @@
+#include "specparser.hh"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <set>
+#include <stdexcept>
+
+// ============================================================================
+// Lexer
+// ============================================================================
+
+struct SpecToken {
+    enum Kind { IDENT, INT, STRING, SYMBOL, END } kind;
+    string text;
+    size_t offset;
+};
+
+// Thrown when a token or an item of text[begin, end) continues past end: the
+// caller has to rescan a larger region. Never escapes a scan of a whole text.
+struct SpecRegionOverrun {};
+
+static int lineOf(const string& text, size_t offset) {
+    return 1 + (int)count(text.begin(), text.begin() + min(offset, text.size()), '\n');
+}
+
+static vector<SpecToken> tokenize(const string& text, size_t begin, size_t end) {
+    vector<SpecToken> tokens;
+    size_t i = begin;
+    while (i < end) {
+        char c = text[i];
+        if (isspace((unsigned char)c)) {
+            i++;
+        } else if (text.compare(i, 2, "//") == 0) {
+            size_t j = text.find('\n', i);
+            if (j == string::npos) j = text.size();
+            if (j > end) throw SpecRegionOverrun();
+            i = j;
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            size_t j = i;
+            while (j < text.size() && (isalnum((unsigned char)text[j]) || text[j] == '_')) j++;
+            if (j > end) throw SpecRegionOverrun();
+            tokens.push_back({ SpecToken::IDENT, text.substr(i, j - i), i });
+            i = j;
+        } else if (isdigit((unsigned char)c)) {
+            size_t j = i;
+            while (j < text.size() && isdigit((unsigned char)text[j])) j++;
+            if (j > end) throw SpecRegionOverrun();
+            tokens.push_back({ SpecToken::INT, text.substr(i, j - i), i });
+            i = j;
+        } else if (c == '"') {
+            size_t j = text.find('"', i + 1);
+            if (j != string::npos && j >= end) throw SpecRegionOverrun();
+            if (j == string::npos) {
+                if (end < text.size()) throw SpecRegionOverrun();
+                throw runtime_error("Spec line " + to_string(lineOf(text, i)) + ": unterminated string");
+            }
+            tokens.push_back({ SpecToken::STRING, text.substr(i + 1, j - i - 1), i });
+            i = j + 1;
+        } else {
+            static const vector<string> symbols = { "==>", "->", "=>", "==", "!=", "<=", ">=", "&&", "||" };
+            string sym(1, c);
+            for (const auto& s : symbols) {
+                if (text.compare(i, s.size(), s) == 0) {
+                    sym = s;
+                    break;
+                }
+            }
+            if (i + sym.size() > end) throw SpecRegionOverrun();
+            tokens.push_back({ SpecToken::SYMBOL, sym, i });
+            i += sym.size();
+        }
+    }
+    tokens.push_back({ SpecToken::END, "", end });
+    return tokens;
+}
+
+// ============================================================================
+// Parser of one item
+// ============================================================================
+
+static unique_ptr<Expr> binary(const string& name, unique_ptr<Expr> l, unique_ptr<Expr> r) {
+    vector<unique_ptr<Expr>> args;
+    args.push_back(std::move(l));
+    args.push_back(std::move(r));
+    return make_unique<FuncCall>(name, std::move(args));
+}
+
+class SpecItemParser {
+private:
+    const string& text;
+    vector<SpecToken> tokens;
+    size_t pos;
+
+    [[noreturn]] void fail(const string& what) const {
+        const SpecToken& t = tokens[pos];
+        throw runtime_error("Spec line " + to_string(lineOf(text, t.offset)) + ": " + what +
+                            (t.kind == SpecToken::END ? " at end of item" : " near '" + t.text + "'"));
+    }
+
+    const SpecToken& peek() const { return tokens[pos]; }
+
+    bool isSymbol(const string& s) const {
+        return peek().kind == SpecToken::SYMBOL && peek().text == s;
+    }
+
+    bool isKeyword(const string& s) const {
+        return peek().kind == SpecToken::IDENT && peek().text == s;
+    }
+
+    bool accept(const string& s) {
+        if (isSymbol(s) || isKeyword(s)) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const string& s) {
+        if (!accept(s)) fail("expected '" + s + "'");
+    }
+
+    string name() {
+        static const set<string> reserved = { "and", "or", "not", "in", "union" };
+        if (peek().kind != SpecToken::IDENT || reserved.count(peek().text)) fail("expected a name");
+        return tokens[pos++].text;
+    }
+
+    // type := postfix ('*' postfix)*
+    unique_ptr<TypeExpr> type() {
+        unique_ptr<TypeExpr> t = postfixType();
+        if (!isSymbol("*")) {
+            return t;
+        }
+        vector<unique_ptr<TypeExpr>> elements;
+        elements.push_back(std::move(t));
+        while (accept("*")) {
+            elements.push_back(postfixType());
+        }
+        return make_unique<TupleType>(std::move(elements));
+    }
+
+    // postfix := NAME | '(' type ')' | '(' type '->' type ')' 'map', then any number of 'set'
+    unique_ptr<TypeExpr> postfixType() {
+        unique_ptr<TypeExpr> t;
+        if (accept("(")) {
+            unique_ptr<TypeExpr> inner = type();
+            if (accept("->")) {
+                unique_ptr<TypeExpr> range = type();
+                expect(")");
+                expect("map");
+                t = make_unique<MapType>(std::move(inner), std::move(range));
+            } else {
+                expect(")");
+                t = std::move(inner);
+            }
+        } else {
+            if (isKeyword("set") || isKeyword("map")) fail("expected a type");
+            t = make_unique<TypeConst>(name());
+        }
+        while (true) {
+            if (accept("set")) {
+                t = make_unique<SetType>(std::move(t));
+            } else if (isKeyword("map")) {
+                fail("a map type is written (K -> V) map");
+            } else {
+                return t;
+            }
+        }
+    }
+
+    // Precedence, loosest first: =>, or, and, comparisons and in, + - union, * /, unary, postfix
+    unique_ptr<Expr> expr() {
+        unique_ptr<Expr> l = orExpr();
+        if (accept("=>")) {
+            return binary("Implies", std::move(l), expr());
+        }
+        return l;
+    }
+
+    unique_ptr<Expr> orExpr() {
+        unique_ptr<Expr> l = andExpr();
+        while (accept("or") || accept("||")) {
+            l = binary("Or", std::move(l), andExpr());
+        }
+        return l;
+    }
+
+    unique_ptr<Expr> andExpr() {
+        unique_ptr<Expr> l = compareExpr();
+        while (accept("and") || accept("&&")) {
+            l = binary("And", std::move(l), compareExpr());
+        }
+        return l;
+    }
+
+    unique_ptr<Expr> compareExpr() {
+        static const map<string, string> ops = {
+            { "=", "Eq" }, { "==", "Eq" }, { "!=", "Neq" },
+            { "<", "Lt" }, { "<=", "Le" }, { ">", "Gt" }, { ">=", "Ge" }
+        };
+        unique_ptr<Expr> l = addExpr();
+        if (peek().kind == SpecToken::SYMBOL && ops.count(peek().text)) {
+            string op = ops.at(tokens[pos++].text);
+            return binary(op, std::move(l), addExpr());
+        }
+        if (accept("in")) {
+            return binary("in", std::move(l), addExpr());
+        }
+        return l;
+    }
+
+    unique_ptr<Expr> addExpr() {
+        unique_ptr<Expr> l = mulExpr();
+        while (true) {
+            if (accept("+")) {
+                l = binary("Add", std::move(l), mulExpr());
+            } else if (accept("-")) {
+                l = binary("Sub", std::move(l), mulExpr());
+            } else if (accept("union")) {
+                l = binary("union", std::move(l), mulExpr());
+            } else {
+                return l;
+            }
+        }
+    }
+
+    unique_ptr<Expr> mulExpr() {
+        unique_ptr<Expr> l = unaryExpr();
+        while (true) {
+            if (accept("*")) {
+                l = binary("Mul", std::move(l), unaryExpr());
+            } else if (accept("/")) {
+                l = binary("Div", std::move(l), unaryExpr());
+            } else {
+                return l;
+            }
+        }
+    }
+
+    unique_ptr<Expr> unaryExpr() {
+        if (accept("not") || accept("!")) {
+            vector<unique_ptr<Expr>> args;
+            args.push_back(unaryExpr());
+            return make_unique<FuncCall>("Not", std::move(args));
+        }
+        if (accept("-")) {
+            if (peek().kind == SpecToken::INT) {
+                return make_unique<Num>(-integer());
+            }
+            return binary("Sub", make_unique<Num>(0), unaryExpr());
+        }
+        return postfixExpr();
+    }
+
+    unique_ptr<Expr> postfixExpr() {
+        unique_ptr<Expr> e = primary();
+        while (true) {
+            if (accept("'")) {
+                vector<unique_ptr<Expr>> args;
+                args.push_back(std::move(e));
+                e = make_unique<FuncCall>("'", std::move(args));
+            } else if (accept("[")) {
+                vector<unique_ptr<Expr>> args;
+                args.push_back(std::move(e));
+                args.push_back(expr());
+                string f = "get";
+                if (accept("->")) {
+                    args.push_back(expr());
+                    f = "put";
+                }
+                expect("]");
+                e = make_unique<FuncCall>(f, std::move(args));
+            } else {
+                return e;
+            }
+        }
+    }
+
+    int integer() {
+        const SpecToken& t = tokens[pos];
+        if (t.kind != SpecToken::INT) fail("expected an integer");
+        if (t.text.size() > 10 || stoll(t.text) > INT_MAX) fail("integer out of range");
+        pos++;
+        return stoi(t.text);
+    }
+
+    vector<unique_ptr<Expr>> arguments() {
+        vector<unique_ptr<Expr>> args;
+        expect("(");
+        if (!accept(")")) {
+            do {
+                args.push_back(expr());
+            } while (accept(","));
+            expect(")");
+        }
+        return args;
+    }
+
+    unique_ptr<Expr> primary() {
+        if (peek().kind == SpecToken::INT) {
+            return make_unique<Num>(integer());
+        }
+        if (peek().kind == SpecToken::STRING) {
+            return make_unique<String>(tokens[pos++].text);
+        }
+        if (isSymbol("(")) {
+            vector<unique_ptr<Expr>> exprs = arguments();
+            if (exprs.empty()) fail("expected an expression");
+            if (exprs.size() == 1) {
+                return std::move(exprs[0]);
+            }
+            return make_unique<Tuple>(std::move(exprs));
+        }
+        if (accept("{")) {
+            return collection();
+        }
+        string id = name();
+        if (isSymbol("(")) {
+            return make_unique<FuncCall>(id, arguments());
+        }
+        return make_unique<Var>(id);
+    }
+
+    // After '{': {} and {a, b} are sets, {k -> v, ...} is a map
+    unique_ptr<Expr> collection() {
+        vector<unique_ptr<Expr>> elements;
+        vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+        if (!accept("}")) {
+            do {
+                unique_ptr<Expr> e = expr();
+                if (accept("->")) {
+                    if (e->exprType != ExprType::VAR || !elements.empty()) fail("map keys must be names");
+                    entries.push_back(make_pair(unique_ptr<Var>(dynamic_cast<Var*>(e.release())), expr()));
+                } else {
+                    if (!entries.empty()) fail("expected '->'");
+                    elements.push_back(std::move(e));
+                }
+            } while (accept(","));
+            expect("}");
+        }
+        if (!entries.empty()) {
+            return make_unique<Map>(std::move(entries));
+        }
+        return make_unique<Set>(std::move(elements));
+    }
+
+    void done() {
+        if (peek().kind != SpecToken::END) fail("unexpected input");
+    }
+
+public:
+    SpecItemParser(const string& text, const SpecItem& item)
+        : text(text), tokens(tokenize(text, item.begin, item.end)), pos(0) {}
+
+    // global NAME ':' type ';'
+    unique_ptr<Decl> global() {
+        expect("global");
+        string id = name();
+        expect(":");
+        unique_ptr<TypeExpr> t = type();
+        expect(";");
+        done();
+        return make_unique<Decl>(id, std::move(t));
+    }
+
+    // init NAME '=' expr ';'   ({} is an empty map if the global is a map)
+    unique_ptr<Init> init(const TypeExpr* declared) {
+        expect("init");
+        string id = name();
+        expect("=");
+        unique_ptr<Expr> e = expr();
+        expect(";");
+        done();
+        if (declared && declared->typeExprType == TypeExprType::MAP_TYPE &&
+            e->exprType == ExprType::SET && dynamic_cast<Set*>(e.get())->elements.empty()) {
+            e = make_unique<Map>(vector<pair<unique_ptr<Var>, unique_ptr<Expr>>>());
+        }
+        return make_unique<Init>(id, std::move(e));
+    }
+
+    // block NAME '{' [pre expr ';'] call NAME args ['==>' expr] ';' [post expr ';'] '}'
+    unique_ptr<API> block() {
+        expect("block");
+        string id = name();
+        expect("{");
+        unique_ptr<Expr> pre;
+        if (accept("pre")) {
+            pre = expr();
+            expect(";");
+        }
+        expect("call");
+        string api = name();
+        vector<unique_ptr<Expr>> args = arguments();
+        unique_ptr<Expr> response;
+        if (accept("==>")) {
+            response = expr();
+        }
+        expect(";");
+        unique_ptr<Expr> post;
+        if (accept("post")) {
+            post = expr();
+            expect(";");
+        }
+        expect("}");
+        done();
+        auto call = make_unique<APIcall>(make_unique<FuncCall>(api, std::move(args)),
+                                         Response(std::move(response)));
+        return make_unique<API>(std::move(pre), std::move(call), Response(std::move(post)), id);
+    }
+};
+
+// ============================================================================
+// SpecParser Implementation
+// ============================================================================
+
+vector<SpecItem> SpecParser::scan(const string& text, size_t begin, size_t end) {
+    vector<SpecToken> tokens = tokenize(text, begin, end);
+    vector<SpecItem> items;
+    size_t i = 0;
+    auto fail = [&](const string& what) {
+        if (tokens[i].kind == SpecToken::END && end < text.size()) {
+            throw SpecRegionOverrun();
+        }
+        throw runtime_error("Spec line " + to_string(lineOf(text, tokens[i].offset)) + ": " + what);
+    };
+    while (tokens[i].kind != SpecToken::END) {
+        SpecItem item;
+        const string& keyword = tokens[i].text;
+        if (tokens[i].kind != SpecToken::IDENT ||
+            (keyword != "global" && keyword != "init" && keyword != "block")) {
+            fail("expected global, init or block near '" + keyword + "'");
+        }
+        item.kind = keyword == "global" ? SpecItemKind::GLOBAL :
+                    keyword == "init" ? SpecItemKind::INIT : SpecItemKind::BLOCK;
+        item.begin = tokens[i].offset;
+        i++;
+        if (tokens[i].kind != SpecToken::IDENT) {
+            fail("expected a name after '" + keyword + "'");
+        }
+        item.name = tokens[i].text;
+
+        // A global or init ends at the first ';' outside brackets, a block at its '}'
+        int depth = 0;
+        while (true) {
+            i++;
+            if (tokens[i].kind == SpecToken::END) {
+                if (end < text.size()) throw SpecRegionOverrun();
+                throw runtime_error("Spec line " + to_string(lineOf(text, item.begin)) + ": unterminated " +
+                                    keyword + " '" + item.name + "'");
+            }
+            if (tokens[i].kind != SpecToken::SYMBOL) continue;
+            const string& s = tokens[i].text;
+            if (s == "(" || s == "[" || s == "{") {
+                depth++;
+            } else if (s == ")" || s == "]" || s == "}") {
+                depth--;
+                if (depth == 0 && item.kind == SpecItemKind::BLOCK && s == "}") break;
+                if (depth < 0) fail("unbalanced '" + s + "'");
+            } else if (s == ";" && depth == 0 && item.kind != SpecItemKind::BLOCK) {
+                break;
+            }
+        }
+        item.end = tokens[i].offset + tokens[i].text.size();
+        items.push_back(item);
+        i++;
+    }
+    return items;
+}
+
+unique_ptr<Decl> SpecParser::parseGlobal(const string& text, const SpecItem& item) {
+    return SpecItemParser(text, item).global();
+}
+
+unique_ptr<Init> SpecParser::parseInit(const string& text, const SpecItem& item) {
+    return SpecItemParser(text, item).init(nullptr);
+}
+
+unique_ptr<API> SpecParser::parseBlock(const string& text, const SpecItem& item) {
+    return SpecItemParser(text, item).block();
+}
+
+static void checkUnique(const vector<SpecItem>& items) {
+    set<pair<SpecItemKind, string>> seen;
+    for (const auto& item : items) {
+        if (!seen.insert(make_pair(item.kind, item.name)).second) {
+            string kind = item.kind == SpecItemKind::GLOBAL ? "global" :
+                          item.kind == SpecItemKind::INIT ? "init" : "block";
+            throw runtime_error("Spec: duplicate " + kind + " '" + item.name + "'");
+        }
+    }
+}
+
+// Declared type of every global, for the initialisations
+static map<string, const TypeExpr*> declaredTypes(const vector<unique_ptr<Decl>>& globals) {
+    map<string, const TypeExpr*> types;
+    for (const auto& g : globals) {
+        types[g->name] = g->type.get();
+    }
+    return types;
+}
+
+static unique_ptr<Init> parseInitItem(const string& text, const SpecItem& item,
+                                      const map<string, const TypeExpr*>& types) {
+    auto it = types.find(item.name);
+    return SpecItemParser(text, item).init(it == types.end() ? nullptr : it->second);
+}
+
+unique_ptr<Spec> SpecParser::parse(const string& text) {
+    vector<SpecItem> items = scan(text, 0, text.size());
+    checkUnique(items);
+    vector<unique_ptr<Decl>> globals;
+    vector<unique_ptr<Init>> inits;
+    vector<unique_ptr<API>> blocks;
+    for (const auto& item : items) {
+        if (item.kind == SpecItemKind::GLOBAL) {
+            globals.push_back(parseGlobal(text, item));
+        }
+    }
+    map<string, const TypeExpr*> types = declaredTypes(globals);
+    for (const auto& item : items) {
+        if (item.kind == SpecItemKind::INIT) {
+            inits.push_back(parseInitItem(text, item, types));
+        } else if (item.kind == SpecItemKind::BLOCK) {
+            blocks.push_back(parseBlock(text, item));
+        }
+    }
+    return make_unique<Spec>(std::move(globals), std::move(inits),
+                             vector<unique_ptr<APIFuncDecl>>(), std::move(blocks));
+}
+
+// ============================================================================
+// SpecDocument Implementation
+// ============================================================================
+
+SpecDocument::SpecDocument(const string& text)
+    : text(text), spec(SpecParser::parse(text)),
+      items(SpecParser::scan(text, 0, text.size())), lastReparsed(items.size()) {}
+
+SpecDelta SpecDocument::update(const string& newText) {
+    size_t prefix = 0;
+    while (prefix < text.size() && prefix < newText.size() && text[prefix] == newText[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < text.size() - prefix && suffix < newText.size() - prefix &&
+           text[text.size() - 1 - suffix] == newText[newText.size() - 1 - suffix]) {
+        suffix++;
+    }
+    return edit(prefix, text.size() - prefix - suffix,
+                newText.substr(prefix, newText.size() - prefix - suffix));
+}
+
+SpecDelta SpecDocument::edit(size_t offset, size_t length, const string& replacement) {
+    if (offset > text.size() || length > text.size() - offset) {
+        throw runtime_error("Spec edit out of range");
+    }
+    string newText = text.substr(0, offset) + replacement + text.substr(offset + length);
+    long shift = (long)replacement.size() - (long)length;
+
+    // Items [first, last) touch the edited span; the region between their
+    // unaffected neighbours is rescanned.
+    size_t first = 0;
+    while (first < items.size() && items[first].end < offset) first++;
+    size_t last = first;
+    while (last < items.size() && items[last].begin <= offset + length) last++;
+    size_t regionBegin = first > 0 ? items[first - 1].end : 0;
+    vector<SpecItem> fresh;
+    try {
+        size_t regionEnd = last < items.size() ? items[last].begin + shift : newText.size();
+        fresh = SpecParser::scan(newText, regionBegin, regionEnd);
+    } catch (const SpecRegionOverrun&) {
+        // An unterminated item, string or comment runs into the following items
+        last = items.size();
+        fresh = SpecParser::scan(newText, regionBegin, newText.size());
+    }
+
+    vector<SpecItem> newItems(items.begin(), items.begin() + first);
+    newItems.insert(newItems.end(), fresh.begin(), fresh.end());
+    for (size_t i = last; i < items.size(); i++) {
+        SpecItem item = items[i];
+        item.begin += shift;
+        item.end += shift;
+        newItems.push_back(item);
+    }
+    checkUnique(newItems);
+
+    // Parse the rescanned items whose text changed; nothing is modified yet
+    map<pair<SpecItemKind, string>, string> oldText;
+    for (size_t i = first; i < last; i++) {
+        oldText[make_pair(items[i].kind, items[i].name)] =
+            text.substr(items[i].begin, items[i].end - items[i].begin);
+    }
+    map<string, unique_ptr<Decl>> newGlobals;
+    map<string, unique_ptr<API>> newBlocks;
+    vector<const SpecItem*> changedInits;
+    size_t reparsed = 0;
+    for (const auto& item : fresh) {
+        auto it = oldText.find(make_pair(item.kind, item.name));
+        if (it != oldText.end() && it->second == newText.substr(item.begin, item.end - item.begin)) {
+            continue;
+        }
+        if (item.kind == SpecItemKind::GLOBAL) {
+            newGlobals[item.name] = SpecParser::parseGlobal(newText, item);
+            reparsed++;
+        } else if (item.kind == SpecItemKind::INIT) {
+            changedInits.push_back(&item);
+        } else {
+            newBlocks[item.name] = SpecParser::parseBlock(newText, item);
+            reparsed++;
+        }
+    }
+
+    set<string> freshNames[3];
+    for (const auto& item : fresh) {
+        freshNames[(int)item.kind].insert(item.name);
+    }
+    bool globalsChanged = !newGlobals.empty();
+    for (size_t i = first; i < last; i++) {
+        if (items[i].kind == SpecItemKind::GLOBAL && !freshNames[(int)SpecItemKind::GLOBAL].count(items[i].name)) {
+            globalsChanged = true;
+        }
+    }
+
+    // Declared types after the edit; a changed declaration may change how {}
+    // initialises, so then every initialisation is parsed again
+    map<string, const TypeExpr*> types = declaredTypes(spec->globals);
+    for (const auto& g : newGlobals) {
+        types[g.first] = g.second->type.get();
+    }
+    map<string, unique_ptr<Init>> newInits;
+    if (globalsChanged) {
+        for (const auto& item : newItems) {
+            if (item.kind == SpecItemKind::INIT) {
+                newInits[item.name] = parseInitItem(newText, item, types);
+                reparsed++;
+            }
+        }
+    } else {
+        for (const SpecItem* item : changedInits) {
+            newInits[item->name] = parseInitItem(newText, *item, types);
+            reparsed++;
+        }
+    }
+
+    // Splice: nothing below throws except on allocation failure
+    SpecDelta delta = { {}, {}, {}, globalsChanged, false };
+    map<string, unique_ptr<Decl>> oldGlobals;
+    for (auto& g : spec->globals) {
+        oldGlobals[g->name] = std::move(g);
+    }
+    spec->globals.clear();
+    for (const auto& item : newItems) {
+        if (item.kind != SpecItemKind::GLOBAL) continue;
+        auto it = newGlobals.find(item.name);
+        spec->globals.push_back(std::move(it != newGlobals.end() ? it->second : oldGlobals[item.name]));
+    }
+
+    bool initRemoved = false;
+    for (size_t i = first; i < last; i++) {
+        if (items[i].kind == SpecItemKind::INIT && !freshNames[(int)SpecItemKind::INIT].count(items[i].name)) {
+            initRemoved = true;
+        }
+    }
+    delta.initChanged = !newInits.empty() || initRemoved;
+    map<string, unique_ptr<Init>> oldInits;
+    for (auto& in : spec->init) {
+        oldInits[in->varName] = std::move(in);
+    }
+    spec->init.clear();
+    for (const auto& item : newItems) {
+        if (item.kind != SpecItemKind::INIT) continue;
+        auto it = newInits.find(item.name);
+        spec->init.push_back(std::move(it != newInits.end() ? it->second : oldInits[item.name]));
+    }
+
+    // Blocks keep their API object and position; new ones are appended
+    for (size_t i = first; i < last; i++) {
+        if (items[i].kind != SpecItemKind::BLOCK || freshNames[(int)SpecItemKind::BLOCK].count(items[i].name)) {
+            continue;
+        }
+        auto& blocks = spec->blocks;
+        blocks.erase(remove_if(blocks.begin(), blocks.end(),
+                               [&](const unique_ptr<API>& b) { return b->name == items[i].name; }),
+                     blocks.end());
+        delta.removedBlocks.push_back(items[i].name);
+    }
+    for (const auto& item : fresh) {
+        auto it = newBlocks.find(item.name);
+        if (item.kind != SpecItemKind::BLOCK || it == newBlocks.end()) {
+            continue;
+        }
+        API* existing = nullptr;
+        for (auto& b : spec->blocks) {
+            if (b->name == item.name) existing = b.get();
+        }
+        if (existing) {
+            existing->pre = std::move(it->second->pre);
+            existing->call = std::move(it->second->call);
+            existing->response = std::move(it->second->response);
+            delta.changedBlocks.push_back(item.name);
+        } else {
+            spec->blocks.push_back(std::move(it->second));
+            delta.addedBlocks.push_back(item.name);
+        }
+    }
+
+    text = std::move(newText);
+    items = std::move(newItems);
+    lastReparsed = reparsed;
+    return delta;
+}
@@ -0,0 +1,127 @@
+#ifndef SPECPARSER_HH
+#define SPECPARSER_HH
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast.hh"
+
+using namespace std;
+
+/**
+ * SpecParser: parses the textual form of a spec
+ *
+ *     global U : (string -> string) map;
+ *     init U = {};
+ *     block signup {
+ *         pre not_in(u, U);
+ *         call signup(u, p) ==> (code, r);
+ *         post U' = U union {u -> p};
+ *     }
+ *
+ * A spec is a sequence of top-level items: global declarations, initialisations
+ * and named API blocks (pre and post are optional, the response after ==> too).
+ * Types: int, string, ..., `T set`, `(K -> V) map` and tuples `A * B`.
+ * Expressions use the evaluators' spellings: = == != < <= > >= become
+ * Eq/Neq/Lt/Le/Gt/Ge, + - * / become Add/Sub/Mul/Div, and/or/not/=> (also
+ * && || !) become And/Or/Not/Implies; `a in S` and `S union T` are calls of
+ * in/union, U' is '(U), m[k] is get(m, k) and m[k -> v] is put(m, k, v).
+ * `{a, b}` is a set and `{k -> v}` a map. Comments run from // to the end of
+ * the line. Errors are reported with runtime_error.
+ */
+enum class SpecItemKind { GLOBAL, INIT, BLOCK };
+
+/**
+ * One top-level item of a spec text and its source range [begin, end)
+ */
+struct SpecItem {
+    SpecItemKind kind;
+    string name;
+    size_t begin;
+    size_t end;
+};
+
+class SpecParser {
+public:
+    /**
+     * Parse a whole spec. Block names must be unique.
+     */
+    static unique_ptr<Spec> parse(const string& text);
+
+    /**
+     * Split text[begin, end) into top-level items without building their ASTs
+     */
+    static vector<SpecItem> scan(const string& text, size_t begin, size_t end);
+
+    static unique_ptr<Decl> parseGlobal(const string& text, const SpecItem& item);
+    static unique_ptr<Init> parseInit(const string& text, const SpecItem& item);
+    static unique_ptr<API> parseBlock(const string& text, const SpecItem& item);
+};
+
+/**
+ * What an edit changed in a SpecDocument's Spec
+ */
+struct SpecDelta {
+    vector<string> addedBlocks;
+    vector<string> changedBlocks;
+    vector<string> removedBlocks;
+    bool globalsChanged;
+    bool initChanged;
+
+    bool empty() const {
+        return addedBlocks.empty() && changedBlocks.empty() && removedBlocks.empty() &&
+               !globalsChanged && !initChanged;
+    }
+
+    /**
+     * A removed block is erased from spec->blocks and the blocks after it
+     * move up. Anything keyed by block position (CoverageMap, the children
+     * of the global SymbolTable, ATCGenerator's use of them) must then be
+     * rebuilt; added and changed blocks keep every position.
+     */
+    bool renumbersBlocks() const { return !removedBlocks.empty(); }
+};
+
+/**
+ * SpecDocument: a spec text and its Spec, kept in sync incrementally.
+ *
+ * An edit rescans only the items it touches, parses only those whose text
+ * changed and splices the new nodes into the existing Spec, so a large spec
+ * suite is not reparsed after every edit. Identities stay stable for
+ * downstream caches: the Spec object never changes; a block keeps its API
+ * object (its contents are replaced in place) as long as its name is
+ * unchanged; new blocks are appended. Positions in spec->blocks stay put
+ * unless a block is removed (see SpecDelta::renumbersBlocks).
+ * Globals and initialisations follow the source order. A failing edit throws
+ * runtime_error and leaves the document unchanged.
+ */
+class SpecDocument {
+private:
+    string text;
+    unique_ptr<Spec> spec;
+    vector<SpecItem> items;      // source order
+    size_t lastReparsed;         // items parsed by the last edit
+
+public:
+    explicit SpecDocument(const string& text);
+
+    /**
+     * Replace text[offset, offset + length) by replacement
+     */
+    SpecDelta edit(size_t offset, size_t length, const string& replacement);
+
+    /**
+     * Replace the whole text; the edit is the span between the common prefix
+     * and suffix of the old and new text
+     */
+    SpecDelta update(const string& newText);
+
+    const string& getText() const { return text; }
+    Spec& getSpec() { return *spec; }
+    const vector<SpecItem>& getItems() const { return items; }
+    size_t getLastReparsed() const { return lastReparsed; }
+};
+
+#endif // SPECPARSER_HH
@@ -1,13 +1,11 @@
 #include "symvar.hh"
 
-unsigned int SymVar::count = 0;
+atomic<unsigned int> SymVar::count(0);
 
 SymVar::SymVar(unsigned int n = 0) : Expr(ExprType::SYMVAR), num(n) {}
 
 unique_ptr<SymVar> SymVar::getNewSymVar() {
-    unique_ptr<SymVar> var = make_unique<SymVar>(count);
-    count++;
-    return var;
+    return make_unique<SymVar>(count.fetch_add(1));
 }
 
 void SymVar::accept(ASTVisitor& visitor) {}
@@ -1,6 +1,7 @@
 #ifndef SYMVAR_HH
 #define SYMVAR_HH
 
+#include <atomic>
 #include <memory>
 #include "ast.hh"
 
@@ -8,7 +9,7 @@ using namespace std;
 
 class SymVar : public Expr {
     private:
-        static unsigned int count;
+        static atomic<unsigned int> count;   // shared by concurrent generators
         unsigned int num;
     public:
         SymVar(unsigned int);
@@ -0,0 +1,179 @@
+#include "batchevaluator.hh"
+#include "intarith.hh"
+#include "../language/symvar.hh"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+typedef int32_t v8i __attribute__((vector_size(32)));
+typedef uint32_t v8u __attribute__((vector_size(32)));
+static const size_t LANES = 8;
+
+int BatchEvaluator::emit(Op op, int a, int b, int32_t value) {
+    code.push_back({ op, registers, a, b, value });
+    return registers++;
+}
+
+int BatchEvaluator::compileExpr(const Expr& e) {
+    if (e.exprType == ExprType::NUM) {
+        return emit(Op::CONST, -1, -1, dynamic_cast<const Num&>(e).value);
+    }
+    if (e.exprType == ExprType::SYMVAR) {
+        unsigned int num = dynamic_cast<const SymVar&>(e).getNum();
+        if (find(inputs.begin(), inputs.end(), num) == inputs.end()) {
+            inputs.push_back(num);
+        }
+        return emit(Op::INPUT, -1, -1, (int32_t)num);
+    }
+    if (e.exprType != ExprType::FUNCCALL) {
+        throw runtime_error("unsupported expression");
+    }
+
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+    const string& f = fc.name;
+    size_t n = fc.args.size();
+
+    static const map<string, Op> binary = {
+        { "Add", Op::ADD }, { "Sub", Op::SUB }, { "Mul", Op::MUL }, { "Div", Op::DIV },
+        { "Eq", Op::EQ }, { "=", Op::EQ }, { "==", Op::EQ },
+        { "Neq", Op::NEQ }, { "!=", Op::NEQ }, { "<>", Op::NEQ },
+        { "Lt", Op::LT }, { "<", Op::LT }, { "Le", Op::LE }, { "<=", Op::LE },
+        { "Gt", Op::GT }, { ">", Op::GT }, { "Ge", Op::GE }, { ">=", Op::GE },
+        { "And", Op::AND }, { "and", Op::AND }, { "&&", Op::AND },
+        { "Or", Op::OR }, { "or", Op::OR }, { "||", Op::OR },
+        { "Implies", Op::IMPLIES }
+    };
+
+    auto it = binary.find(f);
+    if (n == 2 && it != binary.end()) {
+        int a = compileExpr(*fc.args[0]);
+        int b = compileExpr(*fc.args[1]);
+        return emit(it->second, a, b, 0);
+    }
+    if (n == 1 && (f == "Not" || f == "not" || f == "!")) {
+        return emit(Op::NOT, compileExpr(*fc.args[0]), -1, 0);
+    }
+    throw runtime_error("unsupported function " + f);
+}
+
+bool BatchEvaluator::compile(const Expr& e) {
+    code.clear();
+    inputs.clear();
+    registers = 0;
+    result = -1;
+    try {
+        result = compileExpr(e);
+    } catch (const runtime_error&) {
+        code.clear();
+        inputs.clear();
+        registers = 0;
+        result = -1;
+        return false;
+    }
+    return true;
+}
+
+// Vectors go by reference: a 32-byte vector passed by value changes the ABI
+// when AVX is not enabled
+static inline void load(v8i& v, const int32_t* p) {
+    memcpy(&v, p, sizeof(v));
+}
+
+static inline void store(int32_t* p, const v8i& v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+vector<uint8_t> BatchEvaluator::evaluate(const InputBatch& batch) const {
+    if (!isCompiled()) {
+        throw runtime_error("BatchEvaluator: nothing compiled");
+    }
+    vector<const int32_t*> columns(code.size(), nullptr);
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].op != Op::INPUT) continue;
+        auto it = batch.columns.find((unsigned int)code[i].value);
+        if (it == batch.columns.end() || it->second.size() < batch.rows) {
+            throw runtime_error("BatchEvaluator: missing input column X" + to_string(code[i].value));
+        }
+        columns[i] = it->second.data();
+    }
+
+    vector<uint8_t> mask(batch.rows, 0);
+    // One TILE-sized slot per register; the rows of a tile stay in cache
+    // while the whole kernel runs over them.
+    vector<int32_t> regs((size_t)registers * TILE);
+    vector<uint8_t> poisoned(TILE);
+    const v8i zero = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    for (size_t base = 0; base < batch.rows; base += TILE) {
+        size_t rows = min(TILE, batch.rows - base);
+        size_t padded = (rows + LANES - 1) / LANES * LANES;
+        fill(poisoned.begin(), poisoned.end(), 0);
+
+        for (size_t i = 0; i < code.size(); i++) {
+            const Instr& in = code[i];
+            int32_t* d = &regs[(size_t)in.dst * TILE];
+            const int32_t* a = (in.a >= 0) ? &regs[(size_t)in.a * TILE] : nullptr;
+            const int32_t* b = (in.b >= 0) ? &regs[(size_t)in.b * TILE] : nullptr;
+
+            switch (in.op) {
+                case Op::CONST:
+                    fill(d, d + padded, in.value);
+                    continue;
+                case Op::INPUT:
+                    memcpy(d, columns[i] + base, rows * sizeof(int32_t));
+                    fill(d + rows, d + padded, 0);
+                    continue;
+                case Op::DIV:
+                    // No vector integer division; also tracks division by zero
+                    // and INT32_MIN / -1, which traps like it
+                    for (size_t r = 0; r < padded; r++) {
+                        if (!divisionDefined(a[r], b[r])) {
+                            poisoned[r] = 1;
+                            d[r] = 0;
+                        } else {
+                            d[r] = a[r] / b[r];
+                        }
+                    }
+                    continue;
+                default:
+                    break;
+            }
+
+            for (size_t r = 0; r < padded; r += LANES) {
+                v8i x, y = zero;
+                load(x, a + r);
+                if (b) {
+                    load(y, b + r);
+                }
+                v8i z;
+                switch (in.op) {
+                    // Unsigned wrap-around, lane by lane what wrapAdd etc. do
+                    // (intarith.hh)
+                    case Op::ADD: z = (v8i)((v8u)x + (v8u)y); break;
+                    case Op::SUB: z = (v8i)((v8u)x - (v8u)y); break;
+                    case Op::MUL: z = (v8i)((v8u)x * (v8u)y); break;
+                    // Comparisons yield -1/0 per lane; negate to 1/0
+                    case Op::EQ: z = -(x == y); break;
+                    case Op::NEQ: z = -(x != y); break;
+                    case Op::LT: z = -(x < y); break;
+                    case Op::LE: z = -(x <= y); break;
+                    case Op::GT: z = -(x > y); break;
+                    case Op::GE: z = -(x >= y); break;
+                    case Op::AND: z = -((x != zero) & (y != zero)); break;
+                    case Op::OR: z = -((x != zero) | (y != zero)); break;
+                    case Op::NOT: z = -(x == zero); break;
+                    case Op::IMPLIES: z = -((x == zero) | (y != zero)); break;
+                    default: z = zero; break;
+                }
+                store(d + r, z);
+            }
+        }
+
+        const int32_t* res = &regs[(size_t)result * TILE];
+        for (size_t r = 0; r < rows; r++) {
+            mask[base + r] = (res[r] != 0 && !poisoned[r]) ? 1 : 0;
+        }
+    }
+    return mask;
+}
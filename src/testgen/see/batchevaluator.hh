@@ -0,0 +1,77 @@
+#ifndef BATCHEVALUATOR_HH
+#define BATCHEVALUATOR_HH
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "../language/ast.hh"
+
+using namespace std;
+
+// A batch of candidate input vectors, stored column-wise: columns[n][row] is
+// the value of SymVar n in candidate row. All columns have `rows` entries.
+struct InputBatch {
+    size_t rows = 0;
+    map<unsigned int, vector<int32_t>> columns;
+};
+
+// BatchEvaluator compiles an integer path constraint into a flat,
+// register-based kernel and evaluates it over a whole InputBatch at once.
+//
+// Supported: Num, SymVar, Add/Sub/Mul/Div, Eq/Neq/Lt/Le/Gt/Ge (and their
+// symbolic spellings), And/Or/Not/Implies. Anything else (sets, maps,
+// strings, API calls, named variables) makes compile() return false, and
+// the caller uses the ConcreteEvaluator instead.
+//
+// Rows are processed in tiles; every instruction runs over a tile of one
+// register with 8-lane vector operations (GCC/Clang vector extensions, which
+// lower to SSE/AVX/NEON or scalar code depending on the target). Values and
+// semantics match the ConcreteEvaluator: 32-bit ints, booleans as 0/1.
+// Both sides of And/Or/Implies are evaluated; a division by zero anywhere in
+// the constraint marks the row unsatisfied.
+class BatchEvaluator {
+    public:
+        enum class Op {
+            CONST, INPUT,
+            ADD, SUB, MUL, DIV,
+            EQ, NEQ, LT, LE, GT, GE,
+            AND, OR, NOT, IMPLIES
+        };
+
+        struct Instr {
+            Op op;
+            int dst;
+            int a;
+            int b;
+            int32_t value;   // CONST: the constant, INPUT: the SymVar number
+        };
+
+        static constexpr size_t TILE = 256;
+
+    private:
+        vector<Instr> code;
+        int registers;
+        int result;
+        vector<unsigned int> inputs;
+
+        int compileExpr(const Expr&);
+        int emit(Op op, int a, int b, int32_t value);
+
+    public:
+        BatchEvaluator() : registers(0), result(-1) {}
+
+        // Compile a constraint; false if it is outside the supported subset.
+        bool compile(const Expr&);
+        bool isCompiled() const { return result >= 0; }
+
+        // SymVar numbers the kernel reads.
+        const vector<unsigned int>& getInputs() const { return inputs; }
+        const vector<Instr>& getCode() const { return code; }
+
+        // Satisfaction mask: mask[row] is 1 iff the constraint holds for the
+        // candidate in that row. Every input of the kernel must be a column.
+        vector<uint8_t> evaluate(const InputBatch&) const;
+};
+#endif
@@ -0,0 +1,453 @@
+#include "concreteevaluator.hh"
+#include "functionfactory.hh"
+#include "intarith.hh"
+#include "oraclelibrary.hh"
+#include "../language/clonevisitor.hh"
+#include "../language/symvar.hh"
+#include <set>
+#include <stdexcept>
+
+bool ConcreteEvaluator::isBuiltin(const string& fname) {
+    static const set<string> builtInFunctions = {
+        // Arithmetic
+        "Add", "Sub", "Mul", "Div",
+        // Comparison
+        "Eq", "Lt", "Gt", "Le", "Ge", "Neq",
+        "=", "==", "!=", "<>", "<", ">", "<=", ">=",
+        // Logical
+        "And", "Or", "Not", "Implies",
+        "and", "or", "not", "&&", "||", "!",
+        // Input
+        "input", "Any", "any",
+        // Set operations
+        "in", "not_in", "member", "not_member", "contains", "not_contains",
+        "union", "intersection", "intersect", "difference", "diff", "minus",
+        "subset", "is_subset", "add_to_set", "remove_from_set", "is_empty_set",
+        // Map operations
+        "get", "put", "lookup", "select", "store", "update",
+        "contains_key", "has_key",
+        // List/Sequence operations
+        "concat", "append_list", "length", "at", "nth",
+        "prefix", "suffix", "contains_seq",
+        // Prime notation (for postconditions)
+        "'"
+    };
+    return builtInFunctions.find(fname) != builtInFunctions.end();
+}
+
+bool ConcreteEvaluator::isTrue(const Expr& e) {
+    if (e.exprType == ExprType::NUM) {
+        return dynamic_cast<const Num&>(e).value != 0;
+    }
+    throw runtime_error("Predicate did not evaluate to a boolean value");
+}
+
+string ConcreteEvaluator::keyName(const Expr& e) {
+    if (e.exprType == ExprType::VAR) {
+        return dynamic_cast<const Var&>(e).name;
+    }
+    if (e.exprType == ExprType::NUM) {
+        return to_string(dynamic_cast<const Num&>(e).value);
+    }
+    if (e.exprType == ExprType::STRING) {
+        return dynamic_cast<const String&>(e).value;
+    }
+    throw runtime_error("Unsupported map key value");
+}
+
+bool ConcreteEvaluator::equal(const Expr& a, const Expr& b) {
+    // Map keys are Vars while the probing value is usually a Num or String,
+    // so compare those through their key names.
+    if (a.exprType == ExprType::VAR || b.exprType == ExprType::VAR) {
+        return keyName(a) == keyName(b);
+    }
+    if (a.exprType != b.exprType) {
+        return false;
+    }
+    switch (a.exprType) {
+        case ExprType::NUM:
+            return dynamic_cast<const Num&>(a).value == dynamic_cast<const Num&>(b).value;
+        case ExprType::STRING:
+            return dynamic_cast<const String&>(a).value == dynamic_cast<const String&>(b).value;
+        case ExprType::SET: {
+            const Set& sa = dynamic_cast<const Set&>(a);
+            const Set& sb = dynamic_cast<const Set&>(b);
+            // Mutual inclusion, so duplicates do not matter
+            for (const auto& x : sa.elements) {
+                bool found = false;
+                for (const auto& y : sb.elements) {
+                    if (equal(*x, *y)) { found = true; break; }
+                }
+                if (!found) return false;
+            }
+            for (const auto& y : sb.elements) {
+                bool found = false;
+                for (const auto& x : sa.elements) {
+                    if (equal(*x, *y)) { found = true; break; }
+                }
+                if (!found) return false;
+            }
+            return true;
+        }
+        case ExprType::MAP: {
+            const Map& ma = dynamic_cast<const Map&>(a);
+            const Map& mb = dynamic_cast<const Map&>(b);
+            if (ma.value.size() != mb.value.size()) {
+                return false;
+            }
+            for (const auto& kv : ma.value) {
+                bool found = false;
+                for (const auto& other : mb.value) {
+                    if (kv.first->name == other.first->name) {
+                        found = equal(*kv.second, *other.second);
+                        break;
+                    }
+                }
+                if (!found) return false;
+            }
+            return true;
+        }
+        case ExprType::TUPLE: {
+            const Tuple& ta = dynamic_cast<const Tuple&>(a);
+            const Tuple& tb = dynamic_cast<const Tuple&>(b);
+            if (ta.exprs.size() != tb.exprs.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < ta.exprs.size(); i++) {
+                if (!equal(*ta.exprs[i], *tb.exprs[i])) return false;
+            }
+            return true;
+        }
+        case ExprType::FUNCCALL: {
+            const FuncCall& fa = dynamic_cast<const FuncCall&>(a);
+            const FuncCall& fb = dynamic_cast<const FuncCall&>(b);
+            if (fa.name != fb.name || fa.args.size() != fb.args.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < fa.args.size(); i++) {
+                if (!equal(*fa.args[i], *fb.args[i])) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+int ConcreteEvaluator::evaluateInt(const Expr& e, ConcValEnv& env) {
+    unique_ptr<Expr> v = evaluate(e, env);
+    if (v->exprType != ExprType::NUM) {
+        throw runtime_error("Expected an integer value");
+    }
+    return dynamic_cast<Num&>(*v).value;
+}
+
+bool ConcreteEvaluator::truth(const Expr& e, ConcValEnv& env) {
+    unique_ptr<Expr> v = evaluate(e, env);
+    return isTrue(*v);
+}
+
+bool ConcreteEvaluator::evaluateBool(const Expr& e, ConcValEnv& env) {
+    if (oracles != nullptr) {
+        int native = oracles->evaluate(e, env);
+        if (native >= 0) {
+            return native != 0;
+        }
+    }
+    return truth(e, env);
+}
+
+unique_ptr<Expr> ConcreteEvaluator::evaluate(const Expr& expr, ConcValEnv& env) {
+    CloneVisitor cloner;
+
+    switch (expr.exprType) {
+        case ExprType::NUM:
+            return make_unique<Num>(dynamic_cast<const Num&>(expr).value);
+        case ExprType::STRING:
+            return make_unique<String>(dynamic_cast<const String&>(expr).value);
+        case ExprType::VAR: {
+            const Var& v = dynamic_cast<const Var&>(expr);
+            Expr* value = env.getValue(v.name);
+            if (value == nullptr) {
+                throw runtime_error("Unbound variable in concrete evaluation: " + v.name);
+            }
+            return cloner.cloneExpr(value);
+        }
+        case ExprType::SET: {
+            const Set& set = dynamic_cast<const Set&>(expr);
+            vector<unique_ptr<Expr>> elements;
+            for (const auto& elem : set.elements) {
+                elements.push_back(evaluate(*elem, env));
+            }
+            return make_unique<Set>(std::move(elements));
+        }
+        case ExprType::MAP: {
+            const Map& map = dynamic_cast<const Map&>(expr);
+            vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+            for (const auto& kv : map.value) {
+                entries.push_back(make_pair(make_unique<Var>(kv.first->name),
+                                            evaluate(*kv.second, env)));
+            }
+            return make_unique<Map>(std::move(entries));
+        }
+        case ExprType::TUPLE: {
+            const Tuple& tuple = dynamic_cast<const Tuple&>(expr);
+            vector<unique_ptr<Expr>> exprs;
+            for (const auto& e : tuple.exprs) {
+                exprs.push_back(evaluate(*e, env));
+            }
+            return make_unique<Tuple>(std::move(exprs));
+        }
+        case ExprType::FUNCCALL:
+            return evaluateFuncCall(dynamic_cast<const FuncCall&>(expr), env);
+        case ExprType::SYMVAR: {
+            unsigned int num = dynamic_cast<const SymVar&>(expr).getNum();
+            if (symVarValues != nullptr) {
+                auto it = symVarValues->find(num);
+                if (it != symVarValues->end()) {
+                    return make_unique<Num>(it->second);
+                }
+            }
+            throw runtime_error("Symbolic value in concrete evaluation");
+        }
+        case ExprType::INPUT:
+            throw runtime_error("input() in concrete evaluation");
+        default:
+            throw runtime_error("Unknown Expr type in concrete evaluation");
+    }
+}
+
+unique_ptr<Expr> ConcreteEvaluator::evaluateAPICall(const FuncCall& fc, ConcValEnv& env) {
+    if (functionFactory == nullptr) {
+        throw runtime_error("FunctionFactory not set in ConcreteEvaluator");
+    }
+    vector<unique_ptr<Expr>> ownedArgs;
+    vector<Expr*> args;
+    for (const auto& arg : fc.args) {
+        ownedArgs.push_back(evaluate(*arg, env));
+        args.push_back(ownedArgs.back().get());
+    }
+    try {
+        unique_ptr<Function> function = functionFactory->getFunction(fc.name, args);
+        return function->execute();
+    } catch (const char* error) {
+        throw runtime_error(string("Function execution failed: ") + error);
+    }
+}
+
+unique_ptr<Expr> ConcreteEvaluator::evaluateFuncCall(const FuncCall& fc, ConcValEnv& env) {
+    const string& f = fc.name;
+    size_t n = fc.args.size();
+
+    if (!isBuiltin(f)) {
+        return evaluateAPICall(fc, env);
+    }
+
+    // ========== Arithmetic Operations ==========
+    if (n == 2 && (f == "Add" || f == "Sub" || f == "Mul" || f == "Div")) {
+        int l = evaluateInt(*fc.args[0], env);
+        int r = evaluateInt(*fc.args[1], env);
+        if (f == "Add") return make_unique<Num>(wrapAdd(l, r));
+        if (f == "Sub") return make_unique<Num>(wrapSub(l, r));
+        if (f == "Mul") return make_unique<Num>(wrapMul(l, r));
+        if (r == 0) {
+            throw runtime_error("Division by zero in concrete evaluation");
+        }
+        if (!divisionDefined(l, r)) {
+            throw runtime_error("Division overflow in concrete evaluation");
+        }
+        return make_unique<Num>(l / r);
+    }
+
+    // ========== Comparison Operations ==========
+    if (n == 2 && (f == "Eq" || f == "=" || f == "==")) {
+        unique_ptr<Expr> l = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> r = evaluate(*fc.args[1], env);
+        return make_unique<Num>(equal(*l, *r) ? 1 : 0);
+    }
+    if (n == 2 && (f == "Neq" || f == "!=" || f == "<>")) {
+        unique_ptr<Expr> l = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> r = evaluate(*fc.args[1], env);
+        return make_unique<Num>(equal(*l, *r) ? 0 : 1);
+    }
+    if (n == 2 && (f == "Lt" || f == "<" || f == "Gt" || f == ">" ||
+                   f == "Le" || f == "<=" || f == "Ge" || f == ">=")) {
+        int l = evaluateInt(*fc.args[0], env);
+        int r = evaluateInt(*fc.args[1], env);
+        bool b;
+        if (f == "Lt" || f == "<") b = l < r;
+        else if (f == "Gt" || f == ">") b = l > r;
+        else if (f == "Le" || f == "<=") b = l <= r;
+        else b = l >= r;
+        return make_unique<Num>(b ? 1 : 0);
+    }
+
+    // ========== Logical Operations ==========
+    if (n == 2 && (f == "And" || f == "and" || f == "&&")) {
+        if (!truth(*fc.args[0], env)) return make_unique<Num>(0);
+        return make_unique<Num>(truth(*fc.args[1], env) ? 1 : 0);
+    }
+    if (n == 2 && (f == "Or" || f == "or" || f == "||")) {
+        if (truth(*fc.args[0], env)) return make_unique<Num>(1);
+        return make_unique<Num>(truth(*fc.args[1], env) ? 1 : 0);
+    }
+    if (n == 1 && (f == "Not" || f == "not" || f == "!")) {
+        return make_unique<Num>(truth(*fc.args[0], env) ? 0 : 1);
+    }
+    if (n == 2 && f == "Implies") {
+        if (!truth(*fc.args[0], env)) return make_unique<Num>(1);
+        return make_unique<Num>(truth(*fc.args[1], env) ? 1 : 0);
+    }
+
+    // ========== Set/Map Membership Operations ==========
+    if (n == 2 && (f == "in" || f == "member" || f == "contains" ||
+                   f == "not_in" || f == "not_member" || f == "not_contains")) {
+        unique_ptr<Expr> elem = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> coll = evaluate(*fc.args[1], env);
+        bool found = false;
+        if (coll->exprType == ExprType::SET) {
+            for (const auto& x : dynamic_cast<Set&>(*coll).elements) {
+                if (equal(*x, *elem)) { found = true; break; }
+            }
+        } else if (coll->exprType == ExprType::MAP) {
+            string key = keyName(*elem);
+            for (const auto& kv : dynamic_cast<Map&>(*coll).value) {
+                if (kv.first->name == key) { found = true; break; }
+            }
+        } else {
+            throw runtime_error("Membership test on a non-collection value");
+        }
+        bool negated = (f == "not_in" || f == "not_member" || f == "not_contains");
+        return make_unique<Num>((found != negated) ? 1 : 0);
+    }
+
+    // ========== Set Operations ==========
+    if (n == 2 && (f == "union" || f == "intersection" || f == "intersect" ||
+                   f == "difference" || f == "diff" || f == "minus" ||
+                   f == "subset" || f == "is_subset")) {
+        unique_ptr<Expr> a = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> b = evaluate(*fc.args[1], env);
+        if (a->exprType != ExprType::SET || b->exprType != ExprType::SET) {
+            throw runtime_error("Set operation " + f + " on a non-set value");
+        }
+        Set& sa = dynamic_cast<Set&>(*a);
+        Set& sb = dynamic_cast<Set&>(*b);
+        auto inB = [&sb](const Expr& x) {
+            for (const auto& y : sb.elements) {
+                if (equal(x, *y)) return true;
+            }
+            return false;
+        };
+        if (f == "subset" || f == "is_subset") {
+            for (const auto& x : sa.elements) {
+                if (!inB(*x)) return make_unique<Num>(0);
+            }
+            return make_unique<Num>(1);
+        }
+        CloneVisitor cloner;
+        vector<unique_ptr<Expr>> result;
+        for (const auto& x : sa.elements) {
+            bool keep = (f == "union") || ((f == "intersection" || f == "intersect") == inB(*x));
+            if (keep) result.push_back(cloner.cloneExpr(x.get()));
+        }
+        if (f == "union") {
+            for (const auto& y : sb.elements) {
+                bool dup = false;
+                for (const auto& x : sa.elements) {
+                    if (equal(*x, *y)) { dup = true; break; }
+                }
+                if (!dup) result.push_back(cloner.cloneExpr(y.get()));
+            }
+        }
+        return make_unique<Set>(std::move(result));
+    }
+    if (n == 2 && (f == "add_to_set" || f == "remove_from_set")) {
+        unique_ptr<Expr> s = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> elem = evaluate(*fc.args[1], env);
+        if (s->exprType != ExprType::SET) {
+            throw runtime_error("Set operation " + f + " on a non-set value");
+        }
+        CloneVisitor cloner;
+        vector<unique_ptr<Expr>> result;
+        bool present = false;
+        for (const auto& x : dynamic_cast<Set&>(*s).elements) {
+            if (equal(*x, *elem)) {
+                present = true;
+                if (f == "remove_from_set") continue;
+            }
+            result.push_back(cloner.cloneExpr(x.get()));
+        }
+        if (f == "add_to_set" && !present) {
+            result.push_back(std::move(elem));
+        }
+        return make_unique<Set>(std::move(result));
+    }
+    if (n == 1 && f == "is_empty_set") {
+        unique_ptr<Expr> s = evaluate(*fc.args[0], env);
+        if (s->exprType != ExprType::SET) {
+            throw runtime_error("is_empty_set on a non-set value");
+        }
+        return make_unique<Num>(dynamic_cast<Set&>(*s).elements.empty() ? 1 : 0);
+    }
+
+    // ========== Map Operations ==========
+    if (n == 2 && (f == "get" || f == "lookup" || f == "select")) {
+        unique_ptr<Expr> m = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> k = evaluate(*fc.args[1], env);
+        if (m->exprType != ExprType::MAP) {
+            throw runtime_error("Map lookup on a non-map value");
+        }
+        string key = keyName(*k);
+        CloneVisitor cloner;
+        for (const auto& kv : dynamic_cast<Map&>(*m).value) {
+            if (kv.first->name == key) {
+                return cloner.cloneExpr(kv.second.get());
+            }
+        }
+        throw runtime_error("Key " + key + " not found in map");
+    }
+    if (n == 3 && (f == "put" || f == "store" || f == "update")) {
+        unique_ptr<Expr> m = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> k = evaluate(*fc.args[1], env);
+        unique_ptr<Expr> v = evaluate(*fc.args[2], env);
+        if (m->exprType != ExprType::MAP) {
+            throw runtime_error("Map update on a non-map value");
+        }
+        string key = keyName(*k);
+        CloneVisitor cloner;
+        vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+        for (const auto& kv : dynamic_cast<Map&>(*m).value) {
+            if (kv.first->name == key) continue;
+            entries.push_back(make_pair(make_unique<Var>(kv.first->name),
+                                        cloner.cloneExpr(kv.second.get())));
+        }
+        entries.push_back(make_pair(make_unique<Var>(key), std::move(v)));
+        return make_unique<Map>(std::move(entries));
+    }
+    if (n == 2 && (f == "contains_key" || f == "has_key")) {
+        unique_ptr<Expr> m = evaluate(*fc.args[0], env);
+        unique_ptr<Expr> k = evaluate(*fc.args[1], env);
+        if (m->exprType != ExprType::MAP) {
+            throw runtime_error("Map key test on a non-map value");
+        }
+        string key = keyName(*k);
+        for (const auto& kv : dynamic_cast<Map&>(*m).value) {
+            if (kv.first->name == key) return make_unique<Num>(1);
+        }
+        return make_unique<Num>(0);
+    }
+
+    // ========== Special Functions ==========
+    if (n == 1 && (f == "Any" || f == "any")) {
+        return make_unique<Num>(1);
+    }
+    if (n == 1 && f == "'") {
+        return evaluate(*fc.args[0], env);
+    }
+    if (f == "input") {
+        throw runtime_error("input() in concrete evaluation: test case is still abstract");
+    }
+
+    throw runtime_error("Unsupported function in concrete evaluation: " + f +
+                        " with " + to_string(n) + " args");
+}
@@ -0,0 +1,79 @@
+#ifndef CONCRETEEVALUATOR_HH
+#define CONCRETEEVALUATOR_HH
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+
+// Forward declaration
+class FunctionFactory;
+class OracleLibrary;
+
+using namespace std;
+
+// ConcreteEvaluator evaluates expressions whose variables are all bound to
+// concrete values. It is the concrete counterpart of SEE::evaluateExpr and is
+// used wherever a CTC (or a candidate input vector) has to be checked without
+// going through the solver.
+//
+// Values are represented with the ordinary AST nodes:
+//   integers  -> Num
+//   booleans  -> Num (0 = false, anything else = true)
+//   strings   -> String
+//   sets      -> Set of values
+//   maps      -> Map whose keys are Vars named after the key value
+//   tuples    -> Tuple of values
+//
+// Calls to functions that are not built-ins are treated as API calls and are
+// dispatched to the FunctionFactory, if one is set.
+class ConcreteEvaluator {
+    private:
+        FunctionFactory* functionFactory;
+        const map<unsigned int, int>* symVarValues;
+        const OracleLibrary* oracles;
+
+        unique_ptr<Expr> evaluateFuncCall(const FuncCall&, ConcValEnv&);
+        unique_ptr<Expr> evaluateAPICall(const FuncCall&, ConcValEnv&);
+        int evaluateInt(const Expr&, ConcValEnv&);
+        bool truth(const Expr&, ConcValEnv&);
+
+    public:
+        ConcreteEvaluator(FunctionFactory* functionFactory = nullptr)
+            : functionFactory(functionFactory), symVarValues(nullptr), oracles(nullptr) {}
+
+        void setFunctionFactory(FunctionFactory* ff) { functionFactory = ff; }
+
+        // Integer values for symbolic variables (by SymVar number). Lets a
+        // path constraint be checked under a candidate input vector.
+        void setSymVarValues(const map<unsigned int, int>* values) { symVarValues = values; }
+
+        // Native spec predicates. evaluateBool() runs a predicate found in
+        // the library as native code and interprets everything else.
+        void setOracles(const OracleLibrary* library) { oracles = library; }
+
+        // Evaluate an expression to a fresh concrete value.
+        unique_ptr<Expr> evaluate(const Expr&, ConcValEnv&);
+
+        // Evaluate a predicate (assume/assert body).
+        bool evaluateBool(const Expr&, ConcValEnv&);
+
+        // Truth value of an evaluated expression.
+        static bool isTrue(const Expr&);
+
+        // Structural equality of two concrete values. Sets and maps are
+        // compared irrespective of element order.
+        static bool equal(const Expr&, const Expr&);
+
+        // Name used for a value when it is stored as a map key.
+        static string keyName(const Expr&);
+
+        // Built-in functions: the one list of calls that are not API calls,
+        // used by SEE::isAPI and the replay observers as well.
+        static bool isBuiltin(const string& fname);
+};
+
+#endif
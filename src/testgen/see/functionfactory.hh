@@ -12,13 +12,20 @@ class Function {
     protected:
         const vector<Expr*> arguments;
     public:
+        virtual ~Function() = default;
         virtual unique_ptr<Expr> execute() = 0;
 };
 
 class FunctionFactory {
     public:
+        virtual ~FunctionFactory() = default;
         virtual unique_ptr<Function> getFunction(string fname, vector<Expr*> args) = 0;
 
+        // Snapshot of the SUT state held by this factory. Factories that can
+        // copy their state return a fresh, independent instance; the default
+        // returns nullptr, meaning "not snapshotable".
+        virtual unique_ptr<FunctionFactory> snapshot() { return nullptr; }
+
     protected:
 };
 
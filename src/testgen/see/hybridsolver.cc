@@ -0,0 +1,216 @@
+#include "hybridsolver.hh"
+#include "concreteevaluator.hh"
+#include "intarith.hh"
+#include "../language/exprwalk.hh"
+#include "../language/clonevisitor.hh"
+#include "../language/symvar.hh"
+#include <iostream>
+
+HybridSolver::HybridSolver(const Solver& fallback, unsigned int samples, int range,
+                           double minSuccessRate, unsigned int seed)
+    : fallback(fallback), samples(samples), range(range), minSuccessRate(minSuccessRate),
+      rng(seed), randomHits(0), fallbackCalls(0), skippedSampling(0) {}
+
+HybridSolver::HybridSolver(const HybridSolver& other, unsigned int seed)
+    : fallback(other.fallback), samples(other.samples), range(other.range),
+      minSuccessRate(other.minSuccessRate), rng(seed), stats(other.stats),
+      randomHits(other.randomHits), fallbackCalls(other.fallbackCalls),
+      skippedSampling(other.skippedSampling) {}
+
+void HybridSolver::absorb(const vector<unique_ptr<HybridSolver>>& copies) const {
+    const map<string, SampleStats> base = stats;
+    const size_t hits = randomHits, calls = fallbackCalls, skipped = skippedSampling;
+    for (const auto& copy : copies) {
+        for (const auto& entry : copy->stats) {
+            auto old = base.find(entry.first);
+            SampleStats& s = stats[entry.first];
+            s.trials += entry.second.trials - (old == base.end() ? 0 : old->second.trials);
+            s.successes += entry.second.successes - (old == base.end() ? 0 : old->second.successes);
+        }
+        randomHits += copy->randomHits - hits;
+        fallbackCalls += copy->fallbackCalls - calls;
+        skippedSampling += copy->skippedSampling - skipped;
+    }
+}
+
+void HybridSolver::collectConstants(const Expr& e, set<int>& out) {
+    walkExpr(e, [&out](const Expr& node) {
+        if (node.exprType == ExprType::NUM) {
+            int v = static_cast<const Num&>(node).value;
+            out.insert(wrapSub(v, 1));
+            out.insert(v);
+            out.insert(wrapAdd(v, 1));
+        }
+        return WalkAction::DESCEND;
+    });
+}
+
+string HybridSolver::shapeKey(const Expr& e) {
+    string key;
+    ::shapeKey(e, key);
+    return key;
+}
+
+double HybridSolver::expectedSuccessRate(const vector<string>& keys) const {
+    // Laplace estimate per constraint; constraints treated as independent
+    double rate = 1.0;
+    for (const auto& key : keys) {
+        auto it = stats.find(key);
+        size_t trials = (it == stats.end()) ? 0 : it->second.trials;
+        size_t successes = (it == stats.end()) ? 0 : it->second.successes;
+        rate *= double(successes + 1) / double(trials + 2);
+    }
+    return rate;
+}
+
+Result HybridSolver::callFallback(const vector<Expr*>& constraints, unsigned int timeoutMs) const {
+    fallbackCalls++;
+    CloneVisitor cloner;
+    unique_ptr<Expr> formula = make_unique<Num>(1);
+    for (Expr* c : constraints) {
+        vector<unique_ptr<Expr>> args;
+        args.push_back(cloner.cloneExpr(c));
+        args.push_back(std::move(formula));
+        formula = make_unique<FuncCall>("And", std::move(args));
+    }
+    return timeoutMs > 0 ? fallback.solveWithin(std::move(formula), timeoutMs)
+                         : fallback.solve(std::move(formula));
+}
+
+Result HybridSolver::solve(unique_ptr<Expr> formula) const {
+    return solve(vector<Expr*>{ formula.get() });
+}
+
+Result HybridSolver::solve(const vector<Expr*>& constraints) const {
+    return solve(constraints, 0);
+}
+
+Result HybridSolver::solve(const vector<Expr*>& constraints, unsigned int timeoutMs) const {
+    set<unsigned int> symVars;
+    set<int> constantSet;
+    vector<string> keys;
+    for (Expr* c : constraints) {
+        collectSymVars(*c, symVars);
+        collectConstants(*c, constantSet);
+        keys.push_back(shapeKey(*c));
+    }
+    vector<int> constants(constantSet.begin(), constantSet.end());
+
+    double rate = expectedSuccessRate(keys);
+    if (rate < minSuccessRate) {
+        cout << "[HybridSolver] Expected success rate " << rate << ", calling solver" << endl;
+        skippedSampling++;
+        return callFallback(constraints, timeoutMs);
+    }
+
+    // Without symbolic inputs there is nothing to vary
+    unsigned int attempts = symVars.empty() ? 1 : samples;
+
+    // Integer-only constraints go through the batch kernel
+    vector<BatchEvaluator> kernels(constraints.size());
+    bool batchable = true;
+    for (size_t i = 0; i < constraints.size() && batchable; i++) {
+        batchable = kernels[i].compile(*constraints[i]);
+    }
+
+    map<unsigned int, int> values;
+    bool found = batchable
+        ? sampleBatch(kernels, keys, symVars, constants, attempts, values)
+        : sampleScalar(constraints, keys, symVars, constants, attempts, values);
+
+    if (found) {
+        randomHits++;
+        map<string, unique_ptr<ResultValue>> model;
+        for (const auto& v : values) {
+            model["X" + to_string(v.first)] = make_unique<IntResultValue>(v.second);
+        }
+        return Result(true, std::move(model));
+    }
+
+    cout << "[HybridSolver] No random input in " << attempts << " samples, calling solver" << endl;
+    return callFallback(constraints, timeoutMs);
+}
+
+int HybridSolver::drawValue(const vector<int>& constants) const {
+    uniform_int_distribution<int> coin(0, 1);
+    if (!constants.empty() && coin(rng)) {
+        uniform_int_distribution<size_t> pick(0, constants.size() - 1);
+        return constants[pick(rng)];
+    }
+    uniform_int_distribution<int> uniform(-range, range);
+    return uniform(rng);
+}
+
+bool HybridSolver::sampleScalar(const vector<Expr*>& constraints, const vector<string>& keys,
+                                const set<unsigned int>& symVars, const vector<int>& constants,
+                                unsigned int attempts, map<unsigned int, int>& values) const {
+    ConcreteEvaluator evaluator;
+    ConcValEnv env(nullptr);
+    evaluator.setSymVarValues(&values);
+
+    for (unsigned int k = 0; k < attempts; k++) {
+        for (unsigned int num : symVars) {
+            values[num] = drawValue(constants);
+        }
+
+        // Evaluate every constraint so that each block's statistics see
+        // the same number of trials
+        bool all = true;
+        for (size_t i = 0; i < constraints.size(); i++) {
+            bool ok = false;
+            try {
+                ok = evaluator.evaluateBool(*constraints[i], env);
+            } catch (const exception&) {
+                // Not evaluable concretely (e.g. non-integer inputs)
+            }
+            SampleStats& s = stats[keys[i]];
+            s.trials++;
+            if (ok) s.successes++;
+            all = all && ok;
+        }
+
+        if (all) {
+            cout << "[HybridSolver] Random input satisfied the path constraint after "
+                 << (k + 1) << " samples" << endl;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HybridSolver::sampleBatch(const vector<BatchEvaluator>& kernels, const vector<string>& keys,
+                               const set<unsigned int>& symVars, const vector<int>& constants,
+                               unsigned int attempts, map<unsigned int, int>& values) const {
+    InputBatch batch;
+    batch.rows = attempts;
+    for (unsigned int num : symVars) {
+        vector<int32_t>& column = batch.columns[num];
+        column.resize(attempts);
+        for (auto& v : column) {
+            v = drawValue(constants);
+        }
+    }
+
+    vector<uint8_t> all(attempts, 1);
+    for (size_t i = 0; i < kernels.size(); i++) {
+        vector<uint8_t> mask = kernels[i].evaluate(batch);
+        SampleStats& s = stats[keys[i]];
+        s.trials += attempts;
+        for (size_t r = 0; r < attempts; r++) {
+            s.successes += mask[r];
+            all[r] &= mask[r];
+        }
+    }
+
+    for (size_t r = 0; r < attempts; r++) {
+        if (all[r]) {
+            for (unsigned int num : symVars) {
+                values[num] = batch.columns[num][r];
+            }
+            cout << "[HybridSolver] Batch of " << attempts << " candidates: row " << r
+                 << " satisfies the path constraint" << endl;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+#ifndef HYBRIDSOLVER_HH
+#define HYBRIDSOLVER_HH
+
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "batchevaluator.hh"
+#include "solver.hh"
+#include "../language/ast.hh"
+
+using namespace std;
+
+// Per-precondition record of how often random input vectors satisfied it.
+struct SampleStats {
+    size_t trials = 0;
+    size_t successes = 0;
+};
+
+// HybridSolver tries cheap random input vectors before paying for a solve.
+//
+// For a path constraint (one entry per assume the SEE went through) it draws
+// up to K random integer vectors for the symbolic inputs and checks them with
+// the ConcreteEvaluator. The first vector satisfying every constraint is
+// returned as the model; only if all K fail is the fallback solver called.
+//
+// Each constraint is keyed by its shape (the expression with SymVar numbers
+// erased), which identifies the API block precondition it came from. The
+// observed per-key success rates give the probability that a random vector
+// satisfies the whole path constraint; when that drops below minSuccessRate
+// sampling is skipped and the fallback solver is called directly.
+//
+// Candidate values are drawn uniformly from [-range, range] or, half of the
+// time, from the integer constants of the constraints and their neighbours.
+// Integer-only path constraints are compiled with the BatchEvaluator and all
+// K candidates are checked in one pass; others are checked one by one.
+class HybridSolver : public Solver {
+    private:
+        const Solver& fallback;
+        unsigned int samples;
+        int range;
+        double minSuccessRate;
+
+        // solve() is const in the Solver interface; the statistics and the
+        // random engine are bookkeeping, not part of the solver's identity.
+        mutable mt19937 rng;
+        mutable map<string, SampleStats> stats;
+        mutable size_t randomHits;
+        mutable size_t fallbackCalls;
+        mutable size_t skippedSampling;
+
+        // Each integer constant and its neighbours, as sampling hints
+        static void collectConstants(const Expr&, set<int>&);
+        double expectedSuccessRate(const vector<string>& keys) const;
+        Result callFallback(const vector<Expr*>& constraints, unsigned int timeoutMs) const;
+
+        int drawValue(const vector<int>& constants) const;
+        // Draw and check candidates one by one with the ConcreteEvaluator.
+        bool sampleScalar(const vector<Expr*>& constraints, const vector<string>& keys,
+                          const set<unsigned int>& symVars, const vector<int>& constants,
+                          unsigned int attempts, map<unsigned int, int>& values) const;
+        // Draw all candidates as one InputBatch and check it with compiled
+        // kernels; used when every constraint is integer-only.
+        bool sampleBatch(const vector<BatchEvaluator>& kernels, const vector<string>& keys,
+                         const set<unsigned int>& symVars, const vector<int>& constants,
+                         unsigned int attempts, map<unsigned int, int>& values) const;
+
+    public:
+        HybridSolver(const Solver& fallback, unsigned int samples = 1024, int range = 100,
+                     double minSuccessRate = 0.05, unsigned int seed = 0);
+        // Copy for another thread: the same fallback, parameters and
+        // statistics so far, and its own random engine. The fallback is
+        // shared, so it must be safe to call concurrently (Z3Solver is).
+        HybridSolver(const HybridSolver& other, unsigned int seed);
+
+        // Add what copies of this solver recorded since they were made; the
+        // solver must not have been used meanwhile
+        void absorb(const vector<unique_ptr<HybridSolver>>& copies) const;
+
+        Result solve(unique_ptr<Expr>) const override;
+
+        // Solve a path constraint given as its individual constraints.
+        Result solve(const vector<Expr*>& constraints) const;
+        // The same, giving the fallback solver at most timeoutMs
+        // milliseconds (0 = no limit).
+        Result solve(const vector<Expr*>& constraints, unsigned int timeoutMs) const;
+
+        // Shape of a constraint with SymVar numbers erased (see
+        // exprwalk.hh's shapeKey).
+        static string shapeKey(const Expr&);
+
+        const map<string, SampleStats>& getStats() const { return stats; }
+        size_t getRandomHits() const { return randomHits; }
+        size_t getFallbackCalls() const { return fallbackCalls; }
+        size_t getSkippedSampling() const { return skippedSampling; }
+};
+#endif
@@ -0,0 +1,18 @@
+#ifndef INTARITH_HH
+#define INTARITH_HH
+
+#include <cstdint>
+
+// 32-bit integer arithmetic of spec predicates. ConcreteEvaluator, the
+// batch kernel (BatchEvaluator) and the generated oracles (ttr_add, ...,
+// see OracleLibrary) all use these semantics, so they agree on every input:
+// +, - and * wrap around, and a division by 0 or INT32_MIN / -1 has no value.
+
+inline int32_t wrapAdd(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+inline int32_t wrapSub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+inline int32_t wrapMul(int32_t a, int32_t b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+
+// Whether a / b is defined (and does not trap)
+inline bool divisionDefined(int32_t a, int32_t b) { return b != 0 && !(a == INT32_MIN && b == -1); }
+
+#endif // INTARITH_HH
@@ -0,0 +1,353 @@
+#include "oraclelibrary.hh"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+// Most variables a native predicate may read (size of the input buffer)
+static const size_t MAX_SLOTS = 64;
+
+static const map<string, string>& binaryOps() {
+    // Spelling -> helper or operator in the generated code
+    static const map<string, string> ops = {
+        { "Add", "ttr_add" }, { "Sub", "ttr_sub" }, { "Mul", "ttr_mul" }, { "Div", "ttr_div" },
+        { "Eq", "==" }, { "=", "==" }, { "==", "==" },
+        { "Neq", "!=" }, { "!=", "!=" }, { "<>", "!=" },
+        { "Lt", "<" }, { "<", "<" }, { "Le", "<=" }, { "<=", "<=" },
+        { "Gt", ">" }, { ">", ">" }, { "Ge", ">=" }, { ">=", ">=" },
+        { "And", "&&" }, { "and", "&&" }, { "&&", "&&" },
+        { "Or", "||" }, { "or", "||" }, { "||", "||" },
+        { "Implies", "=>" }
+    };
+    return ops;
+}
+
+// genATC names the state before the k-th call that primes U "U_old_k", k
+// counting such calls in the test string. Predicates are registered from
+// one-block ATCs, so they are matched and bound with the version dropped.
+static string unversioned(const string& name) {
+    size_t pos = name.rfind("_old_");
+    if (pos == string::npos || pos + 5 == name.size()) {
+        return name;
+    }
+    for (size_t i = pos + 5; i < name.size(); i++) {
+        if (!isdigit((unsigned char)name[i])) return name;
+    }
+    return name.substr(0, pos + 4);
+}
+
+static bool isNot(const FuncCall& fc) {
+    return fc.args.size() == 1 && (fc.name == "Not" || fc.name == "not" || fc.name == "!");
+}
+
+// Is e in the native subset? Collects its variables (unversioned) in
+// first-use order.
+static bool nativeSubset(const Expr& e, vector<string>& vars) {
+    if (e.exprType == ExprType::NUM) {
+        return true;
+    }
+    if (e.exprType == ExprType::VAR) {
+        string name = unversioned(dynamic_cast<const Var&>(e).name);
+        for (const auto& v : vars) {
+            if (v == name) return true;
+        }
+        vars.push_back(name);
+        return true;
+    }
+    if (e.exprType != ExprType::FUNCCALL) {
+        return false;
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+    if (!isNot(fc) && (fc.args.size() != 2 || binaryOps().count(fc.name) == 0)) {
+        return false;
+    }
+    for (const auto& arg : fc.args) {
+        if (!nativeSubset(*arg, vars)) return false;
+    }
+    return true;
+}
+
+static bool hasVersions(const Expr& e) {
+    if (e.exprType == ExprType::VAR) {
+        const string& name = dynamic_cast<const Var&>(e).name;
+        return unversioned(name) != name;
+    }
+    if (e.exprType == ExprType::FUNCCALL) {
+        for (const auto& arg : dynamic_cast<const FuncCall&>(e).args) {
+            if (hasVersions(*arg)) return true;
+        }
+    }
+    return false;
+}
+
+// The names the variables of e have in this evaluation, per slot; false if
+// one slot would need two versions (U_old_1 and U_old_2)
+static bool bindVersions(const Expr& e, const vector<string>& slots, vector<const string*>& names) {
+    if (e.exprType == ExprType::VAR) {
+        const string& name = dynamic_cast<const Var&>(e).name;
+        size_t slot = find(slots.begin(), slots.end(), unversioned(name)) - slots.begin();
+        if (names[slot] && *names[slot] != name) {
+            return false;
+        }
+        names[slot] = &name;
+    } else if (e.exprType == ExprType::FUNCCALL) {
+        for (const auto& arg : dynamic_cast<const FuncCall&>(e).args) {
+            if (!bindVersions(*arg, slots, names)) return false;
+        }
+    }
+    return true;
+}
+
+size_t OracleLibrary::fingerprint(const Expr& e) {
+    size_t h = hash<int>()((int)e.exprType);
+    auto mix = [&h](size_t x) { h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    switch (e.exprType) {
+        case ExprType::NUM:
+            mix(hash<int>()(dynamic_cast<const Num&>(e).value));
+            break;
+        case ExprType::VAR:
+            mix(hash<string>()(unversioned(dynamic_cast<const Var&>(e).name)));
+            break;
+        case ExprType::FUNCCALL: {
+            const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+            mix(hash<string>()(fc.name));
+            for (const auto& arg : fc.args) {
+                mix(fingerprint(*arg));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return h;
+}
+
+bool OracleLibrary::sameTree(const Expr& a, const Expr& b) {
+    if (a.exprType != b.exprType) {
+        return false;
+    }
+    switch (a.exprType) {
+        case ExprType::NUM:
+            return dynamic_cast<const Num&>(a).value == dynamic_cast<const Num&>(b).value;
+        case ExprType::VAR:
+            return unversioned(dynamic_cast<const Var&>(a).name) ==
+                   unversioned(dynamic_cast<const Var&>(b).name);
+        case ExprType::FUNCCALL: {
+            const FuncCall& fa = dynamic_cast<const FuncCall&>(a);
+            const FuncCall& fb = dynamic_cast<const FuncCall&>(b);
+            if (fa.name != fb.name || fa.args.size() != fb.args.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < fa.args.size(); i++) {
+                if (!sameTree(*fa.args[i], *fb.args[i])) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static unique_ptr<Expr> cloneTree(const Expr& e) {
+    if (e.exprType == ExprType::NUM) {
+        return make_unique<Num>(dynamic_cast<const Num&>(e).value);
+    }
+    if (e.exprType == ExprType::VAR) {
+        return make_unique<Var>(dynamic_cast<const Var&>(e).name);
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+    vector<unique_ptr<Expr>> args;
+    for (const auto& arg : fc.args) {
+        args.push_back(cloneTree(*arg));
+    }
+    return make_unique<FuncCall>(fc.name, std::move(args));
+}
+
+OracleLibrary::~OracleLibrary() {
+    if (handle) {
+        dlclose(handle);
+    }
+    if (!workDir.empty()) {
+        unlink((workDir + "/oracles.cc").c_str());
+        unlink((workDir + "/liboracles.so").c_str());
+        unlink((workDir + "/build.log").c_str());
+        rmdir(workDir.c_str());
+    }
+}
+
+bool OracleLibrary::add(const Expr& predicate, const map<string, string>& types) {
+    if (!source.empty()) {
+        throw runtime_error("OracleLibrary: add() after compile()");
+    }
+    Oracle oracle;
+    if (!nativeSubset(predicate, oracle.vars) || oracle.vars.size() > MAX_SLOTS) {
+        return false;
+    }
+    for (const auto& v : oracle.vars) {
+        auto it = types.find(v);
+        string type = (it == types.end()) ? "int" : it->second;
+        if (type != "int" && type != "bool") {
+            return false;
+        }
+        oracle.types.push_back(type);
+    }
+    if (find(predicate)) {
+        return false;
+    }
+    oracle.predicate = cloneTree(predicate);
+    oracle.versioned = hasVersions(predicate);
+    oracle.hash = fingerprint(predicate);
+    oracle.fn = nullptr;
+    index.emplace(oracle.hash, oracles.size());
+    oracles.push_back(std::move(oracle));
+    return true;
+}
+
+string OracleLibrary::emitExpr(const Expr& e, const Oracle& oracle) const {
+    if (e.exprType == ExprType::NUM) {
+        return "(int32_t)(" + to_string((long long)dynamic_cast<const Num&>(e).value) + "LL)";
+    }
+    if (e.exprType == ExprType::VAR) {
+        string name = unversioned(dynamic_cast<const Var&>(e).name);
+        for (size_t i = 0; i < oracle.vars.size(); i++) {
+            if (oracle.vars[i] == name) return "v" + to_string(i);
+        }
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+    if (isNot(fc)) {
+        return "(int32_t)(" + emitExpr(*fc.args[0], oracle) + " == 0)";
+    }
+    string a = emitExpr(*fc.args[0], oracle);
+    string b = emitExpr(*fc.args[1], oracle);
+    const string& op = binaryOps().at(fc.name);
+    if (op == "ttr_div") {
+        return "ttr_div(" + a + ", " + b + ", &err)";
+    }
+    if (op.compare(0, 4, "ttr_") == 0) {
+        return op + "(" + a + ", " + b + ")";
+    }
+    if (op == "&&" || op == "||") {
+        return "(int32_t)(" + a + " != 0 " + op + " " + b + " != 0)";
+    }
+    if (op == "=>") {
+        return "(int32_t)(" + a + " == 0 || " + b + " != 0)";
+    }
+    return "(int32_t)(" + a + " " + op + " " + b + ")";
+}
+
+void OracleLibrary::compile(const string& compiler) {
+    if (!source.empty()) {
+        throw runtime_error("OracleLibrary: already compiled");
+    }
+
+    ostringstream out;
+    // The helpers spell out intarith.hh for the generated source
+    out << "// Generated by OracleLibrary: native spec predicates\n"
+        << "#include <cstdint>\n\n"
+        << "static inline int32_t ttr_add(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }\n"
+        << "static inline int32_t ttr_sub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }\n"
+        << "static inline int32_t ttr_mul(int32_t a, int32_t b) { return (int32_t)((uint32_t)a * (uint32_t)b); }\n"
+        << "static inline int32_t ttr_div(int32_t a, int32_t b, int* err) {\n"
+        << "    if (b == 0 || (a == INT32_MIN && b == -1)) { *err = 1; return 0; }\n"
+        << "    return a / b;\n"
+        << "}\n";
+    for (size_t n = 0; n < oracles.size(); n++) {
+        const Oracle& oracle = oracles[n];
+        out << "\nextern \"C\" int ttr_oracle_" << n << "(const int32_t* in) {\n";
+        for (size_t i = 0; i < oracle.vars.size(); i++) {
+            out << "    const int32_t v" << i << " = in[" << i << "];   // "
+                << oracle.vars[i] << " : " << oracle.types[i] << "\n";
+        }
+        out << "    int err = 0;\n"
+            << "    int32_t r = " << emitExpr(*oracle.predicate, oracle) << ";\n"
+            << "    return err ? -1 : (r != 0);\n"
+            << "}\n";
+    }
+    source = out.str();
+
+    if (oracles.empty()) {
+        return;
+    }
+
+    char dirTemplate[] = "/tmp/ttr-oracles-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        throw runtime_error("OracleLibrary: cannot create a build directory");
+    }
+    workDir = dirTemplate;
+    string src = workDir + "/oracles.cc";
+    string lib = workDir + "/liboracles.so";
+    string log = workDir + "/build.log";
+    {
+        ofstream file(src);
+        file << source;
+        if (!file) {
+            throw runtime_error("OracleLibrary: cannot write " + src);
+        }
+    }
+
+    string cxx = compiler;
+    if (cxx.empty()) {
+        const char* env = getenv("CXX");
+        cxx = (env && *env) ? env : "g++";
+    }
+    string command = cxx + " -O2 -shared -fPIC -o " + lib + " " + src + " > " + log + " 2>&1";
+    if (system(command.c_str()) != 0) {
+        ifstream file(log);
+        stringstream diagnostics;
+        diagnostics << file.rdbuf();
+        throw runtime_error("OracleLibrary: build failed: " + command + "\n" + diagnostics.str());
+    }
+
+    handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw runtime_error(string("OracleLibrary: dlopen failed: ") + dlerror());
+    }
+    for (size_t n = 0; n < oracles.size(); n++) {
+        string symbol = "ttr_oracle_" + to_string(n);
+        oracles[n].fn = reinterpret_cast<OracleFn>(dlsym(handle, symbol.c_str()));
+        if (!oracles[n].fn) {
+            throw runtime_error("OracleLibrary: missing symbol " + symbol);
+        }
+    }
+}
+
+const OracleLibrary::Oracle* OracleLibrary::find(const Expr& predicate) const {
+    auto range = index.equal_range(fingerprint(predicate));
+    for (auto it = range.first; it != range.second; ++it) {
+        const Oracle& oracle = oracles[it->second];
+        if (sameTree(*oracle.predicate, predicate)) {
+            return &oracle;
+        }
+    }
+    return nullptr;
+}
+
+int OracleLibrary::evaluate(const Expr& predicate, ConcValEnv& env) const {
+    if (!handle) {
+        return -1;
+    }
+    const Oracle* oracle = find(predicate);
+    if (!oracle) {
+        return -1;
+    }
+    // A U_old slot reads the version this predicate names
+    vector<const string*> names(oracle->vars.size(), nullptr);
+    if (oracle->versioned && !bindVersions(predicate, oracle->vars, names)) {
+        return -1;
+    }
+    int32_t in[MAX_SLOTS];
+    for (size_t i = 0; i < oracle->vars.size(); i++) {
+        Expr* value = env.getValue(names[i] ? *names[i] : oracle->vars[i]);
+        if (value == nullptr || value->exprType != ExprType::NUM) {
+            return -1;
+        }
+        in[i] = dynamic_cast<Num*>(value)->value;
+    }
+    return oracle->fn(in);
+}
@@ -0,0 +1,100 @@
+#ifndef ORACLELIBRARY_HH
+#define ORACLELIBRARY_HH
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+
+using namespace std;
+
+// OracleLibrary holds native versions of the spec's pre- and postconditions.
+//
+// Predicates are registered with add() (the campaign registers the assume
+// and assert of every block, exactly as genATC emits them), compile() turns
+// them into one C++ translation unit, builds it into a shared object with the
+// host compiler and loads it with dlopen. Each predicate becomes a function
+//
+//     extern "C" int ttr_oracle_<n>(const int32_t* in)
+//
+// whose parameters are the predicate's variables, declared with their spec
+// types (int or bool) and read from `in` in a fixed slot order.
+//
+// evaluate() finds the native function of a predicate structurally (hash of
+// the tree, then an exact comparison), fetches each variable once from the
+// environment and calls it. The native subset is the one of the
+// BatchEvaluator plus named variables: Num, Var, Add/Sub/Mul/Div,
+// comparisons, And/Or/Not/Implies, with the ConcreteEvaluator's semantics
+// (32-bit wrap-around, short-circuit logic). A predicate outside the subset,
+// a variable not bound to a Num, or a division by zero yields -1 and the
+// caller interprets the predicate instead, which also reports the error.
+//
+// genATC's old-state variables U_old_1, U_old_2, ... (one per call that
+// primes U in the test string) match as U_old: the oracle registered from a
+// block's first occurrence serves every later one, reading the version the
+// evaluated predicate names.
+//
+// After compile() the library is immutable and may be shared by threads.
+class OracleLibrary {
+    public:
+        typedef int (*OracleFn)(const int32_t*);
+
+    private:
+        struct Oracle {
+            unique_ptr<Expr> predicate;
+            vector<string> vars;       // slot order of the function's input
+            vector<string> types;      // "int" or "bool", per slot
+            bool versioned;            // has a U_old slot (see evaluate())
+            size_t hash;
+            OracleFn fn;
+        };
+
+        vector<Oracle> oracles;
+        unordered_multimap<size_t, size_t> index;   // hash -> oracle
+        string source;
+        string workDir;
+        void* handle;
+
+        const Oracle* find(const Expr&) const;
+        string emitExpr(const Expr&, const Oracle&) const;
+
+    public:
+        OracleLibrary() : handle(nullptr) {}
+        ~OracleLibrary();
+
+        OracleLibrary(const OracleLibrary&) = delete;
+        OracleLibrary& operator=(const OracleLibrary&) = delete;
+
+        // Register a predicate. types gives the declared type name of
+        // variables ("int", "bool", ...); unlisted variables are taken as
+        // int. Returns false if the predicate is outside the native subset,
+        // uses a variable of another type, or is already registered.
+        bool add(const Expr& predicate, const map<string, string>& types = {});
+
+        // Generate, build and load the shared object. The compiler is $CXX,
+        // or g++ if unset. Throws runtime_error if the build or the loading
+        // fails.
+        void compile(const string& compiler = "");
+
+        // 1 or 0 for a registered predicate whose variables are all bound to
+        // Nums, -1 if it has to be interpreted.
+        int evaluate(const Expr& predicate, ConcValEnv& env) const;
+
+        bool isLoaded() const { return handle != nullptr; }
+        size_t size() const { return oracles.size(); }
+
+        // The generated translation unit (after compile()).
+        const string& getSource() const { return source; }
+
+        // Structural hash and equality over Num, Var and FuncCall trees,
+        // ignoring the version k of U_old_k.
+        static size_t fingerprint(const Expr&);
+        static bool sameTree(const Expr&, const Expr&);
+};
+
+#endif
@@ -1,7 +1,11 @@
 #include "../language/env.hh" // will change this to normal env.hh later
 #include "./see.hh"
 #include "../language/clonevisitor.hh"
+#include "../language/exprwalk.hh"
+#include "concreteevaluator.hh"
 #include "functionfactory.hh"
+#include "solver.hh"
+#include <algorithm>
 #include <iostream>
 #include <set>
 using namespace std;
@@ -110,7 +114,83 @@ unique_ptr<Expr> SEE::computePathConstraint() {
     return computePathConstraint(pathConstraint);
 }
 
+size_t SEE::termSize(const Expr& e, size_t limit) {
+    size_t size = 0;
+    walkExpr(e, [&](const Expr& node) {
+        size++;
+        if (node.exprType == ExprType::MAP) {
+            size += dynamic_cast<const Map&>(node).value.size();   // keys
+        }
+        return size > limit ? WalkAction::STOP : WalkAction::DESCEND;
+    });
+    return size;
+}
+
+static Expr* makeEq(unique_ptr<Expr> left, unique_ptr<Expr> right) {
+    vector<unique_ptr<Expr>> args;
+    args.push_back(std::move(left));
+    args.push_back(std::move(right));
+    return new FuncCall("Eq", std::move(args));
+}
+
+Expr* SEE::boundTerm(const string& varName, Expr* value) {
+    if (termBudget == 0 || budgetSolver == nullptr || termSize(*value, termBudget) <= termBudget) {
+        return value;
+    }
+    set<unsigned int> symVars;
+    collectSymVars(*value, symVars);
+    if (symVars.empty()) {
+        return value;
+    }
+
+    cout << "[BUDGET] " << varName << " exceeds " << termBudget << " nodes, concretizing" << endl;
+    Result result = budgetSolver->solve(computePathConstraint());
+    if (!result.isSat) {
+        cout << "[BUDGET] No model for the path constraint, keeping the symbolic value" << endl;
+        return value;
+    }
+    // SymVars the path constraint does not mention are unconstrained and get 0
+    map<unsigned int, int> values;
+    for (unsigned int num : symVars) {
+        auto entry = result.model.find("X" + ::to_string(num));
+        values[num] = (entry != result.model.end() && entry->second->type == ResultType::INT)
+            ? dynamic_cast<const IntResultValue*>(entry->second.get())->value : 0;
+    }
+
+    unique_ptr<Expr> concrete;
+    try {
+        ConcreteEvaluator evaluator;
+        evaluator.setSymVarValues(&values);
+        ConcValEnv env(nullptr);
+        concrete = evaluator.evaluate(*value, env);
+    } catch (const exception& e) {
+        cout << "[BUDGET] Cannot evaluate " << varName << " (" << e.what() << "), keeping the symbolic value" << endl;
+        return value;
+    } catch (const char* e) {
+        cout << "[BUDGET] Cannot evaluate " << varName << " (" << e << "), keeping the symbolic value" << endl;
+        return value;
+    }
+
+    // Record the equality: on the value itself for scalars, otherwise on the
+    // SymVars it was computed from
+    CloneVisitor cloner;
+    if (concrete->exprType == ExprType::NUM || concrete->exprType == ExprType::STRING) {
+        pathConstraint.push_back(makeEq(cloner.cloneExpr(value), cloner.cloneExpr(concrete.get())));
+    } else {
+        for (const auto& v : values) {
+            pathConstraint.push_back(makeEq(make_unique<SymVar>(v.first), make_unique<Num>(v.second)));
+        }
+    }
+    concretizations++;
+    cout << "[BUDGET] " << varName << " := " << exprToString(concrete.get()) << endl;
+    return concrete.release();
+}
+
 bool SEE::isReady(Stmt& s, SymbolTable& st) {
+    if(modelAPIs) {
+        // Nothing reaches the SUT, so symbolic values may flow anywhere
+        return true;
+    }
     if(s.statementType == StmtType::ASSIGN) {
         Assign& assign = dynamic_cast<Assign&>(s);
         
@@ -149,6 +229,10 @@ bool SEE::isReady(Stmt& s, SymbolTable& st) {
         // Declaration statements are always ready
         return true;
     }
+    else if(s.statementType == StmtType::ASSERT) {
+        // Postconditions do not constrain inputs; they are checked on replay
+        return true;
+    }
     else {
         return false;
     }
@@ -239,93 +323,25 @@ bool SEE::isReady(Expr& e, SymbolTable& st) {
 }
 
 bool SEE::isAPI(const FuncCall& fc) {
-    // Built-in functions that are NOT API calls
-    static const set<string> builtInFunctions = {
-        // Arithmetic
-        "Add", "Sub", "Mul", "Div",
-        // Comparison
-        "Eq", "Lt", "Gt", "Le", "Ge", "Neq",
-        "=", "==", "!=", "<>", "<", ">", "<=", ">=",
-        // Logical
-        "And", "Or", "Not", "Implies",
-        "and", "or", "not", "&&", "||", "!",
-        // Input
-        "input",
-        // Set operations
-        "in", "not_in", "member", "not_member", "contains", "not_contains",
-        "union", "intersection", "intersect", "difference", "diff", "minus",
-        "subset", "is_subset", "add_to_set", "remove_from_set", "is_empty_set",
-        // Map operations
-        "get", "put", "lookup", "select", "store", "update",
-        "contains_key", "has_key",
-        // List/Sequence operations
-        "concat", "append_list", "length", "at", "nth",
-        "prefix", "suffix", "contains_seq",
-        // Prime notation (for postconditions)
-        "'"
-    };
-    
-    return builtInFunctions.find(fc.name) == builtInFunctions.end();
+    // Everything that is not a built-in is dispatched to the SUT
+    return !ConcreteEvaluator::isBuiltin(fc.name);
 }
 
 bool SEE::isSymbolic(Expr& e, SymbolTable& st) {
-    if(e.exprType == ExprType::SYMVAR) {
-        return true;
-    }
-    else if(e.exprType == ExprType::FUNCCALL) {
-        FuncCall& fc = dynamic_cast<FuncCall&>(e);
-        for(unsigned int i = 0; i < fc.args.size(); i++) {
-            if(isSymbolic(*fc.args[i], st) == true) {
-                return true;
-            }
+    return walkExpr(e, [&](Expr& node) {
+        if(node.exprType == ExprType::SYMVAR) {
+            return WalkAction::STOP;
         }
-        return false;
-    }
-    else if(e.exprType == ExprType::MAP) {
-        Map& map = dynamic_cast<Map&>(e);
-        for(unsigned int i = 0; i < map.value.size(); i++) {
-            if(isSymbolic(*map.value[i].second, st) == true) {
-                return true;
+        if(node.exprType == ExprType::VAR) {
+            // Look up the variable in sigma to see if its value is symbolic
+            Var& var = dynamic_cast<Var&>(node);
+            if(sigma.hasValue(var.name) && isSymbolic(*sigma.getValue(var.name), st)) {
+                return WalkAction::STOP;
             }
+            return WalkAction::SKIP;
         }
-        return false;
-    }
-    else if(e.exprType == ExprType::NUM) {
-        return false;
-    }
-    else if(e.exprType == ExprType::SET) {
-        Set& set = dynamic_cast<Set&>(e);
-        for(unsigned int i = 0; i < set.elements.size(); i++) {
-            if(isSymbolic(*set.elements[i], st) == true) {
-                return true;
-            }
-        }
-        return false;
-    }
-    else if(e.exprType == ExprType::STRING) {
-        return false;
-    }
-    else if(e.exprType == ExprType::TUPLE) {
-        Tuple& tuple = dynamic_cast<Tuple&>(e);
-        for(unsigned int i = 0; i < tuple.exprs.size(); i++) {
-            if(isSymbolic(*tuple.exprs[i], st) == true) {
-                return true;
-            }
-        }
-        return false;
-    }
-    else if(e.exprType == ExprType::VAR) {
-        Var& var = dynamic_cast<Var&>(e);
-        // Look up the variable in sigma to see if its value is symbolic
-        if(sigma.hasValue(var.name)) {
-            Expr* val = sigma.getValue(var.name);
-            return isSymbolic(*val, st);
-        }
-        return false;
-    }
-    else {
-        return false;
-    }
+        return WalkAction::DESCEND;
+    });
 }
 
 // Symbolic Execution function following the algorithm:
@@ -344,6 +360,9 @@ void SEE::execute(Program &pg, SymbolTable& st) {
     
     // Clear previous state
     pathConstraint.clear();
+    constraintOrigins.clear();
+    inputSymVars.clear();
+    modeledResponses.clear();
     
     // Iterate through statements
     for (size_t i = 0; i < pg.statements.size(); i++) {
@@ -353,6 +372,7 @@ void SEE::execute(Program &pg, SymbolTable& st) {
         if (isReady(*stmt, st)) {
             // Execute the statement (symexInstr)
             executeStmt(*stmt, st);
+            constraintOrigins.resize(pathConstraint.size(), i);
         } else {
             // Statement not ready (e.g., contains input() that needs concrete value)
             cout << "[SEE] Statement " << i << " not ready, interrupting execution" << endl;
@@ -392,6 +412,10 @@ void SEE::executeStmt(Stmt& stmt, SymbolTable& st) {
         if(assign.right->exprType == ExprType::FUNCCALL) {
             FuncCall& fc = dynamic_cast<FuncCall&>(*assign.right);
             
+            if(isAPI(fc) && modelAPIs) {
+                modelAPICall(assign);
+                return;
+            }
             if(isAPI(fc)) {
                 // This is an API call - execute it
                 cout << "[API_CALL] Executing API function: " << fc.name << endl;
@@ -439,7 +463,7 @@ void SEE::executeStmt(Stmt& stmt, SymbolTable& st) {
                 }
             } else {
                 // Built-in function call (input, Add, etc.) - evaluate symbolically
-                Expr* rhsExpr = evaluateExpr(*assign.right, st);
+                Expr* rhsExpr = boundTerm(varName, evaluateExpr(*assign.right, st));
                 
                 cout << "[ASSIGN] Result: " << varName << " := " << exprToString(rhsExpr) << endl;
 
@@ -448,7 +472,7 @@ void SEE::executeStmt(Stmt& stmt, SymbolTable& st) {
             }
         } else {
             // Not a function call - evaluate normally
-            Expr* rhsExpr = evaluateExpr(*assign.right, st);
+            Expr* rhsExpr = boundTerm(varName, evaluateExpr(*assign.right, st));
             
             cout << "[ASSIGN] Result: " << varName << " := " << exprToString(rhsExpr) << endl;
 
@@ -467,6 +491,31 @@ void SEE::executeStmt(Stmt& stmt, SymbolTable& st) {
         cout << "[ASSUME] Adding constraint: " << exprToString(constraint) << endl;
         
         pathConstraint.push_back(constraint);
+    } else if(stmt.statementType == StmtType::ASSERT) {
+        // Nothing to do symbolically: the assertion is checked when the CTC is
+        // replayed. A modeled API call is the exception: its postcondition is
+        // all that is known about its result.
+        if(!modeledResponses.empty()) {
+            Assert& assrt = dynamic_cast<Assert&>(stmt);
+            Expr* constraint = evaluateExpr(*assrt.expr, st);
+            bool mentions = walkExpr(*constraint, [&](Expr& node) {
+                if(node.exprType == ExprType::SYMVAR &&
+                   find(modeledResponses.begin(), modeledResponses.end(),
+                        dynamic_cast<SymVar&>(node).getNum()) != modeledResponses.end()) {
+                    return WalkAction::STOP;
+                }
+                return WalkAction::DESCEND;
+            });
+            modeledResponses.clear();
+            if(mentions) {
+                cout << "\n[ASSERT] Modeling API result: " << exprToString(constraint) << endl;
+                pathConstraint.push_back(constraint);
+                return;
+            }
+            // A postcondition about state only: state is not modeled
+            delete constraint;
+        }
+        cout << "\n[ASSERT] Skipped during symbolic execution" << endl;
     } else if(stmt.statementType == StmtType::DECL) {
         // taking this as the declaration of a symbolic variable or the input statement
         // we need to get the last symbolic variable and add it to sigma with a new symbolic expression
@@ -485,7 +534,37 @@ void SEE::executeStmt(Stmt& stmt, SymbolTable& st) {
 
 }
 
+void SEE::modelAPICall(Assign& assign) {
+    FuncCall& fc = dynamic_cast<FuncCall&>(*assign.right);
+    vector<string> names;
+    if(assign.left->exprType == ExprType::VAR) {
+        names.push_back(dynamic_cast<Var&>(*assign.left).name);
+    } else if(assign.left->exprType == ExprType::TUPLE) {
+        for(const auto& e : dynamic_cast<Tuple&>(*assign.left).exprs) {
+            if(e->exprType == ExprType::VAR) {
+                names.push_back(dynamic_cast<Var&>(*e).name);
+            }
+        }
+    }
+    cout << "[API_CALL] Modeling API function: " << fc.name << endl;
+    modeledResponses.clear();
+    for(const auto& name : names) {
+        SymVar* response = SymVar::getNewSymVar().release();
+        modeledResponses.push_back(response->getNum());
+        cout << "[ASSIGN] Result: " << name << " := " << exprToString(response) << endl;
+        sigma.setValue(name, response);
+    }
+}
+
 Expr* SEE::evaluateExpr(Expr& expr, SymbolTable& st) {
+    // Evaluate bottom-up: every node is evaluated once the values of its
+    // subexpressions are known, without recursing once per level
+    return foldExpr<Expr*>(expr, [this](Expr& node, vector<Expr*>& children) {
+        return evaluateNode(node, children);
+    });
+}
+
+Expr* SEE::evaluateNode(Expr& expr, vector<Expr*>& children) {
     // Evaluate expressions based on their type
     CloneVisitor cloner;
     
@@ -497,17 +576,16 @@ Expr* SEE::evaluateExpr(Expr& expr, SymbolTable& st) {
         // Special case: "input" function with no arguments returns a new symbolic variable
         if(fc.name == "input" && fc.args.size() == 0) {
             SymVar* symVar = SymVar::getNewSymVar().release();
+            inputSymVars.push_back(symVar->getNum());
             cout << "    [EVAL] input() returns new symbolic variable: " << exprToString(symVar) << endl;
             return symVar;
         }
         
-        // Evaluate all arguments
+        // Arguments were evaluated before the call
         vector<unique_ptr<Expr>> evaluatedArgs;
-        for (size_t i = 0; i < fc.args.size(); i++) {
-            cout << "    [EVAL] Arg[" << i << "]: " << exprToString(fc.args[i]) << endl;
-            Expr* argResult = evaluateExpr(*fc.args[i], st);
-            cout << "    [EVAL] Arg[" << i << "] result: " << exprToString(argResult) << endl;
-            evaluatedArgs.push_back(cloner.cloneExpr(argResult));
+        for (size_t i = 0; i < children.size(); i++) {
+            cout << "    [EVAL] Arg[" << i << "] result: " << exprToString(children[i]) << endl;
+            evaluatedArgs.push_back(cloner.cloneExpr(children[i]));
         }
         
         FuncCall* result = new FuncCall(fc.name, ::move(evaluatedArgs));
@@ -543,13 +621,11 @@ Expr* SEE::evaluateExpr(Expr& expr, SymbolTable& st) {
         return &expr;
     }
     else if(expr.exprType == ExprType::SET) {
-        // Evaluate each element in the set
         Set& set = dynamic_cast<Set&>(expr);
         cout << "  [EVAL] Set with " << set.elements.size() << " elements" << endl;
         
         vector<unique_ptr<Expr>> evaluatedElements;
-        for (size_t i = 0; i < set.elements.size(); i++) {
-            Expr* elemResult = evaluateExpr(*set.elements[i], st);
+        for (Expr* elemResult : children) {
             evaluatedElements.push_back(cloner.cloneExpr(elemResult));
         }
         
@@ -558,17 +634,14 @@ Expr* SEE::evaluateExpr(Expr& expr, SymbolTable& st) {
         return result;
     }
     else if(expr.exprType == ExprType::MAP) {
-        // Evaluate each key-value pair in the map
+        // Keys are copied, values were evaluated
         Map& map = dynamic_cast<Map&>(expr);
         cout << "  [EVAL] Map with " << map.value.size() << " entries" << endl;
         
         vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> evaluatedPairs;
         for (size_t i = 0; i < map.value.size(); i++) {
-            // Clone the key (Var)
             unique_ptr<Var> keyClone = make_unique<Var>(map.value[i].first->name);
-            // Evaluate the value
-            Expr* valResult = evaluateExpr(*map.value[i].second, st);
-            evaluatedPairs.push_back(make_pair(::move(keyClone), cloner.cloneExpr(valResult)));
+            evaluatedPairs.push_back(make_pair(::move(keyClone), cloner.cloneExpr(children[i])));
         }
         
         Map* result = new Map(::move(evaluatedPairs));
@@ -576,13 +649,11 @@ Expr* SEE::evaluateExpr(Expr& expr, SymbolTable& st) {
         return result;
     }
     else if(expr.exprType == ExprType::TUPLE) {
-        // Evaluate each element in the tuple
         Tuple& tuple = dynamic_cast<Tuple&>(expr);
         cout << "  [EVAL] Tuple with " << tuple.exprs.size() << " elements" << endl;
         
         vector<unique_ptr<Expr>> evaluatedExprs;
-        for (size_t i = 0; i < tuple.exprs.size(); i++) {
-            Expr* elemResult = evaluateExpr(*tuple.exprs[i], st);
+        for (Expr* elemResult : children) {
             evaluatedExprs.push_back(cloner.cloneExpr(elemResult));
         }
         
@@ -1,6 +1,7 @@
 #ifndef SEE_HH
 #define SEE_HH
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -12,6 +13,7 @@
 
 // Forward declaration
 class FunctionFactory;
+class Solver;
 
 using namespace std;
 // see = symbolic execution engine 
@@ -27,7 +29,14 @@ class SEE {
 
         ValueEnvironment sigma;  // Value environment: maps variable names to their values
         vector<Expr*> pathConstraint;
+        vector<size_t> constraintOrigins; // statement that added each path constraint
+        vector<unsigned int> inputSymVars; // SymVars created by input(), in program order
         FunctionFactory* functionFactory; // Factory for creating API functions
+        size_t termBudget;                // largest symbolic value kept in sigma, 0 = no limit
+        const Solver* budgetSolver;       // solves for values over the budget
+        size_t concretizations;
+        bool modelAPIs;                   // see setModelAPIs
+        vector<unsigned int> modeledResponses; // SymVars of the last modeled API call
 
 
         unique_ptr<Expr> computePathConstraint(vector<Expr*>);
@@ -45,15 +54,49 @@ class SEE {
         bool isSymbolic(Expr&, SymbolTable&);
         
         // Check if a function call is an API call (not a built-in function)
-        // Built-in functions: Add, Sub, Mul, Eq, Lt, Gt, And, Or, Not, input
+        // Built-in functions (Add, Sub, Mul, Eq, Lt, Gt, And, Or, Not, input,
+        // ...) are listed in ConcreteEvaluator::isBuiltin
         bool isAPI(const FuncCall& fc);
 
+        // If a symbolic value is larger than the term budget, replace it by a
+        // concrete value it can take under the current path constraint and
+        // add the equality to the path constraint
+        Expr* boundTerm(const string& varName, Expr*);
+
+        // Bind the response variables of an API call to fresh SymVars
+        // instead of calling the SUT
+        void modelAPICall(Assign&);
+
 	void executeStmt(Stmt&, SymbolTable&);
 	Expr* evaluateExpr(Expr&, SymbolTable&);
+        // Value of one node given the values of its subexpressions
+        Expr* evaluateNode(Expr&, vector<Expr*>& children);
     public:
-        SEE(FunctionFactory* functionFactory) : sigma(nullptr) {
+        SEE(FunctionFactory* functionFactory)
+            : sigma(nullptr), termBudget(0), budgetSolver(nullptr), concretizations(0),
+              modelAPIs(false) {
             this->functionFactory = functionFactory;
         }
+
+        // Keep symbolic values assigned to variables at most maxNodes AST
+        // nodes large (0 = no limit). Larger values are concretized with the
+        // solver: later constraints see a constant, at the cost of the paths
+        // where the value differs.
+        void setTermBudget(size_t maxNodes, const Solver* solver) {
+            termBudget = maxNodes;
+            budgetSolver = solver;
+        }
+        size_t getConcretizations() const { return concretizations; }
+
+        // Model API calls instead of executing them: a call returns fresh
+        // symbolic values, constrained by the assert that follows it (the
+        // block's postcondition) when that assert mentions them. A whole
+        // test string then executes without calling the SUT, and its path
+        // constraint covers every input.
+        void setModelAPIs(bool on) { modelAPIs = on; }
+
+        // Number of AST nodes of an expression, counting stops after limit
+        static size_t termSize(const Expr&, size_t limit = SIZE_MAX);
         
         // Program and Type Env
         void execute(Program&, SymbolTable&);
@@ -64,5 +107,8 @@ class SEE {
         // Getters for testing
         ValueEnvironment& getSigma() { return sigma; }
         vector<Expr*>& getPathConstraint() { return pathConstraint; }
+        // Index of the program statement that added each path constraint
+        const vector<size_t>& getConstraintOrigins() const { return constraintOrigins; }
+        const vector<unsigned int>& getInputSymVars() const { return inputSymVars; }
 };
 #endif
@@ -51,5 +51,11 @@ class Result {
 class Solver {
     public:
         virtual Result solve(unique_ptr<Expr>) const = 0;
+
+        // Solve within timeoutMs milliseconds (0 = no limit). Solvers that
+        // cannot be limited ignore the limit.
+        virtual Result solveWithin(unique_ptr<Expr> formula, unsigned int timeoutMs) const {
+            return solve(std::move(formula));
+        }
 };
 #endif
@@ -1,12 +1,17 @@
 #include "z3solver.hh"
+#include "../language/exprwalk.hh"
 #include "../language/symvar.hh"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 // ============================================================================
 // Z3InputMaker Implementation
 // ============================================================================
 
-Z3InputMaker::Z3InputMaker(TypeMap* tm) : typeMap(tm) {}
+Z3InputMaker::Z3InputMaker(TypeMap* tm, z3::context* shared)
+    : ownCtx(shared ? nullptr : new z3::context()), ctx(shared ? *shared : *ownCtx), typeMap(tm),
+      listBound(0) {}
 
 Z3InputMaker::~Z3InputMaker() {
     // Clean up allocated z3::expr pointers
@@ -18,29 +23,49 @@ Z3InputMaker::~Z3InputMaker() {
     }
 }
 
+z3::expr Z3InputMaker::symVarExpr(unsigned int num) {
+    if (symVarMap.find(num) == symVarMap.end()) {
+        string varName = "X" + to_string(num);
+        z3::expr* z3Var = new z3::expr(ctx.int_const(varName.c_str()));
+        symVarMap[num] = z3Var;
+        variables.push_back(*z3Var);
+    }
+    return *symVarMap[num];
+}
+
+// Translate bottom-up with foldExpr: path constraints are deep And chains
+z3::expr Z3InputMaker::convert(const Expr& expr) {
+    return foldExpr<z3::expr>(expr, [this](const Expr& node, vector<z3::expr>& operands) {
+        return convertNode(node, operands);
+    });
+}
+
+z3::expr Z3InputMaker::convertNode(const Expr& node, vector<z3::expr>& operands) {
+    switch (node.exprType) {
+        case ExprType::SYMVAR:
+            return symVarExpr(dynamic_cast<const SymVar&>(node).getNum());
+        case ExprType::FUNCCALL:
+            convertFuncCall(dynamic_cast<const FuncCall&>(node), operands);
+            break;
+        case ExprType::SET:
+            convertSet(dynamic_cast<const Set&>(node), operands);
+            break;
+        case ExprType::MAP:
+            convertMap(dynamic_cast<const Map&>(node), operands);
+            break;
+        default:
+            visit(&node);
+            break;
+    }
+    z3::expr result = theStack.top();
+    theStack.pop();
+    return result;
+}
+
 // ============================================================================
 // Z3 Sort Helpers
 // ============================================================================
- z3::expr Z3InputMaker::convertArg(const unique_ptr<Expr>& arg){
-        if (arg->exprType == ExprType::SYMVAR) {
-            SymVar* sv = dynamic_cast<SymVar*>(arg.get());
-            unsigned int num = sv->getNum();
-            
-            if (symVarMap.find(num) == symVarMap.end()) {
-                string varName = "X" + to_string(num);
-                z3::expr* z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-                symVarMap[num] = z3Var;
-                variables.push_back(*z3Var);
-            }
-            
-            return *symVarMap[num];
-        } else {
-            visit(arg.get());
-            z3::expr result = theStack.top();
-            theStack.pop();
-            return result;
-        }
-}
+
 z3::sort Z3InputMaker::getStringSort() {
     return ctx.string_sort();
 }
@@ -78,6 +103,8 @@ z3::sort Z3InputMaker::typeExprToSort(TypeExpr* type) {
                 return getIntSort();
             } else if (tc->name == "bool" || tc->name == "boolean") {
                 return ctx.bool_sort();
+            } else if (tc->name == "list") {
+                return getListSort(ctx.int_sort());
             }
             return ctx.int_sort(); // Default
         }
@@ -113,62 +140,21 @@ z3::expr Z3InputMaker::makeEmptyMap(z3::sort keySort, z3::sort valueSort) {
 // ============================================================================
 
 z3::expr Z3InputMaker::makeZ3Input(unique_ptr<Expr>& expr) {
-    if (!expr) {
-        throw runtime_error("Null expression in Z3 conversion");
-    }
-    
-    // Handle SymVar specially since it's not part of the ExprVisitor interface
-    if (expr->exprType == ExprType::SYMVAR) {
-        SymVar* sv = dynamic_cast<SymVar*>(expr.get());
-        unsigned int num = sv->getNum();
-        
-        // Check if we've already created a Z3 variable for this SymVar
-        if (symVarMap.find(num) == symVarMap.end()) {
-            string varName = "X" + to_string(num);
-            z3::expr* z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-            symVarMap[num] = z3Var;
-            variables.push_back(*z3Var);
-        }
-        
-        return *symVarMap[num];
-    }
-    
-    visit(expr.get());
-    if (theStack.empty()) {
-        throw runtime_error("Stack empty after visiting expression");
-    }
-    z3::expr result = theStack.top();
-    theStack.pop();
-    return result;
+    return makeZ3Input(expr.get());
 }
 
 z3::expr Z3InputMaker::makeZ3Input(Expr* expr) {
     if (!expr) {
         throw runtime_error("Null expression in Z3 conversion");
     }
-    
-    // Handle SymVar specially
-    if (expr->exprType == ExprType::SYMVAR) {
-        SymVar* sv = dynamic_cast<SymVar*>(expr);
-        unsigned int num = sv->getNum();
-        
-        if (symVarMap.find(num) == symVarMap.end()) {
-            string varName = "X" + to_string(num);
-            z3::expr* z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-            symVarMap[num] = z3Var;
-            variables.push_back(*z3Var);
-        }
-        
-        return *symVarMap[num];
-    }
-    
-    visit(expr);
-    if (theStack.empty()) {
-        throw runtime_error("Stack empty after visiting expression");
+    return convert(*expr);
+}
+
+z3::expr Z3InputMaker::toBool(const z3::expr& e) {
+    if (e.is_int()) {
+        return e != 0;
     }
-    z3::expr result = theStack.top();
-    theStack.pop();
-    return result;
+    return e;
 }
 
 vector<z3::expr> Z3InputMaker::getVariables() {
@@ -190,6 +176,21 @@ void Z3InputMaker::visitVar(const Var &node) {
     z3::sort varSort = ctx.int_sort(); // Default
     if (typeMap && typeMap->hasValue(node.name)) {
         TypeExpr* type = typeMap->getValue(node.name);
+        if (listBound > 0 && type && type->typeExprType == TypeExprType::TYPE_CONST &&
+            dynamic_cast<TypeConst*>(type)->name == "list") {
+            // A bounded list: its elements under the variable's name, its
+            // length as name!len
+            z3::expr* elements = new z3::expr(ctx.constant(node.name.c_str(),
+                                                           ctx.array_sort(ctx.int_sort(), ctx.int_sort())));
+            z3::expr length = ctx.int_const((node.name + "!len").c_str());
+            namedVarMap[node.name] = elements;
+            variables.push_back(*elements);
+            variables.push_back(length);
+            // The upper bound is left to the caller (see getListDomains)
+            listDomains.push_back(length >= 0);
+            theStack.push(makeBoundedList(*elements, length, listBound));
+            return;
+        }
         varSort = typeExprToSort(type);
     }
     
@@ -209,135 +210,237 @@ void Z3InputMaker::visitString(const String &node) {
 }
 
 void Z3InputMaker::visitFuncCall(const FuncCall &node) {
-    // Helper lambda to convert an argument
+    theStack.push(convert(node));
+}
 
-    
+// ============================================================================
+// Bounded Lists
+// ============================================================================
+
+z3::expr Z3InputMaker::makeBoundedList(const z3::expr& elements, const z3::expr& length,
+                                       size_t maxLength) {
+    boundedLists.emplace(elements.id(), BoundedList{ length, maxLength });
+    return elements;
+}
+
+const Z3InputMaker::BoundedList* Z3InputMaker::findBoundedList(const z3::expr& e) const {
+    if (!e.get_sort().is_array()) {
+        return nullptr;
+    }
+    auto it = boundedLists.find(e.id());
+    return it == boundedLists.end() ? nullptr : &it->second;
+}
+
+static z3::expr allOf(z3::context& ctx, const z3::expr_vector& terms) {
+    return terms.empty() ? ctx.bool_val(true) : z3::mk_and(terms);
+}
+
+// Same length and the same elements up to it
+z3::expr Z3InputMaker::listEquals(const z3::expr& a, const z3::expr& b) {
+    BoundedList la = *findBoundedList(a), lb = *findBoundedList(b);
+    z3::expr_vector same(ctx);
+    same.push_back(la.length == lb.length);
+    for (size_t i = 0; i < min(la.maxLength, lb.maxLength); i++) {
+        z3::expr index = ctx.int_val((int)i);
+        same.push_back(z3::implies(index < la.length, z3::select(a, index) == z3::select(b, index)));
+    }
+    return z3::mk_and(same);
+}
+
+bool Z3InputMaker::convertBoundedListOp(const FuncCall& node, vector<z3::expr>& operands) {
+    if (operands.empty() || !findBoundedList(operands[0])) {
+        return false;
+    }
+    const string& name = node.name;
+    z3::expr a = operands[0];
+    BoundedList la = *findBoundedList(a);
+    if (name == "length" && operands.size() == 1) {
+        theStack.push(la.length);
+        return true;
+    }
+    if ((name == "at" || name == "nth") && operands.size() == 2) {
+        // Unconstrained past the end, like seq.nth
+        theStack.push(z3::select(a, operands[1]));
+        return true;
+    }
+    if (operands.size() != 2 || !findBoundedList(operands[1])) {
+        return false;
+    }
+    z3::expr b = operands[1];
+    BoundedList lb = *findBoundedList(b);
+
+    if (name == "concat" || name == "append_list") {
+        z3::expr j = ctx.int_const("j!concat");
+        z3::expr elements = z3::lambda(j, z3::ite(j < la.length, z3::select(a, j),
+                                                  z3::select(b, j - la.length)));
+        theStack.push(makeBoundedList(elements, la.length + lb.length, la.maxLength + lb.maxLength));
+    } else if (name == "prefix" || name == "suffix") {
+        // a is b[0 .. |a|) or b[|b| - |a| .. |b|)
+        z3::expr offset = name == "prefix" ? ctx.int_val(0) : lb.length - la.length;
+        z3::expr_vector holds(ctx);
+        holds.push_back(la.length <= lb.length);
+        for (size_t i = 0; i < la.maxLength; i++) {
+            z3::expr index = ctx.int_val((int)i);
+            holds.push_back(z3::implies(index < la.length,
+                                        z3::select(a, index) == z3::select(b, offset + index)));
+        }
+        theStack.push(z3::mk_and(holds));
+    } else if (name == "contains_seq") {
+        // b occurs in a at some offset k <= |a| - |b|
+        z3::expr_vector offsets(ctx);
+        for (size_t k = 0; k <= la.maxLength; k++) {
+            z3::expr offset = ctx.int_val((int)k);
+            z3::expr_vector holds(ctx);
+            holds.push_back(offset + lb.length <= la.length);
+            for (size_t i = 0; i < lb.maxLength; i++) {
+                z3::expr index = ctx.int_val((int)i);
+                holds.push_back(z3::implies(index < lb.length,
+                                            z3::select(b, index) == z3::select(a, offset + index)));
+            }
+            offsets.push_back(allOf(ctx, holds));
+        }
+        theStack.push(z3::mk_or(offsets));
+    } else if (name == "Eq" || name == "=" || name == "==") {
+        theStack.push(listEquals(a, b));
+    } else if (name == "Neq" || name == "!=" || name == "<>") {
+        theStack.push(!listEquals(a, b));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Pushes the term of a call whose arguments are already translated
+void Z3InputMaker::convertFuncCall(const FuncCall &node, vector<z3::expr>& operands) {
+    if (listBound > 0 && convertBoundedListOp(node, operands)) {
+        return;
+    }
     // ========== Arithmetic Operations ==========
     if (node.name == "Add" && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left + right);
     }
     else if (node.name == "Sub" && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left - right);
     }
     else if (node.name == "Mul" && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left * right);
     }
     
     // ========== Comparison Operations ==========
     else if ((node.name == "Eq" || node.name == "=" || node.name == "==") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left == right);
     }
     else if ((node.name == "Neq" || node.name == "!=" || node.name == "<>") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left != right);
     }
     else if ((node.name == "Lt" || node.name == "<") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left < right);
     }
     else if ((node.name == "Gt" || node.name == ">") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left > right);
     }
     else if ((node.name == "Le" || node.name == "<=") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left <= right);
     }
     else if ((node.name == "Ge" || node.name == ">=") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = operands[0];
+        z3::expr right = operands[1];
         theStack.push(left >= right);
     }
     
     // ========== Logical Operations ==========
     else if ((node.name == "And" || node.name == "and" || node.name == "&&") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = toBool(operands[0]);
+        z3::expr right = toBool(operands[1]);
         theStack.push(left && right);
     }
     else if ((node.name == "Or" || node.name == "or" || node.name == "||") && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = toBool(operands[0]);
+        z3::expr right = toBool(operands[1]);
         theStack.push(left || right);
     }
     else if ((node.name == "Not" || node.name == "not" || node.name == "!") && node.args.size() == 1) {
-        z3::expr arg = convertArg(node.args[0]);
+        z3::expr arg = toBool(operands[0]);
         theStack.push(!arg);
     }
     else if (node.name == "Implies" && node.args.size() == 2) {
-        z3::expr left = convertArg(node.args[0]);
-        z3::expr right = convertArg(node.args[1]);
+        z3::expr left = toBool(operands[0]);
+        z3::expr right = toBool(operands[1]);
         theStack.push(z3::implies(left, right));
     }
     
     // ========== Set/Map Membership Operations ==========
     else if ((node.name == "in" || node.name == "member" || node.name == "contains") && node.args.size() == 2) {
         // in(element, set) or in(key, map) - check if element/key is in set/map
-        z3::expr element = convertArg(node.args[0]);
-        z3::expr setOrMap = convertArg(node.args[1]);
+        z3::expr element = operands[0];
+        z3::expr setOrMap = operands[1];
         // For sets (array to bool): select returns true if member
         // For maps (array to value): we check if key exists
         theStack.push(z3::select(setOrMap, element));
     }
     else if ((node.name == "not_in" || node.name == "not_member" || node.name == "not_contains") && node.args.size() == 2) {
         // not_in(element, set) - check if element is NOT in set
-        z3::expr element = convertArg(node.args[0]);
-        z3::expr setOrMap = convertArg(node.args[1]);
+        z3::expr element = operands[0];
+        z3::expr setOrMap = operands[1];
         theStack.push(!z3::select(setOrMap, element));
     }
     
     // ========== Set Operations ==========
     else if (node.name == "union" && node.args.size() == 2) {
         // union(set1, set2) - set union using Z3's set_union
-        z3::expr set1 = convertArg(node.args[0]);
-        z3::expr set2 = convertArg(node.args[1]);
+        z3::expr set1 = operands[0];
+        z3::expr set2 = operands[1];
         theStack.push(z3::set_union(set1, set2));
     }
     else if ((node.name == "intersection" || node.name == "intersect") && node.args.size() == 2) {
         // intersection(set1, set2) - set intersection
-        z3::expr set1 = convertArg(node.args[0]);
-        z3::expr set2 = convertArg(node.args[1]);
+        z3::expr set1 = operands[0];
+        z3::expr set2 = operands[1];
         theStack.push(z3::set_intersect(set1, set2));
     }
     else if ((node.name == "difference" || node.name == "diff" || node.name == "minus") && node.args.size() == 2) {
         // difference(set1, set2) - set difference
-        z3::expr set1 = convertArg(node.args[0]);
-        z3::expr set2 = convertArg(node.args[1]);
+        z3::expr set1 = operands[0];
+        z3::expr set2 = operands[1];
         theStack.push(z3::set_difference(set1, set2));
     }
     else if ((node.name == "subset" || node.name == "is_subset") && node.args.size() == 2) {
         // subset(set1, set2) - check if set1 is subset of set2
-        z3::expr set1 = convertArg(node.args[0]);
-        z3::expr set2 = convertArg(node.args[1]);
+        z3::expr set1 = operands[0];
+        z3::expr set2 = operands[1];
         theStack.push(z3::set_subset(set1, set2));
     }
     else if (node.name == "add_to_set" && node.args.size() == 2) {
         // add_to_set(set, element) - add element to set
-        z3::expr set = convertArg(node.args[0]);
-        z3::expr element = convertArg(node.args[1]);
+        z3::expr set = operands[0];
+        z3::expr element = operands[1];
         theStack.push(z3::set_add(set, element));
     }
     else if (node.name == "remove_from_set" && node.args.size() == 2) {
         // remove_from_set(set, element) - remove element from set
-        z3::expr set = convertArg(node.args[0]);
-        z3::expr element = convertArg(node.args[1]);
+        z3::expr set = operands[0];
+        z3::expr element = operands[1];
         theStack.push(z3::set_del(set, element));
     }
     else if (node.name == "is_empty_set" && node.args.size() == 1) {
         // is_empty_set(set) - check if set is empty
-        z3::expr set = convertArg(node.args[0]);
+        z3::expr set = operands[0];
         z3::sort elemSort = set.get_sort().array_domain();
         z3::expr emptySet = makeEmptySet(elemSort);
         theStack.push(set == emptySet);
@@ -346,15 +449,15 @@ void Z3InputMaker::visitFuncCall(const FuncCall &node) {
     // ========== Map Operations ==========
     else if ((node.name == "get" || node.name == "lookup" || node.name == "select") && node.args.size() == 2) {
         // get(map, key) - get value for key from map
-        z3::expr map = convertArg(node.args[0]);
-        z3::expr key = convertArg(node.args[1]);
+        z3::expr map = operands[0];
+        z3::expr key = operands[1];
         theStack.push(z3::select(map, key));
     }
     else if ((node.name == "put" || node.name == "store" || node.name == "update") && node.args.size() == 3) {
         // put(map, key, value) - store value at key in map
-        z3::expr map = convertArg(node.args[0]);
-        z3::expr key = convertArg(node.args[1]);
-        z3::expr value = convertArg(node.args[2]);
+        z3::expr map = operands[0];
+        z3::expr key = operands[1];
+        z3::expr value = operands[2];
         theStack.push(z3::store(map, key, value));
     }
     else if ((node.name == "contains_key" || node.name == "has_key") && node.args.size() == 2) {
@@ -362,8 +465,8 @@ void Z3InputMaker::visitFuncCall(const FuncCall &node) {
         // For maps represented as arrays, we need domain tracking
         // Simplified: assume all keys exist (return true)
         // For proper implementation, need separate domain set
-        z3::expr map = convertArg(node.args[0]);
-        z3::expr key = convertArg(node.args[1]);
+        z3::expr map = operands[0];
+        z3::expr key = operands[1];
         // Use select and check against default - simplified version
         theStack.push(ctx.bool_val(true)); // Placeholder
     }
@@ -371,37 +474,38 @@ void Z3InputMaker::visitFuncCall(const FuncCall &node) {
     // ========== List/Sequence Operations ==========
     else if ((node.name == "concat" || node.name == "append_list") && node.args.size() == 2) {
         // concat(list1, list2) - concatenate two lists
-        z3::expr list1 = convertArg(node.args[0]);
-        z3::expr list2 = convertArg(node.args[1]);
+        z3::expr list1 = operands[0];
+        z3::expr list2 = operands[1];
         theStack.push(z3::concat(list1, list2));
     }
     else if (node.name == "length" && node.args.size() == 1) {
         // length(list) - get length of list
-        z3::expr list = convertArg(node.args[0]);
+        z3::expr list = operands[0];
         theStack.push(list.length());
     }
     else if ((node.name == "at" || node.name == "nth") && node.args.size() == 2) {
-        // at(list, index) - get element at index
-        z3::expr list = convertArg(node.args[0]);
-        z3::expr index = convertArg(node.args[1]);
-        theStack.push(list.at(index));
+        // at(list, index) - get element at index; at on a string is the
+        // one-character string there
+        z3::expr list = operands[0];
+        z3::expr index = operands[1];
+        theStack.push(Z3_is_string_sort(ctx, list.get_sort()) ? list.at(index) : list.nth(index));
     }
     else if (node.name == "prefix" && node.args.size() == 2) {
         // prefix(list1, list2) - check if list1 is prefix of list2
-        z3::expr list1 = convertArg(node.args[0]);
-        z3::expr list2 = convertArg(node.args[1]);
+        z3::expr list1 = operands[0];
+        z3::expr list2 = operands[1];
         theStack.push(z3::prefixof(list1, list2));
     }
     else if (node.name == "suffix" && node.args.size() == 2) {
         // suffix(list1, list2) - check if list1 is suffix of list2
-        z3::expr list1 = convertArg(node.args[0]);
-        z3::expr list2 = convertArg(node.args[1]);
+        z3::expr list1 = operands[0];
+        z3::expr list2 = operands[1];
         theStack.push(z3::suffixof(list1, list2));
     }
     else if (node.name == "contains_seq" && node.args.size() == 2) {
         // contains_seq(list, sublist) - check if list contains sublist
-        z3::expr list = convertArg(node.args[0]);
-        z3::expr sublist = convertArg(node.args[1]);
+        z3::expr list = operands[0];
+        z3::expr sublist = operands[1];
         // Use Z3's seq.contains via the C API
         Z3_ast args[2] = { list, sublist };
         Z3_ast result = Z3_mk_seq_contains(ctx, list, sublist);
@@ -411,7 +515,7 @@ void Z3InputMaker::visitFuncCall(const FuncCall &node) {
     // ========== Special Functions ==========
     else if ((node.name == "Any" || node.name == "any") && node.args.size() == 1) {
         // Any(x) - No condition, but ensures variable is registered
-        z3::expr arg = convertArg(node.args[0]);
+        z3::expr arg = operands[0];
         // Return true (tautology) so it satisfies constraints
         theStack.push(ctx.bool_val(true));
     }
@@ -423,70 +527,50 @@ void Z3InputMaker::visitFuncCall(const FuncCall &node) {
 }
 
 void Z3InputMaker::visitSet(const Set &node) {
+    theStack.push(convert(node));
+}
+
+void Z3InputMaker::convertSet(const Set &node, vector<z3::expr>& elements) {
     // Create a set from elements
     // Start with empty set and add each element
-    if (node.elements.empty()) {
+    if (elements.empty()) {
         // Empty set - need to determine element type
         // Default to int sort
         theStack.push(makeEmptySet(ctx.int_sort()));
         return;
     }
     
-    // Get first element to determine sort
-    visit(node.elements[0].get());
-    z3::expr firstElem = theStack.top();
-    theStack.pop();
-    
-    z3::sort elemSort = firstElem.get_sort();
-    z3::expr result = z3::set_add(makeEmptySet(elemSort), firstElem);
-    
-    // Add remaining elements
-    for (size_t i = 1; i < node.elements.size(); i++) {
-        visit(node.elements[i].get());
-        z3::expr elem = theStack.top();
-        theStack.pop();
-        result = z3::set_add(result, elem);
+    // The first element determines the sort
+    z3::expr result = z3::set_add(makeEmptySet(elements[0].get_sort()), elements[0]);
+    for (size_t i = 1; i < elements.size(); i++) {
+        result = z3::set_add(result, elements[i]);
     }
-    
     theStack.push(result);
 }
 
 void Z3InputMaker::visitMap(const Map &node) {
+    theStack.push(convert(node));
+}
+
+void Z3InputMaker::convertMap(const Map &node, vector<z3::expr>& values) {
     // Create a map from key-value pairs
-    if (node.value.empty()) {
+    if (values.empty()) {
         // Empty map - default to string->string
         theStack.push(makeEmptyMap(ctx.string_sort(), ctx.string_sort()));
         return;
     }
     
-    // Get first key-value to determine sorts
-    visit(node.value[0].first.get());
-    z3::expr firstKey = theStack.top();
-    theStack.pop();
-    
-    visit(node.value[0].second.get());
-    z3::expr firstVal = theStack.top();
-    theStack.pop();
-    
-    z3::sort keySort = firstKey.get_sort();
-    z3::sort valSort = firstVal.get_sort();
-    
-    // Start with empty map and store each pair
-    z3::expr result = z3::store(makeEmptyMap(keySort, valSort), firstKey, firstVal);
-    
-    // Add remaining pairs
-    for (size_t i = 1; i < node.value.size(); i++) {
-        visit(node.value[i].first.get());
-        z3::expr key = theStack.top();
+    // Keys are Vars; the first pair determines the sorts
+    vector<z3::expr> keys;
+    for (const auto& kv : node.value) {
+        visitVar(*kv.first);
+        keys.push_back(theStack.top());
         theStack.pop();
-        
-        visit(node.value[i].second.get());
-        z3::expr val = theStack.top();
-        theStack.pop();
-        
-        result = z3::store(result, key, val);
     }
-    
+    z3::expr result = z3::store(makeEmptyMap(keys[0].get_sort(), values[0].get_sort()), keys[0], values[0]);
+    for (size_t i = 1; i < values.size(); i++) {
+        result = z3::store(result, keys[i], values[i]);
+    }
     theStack.push(result);
 }
 
@@ -564,22 +648,198 @@ void Z3InputMaker::visitProgram(const Program &node) {
 // Z3Solver Implementation
 // ============================================================================
 
-Z3Solver::Z3Solver(TypeMap* tm) : typeMap(tm) {}
+Z3Solver::Z3Solver(TypeMap* tm)
+    : typeMap(tm), timeoutMs(0), listBound(0), ctx(new z3::context()), templateHits(0), templateBytes(0), unknowns(0), listRetries(0) {}
 
-Result Z3Solver::solve(unique_ptr<Expr> formula) const {
-    Z3InputMaker inputMaker(typeMap);
-    
-    // Convert the formula to Z3 format
-    z3::expr z3Formula = inputMaker.makeZ3Input(formula);
-    
-    // Create solver and add the constraint
-    z3::solver s(inputMaker.getContext());
+size_t Z3Solver::getTemplateBytes() const {
+    lock_guard<mutex> guard(lock);
+    return templateBytes;
+}
+
+size_t Z3Solver::evictTemplates(size_t maxBytes) const {
+    lock_guard<mutex> guard(lock);
+    while (templateBytes > maxBytes && !recent.empty()) {
+        auto it = templates.find(recent.back());
+        templateBytes -= it->second.bytes;
+        templates.erase(it);
+        recent.pop_back();
+    }
+    return templateBytes;
+}
+
+static z3::expr symVarConst(z3::context& ctx, unsigned int num) {
+    return ctx.int_const(("X" + to_string(num)).c_str());
+}
+
+z3::expr Z3Solver::instantiate(Expr& conjunct, map<string, z3::expr>& variables, size_t bound,
+                               bool& boundedLists) const {
+    // Terms translated with bounded lists are kept apart from sequence terms
+    string key = bound > 0 ? "L" + to_string(bound) + ";" : "";
+    vector<unsigned int> slots;
+    shapeKey(conjunct, key, &slots);
+
+    auto it = templates.find(key);
+    if (it == templates.end()) {
+        Z3InputMaker inputMaker(typeMap, ctx.get());
+        inputMaker.setListBound(bound);
+        z3::expr term = Z3InputMaker::toBool(inputMaker.makeZ3Input(&conjunct));
+        for (const auto& domain : inputMaker.getListDomains()) {
+            term = term && domain;
+        }
+        vector<z3::expr> named;
+        for (const auto& var : inputMaker.getVariables()) {
+            bool isSlot = false;
+            for (unsigned int num : slots) {
+                isSlot = isSlot || z3::eq(var, symVarConst(*ctx, num));
+            }
+            if (!isSlot) {
+                named.push_back(var);
+            }
+        }
+        // The key has a few bytes per node of the conjunct, the term a node
+        // in the context per node
+        size_t bytes = sizeof(Template) + 3 * key.size() + slots.size() * sizeof(unsigned int) +
+                       named.size() * sizeof(z3::expr);
+        recent.push_front(key);
+        it = templates.emplace(key, Template{ term, slots, named, recent.begin(), bytes,
+                                              inputMaker.usesBoundedLists() }).first;
+        templateBytes += bytes;
+    } else {
+        templateHits++;
+        recent.splice(recent.begin(), recent, it->second.use);
+    }
+
+    const Template& t = it->second;
+    boundedLists = boundedLists || t.boundedLists;
+    for (const auto& var : t.named) {
+        variables.emplace(var.to_string(), var);
+    }
+    z3::expr_vector from(*ctx), to(*ctx);
+    for (size_t i = 0; i < slots.size(); i++) {
+        z3::expr actual = symVarConst(*ctx, slots[i]);
+        variables.emplace(actual.to_string(), actual);
+        if (slots[i] != t.slots[i]) {
+            from.push_back(symVarConst(*ctx, t.slots[i]));
+            to.push_back(actual);
+        }
+    }
+    if (from.empty()) {
+        return t.term;
+    }
+    z3::expr term = t.term;
+    return term.substitute(from, to);
+}
+
+// Assumption under which every bounded list has at most `bound` elements
+static z3::expr withinListBound(z3::context& ctx) {
+    return ctx.bool_const("lists!bounded");
+}
+
+static bool isListLength(const string& name) {
+    return name.size() > 4 && name.compare(name.size() - 4, 4, "!len") == 0;
+}
+
+z3::check_result Z3Solver::check(const vector<Expr*>& conjuncts, size_t bound, unsigned int timeout,
+                                 z3::solver& s, map<string, z3::expr>& variables,
+                                 bool& boundedLists) const {
+    // Translate conjunct by conjunct through the template cache
+    z3::expr_vector parts(*ctx);
+    for (Expr* conjunct : conjuncts) {
+        parts.push_back(instantiate(*conjunct, variables, bound, boundedLists));
+    }
+    z3::expr z3Formula = parts.size() == 1 ? parts[0] : z3::mk_and(parts);
+
+    // Add the constraint
     s.add(z3Formula);
+    if(timeout > 0) {
+        z3::params p(*ctx);
+        p.set("timeout", timeout);
+        s.set(p);
+    }
     
     cout << "[Z3Solver] Checking satisfiability..." << endl;
     cout << "[Z3Solver] Formula: " << z3Formula << endl;
-    
-    if(s.check() == z3::sat) {
+
+    if (!boundedLists) {
+        return s.check();
+    }
+    // The length bounds hang off one assumption, so the unsat core tells
+    // whether they were needed for the conflict
+    z3::expr within = withinListBound(*ctx);
+    for (const auto& entry : variables) {
+        if (isListLength(entry.first)) {
+            s.add(z3::implies(within, entry.second <= ctx->int_val((int)bound)));
+        }
+    }
+    z3::expr_vector assumptions(*ctx);
+    assumptions.push_back(within);
+    return s.check(assumptions);
+}
+
+// A list in the model: a sequence, or a bounded list's elements array and
+// length
+static string listValue(z3::model& m, const z3::expr& list, const z3::expr* length) {
+    int n = 0;
+    z3::expr lengthValue = m.eval(length ? *length : list.length(), true);
+    Z3_get_numeral_int(list.ctx(), lengthValue, &n);
+    string text = "[";
+    for (int i = 0; i < n; i++) {
+        z3::expr index = list.ctx().int_val(i);
+        z3::expr element = m.eval(length ? z3::select(list, index) : list.nth(index), true);
+        text += (i > 0 ? ", " : "") + element.to_string();
+    }
+    return text + "]";
+}
+
+Result Z3Solver::solve(unique_ptr<Expr> formula) const {
+    return solveWithin(std::move(formula), timeoutMs);
+}
+
+Result Z3Solver::solveWithin(unique_ptr<Expr> formula, unsigned int timeout) const {
+    if (!formula) {
+        throw runtime_error("Null expression in Z3 conversion");
+    }
+    lock_guard<mutex> guard(lock);
+    lastUnknown.clear();
+
+    vector<Expr*> conjuncts;
+    flattenAnd(*formula, conjuncts);
+    map<string, z3::expr> variables;
+    z3::solver s(*ctx);
+    bool boundedLists = false;
+    auto start = chrono::steady_clock::now();
+    z3::check_result status = check(conjuncts, listBound, timeout, s, variables, boundedLists);
+    string reason;
+    if(status == z3::unsat && boundedLists) {
+        z3::expr within = withinListBound(*ctx);
+        bool boundUsed = false;
+        for (const auto& assumption : s.unsat_core()) {
+            boundUsed = boundUsed || z3::eq(assumption, within);
+        }
+        // Only longer lists may satisfy the query: solve again with
+        // sequences in the time that is left
+        auto used = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        if (boundUsed && timeout > 0 && used.count() >= (long long)timeout) {
+            status = z3::unknown;
+            reason = "timeout";
+        } else if (boundUsed) {
+            cout << "[Z3Solver] No solution with lists of at most " << listBound
+                 << " elements, solving with sequences" << endl;
+            listRetries++;
+            unsigned int left = timeout > 0 ? timeout - (unsigned int)used.count() : 0;
+            s.reset();
+            variables.clear();
+            bool sequences = false;
+            status = check(conjuncts, 0, left, s, variables, sequences);
+        }
+    }
+    if(status == z3::unknown) {
+        unknowns++;
+        lastUnknown = reason.empty() ? s.reason_unknown() : reason;
+        cout << "[Z3Solver] UNKNOWN (" << lastUnknown << ") - treating as no solution" << endl;
+        return Result(false, map<string, unique_ptr<ResultValue>>());
+    }
+    if(status == z3::sat) {
         cout << "[Z3Solver] SAT - Model found!" << endl;
         z3::model m = s.get_model();
         
@@ -587,15 +847,24 @@ Result Z3Solver::solve(unique_ptr<Expr> formula) const {
         map<string, unique_ptr<ResultValue>> var_values;
         
         // Get all variables that were used
-        vector<z3::expr> vars = inputMaker.getVariables();
-        for (const auto& var : vars) {
+        for (const auto& entry : variables) {
+            const z3::expr& var = entry.second;
             z3::expr val = m.eval(var, true);
             string varName = var.to_string();
+            auto length = variables.find(varName + "!len");
             
             // Handle different types of values
-            if (val.is_numeral()) {
+            if (isListLength(varName)) {
+                // Reported with its list
+                continue;
+            } else if (length != variables.end() ||
+                       (var.is_seq() && !Z3_is_string_sort(*ctx, var.get_sort()))) {
+                string listVal = listValue(m, var, length != variables.end() ? &length->second : nullptr);
+                cout << "[Z3Solver] " << varName << " = " << listVal << endl;
+                var_values[varName] = make_unique<StringResultValue>(listVal);
+            } else if (val.is_numeral()) {
                 int intVal;
-                if (val.is_int() && Z3_get_numeral_int(inputMaker.getContext(), val, &intVal)) {
+                if (val.is_int() && Z3_get_numeral_int(*ctx, val, &intVal)) {
                     cout << "[Z3Solver] " << varName << " = " << intVal << endl;
                     var_values[varName] = make_unique<IntResultValue>(intVal);
                 }
@@ -1,7 +1,9 @@
 #ifndef Z3SOLVER_HH
 #define Z3SOLVER_HH
 
+#include <list>
 #include<memory>
+#include <mutex>
 #include <stack>
 #include<string>
 
@@ -14,12 +16,32 @@ using namespace std;
 
 class Z3InputMaker : public ASTVisitor {
     private:
-        z3::context ctx;
+        unique_ptr<z3::context> ownCtx;          // null when translating into a shared context
+        z3::context& ctx;
         stack<z3::expr> theStack;
         vector<z3::expr> variables;
         map<unsigned int, z3::expr*> symVarMap; // Map SymVar numbers to Z3 variables
         map<string, z3::expr*> namedVarMap;     // Map named variables to Z3 expressions
         TypeMap* typeMap;                        // Type information for variables
+
+        // Bounded lists (see setListBound): a list is the array of its
+        // elements, the term pushed on theStack, paired with its length.
+        // maxLength is a static bound on the length; it sizes the
+        // expansions of prefix, suffix, contains_seq and list equality.
+        struct BoundedList {
+            z3::expr length;
+            size_t maxLength;
+        };
+        size_t listBound;                        // 0: lists are sequences
+        map<unsigned int, BoundedList> boundedLists;  // by AST id of the elements array
+        vector<z3::expr> listDomains;            // 0 <= length <= listBound per list variable
+
+        z3::expr makeBoundedList(const z3::expr& elements, const z3::expr& length, size_t maxLength);
+        const BoundedList* findBoundedList(const z3::expr& e) const;
+        z3::expr listEquals(const z3::expr& a, const z3::expr& b);
+        // Pushes the term of a list operation on bounded lists; false if the
+        // call is not one
+        bool convertBoundedListOp(const FuncCall& node, vector<z3::expr>& operands);
         
         // Z3 sorts for custom types
         z3::sort getStringSort();
@@ -36,13 +58,28 @@ class Z3InputMaker : public ASTVisitor {
         z3::expr makeEmptyMap(z3::sort keySort, z3::sort valueSort);
 
     public:
-        Z3InputMaker(TypeMap* typeMap = nullptr);
+        // Translate into `shared` if given (it must outlive the results),
+        // otherwise into a context owned by this object.
+        Z3InputMaker(TypeMap* typeMap = nullptr, z3::context* shared = nullptr);
         ~Z3InputMaker();
         z3::expr makeZ3Input(unique_ptr<Expr>& expr);
         z3::expr makeZ3Input(Expr* expr);
+        // Integers used as truth values (e.g. assume(1)) are read as x != 0
+        static z3::expr toBool(const z3::expr& e);
 	    vector<z3::expr> getVariables();
         z3::context& getContext() { return ctx; }
 
+        // Encode variables of type list (lists of integers) as a length of at
+        // most maxLength and an integer array, with concat, length, at,
+        // prefix, suffix and contains_seq in arithmetic and array theory.
+        // 0 (the default) translates lists to Z3 sequences.
+        void setListBound(size_t maxLength) { listBound = maxLength; }
+        // 0 <= length for every bounded list variable translated so far; the
+        // caller conjoins them with the translated formula and adds
+        // length <= bound itself (Z3Solver does so under an assumption)
+        const vector<z3::expr>& getListDomains() const { return listDomains; }
+        bool usesBoundedLists() const { return !listDomains.empty(); }
+
     protected:
         // Expression visitor methods (protected, called by base class)
         void visitVar(const Var &node) override;
@@ -65,8 +102,15 @@ class Z3InputMaker : public ASTVisitor {
         void visitAssume(const Assume &node) override;
 
 
-        // Declaration/High-level visitor methods
-        z3::expr convertArg(const unique_ptr<Expr>& arg);
+        // Iterative translation (see exprwalk.hh): convertNode gets the
+        // terms of a node's subexpressions; the convert* helpers push the
+        // node's term on theStack
+        z3::expr convert(const Expr& expr);
+        z3::expr convertNode(const Expr& node, vector<z3::expr>& operands);
+        void convertFuncCall(const FuncCall& node, vector<z3::expr>& operands);
+        void convertSet(const Set& node, vector<z3::expr>& elements);
+        void convertMap(const Map& node, vector<z3::expr>& values);
+        z3::expr symVarExpr(unsigned int num);
 
     public:
         // High-level visitor methods
@@ -79,11 +123,97 @@ class Z3InputMaker : public ASTVisitor {
         void visitProgram(const Program &node) override;
 };
 
+// Z3Solver translates each conjunct of a formula through a template cache.
+//
+// Path constraints repeat the same block predicates over and over with only
+// their SymVars renamed (Gt(X0, 5), Gt(X3, 5), ...). A conjunct's shape is
+// its tree with SymVars numbered by first occurrence; the first conjunct of
+// a shape is translated into the solver's own context and kept as a
+// template over its SymVar constants. Later conjuncts of the same shape are
+// instantiated with z3::expr::substitute, which costs a walk over the Expr
+// for the key but no Z3 term construction for the predicate itself.
+//
+// The context and the templates live as long as the solver, so a solver
+// reused across test strings keeps its templates, until evictTemplates drops
+// the least recently used ones. Queries on one solver are serialized.
 class Z3Solver : public Solver {
     private:
+        struct Template {
+            z3::expr term;
+            vector<unsigned int> slots;     // SymVar numbers the term was built with
+            vector<z3::expr> named;         // named variables the term mentions
+            list<string>::iterator use;     // position in recent
+            size_t bytes;                   // approximate footprint
+            bool boundedLists;              // translated with bounded lists
+        };
+
         TypeMap* typeMap;
+        unsigned int timeoutMs;
+        size_t listBound;
+        mutable unique_ptr<z3::context> ctx;
+        mutable map<string, Template> templates;
+        mutable size_t templateHits;
+        mutable list<string> recent;        // template keys, most recently used first
+        mutable size_t templateBytes;
+        mutable size_t unknowns;
+        mutable size_t listRetries;
+        mutable string lastUnknown;
+        mutable mutex lock;
+
+        // Z3 term of one conjunct; adds the variables it uses to `variables`.
+        // Lists are bounded to `bound` elements (0 = sequences); sets
+        // `boundedLists` if the conjunct has a bounded list.
+        z3::expr instantiate(Expr& conjunct, map<string, z3::expr>& variables, size_t bound,
+                             bool& boundedLists) const;
+        // Add the conjuncts to s and check them
+        z3::check_result check(const vector<Expr*>& conjuncts, size_t bound, unsigned int timeout,
+                               z3::solver& s, map<string, z3::expr>& variables,
+                               bool& boundedLists) const;
+
     public:
         Z3Solver(TypeMap* typeMap = nullptr);
         Result solve(unique_ptr<Expr>) const;
+        // solve() with a timeout for this query only, instead of setTimeout's
+        Result solveWithin(unique_ptr<Expr>, unsigned int timeoutMs) const override;
+
+        // Number of cached conjunct shapes, and of conjuncts that were
+        // instantiated from one instead of translated
+        size_t getTemplateCount() const { return templates.size(); }
+        size_t getTemplateHits() const { return templateHits; }
+
+        // Approximate bytes held by the templates (keys, slots and a
+        // per-node estimate for the Z3 terms)
+        size_t getTemplateBytes() const;
+
+        // Drop least recently used templates until at most maxBytes are
+        // held; returns the bytes held afterwards
+        size_t evictTemplates(size_t maxBytes) const;
+
+        // Give up on a query after ms milliseconds (0 = no limit). A query
+        // that times out is reported as unsatisfiable.
+        void setTimeout(unsigned int ms) { timeoutMs = ms; }
+        unsigned int getTimeout() const { return timeoutMs; }
+
+        // Encode list variables (TypeMap type `list`) with at most maxLength
+        // elements in arithmetic and array theory (see
+        // Z3InputMaker::setListBound) instead of sequences, 0 = sequences.
+        // The bound is an assumption: a query that is unsat because of it
+        // (the bound is in the unsat core) is solved again with sequences in
+        // the time left, so the bound only costs time when it is too small.
+        // Queries that are unsat anyway or time out are not retried.
+        // List values are reported as "[1, 2, 3]"; they are for callers
+        // that solve over named list variables, Tester only takes integer
+        // inputs (see Tester::inputValue).
+        void setListBound(size_t maxLength) { listBound = maxLength; }
+        size_t getListBound() const { return listBound; }
+        // Queries solved again with sequences because of the bound
+        size_t getListRetries() const { return listRetries; }
+
+        // Queries Z3 gave up on (timeout or unknown)
+        size_t getUnknowns() const { return unknowns; }
+        // Z3's reason for giving up on the last query ("timeout",
+        // "canceled", "(incomplete (theory arithmetic))", ...), empty if it
+        // did not give up
+        const string& getLastUnknownReason() const { return lastUnknown; }
 };
 #endif
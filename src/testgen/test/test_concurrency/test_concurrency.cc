@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include "ast.hh"
+#include "../../see/z3solver.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/countershards.hh"
+#include "../../tester/coverage.hh"
+#include "../../tester/mpscqueue.hh"
+#include "../../tester/test_utils.hh"
+#include "../../tester/teststringsampler.hh"
+#include "../../tester/testset.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+class ConcurrencyTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    ConcurrencyTest(const string& name) : testName(name) {}
+    virtual ~ConcurrencyTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Items from concurrent producers all arrive, in order per producer
+*/
+class ConcurrencyTest1 : public ConcurrencyTest {
+public:
+    ConcurrencyTest1() : ConcurrencyTest("MPSC queue") {}
+
+protected:
+    void run() override {
+        const size_t producers = 4, items = 20000;
+        MpscQueue<pair<size_t, size_t>> queue;
+        vector<thread> pool;
+        for (size_t p = 0; p < producers; p++) {
+            pool.emplace_back([&queue, p, items]() {
+                for (size_t i = 0; i < items; i++) {
+                    queue.push({ p, i });
+                }
+            });
+        }
+
+        vector<size_t> expected(producers, 0);
+        size_t received = 0;
+        pair<size_t, size_t> item;
+        while (received < producers * items) {
+            if (!queue.tryPop(item)) {
+                this_thread::yield();
+                continue;
+            }
+            assert(item.second == expected[item.first]);
+            expected[item.first]++;
+            received++;
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+        assert(!queue.tryPop(item));
+        cout << "  " << received << " items from " << producers << " producers" << endl;
+    }
+};
+
+/*
+Test 2: Sharded counters add up on read
+*/
+class ConcurrencyTest2 : public ConcurrencyTest {
+public:
+    ConcurrencyTest2() : ConcurrencyTest("Counter shards") {}
+
+protected:
+    void run() override {
+        const size_t threads = 4, adds = 100000;
+        CounterShards counters(threads, 10);
+        vector<thread> pool;
+        for (size_t s = 0; s < threads; s++) {
+            pool.emplace_back([&counters, s, adds]() {
+                for (size_t i = 0; i < adds; i++) {
+                    counters.add(s, 0);
+                    counters.add(s, 9, 2);
+                }
+            });
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+        assert(counters.read(0) == threads * adds);
+        assert(counters.read(9) == 2 * threads * adds);
+        assert(counters.read(5) == 0);
+
+        bool threw = false;
+        try {
+            counters.add(threads, 0);
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+};
+
+/*
+Test 3: Concurrent merges credit every bit exactly once
+*/
+class ConcurrencyTest3 : public ConcurrencyTest {
+public:
+    ConcurrencyTest3() : ConcurrencyTest("Atomic coverage bitmap") {}
+
+protected:
+    void run() override {
+        const size_t bits = 300, threads = 8;
+        CoverageBitmap initial(bits);
+        initial.set(0);
+        AtomicCoverageBitmap shared(initial);
+
+        CoverageBitmap expected = initial;
+        vector<CoverageBitmap> parts;
+        for (size_t t = 0; t < threads; t++) {
+            CoverageBitmap part(bits);
+            for (size_t i = 0; i < bits; i += t + 2) {
+                part.set(i);
+            }
+            expected.merge(part);
+            parts.push_back(part);
+        }
+
+        vector<size_t> fresh(threads, 0);
+        vector<thread> pool;
+        for (size_t t = 0; t < threads; t++) {
+            pool.emplace_back([&, t]() { fresh[t] = shared.merge(parts[t]); });
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+
+        size_t total = 0;
+        for (size_t f : fresh) {
+            total += f;
+        }
+        assert(total == expected.count() - initial.count());
+        assert(shared.count() == expected.count());
+        assert(shared.snapshot().getWords() == expected.getWords());
+        assert(shared.test(0) && shared.test(2) && !shared.test(1));
+        cout << "  " << total << " fresh bits credited over " << threads << " merges" << endl;
+    }
+};
+
+/*
+Test 4: A parallel campaign matches the sequential one, in input order
+*/
+class ConcurrencyTest4 : public ConcurrencyTest {
+public:
+    ConcurrencyTest4() : ConcurrencyTest("Parallel campaign") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        vector<vector<string>> testStrings = {
+            { "f2" }, { "set" }, { "set", "f2" }, { "bad" }, { "f2", "set", "set" },
+            { "set", "bad" }, { "f2", "f2" }, { "set", "set" }
+        };
+
+        Campaign sequential(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        vector<ReplayStatus> statuses;
+        for (size_t i = 0; i < testStrings.size(); i++) {
+            statuses.push_back(sequential.runTestString(testStrings[i], i).result.status);
+        }
+
+        Campaign parallel(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        vector<CampaignEntry> entries = parallel.runParallel(testStrings, 4);
+
+        assert(entries.size() == testStrings.size());
+        size_t newPoints = 0, passed = 0, infeasibleOrError = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            assert(entries[i].testString == testStrings[i]);
+            assert(entries[i].result.status == statuses[i]);
+            newPoints += entries[i].newPoints;
+            passed += (statuses[i] == ReplayStatus::PASSED) ? 1 : 0;
+            infeasibleOrError += (statuses[i] == ReplayStatus::INFEASIBLE ||
+                                  statuses[i] == ReplayStatus::ERROR) ? 1 : 0;
+        }
+        assert(parallel.getCoverage().getWords() == sequential.getCoverage().getWords());
+        assert(newPoints == parallel.getCoverage().count());
+
+        const CampaignStats& stats = parallel.getLastStats();
+        assert(stats.passed == passed);
+        assert(stats.infeasible + stats.errors == infeasibleOrError);
+        assert(stats.newPoints == newPoints);
+        cout << "  " << entries.size() << " test strings on 4 workers: " << stats.passed
+             << " passed, " << newPoints << " points" << endl;
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+// App1 without set_y: generating a test string that calls it throws
+class NoSetFactory : public FunctionFactory {
+private:
+    App1FunctionFactory app;
+
+public:
+    unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+        if (fname == "set_y") {
+            throw runtime_error("set_y is not available");
+        }
+        return app.getFunction(fname, args);
+    }
+
+    unique_ptr<FunctionFactory> snapshot() override {
+        return make_unique<NoSetFactory>();
+    }
+};
+
+static unique_ptr<FunctionFactory> makeNoSetFactory() {
+    return make_unique<NoSetFactory>();
+}
+
+// The test strings of a vector, in order
+class VectorStream : public TestSetStream {
+private:
+    const vector<vector<string>>& testStrings;
+    size_t next_;
+
+public:
+    VectorStream(const vector<vector<string>>& testStrings) : testStrings(testStrings), next_(0) {}
+
+    bool next(vector<string>& out) override {
+        if (next_ == testStrings.size()) {
+            return false;
+        }
+        out = testStrings[next_++];
+        return true;
+    }
+};
+
+/*
+Test 5: A test string whose generation throws is an ERROR entry in the
+sequential run() loops as well as in runParallel, and the campaign goes on
+*/
+class ConcurrencyTest5 : public ConcurrencyTest {
+public:
+    ConcurrencyTest5() : ConcurrencyTest("Failed generation in sequential and parallel campaigns") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        vector<vector<string>> testStrings = {
+            { "f2" }, { "set" }, { "f2", "set" }, { "f2", "f2" }
+        };
+
+        Campaign sequential(spec.get(), symTable, TypeMap(), makeNoSetFactory);
+        VectorStream stream(testStrings);
+        vector<CampaignEntry> seqEntries = sequential.run(stream);
+
+        Campaign parallel(spec.get(), symTable, TypeMap(), makeNoSetFactory);
+        vector<CampaignEntry> parEntries = parallel.runParallel(testStrings, 2);
+
+        assert(seqEntries.size() == testStrings.size());
+        assert(parEntries.size() == testStrings.size());
+        for (size_t i = 0; i < testStrings.size(); i++) {
+            bool callsSet = find(testStrings[i].begin(), testStrings[i].end(), "set") != testStrings[i].end();
+            assert(seqEntries[i].testString == testStrings[i]);
+            assert(seqEntries[i].result.status == parEntries[i].result.status);
+            assert(seqEntries[i].result.message == parEntries[i].result.message);
+            assert((seqEntries[i].result.status == ReplayStatus::ERROR) == callsSet);
+            assert(callsSet == !seqEntries[i].ctc);
+        }
+        assert(parallel.getCoverage().getWords() == sequential.getCoverage().getWords());
+
+        // The sampler learns the failures as infeasible runs
+        Campaign sampled(spec.get(), symTable, TypeMap(), makeNoSetFactory);
+        TestStringSampler sampler(spec.get(), 1);
+        vector<CampaignEntry> sampledEntries = sampled.run(sampler, 6, 2);
+        assert(sampledEntries.size() == 6);
+        size_t errors = 0;
+        for (const auto& entry : sampledEntries) {
+            bool callsSet = find(entry.testString.begin(), entry.testString.end(), "set") != entry.testString.end();
+            // "bad" is an ERROR too, but its CTC is generated
+            bool failed = entry.result.status == ReplayStatus::ERROR && !entry.ctc;
+            assert(failed == callsSet);
+            errors += failed ? 1 : 0;
+        }
+        cout << "  " << errors << " of 6 sampled test strings failed to generate" << endl;
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 6: A parallel campaign samples with per-worker copies of the hybrid
+solver and adds their statistics to it
+*/
+class ConcurrencyTest6 : public ConcurrencyTest {
+public:
+    ConcurrencyTest6() : ConcurrencyTest("Parallel campaign with a hybrid solver") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        vector<vector<string>> testStrings = {
+            { "set" }, { "set", "f2" }, { "f2", "set", "set" }, { "bad" }, { "set", "set" }
+        };
+
+        Z3Solver z3;
+        HybridSolver sequentialSolver(z3, 64, 100, 0.05, 7);
+        Campaign sequential(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        sequential.setHybridSolver(&sequentialSolver);
+        vector<ReplayStatus> statuses;
+        for (size_t i = 0; i < testStrings.size(); i++) {
+            statuses.push_back(sequential.runTestString(testStrings[i], i).result.status);
+        }
+
+        HybridSolver parallelSolver(z3, 64, 100, 0.05, 7);
+        Campaign parallel(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        parallel.setHybridSolver(&parallelSolver);
+        vector<CampaignEntry> entries = parallel.runParallel(testStrings, 3);
+
+        for (size_t i = 0; i < entries.size(); i++) {
+            assert(entries[i].result.status == statuses[i]);
+        }
+        // Every solve went through a worker's copy and was added back
+        size_t solves = parallelSolver.getRandomHits() + parallelSolver.getFallbackCalls();
+        assert(solves > 0);
+        assert(solves == sequentialSolver.getRandomHits() + sequentialSolver.getFallbackCalls());
+        assert(!parallelSolver.getStats().empty());
+        cout << "  " << parallelSolver.getRandomHits() << " sampled, "
+             << parallelSolver.getFallbackCalls() << " fallback solves on 3 workers" << endl;
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<ConcurrencyTest*> testcases = {
+        new ConcurrencyTest1(),
+        new ConcurrencyTest2(),
+        new ConcurrencyTest3(),
+        new ConcurrencyTest4(),
+        new ConcurrencyTest5(),
+        new ConcurrencyTest6()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Concurrency Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Concurrency Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/ctccorpus.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static const string CORPUS_PATH = "/tmp/ttr_test_corpus.bin";
+
+static string render(const Program& p) {
+    string s;
+    for (const auto& stmt : p.statements) {
+        s += TestUtils::stmtToString(*stmt) + "\n";
+    }
+    return s;
+}
+
+class CorpusTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    CorpusTest(const string& name) : testName(name) {}
+    virtual ~CorpusTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Hand-written CTCs round-trip; shared prefixes are stored once
+*/
+class CorpusTest1 : public CorpusTest {
+public:
+    CorpusTest1() : CorpusTest("Round trip and prefix sharing") {}
+
+protected:
+    static vector<unique_ptr<Stmt>> prefix() {
+        vector<unique_ptr<Stmt>> stmts;
+        vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+        entries.push_back(make_pair(make_unique<Var>("alice"), make_unique<String>("pw \"1\"")));
+        stmts.push_back(make_unique<Assign>(make_unique<Var>("U"), make_unique<Map>(std::move(entries))));
+        vector<unique_ptr<Expr>> elems;
+        elems.push_back(make_unique<Num>(-7));
+        elems.push_back(make_unique<Num>(2147483647));
+        stmts.push_back(make_unique<Assign>(make_unique<Var>("S"), make_unique<Set>(std::move(elems))));
+        return stmts;
+    }
+
+    void run() override {
+        vector<unique_ptr<Program>> ctcs;
+        for (int i = 0; i < 20; i++) {
+            vector<unique_ptr<Stmt>> stmts = prefix();
+            vector<unique_ptr<Expr>> args;
+            args.push_back(make_unique<Num>(i % 4));
+            vector<unique_ptr<Expr>> lhs;
+            lhs.push_back(make_unique<Var>("code"));
+            lhs.push_back(make_unique<Var>("r"));
+            stmts.push_back(make_unique<Assign>(make_unique<Tuple>(std::move(lhs)),
+                                                make_unique<FuncCall>("set_y", std::move(args))));
+            stmts.push_back(make_unique<Assert>(TestUtils::makeBinOp("Eq", make_unique<Var>("r"),
+                                                                     make_unique<Num>(i))));
+            ctcs.push_back(make_unique<Program>(std::move(stmts)));
+        }
+        ctcs.push_back(make_unique<Program>(vector<unique_ptr<Stmt>>()));
+
+        CTCCorpusWriter writer;
+        for (size_t i = 0; i < ctcs.size(); i++) {
+            assert(writer.add(*ctcs[i]) == i);
+        }
+        // 2 shared statements, 4 distinct calls, 20 distinct asserts
+        assert(writer.getStatementsAdded() == 80);
+        assert(writer.getNodeCount() == 26);
+        writer.write(CORPUS_PATH);
+
+        CTCCorpus corpus(CORPUS_PATH);
+        assert(corpus.size() == ctcs.size());
+        for (size_t i = 0; i < ctcs.size(); i++) {
+            assert(corpus.length(i) == ctcs[i]->statements.size());
+            assert(render(*corpus.get(i)) == render(*ctcs[i]));
+        }
+        cout << "  80 statements stored as 26 trie nodes; all CTCs decode unchanged" << endl;
+
+        CTCCorpus::Stream stream = corpus.stream();
+        size_t id, count = 0;
+        unique_ptr<Program> ctc;
+        while (stream.next(id, ctc)) {
+            assert(id == count++);
+            assert(render(*ctc) == render(*ctcs[id]));
+        }
+        assert(count == ctcs.size());
+
+        try {
+            corpus.get(ctcs.size());
+            assert(false);
+        } catch (const out_of_range&) {
+        }
+    }
+};
+
+/*
+Test 2: Damaged files are rejected
+*/
+class CorpusTest2 : public CorpusTest {
+public:
+    CorpusTest2() : CorpusTest("Invalid corpus files") {}
+
+protected:
+    void run() override {
+        CTCCorpusWriter writer;
+        vector<unique_ptr<Stmt>> stmts;
+        stmts.push_back(make_unique<Assume>(TestUtils::makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(5))));
+        writer.add(Program(std::move(stmts)));
+        writer.write(CORPUS_PATH);
+
+        ifstream in(CORPUS_PATH, ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+
+        auto rejected = [](const string& contents) {
+            ofstream out(CORPUS_PATH, ios::binary | ios::trunc);
+            out << contents;
+            out.close();
+            try {
+                CTCCorpus corpus(CORPUS_PATH);
+                corpus.get(0);
+            } catch (const runtime_error& e) {
+                cout << "  Rejected: " << e.what() << endl;
+                return true;
+            }
+            return false;
+        };
+        assert(rejected(bytes.substr(0, bytes.size() - 4)));   // truncated
+        string magic = bytes;
+        magic[0] = 'X';
+        assert(rejected(magic));
+        string order = bytes;
+        swap(order[8], order[11]);
+        assert(rejected(order));
+        string count = bytes;
+        for (int i = 12; i < 16; ++i) count[i] = '\xff';   // stringCount = UINT32_MAX
+        assert(rejected(count));
+        assert(rejected(""));
+        assert(!rejected(bytes));
+    }
+};
+
+/*
+Test 3: Replaying from a corpus gives the same verdicts as the CTCs in memory
+*/
+class CorpusTest3 : public CorpusTest {
+public:
+    CorpusTest3() : CorpusTest("Replay from a corpus") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        vector<vector<string>> strings = {
+            { "f2" }, { "set" }, { "f2", "set" }, { "f2", "set", "set" }, { "f2", "f2" }, { "set", "f2" }
+        };
+        vector<unique_ptr<Program>> ctcs;
+        CTCCorpusWriter writer;
+        for (const auto& ts : strings) {
+            ctcs.push_back(campaign.generateCTC(ts));
+            writer.add(*ctcs.back());
+        }
+        writer.write(CORPUS_PATH);
+        cout << "  " << writer.getStatementsAdded() << " statements, "
+             << writer.getNodeCount() << " trie nodes" << endl;
+        assert(writer.getNodeCount() < writer.getStatementsAdded());
+
+        ReplayRunner runner(TestUtils::makeSampleFactory, 3);
+        vector<ReplayResult> inMemory = runner.run(ctcs);
+        CTCCorpus corpus(CORPUS_PATH);
+        vector<ReplayResult> mapped = runner.run(corpus);
+        assert(mapped.size() == inMemory.size());
+        for (size_t i = 0; i < mapped.size(); i++) {
+            cout << "  test " << i << ": " << replayStatusToString(mapped[i].status) << endl;
+            assert(mapped[i].testId == i);
+            assert(mapped[i].status == inMemory[i].status);
+            assert(mapped[i].stmtIndex == inMemory[i].stmtIndex);
+        }
+
+        remove(CORPUS_PATH.c_str());
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<CorpusTest*> testcases = {
+        new CorpusTest1(),
+        new CorpusTest2(),
+        new CorpusTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Corpus Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Corpus Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,337 @@
+#include <iostream>
+#include <cassert>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/coverage.hh"
+#include "../../tester/suiteminimizer.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+/*
+Spec used by all tests:
+    Global: y : int
+    Init: y := 0
+    API f1: r := f1(x, z)
+        Pre:  x > 0 OR z > 0
+        Post: r = x + z
+    API f2: r := f2()
+        Pre:  true
+        Post: r = 0
+
+Coverage points (in order):
+    f1.pre   #0 disjunct (x > 0), #1/#2 (x > 0) true/false,
+             #3 disjunct (z > 0), #4/#5 (z > 0) true/false
+    f1.post  #6/#7 (r = x + z) true/false
+    f2.post  #8/#9 (r = 0) true/false
+*/
+static unique_ptr<Spec> makeSpec() {
+    vector<unique_ptr<Decl>> globals;
+    globals.push_back(make_unique<Decl>("y", make_unique<TypeConst>("int")));
+    vector<unique_ptr<Init>> inits;
+    inits.push_back(make_unique<Init>("y", make_unique<Num>(0)));
+    vector<unique_ptr<APIFuncDecl>> functions;
+    vector<unique_ptr<API>> blocks;
+
+    {
+        auto pre = TestUtils::makeBinOp("Or",
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(0)),
+            TestUtils::makeBinOp("Gt", make_unique<Var>("z"), make_unique<Num>(0)));
+        vector<unique_ptr<Expr>> callArgs;
+        callArgs.push_back(make_unique<Var>("x"));
+        callArgs.push_back(make_unique<Var>("z"));
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f1", std::move(callArgs)),
+            Response(make_unique<Var>("r")));
+        auto post = TestUtils::makeBinOp("Eq", make_unique<Var>("r"),
+            TestUtils::makeBinOp("Add", make_unique<Var>("x"), make_unique<Var>("z")));
+        blocks.push_back(make_unique<API>(std::move(pre), std::move(apiCall),
+                                          Response(std::move(post)), "f1"));
+    }
+    {
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f2", vector<unique_ptr<Expr>>{}),
+            Response(make_unique<Var>("r")));
+        auto post = TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0));
+        blocks.push_back(make_unique<API>(make_unique<Num>(1), std::move(apiCall),
+                                          Response(std::move(post)), "f2"));
+    }
+
+    return make_unique<Spec>(std::move(globals), std::move(inits),
+                             std::move(functions), std::move(blocks));
+}
+
+static SymbolTable* makeSymbolTables() {
+    auto* globalTable = new SymbolTable(nullptr);
+    auto* f1Table = new SymbolTable(globalTable);
+    f1Table->addMapping(new string("x"), nullptr);
+    f1Table->addMapping(new string("z"), nullptr);
+    globalTable->addChild(f1Table);
+    globalTable->addChild(new SymbolTable(globalTable));
+    return globalTable;
+}
+
+static void deleteSymbolTables(SymbolTable* globalTable) {
+    for (size_t i = 0; i < globalTable->getChildCount(); i++) {
+        delete globalTable->getChild(i);
+    }
+    delete globalTable;
+}
+
+static unique_ptr<FunctionFactory> makeApp1() {
+    return unique_ptr<FunctionFactory>(new App1FunctionFactory());
+}
+
+class CoverageTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    CoverageTest(const string& name) : testName(name) {}
+    virtual ~CoverageTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Points are numbered per block, disjuncts and both comparison outcomes
+*/
+class CoverageTest1 : public CoverageTest {
+public:
+    CoverageTest1() : CoverageTest("Coverage point layout") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        CoverageMap map(spec.get());
+        for (size_t i = 0; i < map.size(); i++) {
+            cout << "  " << i << ": " << map.describe(i) << endl;
+        }
+        assert(map.size() == 10);
+        assert(map.blockCount() == 2);
+        assert(map.blockBegin(0) == 0 && map.blockEndIndex(0) == 8);
+        assert(map.blockBegin(1) == 8 && map.blockEndIndex(1) == 10);
+        assert(map.getPoint(0).kind == CoveragePointKind::DISJUNCT);
+        assert(map.getPoint(4).kind == CoveragePointKind::ATOM_TRUE);
+        assert(map.getPoint(7).isPost && map.getPoint(7).kind == CoveragePointKind::ATOM_FALSE);
+        assert(map.getPoint(9).blockIndex == 1);
+    }
+};
+
+/*
+Test 2: Bitmap set/merge/newBits across word boundaries
+*/
+class CoverageTest2 : public CoverageTest {
+public:
+    CoverageTest2() : CoverageTest("Coverage bitmap operations") {}
+
+protected:
+    void run() override {
+        CoverageBitmap a(130), b(130);
+        assert(a.set(3));
+        assert(!a.set(3));
+        a.set(64);
+        b.set(64);
+        b.set(129);
+        assert(a.count() == 2);
+        assert(a.countNew(b) == 1);
+        CoverageBitmap fresh = a.newBits(b);
+        assert(fresh.count() == 1 && fresh.test(129));
+        assert(a.merge(b) == 1);
+        assert(a.count() == 3);
+        assert(a.countRange(60, 130) == 2);
+        cout << "  Bitmap operations correct" << endl;
+    }
+};
+
+/*
+Test 3: The scheduler prefers test strings touching uncovered blocks and
+discounts blocks that stopped producing coverage.
+*/
+class CoverageTest3 : public CoverageTest {
+public:
+    CoverageTest3() : CoverageTest("Scheduler order by expected gain") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        CoverageMap map(spec.get());
+        CoverageScheduler scheduler(map, { {"f2"}, {"f1", "f2"}, {"f2", "f1"}, {"f1"} });
+        CoverageBitmap global(map.size());
+
+        // Both blocks uncovered: the two-block strings win, the first one on ties
+        assert(scheduler.expectedGain(1, global) == 10);
+        assert((scheduler.next(global) == vector<string>{"f1", "f2"}));
+
+        // f1 fully covered; f2 ran without covering anything -> discounted
+        for (size_t i = 0; i < 8; i++) {
+            global.set(i);
+        }
+        scheduler.update({"f1", "f2"}, CoverageBitmap(map.size()));
+        assert(scheduler.expectedGain(0, global) == 1);
+        assert((scheduler.next(global) == vector<string>{"f2"}));
+        assert(scheduler.remainingCandidates() == 2);
+
+        global.set(8);
+        global.set(9);
+        assert(!scheduler.hasNext(global));
+        cout << "  Scheduler order correct" << endl;
+    }
+};
+
+/*
+Test 4: A coverage-guided campaign reaches the coverage of running every
+candidate with fewer CTCs.
+*/
+class CoverageTest4 : public CoverageTest {
+public:
+    CoverageTest4() : CoverageTest("Coverage-guided campaign on App1") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        SymbolTable* symTable = makeSymbolTables();
+        vector<vector<string>> candidates = {
+            {"f2"}, {"f2", "f2"}, {"f1"}, {"f2", "f1"}, {"f1", "f2"}, {"f2", "f2", "f2"}
+        };
+
+        Campaign exhaustive(spec.get(), symTable, TypeMap(), makeApp1);
+        for (size_t i = 0; i < candidates.size(); i++) {
+            CampaignEntry entry = exhaustive.runTestString(candidates[i], i);
+            assert(entry.result.status == ReplayStatus::PASSED);
+        }
+
+        Campaign guided(spec.get(), symTable, TypeMap(), makeApp1);
+        CoverageScheduler scheduler(guided.getCoverageMap(), candidates);
+        vector<CampaignEntry> entries = guided.run(scheduler, candidates.size(), 2);
+        guided.printCoverage();
+
+        cout << "  Exhaustive: " << candidates.size() << " CTCs, "
+             << exhaustive.getCoverage().count() << " points" << endl;
+        cout << "  Guided:     " << entries.size() << " CTCs, "
+             << guided.getCoverage().count() << " points" << endl;
+
+        assert(entries[0].newPoints > 0);
+        assert(entries[0].testString.size() == 2);
+        assert(guided.getCoverage().count() == exhaustive.getCoverage().count());
+        assert(entries.size() < candidates.size());
+
+        deleteSymbolTables(symTable);
+    }
+};
+
+/*
+Test 5: Greedy set cover keeps a minimal covering subset, prefers the cheaper
+of equal tests, and removes picks made redundant later.
+    t0 = {0,1,2,3}  t1 = {0,1,4}  t2 = {2,3,5}  t3 = {}  t4 = {0,1,4} (cheaper)
+Greedy picks t0, t4, t2; t0 is then covered by t4 + t2.
+*/
+class CoverageTest5 : public CoverageTest {
+public:
+    CoverageTest5() : CoverageTest("Set-cover suite minimization") {}
+
+protected:
+    void run() override {
+        vector<vector<size_t>> sets = { {0, 1, 2, 3}, {0, 1, 4}, {2, 3, 5}, {}, {0, 1, 4} };
+        vector<CoverageBitmap> coverage;
+        for (const auto& s : sets) {
+            CoverageBitmap b(6);
+            for (size_t i : s) b.set(i);
+            coverage.push_back(b);
+        }
+        MinimizedSuite suite = SuiteMinimizer::minimize(coverage, { 1, 1, 1, 1, 0.5 });
+        SuiteMinimizer::printReport(suite, coverage.size());
+
+        assert((suite.kept == vector<size_t>{4, 2}));
+        assert(suite.coveredPoints == 6);
+        assert(suite.dropped.size() == 3);
+        assert((suite.dropped[0] == vector<size_t>{4, 2}));
+        assert((suite.dropped[1] == vector<size_t>{4}));
+        assert(suite.dropped[3].empty());
+    }
+};
+
+/*
+Test 6: Minimizing an exhaustive App1 campaign preserves its coverage.
+*/
+class CoverageTest6 : public CoverageTest {
+public:
+    CoverageTest6() : CoverageTest("Minimize a generated suite") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        SymbolTable* symTable = makeSymbolTables();
+        vector<vector<string>> candidates = {
+            {"f2"}, {"f1"}, {"f1", "f2"}, {"f2", "f2"}, {"f2", "f1"}
+        };
+
+        Campaign campaign(spec.get(), symTable, TypeMap(), makeApp1);
+        vector<CampaignEntry> entries;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            entries.push_back(campaign.runTestString(candidates[i], i));
+        }
+
+        MinimizedSuite suite = SuiteMinimizer::minimize(entries);
+        SuiteMinimizer::printReport(suite, entries.size());
+        vector<CampaignEntry> reduced = SuiteMinimizer::reduce(entries, suite);
+
+        CoverageBitmap keptCoverage(campaign.getCoverageMap().size());
+        for (const auto& e : reduced) {
+            assert(e.ctc != nullptr);
+            keptCoverage.merge(e.coverage);
+        }
+        assert(keptCoverage.count() == campaign.getCoverage().count());
+        assert(reduced.size() < candidates.size());
+        assert(reduced.size() + suite.dropped.size() == candidates.size());
+
+        deleteSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<CoverageTest*> testcases = {
+        new CoverageTest1(),
+        new CoverageTest2(),
+        new CoverageTest3(),
+        new CoverageTest4(),
+        new CoverageTest5(),
+        new CoverageTest6()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Coverage Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Coverage Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
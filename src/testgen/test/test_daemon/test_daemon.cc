@@ -0,0 +1,187 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/daemon.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static bool startsWith(const string& s, const string& prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+class DaemonTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    DaemonTest(const string& name) : testName(name) {}
+    virtual ~DaemonTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Requests are answered from the warm state; CTCs are cached
+*/
+class DaemonTest1 : public DaemonTest {
+public:
+    DaemonTest1() : DaemonTest("Request handling and CTC cache") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        GenerationDaemon daemon(campaign, "/tmp/unused.sock");
+
+        vector<string> out;
+        auto collect = [&out](const string& line) { out.push_back(line); };
+
+        daemon.handle("GENERATE f2 set; set", collect);
+        assert(out.back() == "END");
+        assert(out[0].substr(0, 6) == "CTC 0 ");
+        size_t n = stoul(out[0].substr(6));
+        assert(startsWith(out[1 + n], "CTC 1 "));
+        bool hasAssume = false;
+        for (const auto& line : out) {
+            hasAssume = hasAssume || startsWith(line, "assume(");
+        }
+        assert(hasAssume);
+        assert(daemon.getStats().generated == 2 && daemon.getStats().cacheHits == 0);
+
+        out.clear();
+        daemon.handle("REPLAY set ;f2 set", collect);
+        assert(out.size() == 3 && out[2] == "END");
+        assert(startsWith(out[0], "RESULT 0 PASSED +"));
+        assert(startsWith(out[1], "RESULT 1 PASSED +"));
+        assert(daemon.getStats().generated == 2 && daemon.getStats().cacheHits == 2);
+
+        out.clear();
+        daemon.handle("FROB", collect);
+        assert(startsWith(out[0], "ERROR unknown request"));
+        out.clear();
+        daemon.handle("REPLAY", collect);
+        assert(out.size() == 2 && startsWith(out[0], "ERROR") && out[1] == "END");
+
+        // A string literal with a line break, or one that reads END, stays on its line
+        string literal = "s := \"a\\b\nEND\r\n\"";
+        string wire = GenerationDaemon::escapeLine(literal);
+        assert(wire.find('\n') == string::npos && wire.find('\r') == string::npos);
+        assert(GenerationDaemon::unescapeLine(wire) == literal);
+        cout << "  generated " << daemon.getStats().generated << ", served from cache "
+             << daemon.getStats().cacheHits << endl;
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 2: Round trip over the Unix socket; cached requests are fast
+*/
+class DaemonTest2 : public DaemonTest {
+public:
+    DaemonTest2() : DaemonTest("Unix socket round trip") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        string path = "/tmp/ttr-daemon-" + to_string(getpid()) + ".sock";
+        GenerationDaemon daemon(campaign, path);
+        daemon.start();
+        thread server([&daemon]() { daemon.serve(); });
+
+        auto timed = [&path](const string& request, vector<string>& out) {
+            auto start = chrono::steady_clock::now();
+            out = GenerationDaemon::request(path, request);
+            return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        };
+        vector<string> cold, warm, replay, stats, bye;
+        double coldMs = timed("GENERATE f2 set set", cold);
+        double warmMs = timed("GENERATE f2 set set", warm);
+        timed("REPLAY f2 set set", replay);
+        timed("STATS", stats);
+        timed("SHUTDOWN", bye);
+        server.join();
+
+        cout << "  cold GENERATE " << coldMs << " ms, cached " << warmMs << " ms" << endl;
+        cout << "  " << stats[0] << endl;
+        assert(cold == warm && startsWith(cold[0], "CTC 0 "));
+        assert(warmMs < coldMs);
+        assert(replay.size() == 1 && startsWith(replay[0], "RESULT 0 PASSED"));
+        assert(startsWith(stats[0], "STATS requests=4 generated=1 hits=2 replays=1"));
+        assert(bye.size() == 1 && bye[0] == "BYE");
+        assert(access(path.c_str(), F_OK) == 0);
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 3: A client without a daemon gets an error
+*/
+class DaemonTest3 : public DaemonTest {
+public:
+    DaemonTest3() : DaemonTest("No daemon listening") {}
+
+protected:
+    void run() override {
+        bool thrown = false;
+        try {
+            GenerationDaemon::request("/tmp/ttr-no-such-daemon.sock", "STATS");
+        } catch (const runtime_error& e) {
+            thrown = true;
+            cout << "  " << e.what() << endl;
+        }
+        assert(thrown);
+    }
+};
+
+int main() {
+    vector<DaemonTest*> testcases = {
+        new DaemonTest1(),
+        new DaemonTest2(),
+        new DaemonTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Daemon Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Daemon Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/deadlinescheduler.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+/*
+Spec:
+    API f2:   r := f2()        Post: r = 0
+    API set:  r := set_y(v)    Pre: v > 5    Post: r = v
+    API slow: r := slow(v)     Pre: v > 0    Post: r = v
+slow() stands for a pathological task: every call takes 300 ms.
+*/
+class SlowFunction : public Function {
+    private:
+        int value;
+    public:
+        SlowFunction(int v) : value(v) {}
+        unique_ptr<Expr> execute() override {
+            this_thread::sleep_for(chrono::milliseconds(300));
+            return make_unique<Num>(value);
+        }
+};
+
+class SlowFactory : public App1FunctionFactory {
+    public:
+        unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+            if (fname == "slow") {
+                return make_unique<SlowFunction>(dynamic_cast<Num*>(args[0])->value);
+            }
+            return App1FunctionFactory::getFunction(fname, args);
+        }
+        unique_ptr<FunctionFactory> snapshot() override {
+            return make_unique<SlowFactory>(*this);
+        }
+};
+
+static unique_ptr<API> makeUnaryBlock(const string& name, const string& fname,
+                                      unique_ptr<Expr> pre) {
+    vector<unique_ptr<Expr>> callArgs;
+    callArgs.push_back(make_unique<Var>("v"));
+    auto apiCall = make_unique<APIcall>(
+        make_unique<FuncCall>(fname, std::move(callArgs)),
+        Response(make_unique<Var>("r")));
+    return make_unique<API>(std::move(pre), std::move(apiCall),
+        Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Var>("v"))), name);
+}
+
+static unique_ptr<Spec> makeSpec() {
+    vector<unique_ptr<Decl>> globals;
+    globals.push_back(make_unique<Decl>("y", make_unique<TypeConst>("int")));
+    vector<unique_ptr<Init>> inits;
+    inits.push_back(make_unique<Init>("y", make_unique<Num>(0)));
+    vector<unique_ptr<APIFuncDecl>> functions;
+    vector<unique_ptr<API>> blocks;
+
+    {
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f2", vector<unique_ptr<Expr>>{}),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(nullptr, std::move(apiCall),
+            Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0))), "f2"));
+    }
+    blocks.push_back(makeUnaryBlock("set", "set_y",
+        TestUtils::makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(5))));
+    blocks.push_back(makeUnaryBlock("slow", "slow",
+        TestUtils::makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(0))));
+
+    return make_unique<Spec>(std::move(globals), std::move(inits),
+                             std::move(functions), std::move(blocks));
+}
+
+static SymbolTable* makeSymbolTables() {
+    auto* globalTable = new SymbolTable(nullptr);
+    globalTable->addChild(new SymbolTable(globalTable));
+    for (int i = 0; i < 2; i++) {
+        auto* blockTable = new SymbolTable(globalTable);
+        blockTable->addMapping(new string("v"), nullptr);
+        globalTable->addChild(blockTable);
+    }
+    return globalTable;
+}
+
+static void deleteSymbolTables(SymbolTable* globalTable) {
+    for (size_t i = 0; i < globalTable->getChildCount(); i++) {
+        delete globalTable->getChild(i);
+    }
+    delete globalTable;
+}
+
+static Campaign* makeCampaign(const Spec* spec, SymbolTable* symTable) {
+    return new Campaign(spec, symTable, TypeMap(),
+                        []() { return unique_ptr<FunctionFactory>(new SlowFactory()); });
+}
+
+class DeadlineTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    DeadlineTest(const string& name) : testName(name) {}
+    virtual ~DeadlineTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Structural cost grows with predicate size and nonlinear arithmetic
+*/
+class DeadlineTest1 : public DeadlineTest {
+public:
+    DeadlineTest1() : DeadlineTest("Static cost estimate") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        double f2 = DeadlineScheduler::staticCost(*spec->blocks[0]);
+        double set = DeadlineScheduler::staticCost(*spec->blocks[1]);
+        assert(f2 < set);
+
+        unique_ptr<API> linear = makeUnaryBlock("lin", "set_y",
+            TestUtils::makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(5)));
+        unique_ptr<API> square = makeUnaryBlock("sq", "set_y",
+            TestUtils::makeBinOp("Gt",
+                TestUtils::makeBinOp("Mul", make_unique<Var>("v"), make_unique<Var>("v")),
+                make_unique<Num>(5)));
+        double lin = DeadlineScheduler::staticCost(*linear);
+        double sq = DeadlineScheduler::staticCost(*square);
+        cout << "  f2 = " << f2 << ", set = " << set << ", v > 5: " << lin << ", v*v > 5: " << sq << endl;
+        assert(sq > lin + 5);
+
+        SymbolTable* symTable = makeSymbolTables();
+        unique_ptr<Campaign> campaign(makeCampaign(spec.get(), symTable));
+        DeadlineScheduler scheduler(*campaign, {}, 2.0);
+        assert(scheduler.estimateCost({ "set", "f2" }) == 2.0 * (set + f2));
+        assert(scheduler.estimateCost({ "set", "set" }) == 4.0 * set);
+        deleteSymbolTables(symTable);
+    }
+};
+
+/*
+Test 2: The pathological test string is preempted, the rest completes in budget
+*/
+class DeadlineTest2 : public DeadlineTest {
+public:
+    DeadlineTest2() : DeadlineTest("Preemption within the budget") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        SymbolTable* symTable = makeSymbolTables();
+        unique_ptr<Campaign> campaign(makeCampaign(spec.get(), symTable));
+        DeadlineScheduler scheduler(*campaign, { { "slow" }, { "f2" }, { "set" }, { "set", "f2" } });
+        double slowBefore = scheduler.getBlockCost(2);
+
+        double budget = 3000;
+        auto start = chrono::steady_clock::now();
+        vector<CampaignEntry> entries = scheduler.run(budget);
+        double took = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        assert(scheduler.getPreempted().size() == 1);
+        assert(scheduler.getPreempted()[0] == vector<string>{ "slow" });
+        assert(scheduler.getBlockCost(2) > slowBefore);
+
+        bool ranF2 = false, ranSet = false;
+        for (const auto& e : entries) {
+            assert(e.result.status == ReplayStatus::PASSED);
+            ranF2 = ranF2 || e.testString == vector<string>{ "f2" };
+            ranSet = ranSet || e.testString == vector<string>{ "set" };
+        }
+        assert(ranF2 && ranSet);
+
+        // One 300 ms call of slow() is the only overrun of a slice
+        cout << "  " << entries.size() << " completed in " << took << " ms, slow block estimate "
+             << slowBefore << " -> " << scheduler.getBlockCost(2) << " ms" << endl;
+        assert(took < 1500);
+        deleteSymbolTables(symTable);
+    }
+};
+
+/*
+Test 3: Nothing starts when no candidate fits in the budget
+*/
+class DeadlineTest3 : public DeadlineTest {
+public:
+    DeadlineTest3() : DeadlineTest("Budget too small") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = makeSpec();
+        SymbolTable* symTable = makeSymbolTables();
+        unique_ptr<Campaign> campaign(makeCampaign(spec.get(), symTable));
+        DeadlineScheduler scheduler(*campaign, { { "f2" }, { "set" } });
+
+        assert(scheduler.run(0).empty());
+        assert(scheduler.run(1).empty());
+        assert(scheduler.getPreempted().empty());
+        assert(campaign->getCoverage().count() == 0);
+        deleteSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<DeadlineTest*> testcases = {
+        new DeadlineTest1(),
+        new DeadlineTest2(),
+        new DeadlineTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Deadline Scheduler Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Deadline Scheduler Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+#include <iostream>
+#include <cassert>
+#include <mutex>
+#include <thread>
+#include "ast.hh"
+#include "../../tester/differential.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+/*
+Upgraded App1 with two regressions:
+    f1(a, b)     returns a + b + 1 when a > 100
+    set_y(13)    throws
+*/
+class OffByOne : public Function {
+    private:
+        int value;
+    public:
+        OffByOne(int v) : value(v) {}
+        unique_ptr<Expr> execute() override { return make_unique<Num>(value); }
+};
+
+class UpgradedFactory : public App1FunctionFactory {
+    public:
+        unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+            if (fname == "f1") {
+                int a = dynamic_cast<Num*>(args[0])->value;
+                int b = dynamic_cast<Num*>(args[1])->value;
+                if (a > 100) {
+                    return make_unique<OffByOne>(a + b + 1);
+                }
+            }
+            if (fname == "set_y" && dynamic_cast<Num*>(args[0])->value == 13) {
+                throw runtime_error("set_y: 13 is reserved");
+            }
+            return App1FunctionFactory::getFunction(fname, args);
+        }
+        unique_ptr<FunctionFactory> snapshot() override {
+            return make_unique<UpgradedFactory>(*this);
+        }
+};
+
+/*
+Records which SUT resolved each API call, and on which thread
+*/
+struct CallLog {
+    mutex m;
+    vector<pair<int, thread::id>> calls;
+};
+
+class LoggingFactory : public App1FunctionFactory {
+    private:
+        CallLog& log;
+        int side;
+    public:
+        LoggingFactory(CallLog& log, int side) : log(log), side(side) {}
+        unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+            {
+                lock_guard<mutex> lock(log.m);
+                log.calls.push_back({ side, this_thread::get_id() });
+            }
+            return App1FunctionFactory::getFunction(fname, args);
+        }
+};
+
+/*
+CTC:
+    y := 0
+    v := value
+    r0 := set_y(v)
+    r1 := get_y()
+    r2 := f1(r1, 1)
+    assert(r2 == v + 1)
+*/
+static unique_ptr<Program> makeCTC(int value) {
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(make_unique<Assign>(make_unique<Var>("y"), make_unique<Num>(0)));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("v"), make_unique<Num>(value)));
+    vector<unique_ptr<Expr>> setArgs;
+    setArgs.push_back(make_unique<Var>("v"));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("r0"),
+        make_unique<FuncCall>("set_y", std::move(setArgs))));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("r1"),
+        make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{})));
+    vector<unique_ptr<Expr>> f1Args;
+    f1Args.push_back(make_unique<Var>("r1"));
+    f1Args.push_back(make_unique<Num>(1));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("r2"),
+        make_unique<FuncCall>("f1", std::move(f1Args))));
+    statements.push_back(make_unique<Assert>(TestUtils::makeBinOp("Eq", make_unique<Var>("r2"),
+        TestUtils::makeBinOp("Add", make_unique<Var>("v"), make_unique<Num>(1)))));
+    return make_unique<Program>(std::move(statements));
+}
+
+class DifferentialTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    DifferentialTest(const string& name) : testName(name) {}
+    virtual ~DifferentialTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Identical SUTs never diverge
+*/
+class DifferentialTest1 : public DifferentialTest {
+public:
+    DifferentialTest1() : DifferentialTest("Identical SUTs") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Program>> ctcs;
+        for (int v : { 1, 7, 13, 150, -4, 42 }) {
+            ctcs.push_back(makeCTC(v));
+        }
+        DifferentialRunner runner(
+            []() { return unique_ptr<FunctionFactory>(new App1FunctionFactory()); },
+            []() { return unique_ptr<FunctionFactory>(new App1FunctionFactory()); }, 3);
+        vector<DifferentialResult> results = runner.run(ctcs);
+        DifferentialRunner::printReport(results);
+
+        assert(results.size() == ctcs.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            assert(results[i].testId == i);
+            assert(!results[i].diverged);
+            assert(results[i].stmtIndex == -1);
+            assert(results[i].reference.status == ReplayStatus::PASSED);
+            assert(results[i].candidate.status == ReplayStatus::PASSED);
+        }
+    }
+};
+
+/*
+Test 2: The first divergence is reported: a differing result, and a call the
+candidate never reaches
+*/
+class DifferentialTest2 : public DifferentialTest {
+public:
+    DifferentialTest2() : DifferentialTest("Divergences against an upgraded SUT") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Program>> ctcs;
+        ctcs.push_back(makeCTC(7));
+        ctcs.push_back(makeCTC(150));
+        ctcs.push_back(makeCTC(13));
+        DifferentialRunner runner(
+            []() { return unique_ptr<FunctionFactory>(new App1FunctionFactory()); },
+            []() { return unique_ptr<FunctionFactory>(new UpgradedFactory()); }, 2);
+        vector<DifferentialResult> results = runner.run(ctcs);
+        DifferentialRunner::printReport(results);
+
+        assert(!results[0].diverged);
+
+        // f1(150, 1): 151 vs 152, and the candidate's assert fails as well
+        assert(results[1].diverged);
+        assert(results[1].stmtIndex == 4);
+        assert(results[1].referenceValue == "151");
+        assert(results[1].candidateValue == "152");
+        assert(results[1].reference.status == ReplayStatus::PASSED);
+        assert(results[1].candidate.status == ReplayStatus::FAILED);
+
+        // set_y(13) throws in the candidate: the reference's call has no partner
+        assert(results[2].diverged);
+        assert(results[2].stmtIndex == 2);
+        assert(results[2].referenceValue == "13");
+        assert(results[2].candidateValue.find("ERROR") != string::npos);
+        assert(results[2].candidate.status == ReplayStatus::ERROR);
+    }
+};
+
+/*
+Test 3: The two SUTs run on different threads, never more than one API call
+apart
+*/
+class DifferentialTest3 : public DifferentialTest {
+public:
+    DifferentialTest3() : DifferentialTest("Lockstep on two threads") {}
+
+protected:
+    void run() override {
+        CallLog log;
+        LoggingFactory reference(log, 0), candidate(log, 1);
+        unique_ptr<Program> ctc = makeCTC(9);
+        DifferentialResult result = DifferentialRunner::compare(*ctc, reference, candidate);
+        assert(!result.diverged);
+
+        size_t count[2] = { 0, 0 };
+        thread::id ids[2];
+        assert(log.calls.size() == 6);
+        for (const auto& call : log.calls) {
+            count[call.first]++;
+            ids[call.first] = call.second;
+            long gap = long(count[0]) - long(count[1]);
+            assert(gap <= 1 && gap >= -1);
+        }
+        assert(ids[0] != ids[1]);
+        assert(ids[1] == this_thread::get_id());
+        cout << "  6 API calls, sides never more than one call apart" << endl;
+    }
+};
+
+int main() {
+    vector<DifferentialTest*> testcases = {
+        new DifferentialTest1(),
+        new DifferentialTest2(),
+        new DifferentialTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Differential Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Differential Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "ast.hh"
+#include "exprwalk.hh"
+#include "clonevisitor.hh"
+#include "symvar.hh"
+#include "see.hh"
+#include "z3solver.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+// Deep enough to overflow the call stack with one frame per level
+static const size_t DEPTH = 200000;
+
+// And(c(0), And(c(1), ... c(n-1))), built from the innermost conjunct out
+template <typename MakeConjunct>
+static unique_ptr<Expr> chain(const string& op, size_t n, MakeConjunct c) {
+    unique_ptr<Expr> result = c(n - 1);
+    for (size_t i = n - 1; i-- > 0;) {
+        result = TestUtils::makeBinOp(op, c(i), std::move(result));
+    }
+    return result;
+}
+
+static unique_ptr<Expr> gt(unsigned int symVar, int bound) {
+    return TestUtils::makeBinOp("Gt", make_unique<SymVar>(symVar), make_unique<Num>(bound));
+}
+
+class ExprWalkTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    ExprWalkTest(const string& name) : testName(name) {}
+    virtual ~ExprWalkTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Visit order, pruning and folding on a small tree
+    Add(x, Sub(3, {y -> 4}))
+*/
+class ExprWalkTest1 : public ExprWalkTest {
+public:
+    ExprWalkTest1() : ExprWalkTest("Walk and fold order") {}
+
+protected:
+    void run() override {
+        vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+        entries.emplace_back(make_unique<Var>("y"), make_unique<Num>(4));
+        unique_ptr<Expr> e = TestUtils::makeBinOp("Add", make_unique<Var>("x"),
+            TestUtils::makeBinOp("Sub", make_unique<Num>(3), make_unique<Map>(std::move(entries))));
+
+        auto name = [](const Expr& node) -> string {
+            switch (node.exprType) {
+                case ExprType::FUNCCALL: return dynamic_cast<const FuncCall&>(node).name;
+                case ExprType::VAR: return dynamic_cast<const Var&>(node).name;
+                case ExprType::NUM: return to_string(dynamic_cast<const Num&>(node).value);
+                case ExprType::MAP: return "map";
+                default: return "?";
+            }
+        };
+
+        string order;
+        bool stopped = walkExpr(*e, [&](const Expr& node) {
+            order += name(node) + " ";
+            return WalkAction::DESCEND;
+        });
+        assert(!stopped);
+        assert(order == "Add x Sub 3 map 4 ");
+
+        order.clear();
+        stopped = walkExpr(*e, [&](const Expr& node) {
+            order += name(node) + " ";
+            return node.exprType == ExprType::NUM ? WalkAction::STOP : WalkAction::DESCEND;
+        });
+        assert(stopped && order == "Add x Sub 3 ");
+
+        order.clear();
+        walkExpr(*e, [&](const Expr& node) {
+            order += name(node) + " ";
+            return name(node) == "Sub" ? WalkAction::SKIP : WalkAction::DESCEND;
+        });
+        assert(order == "Add x Sub ");
+        cout << "  Pre-order walk with STOP and SKIP" << endl;
+
+        string printed = foldExpr<string>(*e, [&](const Expr& node, vector<string>& children) {
+            string s = name(node);
+            if (node.exprType == ExprType::MAP) {
+                return "{" + dynamic_cast<const Map&>(node).value[0].first->name + " -> " + children[0] + "}";
+            }
+            if (!children.empty()) {
+                s += "(" + children[0];
+                for (size_t i = 1; i < children.size(); i++) s += ", " + children[i];
+                s += ")";
+            }
+            return s;
+        });
+        assert(printed == "Add(x, Sub(3, {y -> 4}))");
+        cout << "  Post-order fold: " << printed << endl;
+
+        CloneVisitor cloner;
+        unique_ptr<Expr> copy = cloner.cloneExpr(e.get());
+        assert(TestUtils::exprToString(copy.get()) == TestUtils::exprToString(e.get()));
+        assert(SEE::termSize(*copy) == 7);
+        assert(SEE::termSize(*copy, 3) == 4);
+    }
+};
+
+/*
+Test 2: A 200000-deep chain is cloned, measured, split and freed
+*/
+class ExprWalkTest2 : public ExprWalkTest {
+public:
+    ExprWalkTest2() : ExprWalkTest("Clone and free a deep chain") {}
+
+protected:
+    void run() override {
+        unique_ptr<Expr> deep = chain("And", DEPTH, [](size_t i) { return gt(i % 4, int(i % 3)); });
+        CloneVisitor cloner;
+        unique_ptr<Expr> copy = cloner.cloneExpr(deep.get());
+        assert(SEE::termSize(*copy) == SEE::termSize(*deep));
+        assert(SEE::termSize(*deep) == DEPTH * 3 + DEPTH - 1);
+
+        size_t depth = 0;
+        for (const Expr* e = copy.get(); e->exprType == ExprType::FUNCCALL &&
+             dynamic_cast<const FuncCall*>(e)->name == "And";
+             e = dynamic_cast<const FuncCall*>(e)->args[1].get()) {
+            depth++;
+        }
+        assert(depth == DEPTH - 1);
+        cout << "  Cloned " << SEE::termSize(*copy) << " nodes, depth " << depth << endl;
+
+        vector<const Expr*> conjuncts;
+        flattenAnd(static_cast<const Expr&>(*copy), conjuncts);
+        assert(conjuncts.size() == DEPTH);
+        assert(conjuncts.front() == dynamic_cast<const FuncCall&>(*copy).args[0].get());
+        copy.reset();
+        deep.reset();
+        cout << "  Freed both chains" << endl;
+    }
+};
+
+/*
+Test 3: A 200000-assumption path constraint is built and solved
+*/
+class ExprWalkTest3 : public ExprWalkTest {
+public:
+    ExprWalkTest3() : ExprWalkTest("Solve a deep path constraint") {}
+
+protected:
+    void run() override {
+        App1FunctionFactory factory;
+        SEE see(&factory);
+        for (size_t i = 0; i < DEPTH; i++) {
+            see.getPathConstraint().push_back(gt(i % 4, int(i % 50)).release());
+        }
+        unique_ptr<Expr> pc = see.computePathConstraint();
+
+        Z3Solver solver;
+        Result result = solver.solve(std::move(pc));
+        assert(result.isSat);
+        for (unsigned int k = 0; k < 4; k++) {
+            const auto& value = result.model.at("X" + to_string(k));
+            assert(dynamic_cast<const IntResultValue*>(value.get())->value >= 49);
+        }
+        assert(solver.getTemplateHits() >= DEPTH - 50);
+        cout << "  " << DEPTH << " conjuncts solved, " << solver.getTemplateHits() << " template hits" << endl;
+
+        // One deep term (no conjuncts to split) goes through the translator
+        unique_ptr<Expr> disjunction = chain("Or", DEPTH, [](size_t i) { return gt(0, int(i)); });
+        Z3InputMaker maker;
+        z3::expr term = maker.makeZ3Input(disjunction);
+        assert(term.is_bool());
+        cout << "  Translated a " << DEPTH << "-deep disjunction" << endl;
+        for (Expr* c : see.getPathConstraint()) {
+            delete c;
+        }
+        see.getPathConstraint().clear();
+    }
+};
+
+/*
+Test 4: Shape keys rename SymVars, tell trees apart and handle deep chains
+*/
+class ExprWalkTest4 : public ExprWalkTest {
+public:
+    ExprWalkTest4() : ExprWalkTest("Shape keys") {}
+
+protected:
+    static string key(const Expr& e, vector<unsigned int>* slots = nullptr) {
+        string k;
+        shapeKey(e, k, slots);
+        return k;
+    }
+
+    static unique_ptr<Expr> call(const string& name, vector<unique_ptr<Expr>> args) {
+        return make_unique<FuncCall>(name, std::move(args));
+    }
+
+    void run() override {
+        vector<unsigned int> slots5, slots9;
+        assert(key(*gt(5, 3), &slots5) == key(*gt(9, 3), &slots9));
+        assert(slots5 == vector<unsigned int>{ 5 } && slots9 == vector<unsigned int>{ 9 });
+        assert(key(*gt(5, 3)) != key(*gt(5, 4)));
+
+        auto add = [](unsigned int a, unsigned int b) {
+            return TestUtils::makeBinOp("Add", make_unique<SymVar>(a), make_unique<SymVar>(b));
+        };
+        vector<unsigned int> s12, s21, s11;
+        assert(key(*add(1, 2), &s12) == key(*add(2, 1), &s21));
+        assert(s21 == (vector<unsigned int>{ 2, 1 }));
+        assert(key(*add(1, 1), &s11) != key(*add(1, 2)));
+        // Without slots every SymVar is the same
+        assert(key(*add(1, 1)) == key(*add(1, 2)));
+
+        // f(g(a), b) and f(g(a, b)) have the same nodes in the same order
+        vector<unique_ptr<Expr>> inner1, outer1, inner2, outer2;
+        inner1.push_back(make_unique<Var>("a"));
+        outer1.push_back(call("g", std::move(inner1)));
+        outer1.push_back(make_unique<Var>("b"));
+        inner2.push_back(make_unique<Var>("a"));
+        inner2.push_back(make_unique<Var>("b"));
+        outer2.push_back(call("g", std::move(inner2)));
+        assert(key(*call("f", std::move(outer1))) != key(*call("f", std::move(outer2))));
+
+        unique_ptr<Expr> deep = chain("And", DEPTH, [](size_t i) { return gt(i % 4, int(i % 3)); });
+        vector<unsigned int> slots;
+        string k = key(*deep, &slots);
+        assert(slots.size() == 4);
+        cout << "  Key of a " << DEPTH << "-deep chain: " << k.size() << " bytes" << endl;
+    }
+};
+
+int main() {
+    vector<ExprWalkTest*> testcases = {
+        new ExprWalkTest1(),
+        new ExprWalkTest2(),
+        new ExprWalkTest3(),
+        new ExprWalkTest4()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Expression Walk Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Expression Walk Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+#include <iostream>
+#include <cassert>
+#include <csignal>
+#include "ast.hh"
+#include "../../tester/forkserver.hh"
+#include "../../tester/replay.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+static ReplayRunner::FactoryMaker app1Maker() {
+    return []() { return unique_ptr<FunctionFactory>(new App1FunctionFactory()); };
+}
+
+static unique_ptr<Stmt> call(const string& var, const string& fname, vector<int> args) {
+    vector<unique_ptr<Expr>> exprs;
+    for (int a : args) {
+        exprs.push_back(make_unique<Num>(a));
+    }
+    return make_unique<Assign>(make_unique<Var>(var), make_unique<FuncCall>(fname, std::move(exprs)));
+}
+
+static unique_ptr<Stmt> assertEq(const string& var, int value) {
+    return make_unique<Assert>(TestUtils::makeBinOp("Eq", make_unique<Var>(var), make_unique<Num>(value)));
+}
+
+static unique_ptr<Program> program(vector<unique_ptr<Stmt>> statements) {
+    return make_unique<Program>(std::move(statements));
+}
+
+static size_t totalStatements(const vector<unique_ptr<Program>>& ctcs) {
+    size_t n = 0;
+    for (const auto& ctc : ctcs) {
+        n += ctc->statements.size();
+    }
+    return n;
+}
+
+class ForkServerTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    ForkServerTest(const string& name) : testName(name) {}
+    virtual ~ForkServerTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: CTCs sharing the prefix set_y(5); results match replaying each CTC on
+a fresh SUT, and a child's set_y(7) is not seen by its siblings
+    0: s := set_y(5); t := set_y(7); r := get_y(); assert(r = 7)   PASSED
+    1: s := set_y(5); r := get_y(); assert(r = 5)                  PASSED
+    2: s := set_y(5); r := get_y(); assert(r = 6)                  FAILED at 2
+    3: s := set_y(5); assume(1 > 2)                                INFEASIBLE at 1
+    4: s := set_y(5)                                               PASSED
+*/
+class ForkServerTest1 : public ForkServerTest {
+public:
+    ForkServerTest1() : ForkServerTest("Shared prefixes match one-by-one replay") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Program>> ctcs;
+        {
+            vector<unique_ptr<Stmt>> s;
+            s.push_back(call("s", "set_y", { 5 }));
+            s.push_back(call("t", "set_y", { 7 }));
+            s.push_back(call("r", "get_y", {}));
+            s.push_back(assertEq("r", 7));
+            ctcs.push_back(program(std::move(s)));
+        }
+        for (int expected : { 5, 6 }) {
+            vector<unique_ptr<Stmt>> s;
+            s.push_back(call("s", "set_y", { 5 }));
+            s.push_back(call("r", "get_y", {}));
+            s.push_back(assertEq("r", expected));
+            ctcs.push_back(program(std::move(s)));
+        }
+        {
+            vector<unique_ptr<Stmt>> s;
+            s.push_back(call("s", "set_y", { 5 }));
+            s.push_back(make_unique<Assume>(
+                TestUtils::makeBinOp("Gt", make_unique<Num>(1), make_unique<Num>(2))));
+            ctcs.push_back(program(std::move(s)));
+        }
+        {
+            vector<unique_ptr<Stmt>> s;
+            s.push_back(call("s", "set_y", { 5 }));
+            ctcs.push_back(program(std::move(s)));
+        }
+
+        ForkServer server(app1Maker());
+        vector<ReplayResult> results = server.run(ctcs);
+        ReplayRunner runner(app1Maker(), 1);
+        vector<ReplayResult> expected = runner.run(ctcs);
+
+        assert(results.size() == ctcs.size());
+        for (size_t i = 0; i < ctcs.size(); i++) {
+            cout << "CTC " << i << ": " << replayStatusToString(results[i].status)
+                 << " " << results[i].message << endl;
+            assert(results[i].testId == i);
+            assert(results[i].status == expected[i].status);
+            assert(results[i].stmtIndex == expected[i].stmtIndex);
+        }
+        assert(results[0].status == ReplayStatus::PASSED);
+        assert(results[1].status == ReplayStatus::PASSED);
+        assert(results[2].status == ReplayStatus::FAILED && results[2].stmtIndex == 2);
+        assert(results[3].status == ReplayStatus::INFEASIBLE && results[3].stmtIndex == 1);
+        assert(results[4].status == ReplayStatus::PASSED);
+
+        // set_y(5) once, get_y() once for CTCs 1 and 2
+        cout << "statements: " << server.getStatementsExecuted() << " of "
+             << totalStatements(ctcs) << ", forks: " << server.getForks() << endl;
+        assert(server.getStatementsExecuted() == 8);
+        assert(totalStatements(ctcs) == 13);
+        assert(server.getForks() == 4);
+    }
+};
+
+/*
+Test 2: A SUT that crashes takes down only the CTCs of its process
+    0: s := set_y(1); c := crash()                 ERROR (killed by a signal)
+    1: s := set_y(1); r := get_y(); assert(r = 1)  PASSED
+    2: s := set_y(1); c := crash()                 ERROR
+*/
+class CrashingFunction : public Function {
+public:
+    unique_ptr<Expr> execute() override {
+        raise(SIGKILL);
+        return nullptr;
+    }
+};
+
+class CrashingFactory : public App1FunctionFactory {
+public:
+    unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+        if (fname == "crash") {
+            return make_unique<CrashingFunction>();
+        }
+        return App1FunctionFactory::getFunction(fname, args);
+    }
+};
+
+class ForkServerTest2 : public ForkServerTest {
+public:
+    ForkServerTest2() : ForkServerTest("Crashing SUT is isolated") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Program>> ctcs;
+        for (int i = 0; i < 3; i++) {
+            vector<unique_ptr<Stmt>> s;
+            s.push_back(call("s", "set_y", { 1 }));
+            if (i == 1) {
+                s.push_back(call("r", "get_y", {}));
+                s.push_back(assertEq("r", 1));
+            } else {
+                s.push_back(call("c", "crash", {}));
+            }
+            ctcs.push_back(program(std::move(s)));
+        }
+
+        ForkServer server([]() { return unique_ptr<FunctionFactory>(new CrashingFactory()); });
+        vector<ReplayResult> results = server.run(ctcs);
+        for (size_t i = 0; i < ctcs.size(); i++) {
+            cout << "CTC " << i << ": " << replayStatusToString(results[i].status)
+                 << " " << results[i].message << endl;
+        }
+        assert(results[0].status == ReplayStatus::ERROR);
+        assert(results[0].message.find("signal") != string::npos);
+        assert(results[1].status == ReplayStatus::PASSED);
+        assert(results[2].status == ReplayStatus::ERROR);
+    }
+};
+
+/*
+Test 3: Many CTCs with a long common prefix; the prefix runs once
+    set_y(0); set_y(1); ... set_y(19); r := get_y(); assert(r = k), k = 10..19
+Only the last CTC passes.
+*/
+class ForkServerTest3 : public ForkServerTest {
+public:
+    ForkServerTest3() : ForkServerTest("Long shared prefix executed once") {}
+
+protected:
+    void run() override {
+        const int PREFIX = 20;
+        const int SUFFIXES = 10;
+        vector<unique_ptr<Program>> ctcs;
+        for (int k = 0; k < SUFFIXES; k++) {
+            vector<unique_ptr<Stmt>> s;
+            for (int i = 0; i < PREFIX; i++) {
+                s.push_back(call("s" + to_string(i), "set_y", { i }));
+            }
+            s.push_back(call("r", "get_y", {}));
+            s.push_back(assertEq("r", PREFIX - SUFFIXES + k));
+            ctcs.push_back(program(std::move(s)));
+        }
+
+        ForkServer server(app1Maker());
+        vector<ReplayResult> results = server.run(ctcs);
+        size_t passed = 0;
+        for (const auto& r : results) {
+            passed += r.status == ReplayStatus::PASSED;
+        }
+        cout << "statements: " << server.getStatementsExecuted() << " of "
+             << totalStatements(ctcs) << ", forks: " << server.getForks() << endl;
+        assert(passed == 1);
+        assert(results[SUFFIXES - 1].status == ReplayStatus::PASSED);
+        assert(results[0].status == ReplayStatus::FAILED && results[0].stmtIndex == PREFIX + 1);
+        assert(server.getStatementsExecuted() == size_t(PREFIX + 1 + SUFFIXES));
+        assert(server.getForks() == size_t(SUFFIXES));
+    }
+};
+
+int main() {
+    vector<ForkServerTest*> testcases = {
+        new ForkServerTest1(),
+        new ForkServerTest2(),
+        new ForkServerTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Fork Server Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Fork Server Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -466,9 +466,9 @@ protected:
         // 2. u0 := input()            (input)
         // 3. p0 := input()            (input)
         // 4. assume(not_in(u0, U))    (precondition)
-        // 5. U_old = U                (save old state for primed variable)
+        // 5. U_old_1 = U              (first version of the primed variable)
         // 6. _result0 = signup(u0, p0) (API call)
-        // 7. assert(U = U_old union {u0 -> p0}) (postcondition with primes removed)
+        // 7. assert(U = U_old_1 union {u0 -> p0}) (postcondition with primes removed)
 
         cout << "  Generated " << atc.statements.size() << " statements" << endl;
         assert(atc.statements.size() >= 7);
@@ -479,12 +479,12 @@ protected:
             const Assign* assign = dynamic_cast<const Assign*>(atc.statements[i].get());
             if (assign && assign->left->exprType == ExprType::VAR) {
                 const Var* leftVar = dynamic_cast<const Var*>(assign->left.get());
-                if (leftVar && leftVar->name == "U_old") {
+                if (leftVar && leftVar->name == "U_old_1") {
                     foundUold = true;
                     assert(assign->right->exprType == ExprType::VAR);
                     const Var* rightVar = dynamic_cast<const Var*>(assign->right.get());
                     assert(rightVar->name == "U");
-                    cout << "  ✓ U_old = U assignment verified" << endl;
+                    cout << "  ✓ U_old_1 = U assignment verified" << endl;
                     break;
                 }
             }
@@ -693,6 +693,65 @@ protected:
     }
 };
 
+/**
+ * Test 5: Repeated state transitions
+ * Every block priming U gets its own version of the old state, bound once
+ */
+class GenATCTest5 : public GenATCTest3 {
+public:
+    GenATCTest5() {
+        testName = "Repeated primed variables - one version per block";
+    }
+
+protected:
+    vector<string> makeTestString() override {
+        return {"signup", "signup"};
+    }
+
+    static bool mentions(const Expr& e, const string& name) {
+        if (e.exprType == ExprType::VAR) {
+            return dynamic_cast<const Var&>(e).name == name;
+        }
+        if (e.exprType == ExprType::FUNCCALL) {
+            for (const auto& arg : dynamic_cast<const FuncCall&>(e).args) {
+                if (mentions(*arg, name)) return true;
+            }
+        }
+        if (e.exprType == ExprType::TUPLE) {
+            for (const auto& elem : dynamic_cast<const Tuple&>(e).exprs) {
+                if (mentions(*elem, name)) return true;
+            }
+        }
+        return false;
+    }
+
+    void verify(const Program& atc) override {
+        vector<string> versions;
+        for (const auto& stmt : atc.statements) {
+            const Assign* assign = dynamic_cast<const Assign*>(stmt.get());
+            if (assign && assign->left->exprType == ExprType::VAR) {
+                const string& name = dynamic_cast<const Var*>(assign->left.get())->name;
+                if (name.compare(0, 6, "U_old_") == 0) {
+                    assert(assign->right->exprType == ExprType::VAR);
+                    assert(dynamic_cast<const Var*>(assign->right.get())->name == "U");
+                    versions.push_back(name);
+                }
+            }
+        }
+        assert(versions.size() == 2);
+        assert(versions[0] == "U_old_1");
+        assert(versions[1] == "U_old_2");
+        cout << "  ✓ Versions U_old_1, U_old_2 each bound once" << endl;
+
+        // The second postcondition refers to the second version
+        const Assert* last = dynamic_cast<const Assert*>(atc.statements.back().get());
+        assert(last != nullptr);
+        assert(mentions(*last->expr, "U_old_2"));
+        assert(!mentions(*last->expr, "U_old_1"));
+        cout << "  ✓ Second postcondition uses U_old_2" << endl;
+    }
+};
+
 /**
  * Main test runner
  */
@@ -701,7 +760,8 @@ int main() {
         new GenATCTest1(),
         new GenATCTest2(),
         new GenATCTest3(),
-        new GenATCTest4()
+        new GenATCTest4(),
+        new GenATCTest5()
     };
 
     cout << "\n========================================" << endl;
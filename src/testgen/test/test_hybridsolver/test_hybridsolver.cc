@@ -0,0 +1,507 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "ast.hh"
+#include "env.hh"
+#include "symvar.hh"
+#include "exprwalk.hh"
+#include "../../see/batchevaluator.hh"
+#include "../../see/concreteevaluator.hh"
+#include "../../see/hybridsolver.hh"
+#include "../../see/z3solver.hh"
+#include "../../tester/tester.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+// Z3 solver that counts how often it is asked
+class CountingSolver : public Solver {
+    private:
+        Z3Solver z3;
+    public:
+        mutable int calls = 0;
+        mutable unsigned int lastTimeout = 0;
+        Result solve(unique_ptr<Expr> formula) const override {
+            calls++;
+            lastTimeout = 0;
+            return z3.solve(std::move(formula));
+        }
+        Result solveWithin(unique_ptr<Expr> formula, unsigned int timeoutMs) const override {
+            calls++;
+            lastTimeout = timeoutMs;
+            return z3.solveWithin(std::move(formula), timeoutMs);
+        }
+};
+
+class HybridSolverTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    HybridSolverTest(const string& name) : testName(name) {}
+    virtual ~HybridSolverTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: A loose constraint is satisfied by random inputs, no solver call
+    X > 0 AND Y < 50
+*/
+class HybridSolverTest1 : public HybridSolverTest {
+public:
+    HybridSolverTest1() : HybridSolverTest("Loose constraint solved by sampling") {}
+
+protected:
+    void run() override {
+        CountingSolver z3;
+        HybridSolver hybrid(z3, 32, 100, 0.05, 1);
+
+        auto c1 = TestUtils::makeBinOp("Gt", make_unique<SymVar>(1000), make_unique<Num>(0));
+        auto c2 = TestUtils::makeBinOp("Lt", make_unique<SymVar>(1001), make_unique<Num>(50));
+        Result result = hybrid.solve(vector<Expr*>{ c1.get(), c2.get() });
+
+        assert(result.isSat);
+        int xv = dynamic_cast<const IntResultValue*>(result.model.at("X1000").get())->value;
+        int yv = dynamic_cast<const IntResultValue*>(result.model.at("X1001").get())->value;
+        cout << "  X1000 = " << xv << ", X1001 = " << yv << endl;
+        assert(xv > 0 && yv < 50);
+        assert(z3.calls == 0);
+        assert(hybrid.getRandomHits() == 1);
+        assert(hybrid.getStats().count(HybridSolver::shapeKey(*c1)) == 1);
+    }
+};
+
+/*
+Test 2: An unsatisfiable constraint falls back to the solver; once its
+block keeps failing, sampling is skipped altogether.
+    X * X == 2
+*/
+class HybridSolverTest2 : public HybridSolverTest {
+public:
+    HybridSolverTest2() : HybridSolverTest("Fallback and adaptive skip") {}
+
+protected:
+    void run() override {
+        CountingSolver z3;
+        HybridSolver hybrid(z3, 32, 100, 0.05, 1);
+
+        for (int round = 0; round < 3; round++) {
+            // Fresh SymVar number each round, same block shape
+            auto c = TestUtils::makeBinOp("Eq",
+                TestUtils::makeBinOp("Mul", make_unique<SymVar>(2000 + round),
+                                            make_unique<SymVar>(2000 + round)),
+                make_unique<Num>(2));
+            Result result = hybrid.solve(vector<Expr*>{ c.get() });
+            assert(!result.isSat);
+        }
+
+        cout << "  Solver calls: " << z3.calls
+             << ", skipped sampling: " << hybrid.getSkippedSampling() << endl;
+        assert(z3.calls == 3);
+        assert(hybrid.getFallbackCalls() == 3);
+        assert(hybrid.getSkippedSampling() == 2);
+        assert(hybrid.getStats().begin()->second.trials == 32);
+    }
+};
+
+/*
+Test 3: Tester with a hybrid solver
+Program:
+    x := input()
+    z := input()
+    assume(x > 5 AND z > 0)
+    r := f1(x, z)
+*/
+class HybridSolverTest3 : public HybridSolverTest {
+public:
+    HybridSolverTest3() : HybridSolverTest("Tester uses random inputs") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(TestUtils::makeInputAssign("z"));
+        statements.push_back(make_unique<Assume>(TestUtils::makeBinOp("And",
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(5)),
+            TestUtils::makeBinOp("Gt", make_unique<Var>("z"), make_unique<Num>(0)))));
+        vector<unique_ptr<Expr>> args;
+        args.push_back(make_unique<Var>("x"));
+        args.push_back(make_unique<Var>("z"));
+        statements.push_back(make_unique<Assign>(make_unique<Var>("r"),
+            make_unique<FuncCall>("f1", std::move(args))));
+
+        App1FunctionFactory factory;
+        CountingSolver z3;
+        HybridSolver hybrid(z3, 32, 100, 0.05, 7);
+        Tester tester(&factory);
+        tester.setHybridSolver(&hybrid);
+        ValueEnvironment ve(nullptr);
+        unique_ptr<Program> ctc = tester.generateCTC(
+            make_unique<Program>(std::move(statements)), {}, &ve);
+
+        const Assign& xAssign = dynamic_cast<const Assign&>(*ctc->statements[0]);
+        const Assign& zAssign = dynamic_cast<const Assign&>(*ctc->statements[1]);
+        int xv = dynamic_cast<const Num&>(*xAssign.right).value;
+        int zv = dynamic_cast<const Num&>(*zAssign.right).value;
+        cout << "  x = " << xv << ", z = " << zv << endl;
+        assert(xv > 5 && zv > 0);
+        assert(z3.calls == 0);
+    }
+};
+
+/*
+Test 4: The batch kernel agrees with the ConcreteEvaluator row by row
+    (X + Y * 3 > 10 OR X - Y == 0) AND (X < 0 => Y / 7 != 2) AND NOT(X >= 90)
+*/
+class HybridSolverTest4 : public HybridSolverTest {
+public:
+    HybridSolverTest4() : HybridSolverTest("Batch kernel matches concrete evaluation") {}
+
+protected:
+    void run() override {
+        auto c = TestUtils::makeBinOp("And",
+            TestUtils::makeBinOp("And",
+                TestUtils::makeBinOp("Or",
+                    TestUtils::makeBinOp("Gt",
+                        TestUtils::makeBinOp("Add", make_unique<SymVar>(1),
+                            TestUtils::makeBinOp("Mul", make_unique<SymVar>(2), make_unique<Num>(3))),
+                        make_unique<Num>(10)),
+                    TestUtils::makeBinOp("Eq",
+                        TestUtils::makeBinOp("Sub", make_unique<SymVar>(1), make_unique<SymVar>(2)),
+                        make_unique<Num>(0))),
+                TestUtils::makeBinOp("Implies",
+                    TestUtils::makeBinOp("Lt", make_unique<SymVar>(1), make_unique<Num>(0)),
+                    TestUtils::makeBinOp("Neq",
+                        TestUtils::makeBinOp("Div", make_unique<SymVar>(2), make_unique<Num>(7)),
+                        make_unique<Num>(2)))),
+            make_unique<FuncCall>("Not", [] {
+                vector<unique_ptr<Expr>> args;
+                args.push_back(TestUtils::makeBinOp("Ge", make_unique<SymVar>(1), make_unique<Num>(90)));
+                return args;
+            }()));
+
+        BatchEvaluator kernel;
+        assert(kernel.compile(*c));
+        assert(kernel.getInputs().size() == 2);
+
+        // 1003 rows: several full tiles plus a partial one
+        InputBatch batch;
+        batch.rows = 1003;
+        mt19937 rng(3);
+        uniform_int_distribution<int> dist(-100, 100);
+        for (unsigned int num : { 1u, 2u }) {
+            for (size_t r = 0; r < batch.rows; r++) {
+                batch.columns[num].push_back(dist(rng));
+            }
+        }
+        vector<uint8_t> mask = kernel.evaluate(batch);
+
+        ConcreteEvaluator evaluator;
+        ConcValEnv env(nullptr);
+        map<unsigned int, int> values;
+        evaluator.setSymVarValues(&values);
+        size_t satisfied = 0;
+        for (size_t r = 0; r < batch.rows; r++) {
+            values[1] = batch.columns[1][r];
+            values[2] = batch.columns[2][r];
+            assert(mask[r] == (evaluator.evaluateBool(*c, env) ? 1 : 0));
+            satisfied += mask[r];
+        }
+        cout << "  " << satisfied << "/" << batch.rows << " rows satisfied, all agree" << endl;
+    }
+};
+
+/*
+Test 5: Division by zero and INT32_MIN / -1 reject the row; unsupported
+constraints do not compile
+*/
+class HybridSolverTest5 : public HybridSolverTest {
+public:
+    HybridSolverTest5() : HybridSolverTest("Batch kernel edge cases") {}
+
+protected:
+    void run() override {
+        auto c = TestUtils::makeBinOp("Ge",
+            TestUtils::makeBinOp("Div", make_unique<Num>(10), make_unique<SymVar>(1)),
+            make_unique<Num>(0));
+        BatchEvaluator kernel;
+        assert(kernel.compile(*c));
+        InputBatch batch;
+        batch.rows = 3;
+        batch.columns[1] = { 5, 0, -5 };
+        vector<uint8_t> mask = kernel.evaluate(batch);
+        assert(mask[0] == 1 && mask[1] == 0 && mask[2] == 0);
+
+        // Would trap (SIGFPE) if evaluated
+        auto overflow = TestUtils::makeBinOp("Ge",
+            TestUtils::makeBinOp("Div", make_unique<SymVar>(1), make_unique<SymVar>(2)),
+            make_unique<Num>(0));
+        BatchEvaluator divider;
+        assert(divider.compile(*overflow));
+        InputBatch pairs;
+        pairs.rows = 3;
+        pairs.columns[1] = { INT32_MIN, INT32_MIN, 6 };
+        pairs.columns[2] = { -1, 1, 2 };
+        mask = divider.evaluate(pairs);
+        assert(mask[0] == 0 && mask[1] == 0 && mask[2] == 1);
+
+        BatchEvaluator unsupported;
+        auto named = TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(0));
+        assert(!unsupported.compile(*named));
+        auto member = TestUtils::makeBinOp("in", make_unique<SymVar>(1), make_unique<Set>(vector<unique_ptr<Expr>>{}));
+        assert(!unsupported.compile(*member));
+        cout << "  Division by zero, INT32_MIN / -1 and unsupported constraints handled" << endl;
+    }
+};
+
+/*
+Test 6: Throughput of the batch kernel against one-by-one evaluation
+*/
+class HybridSolverTest6 : public HybridSolverTest {
+public:
+    HybridSolverTest6() : HybridSolverTest("Batch kernel throughput") {}
+
+protected:
+    void run() override {
+        auto c = TestUtils::makeBinOp("And",
+            TestUtils::makeBinOp("Gt", TestUtils::makeBinOp("Add", make_unique<SymVar>(1), make_unique<SymVar>(2)),
+                                 make_unique<Num>(5)),
+            TestUtils::makeBinOp("Lt", TestUtils::makeBinOp("Mul", make_unique<SymVar>(1), make_unique<Num>(2)),
+                                 make_unique<Num>(40)));
+        BatchEvaluator kernel;
+        assert(kernel.compile(*c));
+
+        InputBatch batch;
+        batch.rows = 100000;
+        mt19937 rng(5);
+        uniform_int_distribution<int> dist(-100, 100);
+        for (unsigned int num : { 1u, 2u }) {
+            for (size_t r = 0; r < batch.rows; r++) {
+                batch.columns[num].push_back(dist(rng));
+            }
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<uint8_t> mask = kernel.evaluate(batch);
+        chrono::duration<double, milli> batchMs = chrono::steady_clock::now() - start;
+
+        ConcreteEvaluator evaluator;
+        ConcValEnv env(nullptr);
+        map<unsigned int, int> values;
+        evaluator.setSymVarValues(&values);
+        size_t scalarSat = 0;
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < batch.rows; r++) {
+            values[1] = batch.columns[1][r];
+            values[2] = batch.columns[2][r];
+            scalarSat += evaluator.evaluateBool(*c, env) ? 1 : 0;
+        }
+        chrono::duration<double, milli> scalarMs = chrono::steady_clock::now() - start;
+
+        size_t batchSat = 0;
+        for (uint8_t m : mask) batchSat += m;
+        cout << "  " << batch.rows << " candidates: batch " << batchMs.count()
+             << " ms, one by one " << scalarMs.count() << " ms" << endl;
+        assert(batchSat == scalarSat);
+    }
+};
+
+/*
+Test 7: Under a deadline the fallback solver gets the time that is left
+Program:
+    x := input()
+    assume(x * x == 2)
+*/
+class HybridSolverTest7 : public HybridSolverTest {
+public:
+    HybridSolverTest7() : HybridSolverTest("Fallback solver bounded by the deadline") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(make_unique<Assume>(TestUtils::makeBinOp("Eq",
+            TestUtils::makeBinOp("Mul", make_unique<Var>("x"), make_unique<Var>("x")),
+            make_unique<Num>(2))));
+
+        App1FunctionFactory factory;
+        CountingSolver z3;
+        HybridSolver hybrid(z3, 32, 100, 0.05, 3);
+        Tester tester(&factory);
+        tester.setHybridSolver(&hybrid);
+        tester.setDeadline(chrono::steady_clock::now() + chrono::seconds(30));
+        ValueEnvironment ve(nullptr);
+        tester.generateCTC(make_unique<Program>(std::move(statements)), {}, &ve);
+
+        cout << "  Fallback timeout: " << z3.lastTimeout << " ms" << endl;
+        assert(z3.calls == 1);
+        assert(z3.lastTimeout > 0 && z3.lastTimeout <= 30000);
+    }
+};
+
+// f2() of App1 taking 200 ms
+class SlowF2 : public Function {
+    public:
+        unique_ptr<Expr> execute() override {
+            this_thread::sleep_for(chrono::milliseconds(200));
+            return make_unique<Num>(0);
+        }
+};
+
+class SlowF2Factory : public App1FunctionFactory {
+    public:
+        unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+            if (fname == "f2") {
+                return make_unique<SlowF2>();
+            }
+            return App1FunctionFactory::getFunction(fname, args);
+        }
+};
+
+/*
+Test 8: A deadline that runs out during symbolic execution stops generation
+before the solver is called
+Program:
+    r := f2()              (takes 200 ms, the deadline is 50 ms away)
+    x := input()
+    assume(x * x == 2)
+*/
+class HybridSolverTest8 : public HybridSolverTest {
+public:
+    HybridSolverTest8() : HybridSolverTest("Deadline expired during symbolic execution") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(make_unique<Assign>(make_unique<Var>("r"),
+            make_unique<FuncCall>("f2", vector<unique_ptr<Expr>>{})));
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(make_unique<Assume>(TestUtils::makeBinOp("Eq",
+            TestUtils::makeBinOp("Mul", make_unique<Var>("x"), make_unique<Var>("x")),
+            make_unique<Num>(2))));
+
+        SlowF2Factory factory;
+        CountingSolver z3;
+        HybridSolver hybrid(z3, 32, 100, 0.05, 3);
+        Tester tester(&factory);
+        tester.setHybridSolver(&hybrid);
+        tester.setDeadline(chrono::steady_clock::now() + chrono::milliseconds(50));
+        ValueEnvironment ve(nullptr);
+        bool expired = false;
+        try {
+            tester.generateCTC(make_unique<Program>(std::move(statements)), {}, &ve);
+        } catch (const DeadlineExceeded&) {
+            expired = true;
+        }
+
+        assert(expired);
+        // No fallback run without a limit
+        assert(z3.calls == 0);
+        cout << "  Generation stopped at the deadline, solver not called" << endl;
+    }
+};
+
+// Solver that gives every SymVar of the formula a list value
+class ListSolver : public Solver {
+    public:
+        Result solve(unique_ptr<Expr> formula) const override {
+            map<string, unique_ptr<ResultValue>> model;
+            walkExpr(static_cast<const Expr&>(*formula), [&model](const Expr& node) {
+                if (node.exprType == ExprType::SYMVAR) {
+                    string name = "X" + to_string(dynamic_cast<const SymVar&>(node).getNum());
+                    model[name] = make_unique<StringResultValue>("[1, 2]");
+                }
+                return WalkAction::DESCEND;
+            });
+            return Result(true, std::move(model));
+        }
+};
+
+/*
+Test 9: Inputs are integers; a list value for an input is rejected instead
+of being replaced by 0
+Program:
+    x := input()
+    assume(x * x == 2)     (no sample satisfies it, the fallback answers)
+*/
+class HybridSolverTest9 : public HybridSolverTest {
+public:
+    HybridSolverTest9() : HybridSolverTest("List values for inputs are not supported") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(make_unique<Assume>(TestUtils::makeBinOp("Eq",
+            TestUtils::makeBinOp("Mul", make_unique<Var>("x"), make_unique<Var>("x")),
+            make_unique<Num>(2))));
+
+        App1FunctionFactory factory;
+        ListSolver lists;
+        HybridSolver hybrid(lists, 32, 100, 0.05, 3);
+        Tester tester(&factory);
+        tester.setHybridSolver(&hybrid);
+        ValueEnvironment ve(nullptr);
+        string message;
+        try {
+            tester.generateCTC(make_unique<Program>(std::move(statements)), {}, &ve);
+        } catch (const runtime_error& e) {
+            message = e.what();
+        }
+        cout << "  " << message << endl;
+        assert(message.find("only integer inputs are supported") != string::npos);
+    }
+};
+
+int main() {
+    vector<HybridSolverTest*> testcases = {
+        new HybridSolverTest1(),
+        new HybridSolverTest2(),
+        new HybridSolverTest3(),
+        new HybridSolverTest4(),
+        new HybridSolverTest5(),
+        new HybridSolverTest6(),
+        new HybridSolverTest7(),
+        new HybridSolverTest8(),
+        new HybridSolverTest9()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Hybrid Solver Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Hybrid Solver Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+#include <iostream>
+#include <cassert>
+#include <list>
+#include <map>
+#include "ast.hh"
+#include "../../see/z3solver.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/daemon.hh"
+#include "../../tester/memorygovernor.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static unique_ptr<Expr> gt(unsigned int symVar, int bound) {
+    return TestUtils::makeBinOp("Gt", make_unique<SymVar>(symVar), make_unique<Num>(bound));
+}
+
+class MemoryTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    MemoryTest(const string& name) : testName(name) {}
+    virtual ~MemoryTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Shares, LRU eviction and admission
+    budget 1000 bytes, high water 0.9; an LRU cache of 100-byte entries
+    allowed 30% of the budget
+*/
+class MemoryTest1 : public MemoryTest {
+public:
+    MemoryTest1() : MemoryTest("Cache shares and admission") {}
+
+protected:
+    void run() override {
+        MemoryGovernor governor(1000, 0.9);
+        size_t resident = 0;
+        governor.setResidentProbe([&resident]() { return resident; });
+
+        list<int> cache;    // most recently used first
+        MemoryGovernor::CacheId id = governor.addCache("test cache", 0.3, [&cache](size_t target) {
+            while (cache.size() * 100 > target) {
+                cache.pop_back();
+            }
+            return cache.size() * 100;
+        });
+
+        for (int k = 0; k < 3; k++) {
+            cache.push_front(k);
+            governor.update(id, cache.size() * 100);
+        }
+        assert(governor.getEvictions(id) == 0 && cache.size() == 3);
+
+        // Over the share: the oldest entry goes
+        cache.push_front(3);
+        governor.update(id, cache.size() * 100);
+        assert(governor.getEvictions(id) == 1);
+        assert(cache.size() == 3 && cache.back() == 1);
+        assert(governor.getBytes(id) == 300);
+
+        // Admission follows the larger of tracked bytes and resident size
+        assert(governor.admit());
+        resident = 950;
+        assert(!governor.admit());
+        assert(!governor.admit());
+        assert(governor.getThrottled() == 2);
+        resident = 100;
+        assert(governor.admit());
+        governor.printReport();
+
+        // A removed cache is no longer asked to evict
+        governor.removeCache(id);
+        for (int k = 4; k < 10; k++) {
+            cache.push_front(k);
+            governor.update(id, cache.size() * 100);
+        }
+        assert(cache.size() == 9 && governor.getTrackedBytes() == 0);
+    }
+};
+
+/*
+Test 2: Solver templates are evicted least recently used first
+    shapes Gt(X, 1), Gt(X, 2), Gt(X, 3); Gt(X, 1) is used again last
+*/
+class MemoryTest2 : public MemoryTest {
+public:
+    MemoryTest2() : MemoryTest("Solver template eviction") {}
+
+protected:
+    void run() override {
+        Z3Solver solver;
+        for (int bound : { 1, 2, 3, 1 }) {
+            Result result = solver.solve(gt(700 + bound, bound));
+            assert(result.isSat);
+        }
+        assert(solver.getTemplateCount() == 3 && solver.getTemplateHits() == 1);
+        size_t all = solver.getTemplateBytes();
+        assert(all > 0);
+
+        // Keep about one template: Gt(X, 1) was used last
+        size_t held = solver.evictTemplates(all / 3 + 1);
+        cout << "template bytes: " << all << " -> " << held << endl;
+        assert(solver.getTemplateCount() == 1 && held <= all / 3 + 1);
+        assert(solver.solve(gt(801, 1)).isSat);
+        assert(solver.getTemplateHits() == 2);
+
+        // An evicted shape is translated again and still solves
+        Result again = solver.solve(gt(802, 2));
+        assert(again.isSat && solver.getTemplateCount() == 2 && solver.getTemplateHits() == 2);
+        assert(solver.evictTemplates(0) == 0 && solver.getTemplateCount() == 0);
+    }
+};
+
+/*
+Test 3: The daemon's CTC cache stays within its share, generation is refused
+near the budget, and campaigns hold test strings back
+*/
+class MemoryTest3 : public MemoryTest {
+public:
+    MemoryTest3() : MemoryTest("Daemon and campaign backpressure") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        size_t resident = 0;
+        MemoryGovernor governor(100000, 0.9);
+        governor.setResidentProbe([&resident]() { return resident; });
+        {
+            GenerationDaemon daemon(campaign, "/tmp/unused.sock");
+            // Room for about one CTC
+            daemon.setMemoryGovernor(&governor, 0.01, 0.25);
+
+            vector<string> out;
+            auto collect = [&out](const string& line) { out.push_back(line); };
+            daemon.handle("GENERATE set; f2 set; set set", collect);
+            assert(out.back() == "END");
+            assert(daemon.getStats().generated == 3);
+            cout << "cached CTCs: " << daemon.getCachedCTCs() << endl;
+            assert(daemon.getCachedCTCs() < 3);
+
+            // The most recent CTC is cached and still served near the budget
+            resident = 95000;
+            out.clear();
+            daemon.handle("REPLAY set set; f2", collect);
+            assert(out[0].compare(0, 17, "RESULT 0 PASSED +") == 0);
+            assert(out[1] == "ERROR 1 memory budget exceeded, retry later");
+            assert(daemon.getStats().generated == 3);
+            resident = 0;
+        }
+        // The daemon is gone; its caches no longer count
+        assert(governor.getTrackedBytes() == 0);
+
+        // Sequential runs stop admitting test strings
+        campaign.setMemoryGovernor(&governor);
+        TestStringSampler sampler(spec.get(), 7);
+        resident = 95000;
+        assert(campaign.run(sampler, 5, 2).empty());
+
+        // Parallel runs wait, and go ahead when nothing is in flight
+        size_t before = governor.getThrottled();
+        vector<CampaignEntry> entries = campaign.runParallel({ { "f2" }, { "set" }, { "f2", "set" } }, 2);
+        assert(entries.size() == 3);
+        for (const auto& entry : entries) {
+            assert(entry.result.status == ReplayStatus::PASSED);
+        }
+        assert(governor.getThrottled() > before);
+        resident = 0;
+        assert(campaign.run(sampler, 2, 2).size() == 2);
+        governor.printReport();
+
+        campaign.setMemoryGovernor(nullptr);
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<MemoryTest*> testcases = {
+        new MemoryTest1(),
+        new MemoryTest2(),
+        new MemoryTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Memory Governor Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Memory Governor Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include "ast.hh"
+#include "../../see/concreteevaluator.hh"
+#include "../../see/oraclelibrary.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static unique_ptr<Expr> bin(const string& op, unique_ptr<Expr> a, unique_ptr<Expr> b) {
+    return TestUtils::makeBinOp(op, std::move(a), std::move(b));
+}
+
+static unique_ptr<Expr> var(const string& name) { return make_unique<Var>(name); }
+static unique_ptr<Expr> num(int n) { return make_unique<Num>(n); }
+
+class OracleTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    OracleTest(const string& name) : testName(name) {}
+    virtual ~OracleTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Native predicates agree with the interpreter; the rest falls back
+*/
+class OracleTest1 : public OracleTest {
+public:
+    OracleTest1() : OracleTest("Native and interpreted predicates agree") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Expr>> preds;
+        // (a > 5 && b != a) || Not(a <= b)
+        preds.push_back(bin("Or",
+            bin("And", bin("Gt", var("a"), num(5)), bin("Neq", var("b"), var("a"))),
+            make_unique<FuncCall>("Not", [] {
+                vector<unique_ptr<Expr>> args;
+                args.push_back(bin("Le", var("a"), var("b")));
+                return args;
+            }())));
+        // a * b - 3 == a / (b - 2)  (division by zero at b == 2)
+        preds.push_back(bin("Eq", bin("Sub", bin("Mul", var("a"), var("b")), num(3)),
+                                  bin("Div", var("a"), bin("Sub", var("b"), num(2)))));
+        // Implies(a < 0, flag)
+        preds.push_back(bin("Implies", bin("Lt", var("a"), num(0)), var("flag")));
+
+        OracleLibrary library;
+        for (const auto& p : preds) {
+            assert(library.add(*p, { { "flag", "bool" } }));
+        }
+        assert(!library.add(*preds[0]));                       // already registered
+        vector<unique_ptr<Expr>> elems;
+        elems.push_back(num(1));
+        auto inSet = bin("in", var("a"), make_unique<Set>(std::move(elems)));
+        assert(!library.add(*inSet));                           // not native
+        assert(!library.add(*bin("Gt", var("s"), num(0)), { { "s", "string" } }));
+
+        library.compile();
+        assert(library.isLoaded() && library.size() == 3);
+        assert(library.getSource().find("// flag : bool") != string::npos);
+
+        ConcreteEvaluator interpreter;
+        size_t checked = 0, fallbacks = 0;
+        for (int a = -12; a <= 12; a++) {
+            for (int b = -12; b <= 12; b++) {
+                Num va(a), vb(b), vf((a + b) & 1);
+                ConcValEnv env(nullptr);
+                env.setValue("a", &va);
+                env.setValue("b", &vb);
+                env.setValue("flag", &vf);
+                for (const auto& p : preds) {
+                    int native = library.evaluate(*p, env);
+                    bool expected;
+                    try {
+                        expected = interpreter.evaluateBool(*p, env);
+                    } catch (const runtime_error&) {
+                        assert(native == -1);
+                        fallbacks++;
+                        continue;
+                    }
+                    assert(native == (expected ? 1 : 0));
+                    checked++;
+                }
+            }
+        }
+        cout << "  " << checked << " evaluations agree, " << fallbacks
+             << " divisions by zero left to the interpreter" << endl;
+        assert(fallbacks == 25);
+
+        // Unregistered predicates and non-integer bindings are interpreted
+        String s("x");
+        ConcValEnv env(nullptr);
+        env.setValue("a", &s);
+        env.setValue("b", &s);
+        assert(library.evaluate(*preds[0], env) == -1);
+        assert(library.evaluate(*inSet, env) == -1);
+    }
+};
+
+/*
+Test 2: The evaluator uses the library and is faster on a hot predicate
+*/
+class OracleTest2 : public OracleTest {
+public:
+    OracleTest2() : OracleTest("Evaluator dispatch") {}
+
+protected:
+    void run() override {
+        // Chain of 16 range checks over four variables
+        unique_ptr<Expr> pred = bin("Gt", var("w"), num(-1000));
+        const char* names[] = { "w", "x", "y", "z" };
+        for (int i = 0; i < 16; i++) {
+            pred = bin("And", std::move(pred),
+                       bin("Lt", bin("Add", var(names[i % 4]), num(i)), num(1000)));
+        }
+        OracleLibrary library;
+        assert(library.add(*pred));
+        library.compile();
+
+        ConcreteEvaluator interpreted, native;
+        native.setOracles(&library);
+        Num w(1), x(2), y(3), z(4);
+        ConcValEnv env(nullptr);
+        env.setValue("w", &w);
+        env.setValue("x", &x);
+        env.setValue("y", &y);
+        env.setValue("z", &z);
+
+        const int rounds = 20000;
+        auto time = [&](ConcreteEvaluator& e) {
+            auto start = chrono::steady_clock::now();
+            for (int i = 0; i < rounds; i++) {
+                assert(e.evaluateBool(*pred, env));
+            }
+            return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        };
+        double slow = time(interpreted);
+        double fast = time(native);
+        cout << "  " << rounds << " evaluations: interpreted " << slow << " ms, native "
+             << fast << " ms" << endl;
+        assert(fast < slow);
+    }
+};
+
+/*
+Test 3: A campaign with compiled oracles gives the same verdicts
+*/
+class OracleTest3 : public OracleTest {
+public:
+    OracleTest3() : OracleTest("Campaign with native oracles") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign interpreted(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+        Campaign native(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        // f2: post; set: pre and post; bad: pre
+        assert(native.compileOracles() == 4);
+        assert(native.getOracles()->isLoaded());
+
+        vector<vector<string>> strings = {
+            { "f2" }, { "set" }, { "f2", "set", "set" }, { "set", "bad" }
+        };
+        for (size_t i = 0; i < strings.size(); i++) {
+            ReplayStatus a = interpreted.runTestString(strings[i], i).result.status;
+            ReplayStatus b = native.runTestString(strings[i], i).result.status;
+            cout << "  test " << i << ": " << replayStatusToString(a) << " / "
+                 << replayStatusToString(b) << endl;
+            assert(a == b);
+        }
+        assert(interpreted.getCoverage().count() == native.getCoverage().count());
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 4: Old-state versions U_old_k share the oracle of their first occurrence
+    registered:  r = U_old_1 + v        U_old_1 = U_old_1
+*/
+class OracleTest4 : public OracleTest {
+public:
+    OracleTest4() : OracleTest("Versioned old state matches one oracle") {}
+
+protected:
+    void run() override {
+        OracleLibrary library;
+        assert(library.add(*bin("Eq", var("r"), bin("Add", var("U_old_1"), var("v")))));
+        assert(library.add(*bin("Eq", var("U_old_1"), var("U_old_1"))));
+        assert(!library.add(*bin("Eq", var("r"), bin("Add", var("U_old_2"), var("v")))));
+        library.compile();
+        assert(library.size() == 2);
+
+        Num r(7), old1(100), old2(3), v(4);
+        ConcValEnv env(nullptr);
+        env.setValue("r", &r);
+        env.setValue("U_old_1", &old1);
+        env.setValue("U_old_2", &old2);
+        env.setValue("v", &v);
+        // The second occurrence reads U_old_2, not the registered U_old_1
+        assert(library.evaluate(*bin("Eq", var("r"), bin("Add", var("U_old_2"), var("v"))), env) == 1);
+        assert(library.evaluate(*bin("Eq", var("r"), bin("Add", var("U_old_1"), var("v"))), env) == 0);
+        // Two versions cannot share one slot
+        assert(library.evaluate(*bin("Eq", var("U_old_1"), var("U_old_2")), env) == -1);
+        assert(library.evaluate(*bin("Eq", var("U_old_2"), var("U_old_2")), env) == 1);
+        // Only a numeric suffix is a version
+        assert(library.evaluate(*bin("Eq", var("r"), bin("Add", var("U_old_x"), var("v"))), env) == -1);
+    }
+};
+
+/*
+Test 5: Overflowing arithmetic: interpreter and native code agree on
+wrap-around, and neither divides INT32_MIN by -1
+*/
+class OracleTest5 : public OracleTest {
+public:
+    OracleTest5() : OracleTest("Overflow semantics agree") {}
+
+protected:
+    void run() override {
+        vector<unique_ptr<Expr>> preds;
+        preds.push_back(bin("Lt", bin("Add", var("a"), var("b")), num(0)));
+        preds.push_back(bin("Gt", bin("Sub", var("a"), var("b")), num(0)));
+        preds.push_back(bin("Eq", bin("Mul", var("a"), var("b")), num(0)));
+        preds.push_back(bin("Gt", bin("Div", var("a"), var("b")), num(0)));
+
+        OracleLibrary library;
+        for (const auto& p : preds) {
+            assert(library.add(*p));
+        }
+        library.compile();
+
+        ConcreteEvaluator interpreter;
+        vector<int> values = { INT32_MIN, INT32_MIN + 1, -65536, -1, 0, 1, 65536, INT32_MAX };
+        size_t undefined = 0;
+        for (int a : values) {
+            for (int b : values) {
+                Num va(a), vb(b);
+                ConcValEnv env(nullptr);
+                env.setValue("a", &va);
+                env.setValue("b", &vb);
+                for (const auto& p : preds) {
+                    int native = library.evaluate(*p, env);
+                    try {
+                        assert(native == (interpreter.evaluateBool(*p, env) ? 1 : 0));
+                    } catch (const runtime_error&) {
+                        assert(native == -1);
+                        undefined++;
+                    }
+                }
+            }
+        }
+        // b == 0 for every a, and INT32_MIN / -1
+        assert(undefined == values.size() + 1);
+
+        // INT32_MAX + 1 wraps to INT32_MIN
+        Num va(INT32_MAX), vb(1);
+        ConcValEnv env(nullptr);
+        env.setValue("a", &va);
+        env.setValue("b", &vb);
+        assert(interpreter.evaluateBool(*preds[0], env));
+        cout << "  " << values.size() * values.size() << " pairs agree, "
+             << undefined << " divisions undefined" << endl;
+    }
+};
+
+int main() {
+    vector<OracleTest*> testcases = {
+        new OracleTest1(),
+        new OracleTest2(),
+        new OracleTest3(),
+        new OracleTest4(),
+        new OracleTest5()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Oracle Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Oracle Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <iostream>
+#include <cassert>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/queryminimizer.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static unique_ptr<Expr> op(const string& name, unique_ptr<Expr> left, unique_ptr<Expr> right) {
+    return TestUtils::makeBinOp(name, std::move(left), std::move(right));
+}
+
+static unique_ptr<Expr> x(unsigned int n) {
+    return make_unique<SymVar>(n);
+}
+
+static unique_ptr<Expr> cube(unsigned int n) {
+    return op("Mul", op("Mul", x(n), x(n)), x(n));
+}
+
+// X1^3 + X2^3 = X3^3: nonlinear, and Z3 gives up on it once X1, X2 > 0
+static unique_ptr<Expr> fermat() {
+    return op("Eq", op("Add", cube(1), cube(2)), cube(3));
+}
+
+static unique_ptr<Expr> positive(unsigned int n) {
+    return op("Gt", x(n), make_unique<Num>(0));
+}
+
+static RecordedQuery slowQuery(unique_ptr<Expr> slowPart) {
+    RecordedQuery query;
+    query.testString = { "set", "f2", "set" };
+    query.solveMs = 0;
+    auto add = [&query](unique_ptr<Expr> e, size_t position) {
+        query.conjuncts.push_back(std::move(e));
+        query.statements.push_back(0);
+        query.positions.push_back(position);
+    };
+    add(op("Gt", x(10), make_unique<Num>(3)), SIZE_MAX);
+    add(positive(1), 0);
+    add(op("Lt", x(11), make_unique<Num>(7)), 0);
+    add(std::move(slowPart), 1);
+    add(positive(2), 2);
+    add(op("Eq", x(12), op("Add", x(10), make_unique<Num>(1))), 2);
+    return query;
+}
+
+class QueryMinimizerTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    QueryMinimizerTest(const string& name) : testName(name) {}
+    virtual ~QueryMinimizerTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Only the conjuncts that make the query slow are kept
+    X10 > 3 (init), X1 > 0 (set), X11 < 7 (set), fermat (f2), X2 > 0 (set),
+    X12 = X10 + 1 (set)
+*/
+class QueryMinimizerTest1 : public QueryMinimizerTest {
+public:
+    QueryMinimizerTest1() : QueryMinimizerTest("Slow conjuncts with their blocks") {}
+
+protected:
+    void run() override {
+        RecordedQuery query = slowQuery(fermat());
+        QueryMinimizer minimizer(200);
+        MinimizedQuery result = minimizer.minimize(query);
+        cout << QueryMinimizer::report(result);
+
+        assert(result.slow);
+        assert(result.conjuncts.size() >= 1 && result.conjuncts.size() <= 3);
+        bool hasFermat = false;
+        for (size_t i = 0; i < result.conjuncts.size(); i++) {
+            string text = TestUtils::exprToString(result.conjuncts[i].get());
+            // The conjuncts on X10, X11 and X12 are fast on their own
+            assert(text.find("X10") == string::npos && text.find("X11") == string::npos && text.find("X12") == string::npos);
+            if (result.positions[i] == 1) {
+                hasFermat = true;
+                assert(result.blocks[i] == "f2");
+            }
+        }
+        assert(hasFermat);
+        assert(QueryMinimizer::report(result).find("Mul(Mul(X1, X1), X1)") != string::npos);
+        assert(result.simplified == 0);
+        cout << "solves: " << result.solves << endl;
+    }
+};
+
+/*
+Test 2: A slow conjunct nested in a connective is reduced to the operand
+that is slow
+    Or(fermat, X20 < X20) -> fermat
+*/
+class QueryMinimizerTest2 : public QueryMinimizerTest {
+public:
+    QueryMinimizerTest2() : QueryMinimizerTest("Subterm reduction") {}
+
+protected:
+    void run() override {
+        RecordedQuery query = slowQuery(op("Or", fermat(), op("Lt", x(20), x(20))));
+        QueryMinimizer minimizer(200);
+        MinimizedQuery result = minimizer.minimize(query);
+        cout << QueryMinimizer::report(result);
+
+        assert(result.slow && result.simplified >= 1);
+        for (const auto& conjunct : result.conjuncts) {
+            string text = TestUtils::exprToString(conjunct.get());
+            assert(text.find("Or") == string::npos && text.find("X20") == string::npos);
+        }
+    }
+};
+
+/*
+Test 3: Campaigns record slow queries with the block of every conjunct; a
+query that is solved in time is not minimized
+*/
+class QueryMinimizerTest3 : public QueryMinimizerTest {
+public:
+    QueryMinimizerTest3() : QueryMinimizerTest("Recording during generation") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        // Not recording
+        campaign.generateCTC({ "f2", "set" });
+        assert(campaign.takeSlowQueries().empty());
+
+        // Every query counts as slow
+        campaign.setSlowQueryThreshold(1e-9);
+        campaign.generateCTC({ "f2", "set" });
+        vector<RecordedQuery> queries = campaign.takeSlowQueries();
+        assert(!queries.empty());
+        assert(campaign.takeSlowQueries().empty());
+        bool fromSet = false;
+        for (const auto& query : queries) {
+            assert(query.testString == vector<string>({ "f2", "set" }));
+            assert(query.conjuncts.size() == query.positions.size());
+            for (size_t i = 0; i < query.conjuncts.size(); i++) {
+                cout << TestUtils::exprToString(query.conjuncts[i].get()) << " <- "
+                     << (query.positions[i] == SIZE_MAX ? string("init") : to_string(query.positions[i]))
+                     << endl;
+                // set's precondition is the only assume
+                assert(query.positions[i] == 1);
+                fromSet = true;
+            }
+        }
+        assert(fromSet);
+
+        QueryMinimizer minimizer(200);
+        MinimizedQuery result = minimizer.minimize(queries.back());
+        assert(!result.slow && result.conjuncts.empty());
+        assert(QueryMinimizer::report(result) == "query is not slow\n");
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<QueryMinimizerTest*> testcases = {
+        new QueryMinimizerTest1(),
+        new QueryMinimizerTest2(),
+        new QueryMinimizerTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Query Minimizer Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Query Minimizer Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
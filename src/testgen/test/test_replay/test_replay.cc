@@ -0,0 +1,229 @@
+#include <iostream>
+#include <cassert>
+#include "ast.hh"
+#include "../../tester/replay.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+class ReplayTest {
+protected:
+    string testName;
+    virtual vector<unique_ptr<Program>> makeCTCs() = 0;
+    virtual void verify(const vector<ReplayResult>& results, const ReplaySummary& summary) = 0;
+    virtual unsigned int workers() { return 4; }
+
+public:
+    ReplayTest(const string& name) : testName(name) {}
+    virtual ~ReplayTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+
+        vector<unique_ptr<Program>> ctcs = makeCTCs();
+        ReplayRunner runner([]() { return unique_ptr<FunctionFactory>(new App1FunctionFactory()); },
+                            workers());
+        vector<ReplayResult> results = runner.run(ctcs);
+        ReplaySummary summary = ReplayRunner::summarize(results, runner.getLastWallMs());
+        ReplayRunner::printReport(results, summary);
+
+        verify(results, summary);
+
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+CTC for the f1 block:
+    y := 0
+    x0 := x
+    z0 := z
+    assume(x0 > 0 AND z0 > 0)
+    r0 := f1(x0, z0)
+    assert(r0 == post)
+*/
+static unique_ptr<Program> makeF1CTC(int x, int z, unique_ptr<Expr> post) {
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(make_unique<Assign>(make_unique<Var>("y"), make_unique<Num>(0)));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("x0"), make_unique<Num>(x)));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("z0"), make_unique<Num>(z)));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp("And",
+        TestUtils::makeBinOp("Gt", make_unique<Var>("x0"), make_unique<Num>(0)),
+        TestUtils::makeBinOp("Gt", make_unique<Var>("z0"), make_unique<Num>(0)))));
+    vector<unique_ptr<Expr>> args;
+    args.push_back(make_unique<Var>("x0"));
+    args.push_back(make_unique<Var>("z0"));
+    statements.push_back(make_unique<Assign>(make_unique<Var>("r0"),
+        make_unique<FuncCall>("f1", std::move(args))));
+    statements.push_back(make_unique<Assert>(TestUtils::makeBinOp("Eq",
+        make_unique<Var>("r0"), std::move(post))));
+    return make_unique<Program>(std::move(statements));
+}
+
+/*
+Test 1: f1 result matches the postcondition, violates it, and skips on an
+unsatisfied precondition.
+*/
+class ReplayTest1 : public ReplayTest {
+public:
+    ReplayTest1() : ReplayTest("Pass, fail and infeasible CTCs") {}
+
+protected:
+    vector<unique_ptr<Program>> makeCTCs() override {
+        vector<unique_ptr<Program>> ctcs;
+        ctcs.push_back(makeF1CTC(3, 4,
+            TestUtils::makeBinOp("Add", make_unique<Var>("x0"), make_unique<Var>("z0"))));
+        ctcs.push_back(makeF1CTC(3, 4,
+            TestUtils::makeBinOp("Sub", make_unique<Var>("x0"), make_unique<Var>("z0"))));
+        ctcs.push_back(makeF1CTC(-1, 4,
+            TestUtils::makeBinOp("Add", make_unique<Var>("x0"), make_unique<Var>("z0"))));
+        return ctcs;
+    }
+
+    void verify(const vector<ReplayResult>& results, const ReplaySummary& summary) override {
+        assert(results.size() == 3);
+        assert(results[0].status == ReplayStatus::PASSED);
+        assert(results[1].status == ReplayStatus::FAILED);
+        assert(results[1].stmtIndex == 5);
+        assert(results[2].status == ReplayStatus::INFEASIBLE);
+        assert(results[2].stmtIndex == 3);
+        assert(summary.passed == 1 && summary.failed == 1 && summary.infeasible == 1);
+        cout << "  Correct verdicts for pass/fail/infeasible" << endl;
+    }
+};
+
+/*
+Test 2: Every CTC runs against its own SUT instance
+Program (repeated):
+    r := get_y()
+    assert(r == 0)
+    t := set_y(7)
+If two CTCs shared a SUT, the second would read y = 7.
+*/
+class ReplayTest2 : public ReplayTest {
+public:
+    ReplayTest2() : ReplayTest("SUT isolation across concurrent CTCs") {}
+
+protected:
+    vector<unique_ptr<Program>> makeCTCs() override {
+        vector<unique_ptr<Program>> ctcs;
+        for (int i = 0; i < 64; i++) {
+            vector<unique_ptr<Stmt>> statements;
+            statements.push_back(make_unique<Assign>(make_unique<Var>("r"),
+                make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{})));
+            statements.push_back(make_unique<Assert>(TestUtils::makeBinOp("Eq",
+                make_unique<Var>("r"), make_unique<Num>(0))));
+            vector<unique_ptr<Expr>> args;
+            args.push_back(make_unique<Num>(7));
+            statements.push_back(make_unique<Assign>(make_unique<Var>("t"),
+                make_unique<FuncCall>("set_y", std::move(args))));
+            ctcs.push_back(make_unique<Program>(std::move(statements)));
+        }
+        return ctcs;
+    }
+
+    void verify(const vector<ReplayResult>& results, const ReplaySummary& summary) override {
+        assert(summary.passed == 64);
+        for (size_t i = 0; i < results.size(); i++) {
+            assert(results[i].testId == i);
+        }
+        cout << "  All 64 CTCs saw a fresh SUT" << endl;
+    }
+};
+
+/*
+Test 3: Large mixed suite; results keep input order and the counts add up.
+*/
+class ReplayTest3 : public ReplayTest {
+public:
+    ReplayTest3() : ReplayTest("Parallel replay of a mixed suite") {}
+
+protected:
+    unsigned int workers() override { return 8; }
+
+    vector<unique_ptr<Program>> makeCTCs() override {
+        vector<unique_ptr<Program>> ctcs;
+        for (int i = 0; i < 400; i++) {
+            string op = (i % 10 == 0) ? "Mul" : "Add";
+            ctcs.push_back(makeF1CTC(i + 1, 2,
+                TestUtils::makeBinOp(op, make_unique<Var>("x0"), make_unique<Var>("z0"))));
+        }
+        return ctcs;
+    }
+
+    void verify(const vector<ReplayResult>& results, const ReplaySummary& summary) override {
+        assert(results.size() == 400);
+        for (size_t i = 0; i < results.size(); i++) {
+            // (i+1) * 2 == (i+1) + 2 only for i == 1, which is not a Mul case
+            ReplayStatus expected = (i % 10 == 0) ? ReplayStatus::FAILED : ReplayStatus::PASSED;
+            assert(results[i].status == expected);
+            assert(results[i].latencyMs >= 0);
+        }
+        assert(summary.failed == 40);
+        assert(summary.passed == 360);
+        cout << "  400 CTCs replayed on 8 workers" << endl;
+    }
+};
+
+/*
+Test 4: A CTC that still contains input() is reported as an error.
+*/
+class ReplayTest4 : public ReplayTest {
+public:
+    ReplayTest4() : ReplayTest("Abstract test case is rejected") {}
+
+protected:
+    vector<unique_ptr<Program>> makeCTCs() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        vector<unique_ptr<Program>> ctcs;
+        ctcs.push_back(make_unique<Program>(std::move(statements)));
+        return ctcs;
+    }
+
+    void verify(const vector<ReplayResult>& results, const ReplaySummary& summary) override {
+        assert(results[0].status == ReplayStatus::ERROR);
+        assert(summary.errors == 1);
+        cout << "  input() rejected: " << results[0].message << endl;
+    }
+};
+
+int main() {
+    vector<ReplayTest*> testcases = {
+        new ReplayTest1(),
+        new ReplayTest2(),
+        new ReplayTest3(),
+        new ReplayTest4()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Replay Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Replay Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
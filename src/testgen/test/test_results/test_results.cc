@@ -0,0 +1,263 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/resultstore.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static const string RESULTS_PATH = "/tmp/ttr_test_results.bin";
+
+class ResultsTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    ResultsTest(const string& name) : testName(name) {}
+    virtual ~ResultsTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Campaign entries round-trip through row groups, column by column
+*/
+class ResultsTest1 : public ResultsTest {
+public:
+    ResultsTest1() : ResultsTest("Write and read campaign results") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        vector<vector<string>> strings = { { "f2" }, { "set" }, { "f2", "set" }, { "bad" }, { "set", "set" } };
+        vector<CampaignEntry> entries;
+        {
+            ResultsWriter writer(RESULTS_PATH, campaign, 2);
+            for (size_t i = 0; i < strings.size(); i++) {
+                entries.push_back(campaign.runTestString(strings[i], i));
+                writer.add(entries.back());
+            }
+            assert(writer.getRowGroups() == 2);
+        }
+
+        ResultsReader reader(RESULTS_PATH);
+        assert(reader.size() == strings.size());
+        assert(reader.getRowGroups() == 3);
+        vector<string> columns = reader.getColumns();
+        for (const char* name : { "testId", "status", "latencyMs", "generationMs", "iterations",
+                                    "block0", "block1", "input0", "input1", "decidingBlock" }) {
+            assert(find(columns.begin(), columns.end(), name) != columns.end());
+        }
+        cout << "  " << columns.size() << " columns in " << reader.getRowGroups() << " row groups" << endl;
+
+        size_t row = 0;
+        reader.scan({ "testId", "status", "block1", "input0", "iterations", "decidingBlock" },
+                    [&](const vector<ResultsColumn>& cols, size_t rows) {
+            for (size_t r = 0; r < rows; r++, row++) {
+                const CampaignEntry& entry = entries[row];
+                assert(cols[0].ints[r] == int64_t(row));
+                assert(reader.lookup(cols[1].ints[r]) == replayStatusToString(entry.result.status));
+                assert(bool(cols[2].present[r]) == (entry.testString.size() > 1));
+                assert(cols[4].ints[r] == int64_t(entry.iterations));
+                if (entry.testString[0] == "set") {
+                    assert(cols[3].present[r] && cols[3].ints[r] > 5);
+                }
+                if (entry.result.status != ReplayStatus::PASSED) {
+                    assert(cols[5].present[r] && reader.lookup(cols[5].ints[r]) == "bad");
+                } else {
+                    assert(!cols[5].present[r]);
+                }
+            }
+        });
+        assert(row == strings.size());
+        cout << "  Statuses, block ids, inputs and deciding blocks read back" << endl;
+
+        map<string, ResultsStats> byStatus = reader.aggregate("latencyMs", "status");
+        size_t counted = 0;
+        for (const auto& s : byStatus) {
+            cout << "  " << s.first << ": " << s.second.count << " tests, mean latency "
+                 << s.second.mean() << " ms" << endl;
+            counted += s.second.count;
+        }
+        assert(counted == strings.size());
+        assert(byStatus["PASSED"].count == 4);
+
+        remove(RESULTS_PATH.c_str());
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 2: Many rows are aggregated one row group at a time
+*/
+class ResultsTest2 : public ResultsTest {
+public:
+    ResultsTest2() : ResultsTest("Aggregate many rows") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        const size_t ROWS = 100000;
+        const char* names[] = { "f2", "set", "bad" };
+        double latency = 0;
+        {
+            ResultsWriter writer(RESULTS_PATH, campaign, 4096);
+            for (size_t i = 0; i < ROWS; i++) {
+                CampaignEntry entry;
+                entry.testString = { names[i % 3] };
+                entry.result = { i, i % 3 == 2 ? ReplayStatus::INFEASIBLE : ReplayStatus::PASSED,
+                                 -1, "", double(i % 10) };
+                entry.newPoints = i < 3 ? 1 : 0;
+                latency += entry.result.latencyMs;
+                writer.add(entry);
+            }
+            writer.close();
+            assert(writer.size() == ROWS);
+        }
+
+        ResultsReader reader(RESULTS_PATH);
+        assert(reader.size() == ROWS);
+        assert(reader.getRowGroups() == (ROWS + 4095) / 4096);
+        for (size_t g = 0; g < reader.getRowGroups(); g++) {
+            assert(reader.getRows(g) <= 4096);
+        }
+
+        map<string, ResultsStats> all = reader.aggregate("latencyMs");
+        assert(all[""].count == ROWS);
+        assert(all[""].sum == latency);
+        assert(all[""].min == 0 && all[""].max == 9);
+
+        map<string, ResultsStats> perBlock = reader.aggregate("newPoints", "block0");
+        assert(perBlock.size() == 3);
+        assert(perBlock["bad"].count == (ROWS + 1) / 3);
+        assert(perBlock["f2"].sum == 1 && perBlock["set"].sum == 1);
+        cout << "  " << ROWS << " rows in " << reader.getRowGroups() << " row groups, mean latency "
+             << all[""].mean() << " ms" << endl;
+
+        // Absent columns read as null, other files are rejected
+        ResultsColumn none = reader.read(0, "input0");
+        assert(none.present.size() == reader.getRows(0) && !none.present[0]);
+        {
+            ofstream junk(RESULTS_PATH, ios::binary | ios::trunc);
+            junk << "not a results file";
+        }
+        try {
+            ResultsReader bad(RESULTS_PATH);
+            assert(false);
+        } catch (const runtime_error& e) {
+            cout << "  Rejected: " << e.what() << endl;
+        }
+
+        remove(RESULTS_PATH.c_str());
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+/*
+Test 3: Per-row messages are plain strings and do not grow the dictionary
+*/
+class ResultsTest3 : public ResultsTest {
+public:
+    ResultsTest3() : ResultsTest("Messages as a string column") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(), TestUtils::makeSampleFactory);
+
+        const size_t ROWS = 5000;
+        {
+            ResultsWriter writer(RESULTS_PATH, campaign, 1024);
+            for (size_t i = 0; i < ROWS; i++) {
+                CampaignEntry entry;
+                entry.testString = { "f2" };
+                string message = i % 2 ? "" : "SUT error at row " + to_string(i);
+                entry.result = { i, i % 2 ? ReplayStatus::PASSED : ReplayStatus::ERROR, -1, message, 1 };
+                writer.add(entry);
+            }
+        }
+
+        ResultsReader reader(RESULTS_PATH);
+        assert(reader.size() == ROWS);
+        // status (PASSED, ERROR) and block0 (f2) only
+        assert(reader.getDictionarySize() == 3);
+        size_t row = 0;
+        reader.scan({ "message" }, [&](const vector<ResultsColumn>& cols, size_t rows) {
+            assert(cols[0].type == ResultsColumnType::STRING);
+            for (size_t r = 0; r < rows; r++, row++) {
+                assert(bool(cols[0].present[r]) == (row % 2 == 0));
+                if (row % 2 == 0) {
+                    assert(cols[0].strings[r] == "SUT error at row " + to_string(row));
+                }
+            }
+        });
+        assert(row == ROWS);
+        cout << "  " << ROWS / 2 << " messages read back, dictionary of "
+             << reader.getDictionarySize() << " strings" << endl;
+
+        map<string, ResultsStats> byMessage = reader.aggregate("latencyMs", "message");
+        assert(byMessage.size() == ROWS / 2 + 1 && byMessage[""].count == ROWS / 2);
+        try {
+            reader.aggregate("message");
+            assert(false);
+        } catch (const runtime_error& e) {
+            cout << "  Rejected: " << e.what() << endl;
+        }
+
+        remove(RESULTS_PATH.c_str());
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<ResultsTest*> testcases = {
+        new ResultsTest1(),
+        new ResultsTest2(),
+        new ResultsTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Results Store Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Results Store Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <cassert>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/teststringsampler.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static bool contains(const vector<string>& ts, const string& name) {
+    for (const auto& n : ts) {
+        if (n == name) return true;
+    }
+    return false;
+}
+
+class SamplerTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    SamplerTest(const string& name) : testName(name) {}
+    virtual ~SamplerTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: The untrained chain is uniform and sampling is reproducible per seed
+*/
+class SamplerTest1 : public SamplerTest {
+public:
+    SamplerTest1() : SamplerTest("Uniform start and reproducible seeds") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        TestStringSampler a(spec.get(), 42), b(spec.get(), 42), c(spec.get(), 43);
+        assert(a.getBlockNames().size() == 3);
+        assert(a.transitionProbability("", "bad") > 0.33 && a.transitionProbability("", "bad") < 0.34);
+
+        vector<string> sa = a.sample(50), sb = b.sample(50), sc = c.sample(50);
+        assert(sa.size() == 50);
+        assert(sa == sb);
+        assert(sa != sc);
+        cout << "  Same seed, same 50-block string; different seed differs" << endl;
+    }
+};
+
+/*
+Test 2: Blamed transitions into "bad" are learned; long samples avoid it
+*/
+class SamplerTest2 : public SamplerTest {
+public:
+    SamplerTest2() : SamplerTest("Learning from feasibility") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        TestStringSampler sampler(spec.get(), 7);
+
+        for (int round = 0; round < 200; round++) {
+            vector<string> ts = sampler.sample(8);
+            size_t blamed = SIZE_MAX;
+            for (size_t k = 0; k < ts.size() && blamed == SIZE_MAX; k++) {
+                if (ts[k] == "bad") blamed = k;
+            }
+            sampler.record(ts, blamed == SIZE_MAX, 0, blamed);
+        }
+
+        double p = sampler.transitionProbability("f2", "bad");
+        cout << "  P(f2 -> bad) after training: " << p << endl;
+        assert(p < 0.1);
+
+        size_t withBad = 0;
+        for (int i = 0; i < 50; i++) {
+            withBad += contains(sampler.sample(20), "bad") ? 1 : 0;
+        }
+        cout << "  " << withBad << "/50 sampled 20-block strings contain bad" << endl;
+        assert(withBad < 40);
+        assert(sampler.feasibility({ "f2", "set", "f2" }) > sampler.feasibility({ "f2", "bad" }));
+    }
+};
+
+/*
+Test 3: Coverage feedback boosts transitions that found new points
+*/
+class SamplerTest3 : public SamplerTest {
+public:
+    SamplerTest3() : SamplerTest("Coverage bonus") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        TestStringSampler sampler(spec.get(), 1, 2.0);
+        for (int i = 0; i < 10; i++) {
+            sampler.record({ "set" }, true, 3);
+            sampler.record({ "f2" }, true, 0);
+        }
+        assert(sampler.transitionProbability("", "set") > sampler.transitionProbability("", "f2"));
+        cout << "  P(start -> set) = " << sampler.transitionProbability("", "set")
+             << ", P(start -> f2) = " << sampler.transitionProbability("", "f2") << endl;
+    }
+};
+
+/*
+Test 4: Sampled campaign on App1 learns to avoid the infeasible block
+*/
+class SamplerTest4 : public SamplerTest {
+public:
+    SamplerTest4() : SamplerTest("Sampled campaign on App1") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(),
+                          TestUtils::makeSampleFactory);
+        TestStringSampler sampler(spec.get(), 3);
+
+        double before = sampler.transitionProbability("set", "bad");
+        vector<CampaignEntry> entries = campaign.run(sampler, 24, 3);
+        double after = sampler.transitionProbability("set", "bad");
+
+        size_t feasible = 0;
+        for (const auto& e : entries) {
+            ReplayStatus s = e.result.status;
+            bool ok = (s == ReplayStatus::PASSED || s == ReplayStatus::FAILED);
+            assert(ok == !contains(e.testString, "bad"));
+            if (!ok) {
+                size_t blamed = campaign.blamePosition(e);
+                assert(blamed < e.testString.size() && e.testString[blamed] == "bad");
+            }
+            feasible += ok ? 1 : 0;
+        }
+        cout << "  " << feasible << "/" << entries.size() << " sampled strings feasible" << endl;
+        cout << "  P(set -> bad): " << before << " -> " << after << endl;
+        assert(after < before);
+
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<SamplerTest*> testcases = {
+        new SamplerTest1(),
+        new SamplerTest2(),
+        new SamplerTest3(),
+        new SamplerTest4()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Sampler Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Sampler Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
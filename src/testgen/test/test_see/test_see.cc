@@ -14,6 +14,7 @@ protected:
     string testName;
     virtual Program makeProgram() = 0;
     virtual void verify(SEE& see, map<string, int>& model, bool isSat) = 0;
+    virtual void configure(SEE& see, Z3Solver& solver) {}
     
 public:
     SEETest(const string& name) : testName(name) {}
@@ -27,6 +28,8 @@ public:
         FunctionFactory* functionFactory = new App1FunctionFactory();
         
         SEE see(move(functionFactory));
+        Z3Solver solver;
+        configure(see, solver);
         
         // Execute the program
         see.execute(program, st);
@@ -666,6 +669,105 @@ protected:
     }
 };
 
+/*
+Test 11: Term-size budget
+Program:
+    x := input
+    assume(x > 3)
+    s := x + x
+    s := s + x      (10 times)
+    assume(s > 0)
+With a budget of 8 nodes, s is concretized whenever it grows to
+Add(Add(Add(_, X), X), X); each time the equality is added to the path constraint
+Expected: SAT, s never larger than the budget
+*/
+class SEETest11 : public SEETest {
+public:
+    SEETest11() : SEETest("Term-size budget concretizes large values") {}
+    
+protected:
+    void configure(SEE& see, Z3Solver& solver) override {
+        see.setTermBudget(8, &solver);
+    }
+
+    Program makeProgram() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(3))
+        ));
+        statements.push_back(make_unique<Assign>(
+            make_unique<Var>("s"),
+            TestUtils::makeBinOp("Add", make_unique<Var>("x"), make_unique<Var>("x"))
+        ));
+        for (int i = 0; i < 10; i++) {
+            statements.push_back(make_unique<Assign>(
+                make_unique<Var>("s"),
+                TestUtils::makeBinOp("Add", make_unique<Var>("s"), make_unique<Var>("x"))
+            ));
+        }
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("s"), make_unique<Num>(0))
+        ));
+        return Program(std::move(statements));
+    }
+    
+    void verify(SEE& see, map<string, int>& model, bool isSat) override {
+        assert(see.getConcretizations() >= 1);
+        assert(SEE::termSize(*see.getSigma().getValue("s")) <= 8);
+        // x > 3, one recorded equality per concretization, s > 0
+        assert(see.getPathConstraint().size() == 2 + see.getConcretizations());
+        assert(isSat);
+        for (const auto& entry : model) {
+            assert(entry.second > 3);
+        }
+        cout << "  " << see.getConcretizations() << " concretizations, s bounded by 8 nodes" << endl;
+    }
+};
+
+/*
+Test 12: Asserts are skipped during symbolic execution
+Program:
+    x := input
+    assert(x > 100)
+    assume(x > 5)
+    y := input
+Expected: the assert neither stops execution nor adds a path constraint;
+          SAT with x > 5 and both inputs recorded
+*/
+class SEETest12 : public SEETest {
+public:
+    SEETest12() : SEETest("Asserts are skipped during symbolic execution") {}
+    
+protected:
+    Program makeProgram() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(make_unique<Assert>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(100))
+        ));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x"), make_unique<Num>(5))
+        ));
+        statements.push_back(TestUtils::makeInputAssign("y"));
+        return Program(std::move(statements));
+    }
+    
+    void verify(SEE& see, map<string, int>& model, bool isSat) override {
+        ValueEnvironment& sigma = see.getSigma();
+        assert(sigma.hasValue("y"));
+        assert(sigma.getValue("y")->exprType == ExprType::SYMVAR);
+        // Only the assume constrains the path
+        assert(see.getPathConstraint().size() == 1);
+        assert(see.getInputSymVars().size() == 2);
+        assert(isSat);
+        SymVar* x = dynamic_cast<SymVar*>(sigma.getValue("x"));
+        assert(x != nullptr);
+        string name = "X" + to_string(x->getNum());
+        assert(model.count(name) && model[name] > 5);
+    }
+};
+
 int main() {
     vector<SEETest*> testcases = {
         new SEETest1(),
@@ -677,7 +779,9 @@ int main() {
         new SEETest7(),
         new SEETest8(),
         new SEETest9(),
-        new SEETest10()
+        new SEETest10(),
+        new SEETest11(),
+        new SEETest12()
     };
     
     cout << "========================================" << endl;
@@ -0,0 +1,289 @@
+#include <iostream>
+#include <cassert>
+#include "ast.hh"
+#include "../../tester/shrinker.hh"
+#include "../../tester/test_utils.hh"
+#include "../../apps/app1/app1.hh"
+using namespace std;
+
+/*
+Spec:
+    Global: y : int
+    Init: y := 0
+    API set: r := set_y(v)
+        Pre:  v > 5
+        Post: r = v
+    API get: r := get_y()
+        Post: r = 0          (wrong once y was set)
+    API f2:  r := f2()
+        Post: r = 0
+    API check: r := check_y(w)
+        Pre:  w > 0
+        Post: r = 0          (check_y is a SUT error unless y was set)
+Any test string with a set before a get fails; the minimal one is [set, get].
+*/
+static unique_ptr<Spec> makeSpec() {
+    vector<unique_ptr<Decl>> globals;
+    globals.push_back(make_unique<Decl>("y", make_unique<TypeConst>("int")));
+    vector<unique_ptr<Init>> inits;
+    inits.push_back(make_unique<Init>("y", make_unique<Num>(0)));
+    vector<unique_ptr<APIFuncDecl>> functions;
+    vector<unique_ptr<API>> blocks;
+
+    {
+        vector<unique_ptr<Expr>> callArgs;
+        callArgs.push_back(make_unique<Var>("v"));
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("set_y", std::move(callArgs)),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(5)),
+            std::move(apiCall),
+            Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Var>("v"))),
+            "set"));
+    }
+    {
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{}),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            nullptr,
+            std::move(apiCall),
+            Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0))),
+            "get"));
+    }
+    {
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f2", vector<unique_ptr<Expr>>{}),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            nullptr,
+            std::move(apiCall),
+            Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0))),
+            "f2"));
+    }
+    {
+        vector<unique_ptr<Expr>> callArgs;
+        callArgs.push_back(make_unique<Var>("w"));
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("check_y", std::move(callArgs)),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("w"), make_unique<Num>(0)),
+            std::move(apiCall),
+            Response(TestUtils::makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0))),
+            "check"));
+    }
+
+    return make_unique<Spec>(std::move(globals), std::move(inits),
+                             std::move(functions), std::move(blocks));
+}
+
+static SymbolTable* makeSymbolTables() {
+    auto* globalTable = new SymbolTable(nullptr);
+    auto* setTable = new SymbolTable(globalTable);
+    setTable->addMapping(new string("v"), nullptr);
+    globalTable->addChild(setTable);
+    globalTable->addChild(new SymbolTable(globalTable));
+    globalTable->addChild(new SymbolTable(globalTable));
+    auto* checkTable = new SymbolTable(globalTable);
+    checkTable->addMapping(new string("w"), nullptr);
+    globalTable->addChild(checkTable);
+    return globalTable;
+}
+
+static void deleteSymbolTables(SymbolTable* globalTable) {
+    for (size_t i = 0; i < globalTable->getChildCount(); i++) {
+        delete globalTable->getChild(i);
+    }
+    delete globalTable;
+}
+
+// App1 plus check_y, which throws until set_y has been called
+class CheckedFactory : public FunctionFactory {
+private:
+    unique_ptr<FunctionFactory> app;
+    bool set;
+
+public:
+    CheckedFactory(unique_ptr<FunctionFactory> app, bool set) : app(std::move(app)), set(set) {}
+
+    unique_ptr<Function> getFunction(string fname, vector<Expr*> args) override {
+        if (fname == "check_y") {
+            if (!set) {
+                throw "check_y before set_y!";
+            }
+            fname = "f2";
+            args.clear();
+        }
+        set = set || fname == "set_y";
+        return app->getFunction(fname, args);
+    }
+
+    unique_ptr<FunctionFactory> snapshot() override {
+        return make_unique<CheckedFactory>(app->snapshot(), set);
+    }
+};
+
+static unique_ptr<FunctionFactory> makeApp1() {
+    return make_unique<CheckedFactory>(make_unique<App1FunctionFactory>(), false);
+}
+
+class ShrinkerTest {
+protected:
+    string testName;
+    virtual vector<string> makeTestString() = 0;
+    virtual void verify(const ShrinkResult& result) = 0;
+
+public:
+    ShrinkerTest(const string& name) : testName(name) {}
+    virtual ~ShrinkerTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+
+        unique_ptr<Spec> spec = makeSpec();
+        SymbolTable* symTable = makeSymbolTables();
+        Shrinker shrinker(spec.get(), symTable, TypeMap(), makeApp1, 4);
+
+        ShrinkResult result = shrinker.shrink(makeTestString());
+        cout << "  Shrunk test string:";
+        for (const auto& name : result.testString) {
+            cout << " " << name;
+        }
+        cout << endl;
+        verify(result);
+
+        deleteSymbolTables(symTable);
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: A long failing string shrinks to [set, get]
+*/
+class ShrinkerTest1 : public ShrinkerTest {
+public:
+    ShrinkerTest1() : ShrinkerTest("Shrink a long failing test string") {}
+
+protected:
+    vector<string> makeTestString() override {
+        return { "f2", "get", "f2", "f2", "set", "f2", "f2", "f2",
+                 "f2", "f2", "get", "f2", "f2", "f2", "f2", "f2" };
+    }
+
+    void verify(const ShrinkResult& result) override {
+        assert((result.testString == vector<string>{"set", "get"}));
+        assert(result.result.status == ReplayStatus::FAILED);
+        assert(result.ctc != nullptr);
+        assert(result.cacheHits > 0);
+    }
+};
+
+/*
+Test 2: An already minimal failing string is kept
+*/
+class ShrinkerTest2 : public ShrinkerTest {
+public:
+    ShrinkerTest2() : ShrinkerTest("Minimal failing test string is kept") {}
+
+protected:
+    vector<string> makeTestString() override {
+        return { "set", "get" };
+    }
+
+    void verify(const ShrinkResult& result) override {
+        assert((result.testString == vector<string>{"set", "get"}));
+        assert(result.result.status == ReplayStatus::FAILED);
+    }
+};
+
+/*
+Test 3: A passing test string is rejected
+*/
+class ShrinkerTest3 : public ShrinkerTest {
+public:
+    ShrinkerTest3() : ShrinkerTest("Passing test string is rejected") {}
+
+    void run() {
+        bool thrown = false;
+        try {
+            execute();
+        } catch (const runtime_error& e) {
+            cout << "  Rejected: " << e.what() << endl;
+            thrown = true;
+        }
+        assert(thrown);
+        cout << "✓ Test passed!" << endl;
+    }
+
+protected:
+    vector<string> makeTestString() override {
+        return { "get", "f2", "set" };
+    }
+
+    void verify(const ShrinkResult& result) override {
+        assert(false);
+    }
+};
+
+/*
+Test 4: Candidates whose generation fails do not abort shrinking
+Chunks that keep check but drop set hit a SUT error during generation.
+*/
+class ShrinkerTest4 : public ShrinkerTest {
+public:
+    ShrinkerTest4() : ShrinkerTest("Generation errors count as passing candidates") {}
+
+protected:
+    vector<string> makeTestString() override {
+        return { "set", "f2", "check", "f2", "check", "get" };
+    }
+
+    void verify(const ShrinkResult& result) override {
+        assert((result.testString == vector<string>{"set", "get"}));
+        assert(result.result.status == ReplayStatus::FAILED);
+    }
+};
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "Running Shrinker Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    vector<ShrinkerTest*> testcases = {
+        new ShrinkerTest1(),
+        new ShrinkerTest2(),
+        new ShrinkerTest4()
+    };
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+        }
+        delete t;
+    }
+
+    ShrinkerTest3 rejected;
+    try {
+        rejected.run();
+        passed++;
+    }
+    catch(const exception& e) {
+        cout << "Test exception: " << e.what() << endl;
+        failed++;
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Shrinker Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "ast.hh"
+#include "specparser.hh"
+using namespace std;
+
+static const string SPEC =
+    "// Users and their passwords\n"
+    "global U : (string -> string) map;\n"
+    "global y : int;\n"
+    "init U = {};\n"
+    "init y = 0;\n"
+    "\n"
+    "block signup {\n"
+    "    pre not_in(u, U);\n"
+    "    call signup(u, p) ==> (code, r);\n"
+    "    post U' = U union {u -> p};\n"
+    "}\n"
+    "\n"
+    "block set {\n"
+    "    pre v > 5 and v <= 100;\n"
+    "    call set_y(v) ==> r;\n"
+    "    post r = v;\n"
+    "}\n"
+    "\n"
+    "block bad {\n"
+    "    pre v < 0 && v > 0;\n"
+    "    call f1(v, v);\n"
+    "}\n";
+
+static const API* findBlock(Spec& spec, const string& name) {
+    for (const auto& b : spec.blocks) {
+        if (b->name == name) return b.get();
+    }
+    return nullptr;
+}
+
+static const FuncCall* call(const Expr* e, const string& name, size_t arity) {
+    const FuncCall* fc = dynamic_cast<const FuncCall*>(e);
+    assert(fc != nullptr);
+    assert(fc->name == name);
+    assert(fc->args.size() == arity);
+    return fc;
+}
+
+class SpecParserTest {
+protected:
+    string testName;
+
+    virtual void run() = 0;
+
+public:
+    SpecParserTest(const string& name) : testName(name) {}
+    virtual ~SpecParserTest() = default;
+
+    void execute() {
+        cout << "\n==================== Test: " << testName << " ====================" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: A whole spec parses into the AST the generators expect
+*/
+class SpecParserTest1 : public SpecParserTest {
+public:
+    SpecParserTest1() : SpecParserTest("Parse a spec") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = SpecParser::parse(SPEC);
+        assert(spec->globals.size() == 2);
+        assert(spec->globals[0]->name == "U");
+        assert(spec->globals[0]->type->toString() == MapType(make_unique<TypeConst>("string"),
+                                                             make_unique<TypeConst>("string")).toString());
+        assert(spec->init.size() == 2);
+        assert(spec->init[0]->expr->exprType == ExprType::MAP);   // {} of a map global
+        assert(spec->blocks.size() == 3);
+
+        const API* signup = findBlock(*spec, "signup");
+        call(signup->pre.get(), "not_in", 2);
+        assert(signup->call->call->name == "signup");
+        assert(signup->call->response.ResponseExpr->exprType == ExprType::TUPLE);
+        const FuncCall* post = call(signup->response.ResponseExpr.get(), "Eq", 2);
+        call(post->args[0].get(), "'", 1);
+        const FuncCall* u = call(post->args[1].get(), "union", 2);
+        assert(u->args[1]->exprType == ExprType::MAP);
+
+        const API* set = findBlock(*spec, "set");
+        const FuncCall* pre = call(set->pre.get(), "And", 2);
+        call(pre->args[0].get(), "Gt", 2);
+        call(pre->args[1].get(), "Le", 2);
+
+        const API* bad = findBlock(*spec, "bad");
+        assert(bad->call->response.ResponseExpr == nullptr);
+        assert(bad->response.ResponseExpr == nullptr);
+        cout << "  Globals, initialisations and 3 blocks parsed" << endl;
+
+        try {
+            SpecParser::parse("global y : int;\ninit y = (1 + ;\n");
+            assert(false);
+        } catch (const runtime_error& e) {
+            assert(string(e.what()).find("line 2") != string::npos);
+            cout << "  Error reported: " << e.what() << endl;
+        }
+        try {
+            SpecParser::parse("block a { call f(); }\nblock a { call g(); }\n");
+            assert(false);
+        } catch (const runtime_error& e) {
+            assert(string(e.what()).find("duplicate block 'a'") != string::npos);
+        }
+    }
+};
+
+/*
+Test 2: Editing one block reparses only that block and keeps identities
+*/
+class SpecParserTest2 : public SpecParserTest {
+public:
+    SpecParserTest2() : SpecParserTest("Incremental edit of one block") {}
+
+protected:
+    void run() override {
+        SpecDocument doc(SPEC);
+        Spec* spec = &doc.getSpec();
+        const API* signup = findBlock(*spec, "signup");
+        const API* set = findBlock(*spec, "set");
+        const Expr* signupPre = signup->pre.get();
+
+        string text = doc.getText();
+        size_t at = text.find("v > 5");
+        SpecDelta delta = doc.edit(at + 4, 1, "7");
+        assert(doc.getLastReparsed() == 1);
+        assert(delta.changedBlocks == vector<string>{ "set" });
+        assert(delta.addedBlocks.empty() && delta.removedBlocks.empty());
+        assert(!delta.globalsChanged && !delta.initChanged);
+
+        assert(&doc.getSpec() == spec);
+        assert(spec->blocks[0].get() == signup && spec->blocks[1].get() == set);
+        assert(signup->pre.get() == signupPre);
+        const FuncCall* gt = call(call(set->pre.get(), "And", 2)->args[0].get(), "Gt", 2);
+        assert(dynamic_cast<const Num*>(gt->args[1].get())->value == 7);
+        cout << "  One block reparsed; Spec and API objects unchanged" << endl;
+
+        // Whitespace and comment edits reparse nothing
+        delta = doc.update(doc.getText() + "\n// trailing comment\n");
+        assert(delta.empty());
+        assert(doc.getLastReparsed() == 0);
+
+        // Ranges of later items move with the edit
+        vector<SpecItem> rescanned = SpecParser::scan(doc.getText(), 0, doc.getText().size());
+        assert(rescanned.size() == doc.getItems().size());
+        for (size_t i = 0; i < rescanned.size(); i++) {
+            assert(rescanned[i].begin == doc.getItems()[i].begin);
+            assert(rescanned[i].end == doc.getItems()[i].end);
+        }
+        cout << "  Item ranges match a full rescan" << endl;
+    }
+};
+
+/*
+Test 3: Adding, removing and breaking blocks
+*/
+class SpecParserTest3 : public SpecParserTest {
+public:
+    SpecParserTest3() : SpecParserTest("Added, removed and invalid blocks") {}
+
+protected:
+    void run() override {
+        SpecDocument doc(SPEC);
+        Spec& spec = doc.getSpec();
+        const API* bad = findBlock(spec, "bad");
+
+        // Insert a block between signup and set: appended, others keep their place
+        string text = doc.getText();
+        SpecDelta delta = doc.edit(text.find("block set"), 0, "block login {\n    call login(u, p) ==> t;\n}\n\n");
+        assert(delta.addedBlocks == vector<string>{ "login" });
+        assert(doc.getLastReparsed() == 1);
+        assert(spec.blocks.size() == 4);
+        assert(spec.blocks[3]->name == "login");
+        assert(spec.blocks[2].get() == bad);
+
+        assert(!delta.renumbersBlocks());
+
+        // Remove signup: the blocks after it move up, so position-keyed
+        // consumers have to be rebuilt
+        text = doc.getText();
+        size_t begin = text.find("block signup");
+        size_t end = text.find("block login");
+        delta = doc.edit(begin, end - begin, "");
+        assert(delta.removedBlocks == vector<string>{ "signup" });
+        assert(delta.renumbersBlocks());
+        assert(spec.blocks.size() == 3);
+        assert(findBlock(spec, "signup") == nullptr);
+        assert(spec.blocks[1].get() == bad && spec.blocks[2]->name == "login");
+        cout << "  Block added at the end, removed block erased, later blocks moved up" << endl;
+
+        // An unterminated block is an error and changes nothing
+        text = doc.getText();
+        size_t close = text.find("}", text.find("block login"));
+        try {
+            doc.edit(close, 1, "");
+            assert(false);
+        } catch (const runtime_error& e) {
+            cout << "  Rejected: " << e.what() << endl;
+        }
+        assert(doc.getText() == text);
+        assert(spec.blocks.size() == 3);
+
+        // A comment that swallows the next item on the same line is seen
+        SpecDocument line("global y : int; init y = 1; init z = 2;");
+        delta = line.update("global y : int; init y = 1; // init z = 2;");
+        assert(delta.initChanged);
+        assert(line.getSpec().init.size() == 1);
+        cout << "  Edits running into later items rescan them" << endl;
+
+        // Changing a global's type reparses the initialisations that depend on it
+        SpecDocument typed("global S : int set;\ninit S = {};\n");
+        assert(typed.getSpec().init[0]->expr->exprType == ExprType::SET);
+        delta = typed.update("global S : (int -> int) map;\ninit S = {};\n");
+        assert(delta.globalsChanged && delta.initChanged);
+        assert(typed.getSpec().init[0]->expr->exprType == ExprType::MAP);
+        cout << "  Type change re-initialises {} as a map" << endl;
+    }
+};
+
+int main() {
+    vector<SpecParserTest*> testcases = {
+        new SpecParserTest1(),
+        new SpecParserTest2(),
+        new SpecParserTest3()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Spec Parser Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Spec Parser Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -13,6 +13,8 @@ protected:
     string testName;
     virtual Program makeAbstractProgram() = 0;
     virtual void verify(Tester& tester, unique_ptr<Program>& result) = 0;
+    // Set generation options before generateCTC runs
+    virtual void configure(Tester& tester) {}
     
 public:
     TesterTest(const string& name) : testName(name) {}
@@ -43,6 +45,7 @@ public:
         FunctionFactory* functionFactory = new App1FunctionFactory();
         
         Tester tester(functionFactory);
+        configure(tester);
         vector<Expr*> initialConcreteVals; // Empty initially
         ValueEnvironment ve(nullptr);
         
@@ -1113,6 +1116,172 @@ protected:
     }
 };
 
+static int assignedValue(const Program& prog, const string& name) {
+    for(const auto& stmt : prog.statements) {
+        if(stmt->statementType != StmtType::ASSIGN) continue;
+        Assign& assign = dynamic_cast<Assign&>(*stmt);
+        Var* left = dynamic_cast<Var*>(assign.left.get());
+        if(left && left->name == name && assign.right->exprType == ExprType::NUM) {
+            return dynamic_cast<Num&>(*assign.right).value;
+        }
+    }
+    throw runtime_error(name + " is not assigned a number");
+}
+
+/*
+Test: One-shot generation, postconditions as API models
+Program:
+    x1 := input()
+    assume(x1 > 0)
+    r1 := f1(x1, 3)
+    assert(r1 = x1 + 3)
+    x2 := input()
+    assume(x2 > r1)
+    assume(x2 < 20)
+    r2 := f1(x2, 0)
+    assert(r2 = x2)
+Expected: x2 depends on the result of f1, yet one query fixes both inputs
+(solving once per API call takes three)
+*/
+class TesterTest8 : public TesterTest {
+public:
+    TesterTest8() : TesterTest("One-shot generation with postconditions as API models") {}
+    
+protected:
+    Program makeAbstractProgram() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x1"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x1"), make_unique<Num>(0))
+        ));
+        statements.push_back(make_unique<Assign>(
+            make_unique<Var>("r1"),
+            TestUtils::makeBinOp("f1", make_unique<Var>("x1"), make_unique<Num>(3))
+        ));
+        statements.push_back(make_unique<Assert>(
+            TestUtils::makeBinOp("Eq", make_unique<Var>("r1"),
+                TestUtils::makeBinOp("Add", make_unique<Var>("x1"), make_unique<Num>(3)))
+        ));
+        statements.push_back(TestUtils::makeInputAssign("x2"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x2"), make_unique<Var>("r1"))
+        ));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Lt", make_unique<Var>("x2"), make_unique<Num>(20))
+        ));
+        statements.push_back(make_unique<Assign>(
+            make_unique<Var>("r2"),
+            TestUtils::makeBinOp("f1", make_unique<Var>("x2"), make_unique<Num>(0))
+        ));
+        statements.push_back(make_unique<Assert>(
+            TestUtils::makeBinOp("Eq", make_unique<Var>("r2"), make_unique<Var>("x2"))
+        ));
+        return Program(std::move(statements));
+    }
+    
+    void configure(Tester& tester) override {
+        tester.setOneShot(true);
+    }
+    
+    void verify(Tester& tester, unique_ptr<Program>& result) override {
+        int x1 = assignedValue(*result, "x1");
+        int x2 = assignedValue(*result, "x2");
+        cout << "x1 = " << x1 << ", x2 = " << x2 << ", iterations = " << tester.getIterations() << endl;
+        assert(x1 > 0);
+        assert(x2 > x1 + 3 && x2 < 20);
+        assert(tester.getIterations() == 1);
+        assert(tester.getDivergences() == 0);
+        cout << "  ✓ Whole test string solved in one query" << endl;
+    }
+};
+
+/*
+Test: One-shot generation falls back when the SUT diverges from the model
+Program:
+    x1 := input()
+    assume(x1 > 0)
+    r1 := f1(x1, 3)
+    assert(r1 = x1 - 3)     (wrong: f1 adds)
+    x2 := input()
+    assume(x2 = r1)
+Expected: the predicted x2 = x1 - 3 fails on the real result, so the inputs
+are solved again once per API call and x2 = x1 + 3
+*/
+class TesterTest9 : public TesterTest {
+public:
+    TesterTest9() : TesterTest("One-shot generation falls back on divergence") {}
+    
+protected:
+    Program makeAbstractProgram() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x1"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("x1"), make_unique<Num>(0))
+        ));
+        statements.push_back(make_unique<Assign>(
+            make_unique<Var>("r1"),
+            TestUtils::makeBinOp("f1", make_unique<Var>("x1"), make_unique<Num>(3))
+        ));
+        statements.push_back(make_unique<Assert>(
+            TestUtils::makeBinOp("Eq", make_unique<Var>("r1"),
+                TestUtils::makeBinOp("Sub", make_unique<Var>("x1"), make_unique<Num>(3)))
+        ));
+        statements.push_back(TestUtils::makeInputAssign("x2"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Eq", make_unique<Var>("x2"), make_unique<Var>("r1"))
+        ));
+        return Program(std::move(statements));
+    }
+    
+    void configure(Tester& tester) override {
+        tester.setOneShot(true);
+    }
+    
+    void verify(Tester& tester, unique_ptr<Program>& result) override {
+        int x1 = assignedValue(*result, "x1");
+        int x2 = assignedValue(*result, "x2");
+        cout << "x1 = " << x1 << ", x2 = " << x2 << ", iterations = " << tester.getIterations() << endl;
+        assert(tester.getDivergences() == 1);
+        assert(tester.getIterations() > 1);
+        assert(x2 == x1 + 3);
+        cout << "  ✓ Divergence detected, inputs solved against the real results" << endl;
+    }
+};
+
+/*
+Test: Model values are matched to the inputs that created them
+Program:
+    x := input()
+    y := input()
+    assume(y > 5)
+Expected: x does not occur in the path constraint, so the model has no value
+for it and x gets 0; y still gets its own value > 5
+*/
+class TesterTest10 : public TesterTest {
+public:
+    TesterTest10() : TesterTest("Unconstrained inputs keep model values aligned") {}
+    
+protected:
+    Program makeAbstractProgram() override {
+        vector<unique_ptr<Stmt>> statements;
+        statements.push_back(TestUtils::makeInputAssign("x"));
+        statements.push_back(TestUtils::makeInputAssign("y"));
+        statements.push_back(make_unique<Assume>(
+            TestUtils::makeBinOp("Gt", make_unique<Var>("y"), make_unique<Num>(5))
+        ));
+        return Program(std::move(statements));
+    }
+    
+    void verify(Tester& tester, unique_ptr<Program>& result) override {
+        int x = assignedValue(*result, "x");
+        int y = assignedValue(*result, "y");
+        cout << "x = " << x << ", y = " << y << endl;
+        assert(x == 0);
+        assert(y > 5);
+        cout << "  ✓ Unconstrained input defaults to 0" << endl;
+    }
+};
+
 int main() {
     cout << "========================================" << endl;
     cout << "Running rewriteATC Test Suite" << endl;
@@ -1158,7 +1327,10 @@ int main() {
         // new TesterTest4(),
         new TesterTest5(),
         new TesterTest6(),
-        new TesterTest7()
+        new TesterTest7(),
+        new TesterTest8(),
+        new TesterTest9(),
+        new TesterTest10()
     };
     
     for(auto& t : integrationTests) {
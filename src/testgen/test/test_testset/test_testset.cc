@@ -0,0 +1,243 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include "ast.hh"
+#include "../../tester/campaign.hh"
+#include "../../tester/testset.hh"
+#include "../../tester/test_utils.hh"
+using namespace std;
+
+static vector<vector<string>> all(const TestSetExpr& e) {
+    return e.take(SIZE_MAX);
+}
+
+static shared_ptr<const TestSetExpr> names(const vector<string>& blocks) {
+    shared_ptr<const TestSetExpr> e;
+    for (const auto& b : blocks) {
+        auto lit = TestSetExpr::literal({ b });
+        e = e ? TestSetExpr::setUnion(e, lit) : lit;
+    }
+    return e;
+}
+
+class TestSetTest {
+protected:
+    string testName;
+    virtual void run() = 0;
+
+public:
+    TestSetTest(const string& name) : testName(name) {}
+    virtual ~TestSetTest() = default;
+
+    void execute() {
+        cout << "\n*********************Test case: " << testName << " *************" << endl;
+        run();
+        cout << "✓ Test passed!" << endl;
+    }
+};
+
+/*
+Test 1: Operators have set semantics
+*/
+class TestSetTest1 : public TestSetTest {
+public:
+    TestSetTest1() : TestSetTest("Set operators") {}
+
+protected:
+    void run() override {
+        auto u = names({ "a", "b", "c", "d" });
+        auto ab = names({ "a", "b", "a" });
+        assert(all(*ab).size() == 2);
+        assert(all(*TestSetExpr::intersection(u, ab)).size() == 2);
+        assert(all(*TestSetExpr::difference(u, ab)) == (vector<vector<string>>{ { "c" }, { "d" } }));
+
+        auto u2 = TestSetExpr::power(u, 2);
+        vector<vector<string>> pairs = all(*u2);
+        assert(pairs.size() == 16);
+        assert(set<vector<string>>(pairs.begin(), pairs.end()).size() == 16);
+        assert(u2->contains({ "d", "a" }) && !u2->contains({ "a" }) && !u2->contains({ "a", "e" }));
+        assert(all(*TestSetExpr::power(u, 0)) == vector<vector<string>>{ {} });
+
+        // p+qr and pq+r are the same test string
+        auto left = TestSetExpr::setUnion(TestSetExpr::literal({ "p" }), TestSetExpr::literal({ "p", "q" }));
+        auto right = TestSetExpr::setUnion(TestSetExpr::literal({ "q", "r" }), TestSetExpr::literal({ "r" }));
+        vector<vector<string>> products = all(*TestSetExpr::product(left, right));
+        assert(products.size() == 3);
+        assert(set<vector<string>>(products.begin(), products.end()).size() == 3);
+
+        auto unique = TestSetExpr::unique(u2, 1);
+        assert(all(*unique).size() == 12);
+        assert(!unique->contains({ "a", "a" }) && unique->contains({ "a", "b" }));
+    }
+};
+
+/*
+Test 2: The prototype's example program (src/ocaml/input.txt)
+*/
+class TestSetTest2 : public TestSetTest {
+public:
+    TestSetTest2() : TestSetTest("Parsing the OCaml example") {}
+
+protected:
+    void run() override {
+        const string program = R"(
+            u = {api_a() -> ();} |
+                {api_b() -> ();} |
+                {api_c() -> ();} |
+                {api_d() -> ();} ;
+
+            fixed = {
+                api_1(int arg1) -> (int res1);
+                api_2(int arg2) -> (string res2);
+                api_3(string arg3) -> (string response);
+                ASSUME res1 == arg2 && res2 == arg3;
+                ASSERT response == "OK";
+            };
+
+            result = (u ^ 2 * fixed * u ^ 2) WHERE UNIQUE(1);
+            RETURN result;
+        )";
+        map<string, shared_ptr<const TestSetExpr>> named;
+        shared_ptr<const TestSetExpr> result = TestSetParser::parse(program, &named);
+        assert(named.size() == 3);
+        assert(all(*named["fixed"]) == (vector<vector<string>>{ { "api_1", "api_2", "api_3" } }));
+
+        vector<vector<string>> tests = all(*result);
+        cout << "  " << tests.size() << " test strings" << endl;
+        assert(tests.size() == 24);   // 4 * 3 * 2 * 1 orders of the u blocks
+        for (const auto& ts : tests) {
+            assert(ts.size() == 7 && ts[2] == "api_1" && ts[4] == "api_3");
+            assert(result->contains(ts));
+        }
+
+        // Precedence: ^ over * over & and / over |
+        auto e = TestSetParser::parse("a = {x}; b = {y}; RETURN a | a * b ^ 2 / {x; y; y};");
+        assert(all(*e) == vector<vector<string>>{ { "x" } });
+    }
+};
+
+/*
+Test 3: A product with ~10^12 elements streams without being materialized
+*/
+class TestSetTest3 : public TestSetTest {
+public:
+    TestSetTest3() : TestSetTest("Lazy evaluation of huge products") {}
+
+protected:
+    void run() override {
+        auto start = chrono::steady_clock::now();
+        auto huge = TestSetParser::parse("u = {a} | {b} | {c} | {d}; RETURN u ^ 20 | u ^ 19;");
+        vector<vector<string>> first = huge->take(2000);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        assert(first.size() == 2000);
+        assert(set<vector<string>>(first.begin(), first.end()).size() == 2000);
+        for (const auto& ts : first) {
+            assert(ts.size() == 20);
+        }
+        vector<string> probe(19, "c");
+        assert(huge->contains(probe));
+        probe.push_back("e");
+        assert(!huge->contains(probe));
+        cout << "  First 2000 of 4^20 + 4^19 test strings in " << ms << " ms" << endl;
+        assert(ms < 5000);
+    }
+};
+
+/*
+Test 4: Errors name the line
+*/
+class TestSetTest4 : public TestSetTest {
+public:
+    TestSetTest4() : TestSetTest("Parse errors") {}
+
+protected:
+    void run() override {
+        const vector<string> bad = {
+            "a = {x};\nRETURN b;",
+            "a = {x}",
+            "a = {x} WHERE UNIQUE(z); RETURN a;",
+            "a = ({x} | {y}; RETURN a;"
+        };
+        for (const auto& program : bad) {
+            bool threw = false;
+            try {
+                TestSetParser::parse(program);
+            } catch (const runtime_error& e) {
+                threw = true;
+                cout << "  " << e.what() << endl;
+                assert(string(e.what()).find("line") != string::npos);
+            }
+            assert(threw);
+        }
+    }
+};
+
+/*
+Test 5: A test-set stream drives a campaign
+*/
+class TestSetTest5 : public TestSetTest {
+public:
+    TestSetTest5() : TestSetTest("Campaign from a test-set stream") {}
+
+protected:
+    void run() override {
+        unique_ptr<Spec> spec = TestUtils::makeSampleSpec();
+        SymbolTable* symTable = TestUtils::makeSampleSymbolTables();
+        Campaign campaign(spec.get(), symTable, TypeMap(),
+                          TestUtils::makeSampleFactory);
+
+        auto tests = TestSetParser::parse("s = {f2} | {set}; RETURN s ^ 2 | s ^ 100;");
+        unique_ptr<TestSetStream> stream = tests->stream();
+        vector<CampaignEntry> entries = campaign.run(*stream, 4);
+        assert(entries.size() == 4);
+        for (const auto& e : entries) {
+            assert(e.testString.size() == 2);
+            assert(e.result.status == ReplayStatus::PASSED);
+        }
+        assert(campaign.getCoverage().count() > 0);
+        TestUtils::deleteSampleSymbolTables(symTable);
+    }
+};
+
+int main() {
+    vector<TestSetTest*> testcases = {
+        new TestSetTest1(),
+        new TestSetTest2(),
+        new TestSetTest3(),
+        new TestSetTest4(),
+        new TestSetTest5()
+    };
+
+    cout << "========================================" << endl;
+    cout << "Running Test Set Test Suite" << endl;
+    cout << "========================================" << endl;
+
+    int passed = 0;
+    int failed = 0;
+
+    for(auto& t : testcases) {
+        try {
+            t->execute();
+            passed++;
+            delete t;
+        }
+        catch(const exception& e) {
+            cout << "Test exception: " << e.what() << endl;
+            failed++;
+            delete t;
+        }
+        catch(...) {
+            cout << "Unknown test exception" << endl;
+            failed++;
+            delete t;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "Test Set Test Results: " << passed << " passed, " << failed << " failed" << endl;
+    cout << "========================================" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
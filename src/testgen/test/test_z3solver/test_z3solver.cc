@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -694,6 +695,197 @@ protected:
     }
 };
 
+/*
+Test: Conjuncts of one shape over permuted variables (template instantiation)
+Constraint: (Xa - Xb < 0) AND (Xb - Xc < 0) AND (Xc - Xa < 3)
+Expected: SAT with b = a + 1, c = a + 2
+*/
+class Z3Test15 : public Z3Test {
+private:
+    string a, b, c;
+
+public:
+    Z3Test15() : Z3Test("Repeated predicate shape over renamed variables") {}
+    
+protected:
+    unique_ptr<Expr> makeConstraint() override {
+        unique_ptr<SymVar> xa = SymVar::getNewSymVar();
+        unique_ptr<SymVar> xb = SymVar::getNewSymVar();
+        unique_ptr<SymVar> xc = SymVar::getNewSymVar();
+        a = "X" + to_string(xa->getNum());
+        b = "X" + to_string(xb->getNum());
+        c = "X" + to_string(xc->getNum());
+
+        CloneVisitor cloner;
+        auto less = [&cloner](SymVar* l, SymVar* r, int bound) {
+            return TestUtils::makeBinOp("Lt",
+                TestUtils::makeBinOp("Sub", cloner.cloneExpr(l), cloner.cloneExpr(r)),
+                make_unique<Num>(bound));
+        };
+        // The first two conjuncts share a shape; the second one maps its
+        // slots onto a partly overlapping set of variables
+        return TestUtils::makeBinOp("And",
+            TestUtils::makeBinOp("And", less(xa.get(), xb.get(), 0), less(xb.get(), xc.get(), 0)),
+            less(xc.get(), xa.get(), 3));
+    }
+    
+    void verify(const Result& result) override {
+        assert(result.isSat);
+        assert(result.model.size() == 3);
+        int va = dynamic_cast<const IntResultValue*>(result.model.at(a).get())->value;
+        int vb = dynamic_cast<const IntResultValue*>(result.model.at(b).get())->value;
+        int vc = dynamic_cast<const IntResultValue*>(result.model.at(c).get())->value;
+        assert(vb == va + 1 && vc == va + 2);
+
+        // Same shape again on one solver: translated once, instantiated after
+        Z3Solver solver;
+        for (int i = 0; i < 3; i++) {
+            unique_ptr<SymVar> x = SymVar::getNewSymVar();
+            assert(solver.solve(TestUtils::makeBinOp("Gt", std::move(x), make_unique<Num>(i))).isSat);
+        }
+        assert(solver.getTemplateCount() == 3);
+        unique_ptr<SymVar> y = SymVar::getNewSymVar();
+        CloneVisitor cloner;
+        assert(!solver.solve(TestUtils::makeBinOp("And",
+            TestUtils::makeBinOp("Gt", cloner.cloneExpr(y.get()), make_unique<Num>(2)),
+            TestUtils::makeBinOp("Lt", cloner.cloneExpr(y.get()), make_unique<Num>(1)))).isSat);
+        unique_ptr<SymVar> z = SymVar::getNewSymVar();
+        assert(solver.solve(TestUtils::makeBinOp("Gt", std::move(z), make_unique<Num>(1))).isSat);
+        assert(solver.getTemplateCount() == 4 && solver.getTemplateHits() == 2);
+
+        cout << "Verification: " << b << " = " << a << " + 1, " << c << " = " << a
+             << " + 2; templates reused across queries" << endl;
+    }
+};
+
+/*
+Test: List operations with bounded lists, with sequences, and past the bound
+Constraint: length(L) = n AND at(L, 0) = 7 AND prefix(M, L) AND length(M) = n - 1
+            AND suffix(N, L) AND length(N) = 1 AND at(N, 0) = 9
+            AND contains_seq(L, N) AND Eq(concat(M, N), L)
+Expected: SAT with L = [7, ..., 9], M = L without its last element, N = [9]
+*/
+class Z3Test16 : public Z3Test {
+public:
+    Z3Test16() : Z3Test("Lists as bounded length and array") {}
+
+protected:
+    static unique_ptr<Expr> call(const string& name, unique_ptr<Expr> a, unique_ptr<Expr> b = nullptr) {
+        vector<unique_ptr<Expr>> args;
+        args.push_back(std::move(a));
+        if (b) {
+            args.push_back(std::move(b));
+        }
+        return make_unique<FuncCall>(name, std::move(args));
+    }
+
+    static unique_ptr<Expr> var(const string& name) {
+        return make_unique<Var>(name);
+    }
+
+    static unique_ptr<Expr> listConstraint(int n) {
+        auto eq = [](unique_ptr<Expr> l, unique_ptr<Expr> r) {
+            return TestUtils::makeBinOp("Eq", std::move(l), std::move(r));
+        };
+        vector<unique_ptr<Expr>> conjuncts;
+        conjuncts.push_back(eq(call("length", var("L")), make_unique<Num>(n)));
+        conjuncts.push_back(eq(call("at", var("L"), make_unique<Num>(0)), make_unique<Num>(7)));
+        conjuncts.push_back(call("prefix", var("M"), var("L")));
+        conjuncts.push_back(eq(call("length", var("M")), make_unique<Num>(n - 1)));
+        conjuncts.push_back(call("suffix", var("N"), var("L")));
+        conjuncts.push_back(eq(call("length", var("N")), make_unique<Num>(1)));
+        conjuncts.push_back(eq(call("at", var("N"), make_unique<Num>(0)), make_unique<Num>(9)));
+        conjuncts.push_back(call("contains_seq", var("L"), var("N")));
+        conjuncts.push_back(eq(call("concat", var("M"), var("N")), var("L")));
+        unique_ptr<Expr> formula = std::move(conjuncts.back());
+        for (size_t i = conjuncts.size() - 1; i-- > 0;) {
+            formula = TestUtils::makeBinOp("And", std::move(conjuncts[i]), std::move(formula));
+        }
+        return formula;
+    }
+
+    static string listValue(const Result& result, const string& name) {
+        return dynamic_cast<const StringResultValue*>(result.model.at(name).get())->value;
+    }
+
+    static size_t elements(const string& list) {
+        return list == "[]" ? 0 : count(list.begin(), list.end(), ',') + 1;
+    }
+
+    unique_ptr<Expr> makeConstraint() override {
+        return TestUtils::makeBinOp("Gt", make_unique<Num>(1), make_unique<Num>(0));
+    }
+
+    void verify(const Result&) override {
+        TypeMap typeMap;
+        for (const string name : { "L", "M", "N" }) {
+            typeMap.setValue(name, new TypeConst("list"));
+        }
+
+        for (size_t bound : { 4, 0 }) {
+            Z3Solver solver(&typeMap);
+            solver.setListBound(bound);
+            Result result = solver.solve(listConstraint(3));
+            assert(result.isSat);
+            string l = listValue(result, "L"), m = listValue(result, "M"), n = listValue(result, "N");
+            cout << "bound " << bound << ": L = " << l << ", M = " << m << ", N = " << n << endl;
+            assert(elements(l) == 3 && l.compare(0, 4, "[7, ") == 0 && l.substr(l.size() - 4) == ", 9]");
+            assert(m == l.substr(0, l.size() - 4) + "]" && n == "[9]");
+            assert(result.model.count("L!len") == 0);
+        }
+
+        // Past the bound: solved with sequences
+        Z3Solver solver(&typeMap);
+        solver.setListBound(4);
+        Result longer = solver.solve(listConstraint(6));
+        assert(longer.isSat && elements(listValue(longer, "L")) == 6);
+        assert(solver.getListRetries() == 1);
+        // Unsat whatever the bound: not solved again
+        assert(!solver.solve(listConstraint(0)).isSat);
+        assert(solver.getListRetries() == 1);
+        cout << "Verification: bounded lists, sequences and the fallback agree" << endl;
+    }
+};
+
+/*
+Test: Integers used as booleans
+Constraint: And(1, X > 3)
+Expected: SAT with X > 3; And(0, X > 3) is UNSAT, Not(0) and a bare 1 are SAT
+(an integer is true iff it is not 0)
+*/
+class Z3Test17 : public Z3Test {
+public:
+    Z3Test17() : Z3Test("Integers coerced to booleans") {}
+
+protected:
+    static unique_ptr<Expr> gtThree(const SymVar& x) {
+        CloneVisitor cloner;
+        return TestUtils::makeBinOp("Gt", cloner.cloneExpr(&x), make_unique<Num>(3));
+    }
+
+    unique_ptr<Expr> makeConstraint() override {
+        x = SymVar::getNewSymVar();
+        return TestUtils::makeBinOp("And", make_unique<Num>(1), gtThree(*x));
+    }
+
+    void verify(const Result& result) override {
+        assert(result.isSat);
+        string name = "X" + to_string(x->getNum());
+        assert(dynamic_cast<const IntResultValue*>(result.model.at(name).get())->value > 3);
+
+        Z3Solver solver;
+        assert(!solver.solve(TestUtils::makeBinOp("And", make_unique<Num>(0), gtThree(*x))).isSat);
+        vector<unique_ptr<Expr>> args;
+        args.push_back(make_unique<Num>(0));
+        assert(solver.solve(make_unique<FuncCall>("Not", std::move(args))).isSat);
+        assert(solver.solve(make_unique<Num>(1)).isSat);
+        cout << "Verification: non-zero integers are true, 0 is false" << endl;
+    }
+
+private:
+    unique_ptr<SymVar> x;
+};
+
 int main() {
     vector<Z3Test*> testcases = {
         new Z3Test1(),
@@ -709,7 +901,10 @@ int main() {
         new Z3Test11(),
         new Z3Test12(),
         new Z3Test13(),
-        new Z3Test14()
+        new Z3Test14(),
+        new Z3Test15(),
+        new Z3Test16(),
+        new Z3Test17()
     };
     
     cout << "========================================" << endl;
@@ -0,0 +1,392 @@
+#include "campaign.hh"
+#include "countershards.hh"
+#include "genATC.hh"
+#include "mpscqueue.hh"
+#include "tester.hh"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+Campaign::Campaign(const Spec* spec, SymbolTable* globalSymTable, TypeMap typeMap,
+                   ReplayRunner::FactoryMaker makeFactory)
+    : spec(spec), globalSymTable(globalSymTable), typeMap(std::move(typeMap)),
+      makeFactory(std::move(makeFactory)), coverageMap(spec), coverage(coverageMap.size()),
+      hybridSolver(nullptr), termBudget(0), oneShot(false), governor(nullptr), slowQueryMs(0), lastStats{ 0, 0, 0, 0, 0 } {}
+
+unique_ptr<Program> Campaign::generate(const vector<string>& testString, double sliceMs,
+                                       const HybridSolver* hs, size_t* iterations) const {
+    auto start = chrono::steady_clock::now();
+    ATCGenerator generator(spec, typeMap);
+    Program atc = generator.generate(spec, globalSymTable, testString);
+
+    unique_ptr<Program> atcCopy = make_unique<Program>(
+        std::move(const_cast<vector<unique_ptr<Stmt>>&>(atc.statements))
+    );
+
+    unique_ptr<FunctionFactory> factory = makeFactory();
+    Tester tester(factory.get());
+    tester.setHybridSolver(hs);
+    tester.setTermBudget(termBudget);
+    tester.setOneShot(oneShot);
+    tester.setSlowQueryThreshold(slowQueryMs);
+    tester.setListBound(spec->maxListLength);
+    if (sliceMs > 0) {
+        tester.setDeadline(start + chrono::microseconds(int64_t(sliceMs * 1000)));
+    }
+    vector<size_t> positions;
+    if (slowQueryMs > 0) {
+        positions = statementPositions(testString, *atcCopy);
+    }
+    ValueEnvironment ve(nullptr);
+    unique_ptr<Program> ctc;
+    try {
+        ctc = tester.generateCTC(std::move(atcCopy), {}, &ve);
+    } catch (...) {
+        // A slow query often ends in a deadline: keep it
+        collectSlowQueries(tester, testString, positions);
+        throw;
+    }
+    collectSlowQueries(tester, testString, positions);
+    if (iterations) {
+        *iterations = tester.getIterations();
+    }
+    return ctc;
+}
+
+void Campaign::collectSlowQueries(Tester& tester, const vector<string>& testString,
+                                  const vector<size_t>& positions) const {
+    vector<RecordedQuery>& recorded = tester.getSlowQueries();
+    if (recorded.empty()) {
+        return;
+    }
+    lock_guard<mutex> guard(slowLock);
+    for (auto& query : recorded) {
+        query.testString = testString;
+        query.positions.clear();
+        for (size_t stmt : query.statements) {
+            query.positions.push_back(stmt < positions.size() ? positions[stmt] : SIZE_MAX);
+        }
+        slowQueries.push_back(std::move(query));
+    }
+    recorded.clear();
+}
+
+vector<RecordedQuery> Campaign::takeSlowQueries() {
+    lock_guard<mutex> guard(slowLock);
+    vector<RecordedQuery> taken = std::move(slowQueries);
+    slowQueries.clear();
+    return taken;
+}
+
+CampaignEntry Campaign::execute(const vector<string>& testString, size_t testId, double sliceMs,
+                                const HybridSolver* hs) const {
+    auto start = chrono::steady_clock::now();
+    size_t iterations = 0;
+    unique_ptr<Program> ctc = generate(testString, sliceMs, hs, &iterations);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    CampaignEntry entry = replayEntry(testString, std::move(ctc), testId);
+    entry.generationMs = elapsed.count();
+    entry.iterations = iterations;
+    return entry;
+}
+
+CampaignEntry Campaign::executeCaught(const vector<string>& testString, size_t testId,
+                                      const HybridSolver* hs) const {
+    CampaignEntry entry;
+    try {
+        entry = execute(testString, testId, 0, hs);
+    } catch (const exception& e) {
+        entry.testString = testString;
+        entry.result = { testId, ReplayStatus::ERROR, -1, e.what(), 0 };
+    } catch (const char* e) {
+        entry.testString = testString;
+        entry.result = { testId, ReplayStatus::ERROR, -1, e, 0 };
+    }
+    return entry;
+}
+
+CampaignEntry Campaign::replayEntry(const vector<string>& testString, unique_ptr<Program> ctc,
+                                    size_t testId) const {
+    CampaignEntry entry;
+    entry.testString = testString;
+    entry.ctc = std::move(ctc);
+
+    CoverageCollector collector(coverageMap, spec, testString);
+    unique_ptr<FunctionFactory> sut = makeFactory();
+    entry.result = ReplayRunner::replay(*entry.ctc, *sut, testId, &collector, oracles.get());
+    entry.coverage = collector.getBitmap();
+    entry.newPoints = 0;
+    return entry;
+}
+
+unique_ptr<Program> Campaign::generateCTC(const vector<string>& testString, double sliceMs) {
+    return generate(testString, sliceMs, hybridSolver);
+}
+
+CampaignEntry Campaign::runTestString(const vector<string>& testString, size_t testId,
+                                      double sliceMs) {
+    CampaignEntry entry = execute(testString, testId, sliceMs, hybridSolver);
+    entry.newPoints = coverage.merge(entry.coverage);
+    return entry;
+}
+
+CampaignEntry Campaign::runCaught(const vector<string>& testString, size_t testId) {
+    CampaignEntry entry = executeCaught(testString, testId, hybridSolver);
+    entry.newPoints = coverage.merge(entry.coverage);
+    return entry;
+}
+
+CampaignEntry Campaign::replayCTC(const vector<string>& testString, unique_ptr<Program> ctc,
+                                  size_t testId) {
+    CampaignEntry entry = replayEntry(testString, std::move(ctc), testId);
+    entry.newPoints = coverage.merge(entry.coverage);
+    return entry;
+}
+
+bool Campaign::admitNext() const {
+    if (!governor || governor->admit()) {
+        return true;
+    }
+    cout << "[CAMPAIGN] Near the memory budget, no more test strings admitted" << endl;
+    return false;
+}
+
+vector<CampaignEntry> Campaign::run(CoverageScheduler& scheduler, size_t maxTests,
+                                    size_t stallLimit) {
+    vector<CampaignEntry> entries;
+    size_t stalled = 0;
+
+    while (entries.size() < maxTests && scheduler.hasNext(coverage) && admitNext()) {
+        vector<string> testString = scheduler.next(coverage);
+        CoverageBitmap before = coverage;
+        CampaignEntry entry = runCaught(testString, entries.size());
+        scheduler.update(testString, before.newBits(entry.coverage));
+
+        cout << "[CAMPAIGN] test " << entries.size() << ": ";
+        for (const auto& name : testString) {
+            cout << name << " ";
+        }
+        cout << "-> " << replayStatusToString(entry.result.status)
+             << ", +" << entry.newPoints << " points ("
+             << coverage.count() << "/" << coverageMap.size() << ")" << endl;
+
+        stalled = (entry.newPoints == 0) ? stalled + 1 : 0;
+        entries.push_back(std::move(entry));
+        if (stallLimit > 0 && stalled >= stallLimit) {
+            cout << "[CAMPAIGN] No new coverage in " << stalled << " test strings, stopping" << endl;
+            break;
+        }
+    }
+    return entries;
+}
+
+vector<CampaignEntry> Campaign::run(TestStringSampler& sampler, size_t count, size_t length) {
+    vector<CampaignEntry> entries;
+    for (size_t i = 0; i < count && admitNext(); i++) {
+        vector<string> testString = sampler.sample(length);
+        CampaignEntry entry = runCaught(testString, i);
+
+        ReplayStatus status = entry.result.status;
+        bool feasible = (status == ReplayStatus::PASSED || status == ReplayStatus::FAILED);
+        sampler.record(testString, feasible, entry.newPoints, blamePosition(entry));
+
+        cout << "[CAMPAIGN] sampled test " << i << ": " << testString.size() << " blocks -> "
+             << replayStatusToString(status) << ", +" << entry.newPoints << " points" << endl;
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+vector<CampaignEntry> Campaign::run(TestSetStream& testSet, size_t maxTests) {
+    vector<CampaignEntry> entries;
+    vector<string> testString;
+    while (entries.size() < maxTests && admitNext() && testSet.next(testString)) {
+        CampaignEntry entry = runCaught(testString, entries.size());
+        cout << "[CAMPAIGN] test " << entries.size() << ": " << testString.size() << " blocks -> "
+             << replayStatusToString(entry.result.status) << ", +" << entry.newPoints
+             << " points" << endl;
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+vector<CampaignEntry> Campaign::runParallel(const vector<vector<string>>& testStrings,
+                                            unsigned int workers) {
+    if (workers == 0) {
+        workers = max(1u, thread::hardware_concurrency());
+    }
+    workers = max<size_t>(1, min<size_t>(workers, testStrings.size()));
+
+    // Counters per worker: one per ReplayStatus, then new points
+    const size_t NEW_POINTS = 4;
+    CounterShards counters(workers, NEW_POINTS + 1);
+    AtomicCoverageBitmap shared(coverage);
+    MpscQueue<pair<size_t, CampaignEntry>> finished;
+    atomic<size_t> next(0);
+    atomic<size_t> active(0);
+    // The hybrid solver's statistics and random engine are not thread-safe:
+    // every worker samples with its own copy
+    vector<unique_ptr<HybridSolver>> solvers;
+    if (hybridSolver) {
+        for (unsigned int w = 0; w < workers; w++) {
+            solvers.push_back(make_unique<HybridSolver>(*hybridSolver, w + 1));
+        }
+    }
+
+    auto work = [&](size_t shard) {
+        for (size_t i = next.fetch_add(1); i < testStrings.size(); i = next.fetch_add(1)) {
+            // Backpressure: near the memory budget, wait for the test strings
+            // in flight; once none is left, go ahead
+            if (governor && !governor->admit()) {
+                cout << "[CAMPAIGN] test " << i << " waits for memory" << endl;
+                while (active.load() > 0 && !governor->admit()) {
+                    this_thread::sleep_for(chrono::milliseconds(10));
+                }
+            }
+            active++;
+            CampaignEntry entry = executeCaught(testStrings[i], i,
+                                                solvers.empty() ? nullptr : solvers[shard].get());
+            active--;
+            entry.newPoints = shared.merge(entry.coverage);
+            counters.add(shard, size_t(entry.result.status));
+            counters.add(shard, NEW_POINTS, entry.newPoints);
+            finished.push({ i, std::move(entry) });
+        }
+    };
+    vector<thread> pool;
+    for (unsigned int w = 0; w < workers; w++) {
+        pool.emplace_back(work, w);
+    }
+
+    // Single writer: restore input order from the sequence numbers
+    vector<CampaignEntry> entries(testStrings.size());
+    vector<bool> arrived(testStrings.size(), false);
+    size_t received = 0, emitted = 0;
+    pair<size_t, CampaignEntry> item;
+    while (received < testStrings.size()) {
+        if (!finished.tryPop(item)) {
+            this_thread::yield();
+            continue;
+        }
+        received++;
+        entries[item.first] = std::move(item.second);
+        arrived[item.first] = true;
+        for (; emitted < entries.size() && arrived[emitted]; emitted++) {
+            cout << "[CAMPAIGN] test " << emitted << " -> "
+                 << replayStatusToString(entries[emitted].result.status)
+                 << ", +" << entries[emitted].newPoints << " points" << endl;
+        }
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (hybridSolver) {
+        hybridSolver->absorb(solvers);
+    }
+
+    coverage.merge(shared.snapshot());
+    lastStats = { size_t(counters.read(size_t(ReplayStatus::PASSED))),
+                  size_t(counters.read(size_t(ReplayStatus::FAILED))),
+                  size_t(counters.read(size_t(ReplayStatus::INFEASIBLE))),
+                  size_t(counters.read(size_t(ReplayStatus::ERROR))),
+                  size_t(counters.read(NEW_POINTS)) };
+    return entries;
+}
+
+vector<size_t> Campaign::statementPositions(const vector<string>& testString,
+                                            const Program& ctc) const {
+    // genATC layout: init statements, then per block its inputs, assume,
+    // old-value copies and API call, followed by the assert if it has a post
+    vector<size_t> positions(ctc.statements.size(), SIZE_MAX);
+    size_t i = min(spec->init.size(), ctc.statements.size());
+    for (size_t pos = 0; pos < testString.size(); pos++) {
+        for (size_t b : coverageMap.blocksNamed(testString[pos])) {
+            const API& block = *spec->blocks[b];
+            while (i < ctc.statements.size()) {
+                const Stmt& stmt = *ctc.statements[i];
+                positions[i++] = pos;
+                if (stmt.statementType == StmtType::ASSIGN) {
+                    const Assign& assign = dynamic_cast<const Assign&>(stmt);
+                    if (assign.right->exprType == ExprType::FUNCCALL &&
+                        dynamic_cast<const FuncCall&>(*assign.right).name == block.call->call->name) {
+                        break;
+                    }
+                }
+            }
+            if (block.response.ResponseExpr && i < ctc.statements.size() &&
+                ctc.statements[i]->statementType == StmtType::ASSERT) {
+                positions[i++] = pos;
+            }
+        }
+    }
+    return positions;
+}
+
+size_t Campaign::blamePosition(const CampaignEntry& entry) const {
+    if (!entry.ctc) {
+        return SIZE_MAX;
+    }
+    vector<size_t> positions = statementPositions(entry.testString, *entry.ctc);
+
+    // Replay reached an assume that does not hold
+    if (entry.result.status == ReplayStatus::INFEASIBLE && entry.result.stmtIndex >= 0) {
+        return positions[entry.result.stmtIndex];
+    }
+    // Generation got stuck: the first input() left is in the first block
+    // whose path constraint could not be solved
+    if (entry.result.status == ReplayStatus::ERROR) {
+        for (size_t i = 0; i < entry.ctc->statements.size(); i++) {
+            const Stmt& stmt = *entry.ctc->statements[i];
+            if (stmt.statementType != StmtType::ASSIGN) continue;
+            const Expr& right = *dynamic_cast<const Assign&>(stmt).right;
+            if (right.exprType == ExprType::FUNCCALL &&
+                dynamic_cast<const FuncCall&>(right).name == "input") {
+                return positions[i];
+            }
+        }
+    }
+    return SIZE_MAX;
+}
+
+size_t Campaign::compileOracles(const string& compiler) {
+    // Declared scalar types of the globals; block-local variables are ints
+    map<string, string> types;
+    for (const auto& decl : spec->globals) {
+        const TypeConst* scalar = dynamic_cast<const TypeConst*>(decl->type.get());
+        types[decl->name] = scalar ? scalar->name : "composite";
+    }
+
+    auto library = make_unique<OracleLibrary>();
+    size_t predicates = 0;
+    for (const auto& block : spec->blocks) {
+        // A one-block ATC holds the block's predicates exactly as every CTC does
+        ATCGenerator generator(spec, typeMap);
+        Program atc = generator.generate(spec, globalSymTable, { block->name });
+        for (const auto& stmt : atc.statements) {
+            const Expr* predicate = nullptr;
+            if (stmt->statementType == StmtType::ASSUME) {
+                predicate = dynamic_cast<const Assume&>(*stmt).expr.get();
+            } else if (stmt->statementType == StmtType::ASSERT) {
+                predicate = dynamic_cast<const Assert&>(*stmt).expr.get();
+            }
+            if (predicate) {
+                predicates++;
+                library->add(*predicate, types);
+            }
+        }
+    }
+    library->compile(compiler);
+    cout << "[ORACLE] " << library->size() << "/" << predicates
+         << " predicates compiled to native code" << endl;
+    oracles = std::move(library);
+    return oracles->size();
+}
+
+void Campaign::printCoverage() const {
+    cout << "[COVERAGE] " << coverage.count() << "/" << coverageMap.size() << " points" << endl;
+    for (size_t i = 0; i < coverageMap.size(); i++) {
+        cout << "  [" << (coverage.test(i) ? "x" : " ") << "] " << coverageMap.describe(i) << endl;
+    }
+}
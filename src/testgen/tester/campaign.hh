@@ -0,0 +1,213 @@
+#ifndef CAMPAIGN_HH
+#define CAMPAIGN_HH
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+#include "../language/typemap.hh"
+#include "../see/hybridsolver.hh"
+#include "../see/oraclelibrary.hh"
+#include "coverage.hh"
+#include "memorygovernor.hh"
+#include "replay.hh"
+#include "testset.hh"
+#include "teststringsampler.hh"
+#include "tester.hh"
+
+using namespace std;
+
+/**
+ * One executed test string of a campaign
+ */
+struct CampaignEntry {
+    vector<string> testString;
+    unique_ptr<Program> ctc;
+    ReplayResult result;
+    CoverageBitmap coverage;   // points hit by this CTC
+    size_t newPoints;          // points it added to the global coverage
+    double generationMs = 0;   // wall time spent generating the CTC
+    size_t iterations = 0;     // path constraints solved during generation
+};
+
+/**
+ * Totals over the last runParallel()
+ */
+struct CampaignStats {
+    size_t passed;
+    size_t failed;
+    size_t infeasible;
+    size_t errors;
+    size_t newPoints;
+};
+
+/**
+ * Campaign: runs test strings end to end (genATC -> CTC -> replay) and keeps
+ * the global coverage of the spec's pre/postconditions.
+ *
+ * run() lets a CoverageScheduler pick the test strings, so test strings that
+ * only re-exercise already covered disjuncts and comparison outcomes are
+ * tried last (or not at all).
+ */
+class Campaign {
+private:
+    const Spec* spec;
+    SymbolTable* globalSymTable;
+    TypeMap typeMap;
+    ReplayRunner::FactoryMaker makeFactory;
+    CoverageMap coverageMap;
+    CoverageBitmap coverage;
+    const HybridSolver* hybridSolver;
+    size_t termBudget;
+    bool oneShot;
+    MemoryGovernor* governor;
+    double slowQueryMs;
+    mutable mutex slowLock;
+    mutable vector<RecordedQuery> slowQueries;
+    CampaignStats lastStats;
+    unique_ptr<OracleLibrary> oracles;
+
+    unique_ptr<Program> generate(const vector<string>& testString, double sliceMs,
+                                 const HybridSolver* hs, size_t* iterations = nullptr) const;
+    CampaignEntry execute(const vector<string>& testString, size_t testId, double sliceMs,
+                          const HybridSolver* hs) const;
+    CampaignEntry replayEntry(const vector<string>& testString, unique_ptr<Program> ctc,
+                              size_t testId) const;
+    // execute() that records a failed generation as an ERROR entry
+    CampaignEntry executeCaught(const vector<string>& testString, size_t testId,
+                                const HybridSolver* hs) const;
+    // runTestString() for the run() loops: a failed generation becomes an
+    // ERROR entry as in runParallel() instead of ending the campaign
+    CampaignEntry runCaught(const vector<string>& testString, size_t testId);
+    // Whether the memory governor (if any) lets another test string start
+    bool admitNext() const;
+    // Keep the slow queries a Tester recorded, with their blocks
+    void collectSlowQueries(Tester& tester, const vector<string>& testString,
+                            const vector<size_t>& positions) const;
+
+public:
+    Campaign(const Spec* spec, SymbolTable* globalSymTable, TypeMap typeMap,
+             ReplayRunner::FactoryMaker makeFactory);
+
+    /**
+     * Generate the CTC for a test string (symbolic execution on a fresh SUT).
+     * With sliceMs > 0, throws DeadlineExceeded if generation takes longer.
+     */
+    unique_ptr<Program> generateCTC(const vector<string>& testString, double sliceMs = 0);
+
+    /**
+     * Generate, replay and record the coverage of one test string. sliceMs
+     * bounds the generation step only (see generateCTC).
+     */
+    CampaignEntry runTestString(const vector<string>& testString, size_t testId = 0,
+                                double sliceMs = 0);
+
+    /**
+     * Replay an already generated CTC of a test string and record its
+     * coverage (runTestString without the generation step)
+     */
+    CampaignEntry replayCTC(const vector<string>& testString, unique_ptr<Program> ctc,
+                            size_t testId = 0);
+
+    /**
+     * Run scheduled test strings until the scheduler runs dry, maxTests test
+     * strings were executed, or stallLimit consecutive ones added no coverage
+     * (stallLimit 0 disables that cut-off).
+     */
+    vector<CampaignEntry> run(CoverageScheduler& scheduler, size_t maxTests = SIZE_MAX,
+                              size_t stallLimit = 3);
+
+    /**
+     * Run `count` test strings of the given length drawn from a Markov
+     * sampler, feeding every outcome (feasibility, blamed block, new
+     * coverage) back into it
+     */
+    vector<CampaignEntry> run(TestStringSampler& sampler, size_t count, size_t length);
+
+    /**
+     * Run test strings as they are pulled from a test-set stream, so huge
+     * test-set expressions are never materialized (at most maxTests of them)
+     */
+    vector<CampaignEntry> run(TestSetStream& testSet, size_t maxTests = SIZE_MAX);
+
+    /**
+     * Run all test strings on `workers` threads (0 = one per core).
+     *
+     * Workers merge their coverage into a shared atomic bitmap, count
+     * outcomes in per-thread counter shards and hand finished entries to the
+     * calling thread through a lock-free queue, tagged with the test string's
+     * index; the caller puts them back in input order. Which entry is
+     * credited with a point both of them hit depends on timing, the total
+     * does not. Each worker samples with its own copy of the hybrid solver
+     * (if set); their statistics are added to it when all are done.
+     */
+    vector<CampaignEntry> runParallel(const vector<vector<string>>& testStrings,
+                                      unsigned int workers = 0);
+    const CampaignStats& getLastStats() const { return lastStats; }
+
+    /**
+     * Test-string position of every CTC statement (SIZE_MAX for init)
+     */
+    vector<size_t> statementPositions(const vector<string>& testString, const Program& ctc) const;
+
+    /**
+     * Position in the test string of the block that made a test string
+     * infeasible: the block of the failing assume, or of the first input()
+     * generation could not concretize. SIZE_MAX if unknown or feasible.
+     */
+    size_t blamePosition(const CampaignEntry& entry) const;
+
+    /**
+     * Generate inputs with random sampling first (nullptr = always solve).
+     * The solver's per-block statistics carry over across test strings.
+     */
+    void setHybridSolver(const HybridSolver* hs) { hybridSolver = hs; }
+
+    /**
+     * Bound symbolic values during generation to maxNodes AST nodes
+     * (0 = no limit, see SEE::setTermBudget)
+     */
+    void setTermBudget(size_t maxNodes) { termBudget = maxNodes; }
+
+    /**
+     * Solve each test string in one query with API results modeled by their
+     * postconditions (see Tester::setOneShot)
+     */
+    void setOneShot(bool on) { oneShot = on; }
+
+    /**
+     * Hold back new test strings while the process is near the governor's
+     * budget (nullptr = no limit). The sequential run() loops stop early;
+     * runParallel() lets a worker wait while others are still running and
+     * starts a test string anyway once none is.
+     */
+    void setMemoryGovernor(MemoryGovernor* g) { governor = g; }
+
+    /**
+     * Record every path constraint that takes at least ms to solve during
+     * generation (0 = none), with the test-string block each conjunct comes
+     * from. takeSlowQueries() hands the records over, e.g. to QueryMinimizer.
+     */
+    void setSlowQueryThreshold(double ms) { slowQueryMs = ms; }
+    vector<RecordedQuery> takeSlowQueries();
+
+    /**
+     * Compile the assume and assert of every block into a shared object
+     * (see OracleLibrary) and check them natively in all later replays.
+     * Call once, before running test strings. Returns the number of
+     * predicates compiled; throws runtime_error if the build fails.
+     */
+    size_t compileOracles(const string& compiler = "");
+    const OracleLibrary* getOracles() const { return oracles.get(); }
+
+    const CoverageMap& getCoverageMap() const { return coverageMap; }
+    const CoverageBitmap& getCoverage() const { return coverage; }
+
+    void printCoverage() const;
+};
+
+#endif // CAMPAIGN_HH
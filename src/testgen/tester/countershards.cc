@@ -0,0 +1,28 @@
+#include "countershards.hh"
+#include <stdexcept>
+
+CounterShards::CounterShards(size_t shards, size_t counters)
+    : shards(shards), counters(counters),
+      linesPerShard((counters + PER_LINE - 1) / PER_LINE),
+      lines(shards * ((counters + PER_LINE - 1) / PER_LINE)) {}
+
+void CounterShards::add(size_t shard, size_t counter, uint64_t n) {
+    if (shard >= shards || counter >= counters) {
+        throw runtime_error("Counter shard out of range");
+    }
+    // Only the owning thread writes a shard: a relaxed add is uncontended
+    Line& line = lines[shard * linesPerShard + counter / PER_LINE];
+    line.values[counter % PER_LINE].fetch_add(n, memory_order_relaxed);
+}
+
+uint64_t CounterShards::read(size_t counter) const {
+    if (counter >= counters) {
+        throw runtime_error("Counter out of range");
+    }
+    uint64_t total = 0;
+    for (size_t s = 0; s < shards; s++) {
+        const Line& line = lines[s * linesPerShard + counter / PER_LINE];
+        total += line.values[counter % PER_LINE].load(memory_order_relaxed);
+    }
+    return total;
+}
@@ -0,0 +1,53 @@
+#ifndef COUNTERSHARDS_HH
+#define COUNTERSHARDS_HH
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * CounterShards: a set of counters split into one shard per writer thread
+ *
+ * Each writer only adds to its own shard, and shards never share a cache
+ * line, so concurrent add() calls do not contend. read() merges the shards;
+ * it may run concurrently with writers and then sees a value somewhere
+ * between the totals before and after the in-flight adds.
+ */
+class CounterShards {
+private:
+    static constexpr size_t PER_LINE = 8;   // 64-byte line of uint64 counters
+
+    struct alignas(64) Line {
+        atomic<uint64_t> values[PER_LINE];
+        Line() {
+            for (auto& v : values) {
+                v.store(0, memory_order_relaxed);
+            }
+        }
+    };
+
+    size_t shards;
+    size_t counters;
+    size_t linesPerShard;
+    vector<Line> lines;
+
+public:
+    CounterShards(size_t shards, size_t counters);
+
+    /**
+     * Add n to a counter of the given shard (owned by the calling thread)
+     */
+    void add(size_t shard, size_t counter, uint64_t n = 1);
+
+    /**
+     * Sum of a counter over all shards
+     */
+    uint64_t read(size_t counter) const;
+
+    size_t getShards() const { return shards; }
+    size_t getCounters() const { return counters; }
+};
+
+#endif // COUNTERSHARDS_HH
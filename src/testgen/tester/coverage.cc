@@ -0,0 +1,394 @@
+#include "coverage.hh"
+#include "../see/concreteevaluator.hh"
+#include <set>
+
+// ============================================================================
+// CoverageBitmap Implementation
+// ============================================================================
+
+CoverageBitmap::CoverageBitmap(size_t bits) : words((bits + 63) / 64, 0), bits(bits) {}
+
+void CoverageBitmap::resize(size_t n) {
+    bits = n;
+    words.resize((n + 63) / 64, 0);
+}
+
+bool CoverageBitmap::set(size_t i) {
+    if (i >= bits) {
+        throw runtime_error("Coverage point out of range");
+    }
+    uint64_t mask = uint64_t(1) << (i % 64);
+    bool fresh = (words[i / 64] & mask) == 0;
+    words[i / 64] |= mask;
+    return fresh;
+}
+
+bool CoverageBitmap::test(size_t i) const {
+    if (i >= bits) {
+        return false;
+    }
+    return (words[i / 64] >> (i % 64)) & 1;
+}
+
+void CoverageBitmap::clear() {
+    for (auto& w : words) {
+        w = 0;
+    }
+}
+
+size_t CoverageBitmap::count() const {
+    size_t n = 0;
+    for (uint64_t w : words) {
+        n += __builtin_popcountll(w);
+    }
+    return n;
+}
+
+size_t CoverageBitmap::countRange(size_t begin, size_t end) const {
+    size_t n = 0;
+    for (size_t i = begin; i < end && i < bits; i++) {
+        if (test(i)) n++;
+    }
+    return n;
+}
+
+size_t CoverageBitmap::merge(const CoverageBitmap& other) {
+    if (other.bits > bits) {
+        resize(other.bits);
+    }
+    size_t fresh = 0;
+    for (size_t i = 0; i < other.words.size(); i++) {
+        fresh += __builtin_popcountll(other.words[i] & ~words[i]);
+        words[i] |= other.words[i];
+    }
+    return fresh;
+}
+
+CoverageBitmap CoverageBitmap::newBits(const CoverageBitmap& other) const {
+    CoverageBitmap result(other.bits);
+    for (size_t i = 0; i < other.words.size(); i++) {
+        uint64_t mine = (i < words.size()) ? words[i] : 0;
+        result.words[i] = other.words[i] & ~mine;
+    }
+    return result;
+}
+
+size_t CoverageBitmap::countNew(const CoverageBitmap& other) const {
+    size_t n = 0;
+    for (size_t i = 0; i < other.words.size(); i++) {
+        uint64_t mine = (i < words.size()) ? words[i] : 0;
+        n += __builtin_popcountll(other.words[i] & ~mine);
+    }
+    return n;
+}
+
+// ============================================================================
+// AtomicCoverageBitmap Implementation
+// ============================================================================
+
+AtomicCoverageBitmap::AtomicCoverageBitmap(const CoverageBitmap& initial)
+    : words(new atomic<uint64_t>[initial.words.size()]), wordCount(initial.words.size()),
+      bits(initial.bits) {
+    for (size_t i = 0; i < wordCount; i++) {
+        words[i].store(initial.words[i], memory_order_relaxed);
+    }
+}
+
+size_t AtomicCoverageBitmap::merge(const CoverageBitmap& other) {
+    if (other.bits > bits) {
+        throw runtime_error("Coverage bitmap larger than the shared bitmap");
+    }
+    size_t fresh = 0;
+    for (size_t i = 0; i < other.words.size(); i++) {
+        uint64_t w = other.words[i];
+        if ((words[i].load(memory_order_relaxed) & w) == w) {
+            continue;
+        }
+        uint64_t before = words[i].fetch_or(w, memory_order_relaxed);
+        fresh += __builtin_popcountll(w & ~before);
+    }
+    return fresh;
+}
+
+bool AtomicCoverageBitmap::test(size_t i) const {
+    if (i >= bits) {
+        return false;
+    }
+    return (words[i / 64].load(memory_order_relaxed) >> (i % 64)) & 1;
+}
+
+size_t AtomicCoverageBitmap::count() const {
+    size_t n = 0;
+    for (size_t i = 0; i < wordCount; i++) {
+        n += __builtin_popcountll(words[i].load(memory_order_relaxed));
+    }
+    return n;
+}
+
+CoverageBitmap AtomicCoverageBitmap::snapshot() const {
+    CoverageBitmap copy(bits);
+    for (size_t i = 0; i < wordCount; i++) {
+        copy.words[i] = words[i].load(memory_order_relaxed);
+    }
+    return copy;
+}
+
+// ============================================================================
+// CoverageMap Implementation
+// ============================================================================
+
+bool CoverageMap::isAtom(const FuncCall& fc) {
+    static const set<string> atoms = {
+        "Eq", "Neq", "Lt", "Gt", "Le", "Ge",
+        "=", "==", "!=", "<>", "<", ">", "<=", ">=",
+        "in", "not_in", "member", "not_member", "contains", "not_contains",
+        "subset", "is_subset", "is_empty_set", "contains_key", "has_key",
+        "prefix", "suffix", "contains_seq"
+    };
+    return atoms.find(fc.name) != atoms.end();
+}
+
+static bool isOr(const Expr& e) {
+    if (e.exprType != ExprType::FUNCCALL) {
+        return false;
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+    return fc.args.size() == 2 && (fc.name == "Or" || fc.name == "or" || fc.name == "||");
+}
+
+void CoverageMap::flattenOr(const Expr& e, vector<const Expr*>& disjuncts) {
+    if (isOr(e)) {
+        const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+        flattenOr(*fc.args[0], disjuncts);
+        flattenOr(*fc.args[1], disjuncts);
+    } else {
+        disjuncts.push_back(&e);
+    }
+}
+
+void CoverageMap::walk(const Expr& e, const function<void(const Expr&, SiteKind)>& site) {
+    if (e.exprType != ExprType::FUNCCALL) {
+        return;
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+
+    if (isOr(e)) {
+        vector<const Expr*> disjuncts;
+        flattenOr(e, disjuncts);
+        for (const Expr* d : disjuncts) {
+            site(*d, SiteKind::DISJUNCT);
+            walk(*d, site);
+        }
+        return;
+    }
+    if (isAtom(fc)) {
+        site(e, SiteKind::ATOM);
+        return;
+    }
+    if (fc.name == "And" || fc.name == "and" || fc.name == "&&" ||
+        fc.name == "Not" || fc.name == "not" || fc.name == "!" ||
+        fc.name == "Implies") {
+        for (const auto& arg : fc.args) {
+            walk(*arg, site);
+        }
+    }
+}
+
+CoverageMap::CoverageMap(const Spec* spec) : spec(spec) {
+    for (size_t b = 0; b < spec->blocks.size(); b++) {
+        const API& block = *spec->blocks[b];
+        for (int phase = 0; phase < 2; phase++) {
+            bool isPost = (phase == 1);
+            (isPost ? postBegin : preBegin).push_back(points.size());
+            const Expr* predicate = isPost ? block.response.ResponseExpr.get() : block.pre.get();
+            if (!predicate) {
+                continue;
+            }
+            walk(*predicate, [&](const Expr&, SiteKind kind) {
+                if (kind == SiteKind::DISJUNCT) {
+                    points.push_back({ b, isPost, CoveragePointKind::DISJUNCT });
+                } else {
+                    points.push_back({ b, isPost, CoveragePointKind::ATOM_TRUE });
+                    points.push_back({ b, isPost, CoveragePointKind::ATOM_FALSE });
+                }
+            });
+        }
+        blockEnd.push_back(points.size());
+    }
+}
+
+vector<size_t> CoverageMap::blocksNamed(const string& name) const {
+    vector<size_t> result;
+    for (size_t b = 0; b < spec->blocks.size(); b++) {
+        if (spec->blocks[b]->name == name) {
+            result.push_back(b);
+        }
+    }
+    return result;
+}
+
+void CoverageMap::record(size_t block, bool isPost, const Expr& predicate,
+                         ConcreteEvaluator& evaluator, ConcValEnv& env,
+                         CoverageBitmap& bitmap) const {
+    if (bitmap.size() < points.size()) {
+        bitmap.resize(points.size());
+    }
+    size_t id = isPost ? postBegin[block] : preBegin[block];
+    size_t end = isPost ? blockEnd[block] : postBegin[block];
+
+    walk(predicate, [&](const Expr& e, SiteKind kind) {
+        size_t width = (kind == SiteKind::DISJUNCT) ? 1 : 2;
+        if (id + width > end) {
+            return;  // shape differs from the spec's predicate
+        }
+        try {
+            bool outcome = evaluator.evaluateBool(e, env);
+            if (kind == SiteKind::DISJUNCT) {
+                if (outcome) bitmap.set(id);
+            } else {
+                bitmap.set(outcome ? id : id + 1);
+            }
+        } catch (const exception&) {
+            // Not evaluable at this point (e.g. unbound variable): no coverage
+        }
+        id += width;
+    });
+}
+
+string CoverageMap::describe(size_t i) const {
+    const CoveragePoint& p = points[i];
+    string s = spec->blocks[p.blockIndex]->name + (p.isPost ? ".post" : ".pre");
+    size_t first = p.isPost ? postBegin[p.blockIndex] : preBegin[p.blockIndex];
+    s += "#" + to_string(i - first);
+    switch (p.kind) {
+        case CoveragePointKind::DISJUNCT: return s + " disjunct";
+        case CoveragePointKind::ATOM_TRUE: return s + " true";
+        case CoveragePointKind::ATOM_FALSE: return s + " false";
+    }
+    return s;
+}
+
+// ============================================================================
+// CoverageCollector Implementation
+// ============================================================================
+
+CoverageCollector::CoverageCollector(const CoverageMap& coverageMap, const Spec* spec,
+                                     const vector<string>& testString)
+    : coverageMap(coverageMap), assumeCount(0), assertCount(0), bitmap(coverageMap.size()) {
+    for (const auto& name : testString) {
+        for (size_t b : coverageMap.blocksNamed(name)) {
+            if (spec->blocks[b]->pre) {
+                assumeBlocks.push_back(b);
+            }
+            if (spec->blocks[b]->response.ResponseExpr) {
+                assertBlocks.push_back(b);
+            }
+        }
+    }
+}
+
+void CoverageCollector::onAssume(size_t stmtIndex, const Assume& stmt,
+                                 ConcreteEvaluator& evaluator, ConcValEnv& env) {
+    if (assumeCount < assumeBlocks.size()) {
+        coverageMap.record(assumeBlocks[assumeCount], false, *stmt.expr, evaluator, env, bitmap);
+    }
+    assumeCount++;
+}
+
+void CoverageCollector::onAssert(size_t stmtIndex, const Assert& stmt,
+                                 ConcreteEvaluator& evaluator, ConcValEnv& env) {
+    if (assertCount < assertBlocks.size()) {
+        coverageMap.record(assertBlocks[assertCount], true, *stmt.expr, evaluator, env, bitmap);
+    }
+    assertCount++;
+}
+
+// ============================================================================
+// CoverageScheduler Implementation
+// ============================================================================
+
+CoverageScheduler::CoverageScheduler(const CoverageMap& coverageMap,
+                                     vector<vector<string>> candidates)
+    : coverageMap(coverageMap), candidates(std::move(candidates)),
+      runs(coverageMap.blockCount(), 0), hits(coverageMap.blockCount(), 0) {
+    for (const auto& ts : this->candidates) {
+        set<size_t> blocks;
+        for (const auto& name : ts) {
+            for (size_t b : coverageMap.blocksNamed(name)) {
+                blocks.insert(b);
+            }
+        }
+        candidateBlocks.push_back(vector<size_t>(blocks.begin(), blocks.end()));
+    }
+    used.assign(this->candidates.size(), false);
+    remaining = this->candidates.size();
+}
+
+double CoverageScheduler::blockGain(size_t block, const CoverageBitmap& global) const {
+    size_t begin = coverageMap.blockBegin(block);
+    size_t end = coverageMap.blockEndIndex(block);
+    size_t uncovered = (end - begin) - global.countRange(begin, end);
+    double hitRate = double(hits[block] + 1) / double(runs[block] + 1);
+    return uncovered * hitRate;
+}
+
+double CoverageScheduler::expectedGain(size_t candidate, const CoverageBitmap& global) const {
+    double gain = 0;
+    for (size_t b : candidateBlocks[candidate]) {
+        gain += blockGain(b, global);
+    }
+    return gain;
+}
+
+bool CoverageScheduler::hasNext(const CoverageBitmap& global) const {
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!used[i] && expectedGain(i, global) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+vector<string> CoverageScheduler::next(const CoverageBitmap& global) {
+    // Per-block gains are shared by all candidates; compute them once.
+    vector<double> gains(coverageMap.blockCount());
+    for (size_t b = 0; b < gains.size(); b++) {
+        gains[b] = blockGain(b, global);
+    }
+
+    size_t best = candidates.size();
+    double bestGain = -1;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (used[i]) continue;
+        double gain = 0;
+        for (size_t b : candidateBlocks[i]) {
+            gain += gains[b];
+        }
+        if (gain > bestGain ||
+            (gain == bestGain && candidates[i].size() < candidates[best].size())) {
+            best = i;
+            bestGain = gain;
+        }
+    }
+    if (best == candidates.size()) {
+        throw runtime_error("CoverageScheduler: no candidates left");
+    }
+    used[best] = true;
+    remaining--;
+    return candidates[best];
+}
+
+void CoverageScheduler::update(const vector<string>& testString, const CoverageBitmap& fresh) {
+    set<size_t> blocks;
+    for (const auto& name : testString) {
+        for (size_t b : coverageMap.blocksNamed(name)) {
+            blocks.insert(b);
+        }
+    }
+    for (size_t b : blocks) {
+        runs[b]++;
+        if (fresh.countRange(coverageMap.blockBegin(b), coverageMap.blockEndIndex(b)) > 0) {
+            hits[b]++;
+        }
+    }
+}
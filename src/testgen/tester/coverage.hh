@@ -0,0 +1,230 @@
+#ifndef COVERAGE_HH
+#define COVERAGE_HH
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+#include "replay.hh"
+
+class ConcreteEvaluator;
+
+using namespace std;
+
+/**
+ * CoverageBitmap: one bit per coverage point
+ */
+class CoverageBitmap {
+private:
+    vector<uint64_t> words;
+    size_t bits;
+
+public:
+    explicit CoverageBitmap(size_t bits = 0);
+
+    void resize(size_t bits);
+    size_t size() const { return bits; }
+
+    /**
+     * Set bit i; returns true if it was not set before
+     */
+    bool set(size_t i);
+    bool test(size_t i) const;
+    void clear();
+
+    size_t count() const;
+    size_t countRange(size_t begin, size_t end) const;
+
+    /**
+     * OR other into this bitmap; returns the number of newly set bits
+     */
+    size_t merge(const CoverageBitmap& other);
+
+    /**
+     * Bits set in other but not in this bitmap
+     */
+    CoverageBitmap newBits(const CoverageBitmap& other) const;
+    size_t countNew(const CoverageBitmap& other) const;
+
+    const vector<uint64_t>& getWords() const { return words; }
+
+    friend class AtomicCoverageBitmap;
+};
+
+/**
+ * AtomicCoverageBitmap: coverage bitmap shared by concurrent workers
+ *
+ * merge() ORs a worker's bitmap in word by word with fetch_or, skipping
+ * words that would not change, so fully covered regions are only read.
+ * Every bit is credited to exactly one merge() call, hence the fresh counts
+ * returned to all workers add up to the bits set in total.
+ */
+class AtomicCoverageBitmap {
+private:
+    unique_ptr<atomic<uint64_t>[]> words;
+    size_t wordCount;
+    size_t bits;
+
+public:
+    explicit AtomicCoverageBitmap(const CoverageBitmap& initial);
+
+    size_t size() const { return bits; }
+
+    /**
+     * OR other into this bitmap; returns the number of bits this call set
+     */
+    size_t merge(const CoverageBitmap& other);
+    bool test(size_t i) const;
+    size_t count() const;
+
+    /**
+     * Plain copy of the current contents
+     */
+    CoverageBitmap snapshot() const;
+};
+
+enum class CoveragePointKind {
+    DISJUNCT,    // a disjunct of an Or evaluated to true
+    ATOM_TRUE,   // an atomic comparison evaluated to true
+    ATOM_FALSE   // an atomic comparison evaluated to false
+};
+
+struct CoveragePoint {
+    size_t blockIndex;
+    bool isPost;
+    CoveragePointKind kind;
+};
+
+/**
+ * CoverageMap: numbers the coverage points of every API block of a spec
+ *
+ * Points are laid out block by block, precondition first:
+ *   - every disjunct of an Or (nested Ors are flattened) gets one point
+ *   - every atomic comparison (Eq, Lt, in, subset, ...) gets two points,
+ *     one per outcome
+ * And/Not/Implies are traversed but have no points of their own.
+ *
+ * The numbering only depends on the shape of the predicate, so the renamed
+ * pre/postconditions that genATC emits into the ATC hit the same points as
+ * the spec's originals.
+ */
+class CoverageMap {
+private:
+    const Spec* spec;
+    vector<CoveragePoint> points;
+    vector<size_t> preBegin;   // first point of block i's precondition
+    vector<size_t> postBegin;  // first point of block i's postcondition
+    vector<size_t> blockEnd;   // one past the last point of block i
+
+    enum class SiteKind { DISJUNCT, ATOM };
+    static bool isAtom(const FuncCall& fc);
+    static void flattenOr(const Expr& e, vector<const Expr*>& disjuncts);
+    static void walk(const Expr& e, const function<void(const Expr&, SiteKind)>& site);
+
+public:
+    explicit CoverageMap(const Spec* spec);
+
+    size_t size() const { return points.size(); }
+    const CoveragePoint& getPoint(size_t i) const { return points[i]; }
+    size_t blockBegin(size_t block) const { return preBegin[block]; }
+    size_t blockEndIndex(size_t block) const { return blockEnd[block]; }
+    size_t blockCount() const { return preBegin.size(); }
+    const Spec* getSpec() const { return spec; }
+
+    /**
+     * Indices of the spec blocks named name (genATC expands all of them)
+     */
+    vector<size_t> blocksNamed(const string& name) const;
+
+    /**
+     * Evaluate the coverage sites of block's pre- or postcondition, given in
+     * its renamed (ATC) form, under a concrete environment and set the bits
+     * that were hit. Sites that cannot be evaluated are skipped.
+     */
+    void record(size_t block, bool isPost, const Expr& predicate,
+                ConcreteEvaluator& evaluator, ConcValEnv& env,
+                CoverageBitmap& bitmap) const;
+
+    string describe(size_t point) const;
+};
+
+/**
+ * CoverageCollector: replay observer that attributes the assume/assert
+ * statements of a CTC to the blocks of its test string and records their
+ * coverage.
+ *
+ * genATC emits, per block of the test string, one assume (if the block has a
+ * precondition) followed by one assert (if it has a postcondition), so the
+ * k-th assume/assert of the CTC belongs to the k-th block with a pre/post.
+ */
+class CoverageCollector : public ReplayObserver {
+private:
+    const CoverageMap& coverageMap;
+    vector<size_t> assumeBlocks;
+    vector<size_t> assertBlocks;
+    size_t assumeCount;
+    size_t assertCount;
+    CoverageBitmap bitmap;
+
+public:
+    CoverageCollector(const CoverageMap& coverageMap, const Spec* spec,
+                      const vector<string>& testString);
+
+    void onAssume(size_t stmtIndex, const Assume& stmt,
+                  ConcreteEvaluator& evaluator, ConcValEnv& env) override;
+    void onAssert(size_t stmtIndex, const Assert& stmt,
+                  ConcreteEvaluator& evaluator, ConcValEnv& env) override;
+
+    const CoverageBitmap& getBitmap() const { return bitmap; }
+};
+
+/**
+ * CoverageScheduler: orders candidate test strings by expected new coverage
+ *
+ * The expected gain of a candidate is the sum, over the distinct blocks it
+ * exercises, of the block's uncovered points weighted by the block's observed
+ * hit rate (runs that produced new coverage / runs, with a +1 prior). Blocks
+ * that keep running without covering anything new are gradually discounted.
+ */
+class CoverageScheduler {
+private:
+    const CoverageMap& coverageMap;
+    vector<vector<string>> candidates;
+    vector<vector<size_t>> candidateBlocks;  // distinct blocks per candidate
+    vector<bool> used;
+    size_t remaining;
+    vector<size_t> runs;   // per block
+    vector<size_t> hits;   // per block: runs that covered a new point
+
+    double blockGain(size_t block, const CoverageBitmap& global) const;
+
+public:
+    CoverageScheduler(const CoverageMap& coverageMap, vector<vector<string>> candidates);
+
+    double expectedGain(size_t candidate, const CoverageBitmap& global) const;
+
+    /**
+     * True while some unused candidate is expected to add coverage
+     */
+    bool hasNext(const CoverageBitmap& global) const;
+
+    /**
+     * Pick (and consume) the candidate with the highest expected gain.
+     * Ties go to the shorter, i.e. cheaper, test string.
+     */
+    vector<string> next(const CoverageBitmap& global);
+
+    /**
+     * Feed back the points a test string newly covered
+     */
+    void update(const vector<string>& testString, const CoverageBitmap& fresh);
+
+    size_t remainingCandidates() const { return remaining; }
+};
+
+#endif // COVERAGE_HH
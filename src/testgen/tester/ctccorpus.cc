@@ -0,0 +1,388 @@
+#include "ctccorpus.hh"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[8] = { 'T', 'T', 'R', 'C', 'T', 'C', '0', '1' };
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint32_t NONE = UINT32_MAX;
+
+// Expression node tags
+enum : uint32_t {
+    TAG_VAR = 1,        // name
+    TAG_NUM,            // value
+    TAG_STRING,         // string
+    TAG_FUNCCALL,       // name, n, n children
+    TAG_SET,            // n, n children
+    TAG_TUPLE,          // n, n children
+    TAG_MAP,            // n, n (key name, child) pairs
+    TAG_INPUT
+};
+
+// Statement kinds
+enum : uint32_t { STMT_ASSIGN, STMT_ASSUME, STMT_ASSERT };
+
+// ============================================================================
+// CTCCorpusWriter Implementation
+// ============================================================================
+
+CTCCorpusWriter::CTCCorpusWriter() : statementsAdded(0) {
+    nodes.push_back(make_pair(NONE, NONE));   // root
+}
+
+uint32_t CTCCorpusWriter::intern(const string& s) {
+    auto it = stringIds.find(s);
+    if (it != stringIds.end()) {
+        return it->second;
+    }
+    uint32_t id = strings.size();
+    strings.push_back(s);
+    stringIds.emplace(s, id);
+    return id;
+}
+
+uint32_t CTCCorpusWriter::internExpr(const Expr& e) {
+    vector<uint32_t> node;
+    switch (e.exprType) {
+        case ExprType::VAR:
+            node = { TAG_VAR, intern(dynamic_cast<const Var&>(e).name) };
+            break;
+        case ExprType::NUM:
+            node = { TAG_NUM, (uint32_t)dynamic_cast<const Num&>(e).value };
+            break;
+        case ExprType::STRING:
+            node = { TAG_STRING, intern(dynamic_cast<const String&>(e).value) };
+            break;
+        case ExprType::FUNCCALL: {
+            const FuncCall& fc = dynamic_cast<const FuncCall&>(e);
+            node = { TAG_FUNCCALL, intern(fc.name), (uint32_t)fc.args.size() };
+            for (const auto& arg : fc.args) {
+                node.push_back(internExpr(*arg));
+            }
+            break;
+        }
+        case ExprType::SET: {
+            const Set& set = dynamic_cast<const Set&>(e);
+            node = { TAG_SET, (uint32_t)set.elements.size() };
+            for (const auto& elem : set.elements) {
+                node.push_back(internExpr(*elem));
+            }
+            break;
+        }
+        case ExprType::TUPLE: {
+            const Tuple& tuple = dynamic_cast<const Tuple&>(e);
+            node = { TAG_TUPLE, (uint32_t)tuple.exprs.size() };
+            for (const auto& elem : tuple.exprs) {
+                node.push_back(internExpr(*elem));
+            }
+            break;
+        }
+        case ExprType::MAP: {
+            const Map& map = dynamic_cast<const Map&>(e);
+            node = { TAG_MAP, (uint32_t)map.value.size() };
+            for (const auto& kv : map.value) {
+                node.push_back(intern(kv.first->name));
+                node.push_back(internExpr(*kv.second));
+            }
+            break;
+        }
+        case ExprType::INPUT:
+            node = { TAG_INPUT };
+            break;
+        default:
+            throw runtime_error("CTC corpus: symbolic value in a CTC");
+    }
+
+    auto it = exprIds.find(node);
+    if (it != exprIds.end()) {
+        return it->second;
+    }
+    uint32_t ref = exprs.size();
+    exprs.insert(exprs.end(), node.begin(), node.end());
+    exprIds.emplace(std::move(node), ref);
+    return ref;
+}
+
+uint32_t CTCCorpusWriter::internStmt(const Stmt& s) {
+    array<uint32_t, 3> record;
+    switch (s.statementType) {
+        case StmtType::ASSIGN: {
+            const Assign& assign = dynamic_cast<const Assign&>(s);
+            record = { STMT_ASSIGN, internExpr(*assign.left), internExpr(*assign.right) };
+            break;
+        }
+        case StmtType::ASSUME:
+            record = { STMT_ASSUME, internExpr(*dynamic_cast<const Assume&>(s).expr), NONE };
+            break;
+        case StmtType::ASSERT:
+            record = { STMT_ASSERT, internExpr(*dynamic_cast<const Assert&>(s).expr), NONE };
+            break;
+        default:
+            throw runtime_error("CTC corpus: unsupported statement in a CTC");
+    }
+
+    auto it = stmtIds.find(record);
+    if (it != stmtIds.end()) {
+        return it->second;
+    }
+    uint32_t id = stmts.size();
+    stmts.push_back(record);
+    stmtIds.emplace(record, id);
+    return id;
+}
+
+size_t CTCCorpusWriter::add(const Program& ctc) {
+    uint32_t node = 0;
+    for (const auto& stmt : ctc.statements) {
+        pair<uint32_t, uint32_t> key(node, internStmt(*stmt));
+        auto it = children.find(key);
+        if (it != children.end()) {
+            node = it->second;
+        } else {
+            uint32_t child = nodes.size();
+            nodes.push_back(key);
+            children.emplace(key, child);
+            node = child;
+        }
+    }
+    statementsAdded += ctc.statements.size();
+    tests.push_back(make_pair(node, (uint32_t)ctc.statements.size()));
+    return tests.size() - 1;
+}
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+void CTCCorpusWriter::write(const string& path) const {
+    vector<uint32_t> stringIndex(1, 0);
+    string blob;
+    for (const auto& s : strings) {
+        blob += s;
+        stringIndex.push_back(blob.size());
+    }
+
+    CTCCorpusHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.stringCount = strings.size();
+    header.exprWords = exprs.size();
+    header.stmtCount = stmts.size();
+    header.nodeCount = nodes.size();
+    header.testCount = tests.size();
+    header.stringIndexOffset = align8(sizeof(header));
+    header.stringBlobOffset = align8(header.stringIndexOffset + stringIndex.size() * 4);
+    header.exprOffset = align8(header.stringBlobOffset + blob.size());
+    header.stmtOffset = align8(header.exprOffset + exprs.size() * 4);
+    header.nodeOffset = align8(header.stmtOffset + stmts.size() * 12);
+    header.testOffset = align8(header.nodeOffset + nodes.size() * 8);
+    header.fileSize = header.testOffset + tests.size() * 8;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("CTC corpus: cannot write " + path);
+    }
+    auto pad = [&out](uint64_t offset) {
+        static const char zeros[8] = { 0 };
+        out.write(zeros, offset - (uint64_t)out.tellp());
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.stringIndexOffset);
+    out.write(reinterpret_cast<const char*>(stringIndex.data()), stringIndex.size() * 4);
+    pad(header.stringBlobOffset);
+    out.write(blob.data(), blob.size());
+    pad(header.exprOffset);
+    out.write(reinterpret_cast<const char*>(exprs.data()), exprs.size() * 4);
+    pad(header.stmtOffset);
+    for (const auto& record : stmts) {
+        out.write(reinterpret_cast<const char*>(record.data()), 12);
+    }
+    pad(header.nodeOffset);
+    for (const auto& node : nodes) {
+        uint32_t words[2] = { node.first, node.second };
+        out.write(reinterpret_cast<const char*>(words), 8);
+    }
+    pad(header.testOffset);
+    for (const auto& test : tests) {
+        uint32_t words[2] = { test.first, test.second };
+        out.write(reinterpret_cast<const char*>(words), 8);
+    }
+    out.close();
+    if (!out) {
+        throw runtime_error("CTC corpus: cannot write " + path);
+    }
+}
+
+// ============================================================================
+// CTCCorpus Implementation
+// ============================================================================
+
+[[noreturn]] static void corrupt(const string& what) {
+    throw runtime_error("CTC corpus: corrupt file (" + what + ")");
+}
+
+CTCCorpus::CTCCorpus(const string& path) : data(nullptr), mappedSize(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("CTC corpus: cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(CTCCorpusHeader)) {
+        close(fd);
+        throw runtime_error("CTC corpus: " + path + " is not a corpus");
+    }
+    mappedSize = st.st_size;
+    void* p = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        throw runtime_error("CTC corpus: cannot map " + path);
+    }
+    data = static_cast<const char*>(p);
+    header = reinterpret_cast<const CTCCorpusHeader*>(data);
+
+    try {
+        if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw runtime_error("CTC corpus: " + path + " is not a corpus");
+        }
+        if (header->byteOrder != BYTE_ORDER_MARK) {
+            throw runtime_error("CTC corpus: " + path + " was written with another byte order");
+        }
+        if (header->fileSize != mappedSize) corrupt("size");
+        auto section = [this](uint64_t offset, uint64_t bytes) {
+            if (offset % 4 != 0 || offset > mappedSize || bytes > mappedSize - offset) corrupt("section bounds");
+            return data + offset;
+        };
+        stringIndex = reinterpret_cast<const uint32_t*>(
+            section(header->stringIndexOffset, ((uint64_t)header->stringCount + 1) * 4));
+        uint64_t blobSize = stringIndex[header->stringCount];
+        stringBlob = section(header->stringBlobOffset, blobSize);
+        exprs = reinterpret_cast<const uint32_t*>(section(header->exprOffset, (uint64_t)header->exprWords * 4));
+        stmts = reinterpret_cast<const uint32_t*>(section(header->stmtOffset, (uint64_t)header->stmtCount * 12));
+        nodes = reinterpret_cast<const uint32_t*>(section(header->nodeOffset, (uint64_t)header->nodeCount * 8));
+        tests = reinterpret_cast<const uint32_t*>(section(header->testOffset, (uint64_t)header->testCount * 8));
+        if (header->nodeCount == 0) corrupt("no root");
+        for (uint32_t i = 0; i < header->stringCount; i++) {
+            if (stringIndex[i] > stringIndex[i + 1]) corrupt("string index");
+        }
+    } catch (...) {
+        munmap(const_cast<char*>(data), mappedSize);
+        throw;
+    }
+}
+
+CTCCorpus::~CTCCorpus() {
+    munmap(const_cast<char*>(data), mappedSize);
+}
+
+string CTCCorpus::str(uint32_t id) const {
+    if (id >= header->stringCount) corrupt("string id");
+    return string(stringBlob + stringIndex[id], stringIndex[id + 1] - stringIndex[id]);
+}
+
+unique_ptr<Expr> CTCCorpus::decodeExpr(uint32_t ref) const {
+    // Children are always written before their parent, so refs decrease on
+    // the way down and a damaged file cannot make decoding loop.
+    auto word = [this, ref](uint32_t i) {
+        if ((uint64_t)ref + i >= header->exprWords) corrupt("expression bounds");
+        return exprs[ref + i];
+    };
+    auto child = [this, ref](uint32_t childRef) {
+        if (childRef >= ref) corrupt("expression order");
+        return decodeExpr(childRef);
+    };
+    switch (word(0)) {
+        case TAG_VAR:
+            return make_unique<Var>(str(word(1)));
+        case TAG_NUM:
+            return make_unique<Num>((int)word(1));
+        case TAG_STRING:
+            return make_unique<String>(str(word(1)));
+        case TAG_FUNCCALL: {
+            vector<unique_ptr<Expr>> args;
+            for (uint32_t i = 0; i < word(2); i++) {
+                args.push_back(child(word(3 + i)));
+            }
+            return make_unique<FuncCall>(str(word(1)), std::move(args));
+        }
+        case TAG_SET:
+        case TAG_TUPLE: {
+            vector<unique_ptr<Expr>> elements;
+            for (uint32_t i = 0; i < word(1); i++) {
+                elements.push_back(child(word(2 + i)));
+            }
+            if (word(0) == TAG_SET) {
+                return make_unique<Set>(std::move(elements));
+            }
+            return make_unique<Tuple>(std::move(elements));
+        }
+        case TAG_MAP: {
+            vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> entries;
+            for (uint32_t i = 0; i < word(1); i++) {
+                entries.push_back(make_pair(make_unique<Var>(str(word(2 + 2 * i))),
+                                            child(word(3 + 2 * i))));
+            }
+            return make_unique<Map>(std::move(entries));
+        }
+        case TAG_INPUT:
+            return make_unique<Input>();
+        default:
+            corrupt("expression tag");
+    }
+}
+
+unique_ptr<Stmt> CTCCorpus::decodeStmt(uint32_t id) const {
+    if (id >= header->stmtCount) corrupt("statement id");
+    const uint32_t* record = stmts + 3 * (size_t)id;
+    switch (record[0]) {
+        case STMT_ASSIGN:
+            return make_unique<Assign>(decodeExpr(record[1]), decodeExpr(record[2]));
+        case STMT_ASSUME:
+            return make_unique<Assume>(decodeExpr(record[1]));
+        case STMT_ASSERT:
+            return make_unique<Assert>(decodeExpr(record[1]));
+        default:
+            corrupt("statement kind");
+    }
+}
+
+size_t CTCCorpus::length(size_t testId) const {
+    if (testId >= header->testCount) {
+        throw out_of_range("CTC corpus: no test " + to_string(testId));
+    }
+    return tests[2 * testId + 1];
+}
+
+unique_ptr<Program> CTCCorpus::get(size_t testId) const {
+    size_t n = length(testId);
+    vector<uint32_t> path(n);
+    uint32_t node = tests[2 * testId];
+    for (size_t i = n; i > 0; i--) {
+        if (node == 0 || node >= header->nodeCount) corrupt("trie path");
+        path[i - 1] = nodes[2 * (size_t)node + 1];
+        uint32_t parent = nodes[2 * (size_t)node];
+        if (parent >= node) corrupt("trie order");
+        node = parent;
+    }
+    if (node != 0) corrupt("trie path");
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.reserve(n);
+    for (uint32_t stmt : path) {
+        statements.push_back(decodeStmt(stmt));
+    }
+    return make_unique<Program>(std::move(statements));
+}
+
+bool CTCCorpus::Stream::next(size_t& testId, unique_ptr<Program>& ctc) {
+    if (nextId >= corpus.size()) {
+        return false;
+    }
+    testId = nextId++;
+    ctc = corpus.get(testId);
+    return true;
+}
@@ -0,0 +1,152 @@
+#ifndef CTCCORPUS_HH
+#define CTCCORPUS_HH
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../language/ast.hh"
+
+using namespace std;
+
+/**
+ * On-disk CTC corpus: CTCs of one spec stored as a trie of statements.
+ *
+ * Names, string constants, expressions and statements are interned, so a
+ * statement shared by many CTCs (the init block, a common test-string prefix)
+ * is stored once, and every CTC is a path from the root of a trie whose nodes
+ * are (parent, statement) pairs. A CTC is addressed by its test id, the order
+ * in which it was added.
+ *
+ * The file is a header followed by arrays of 32-bit words in the writer's
+ * byte order, so it can be memory-mapped and read in place:
+ *   string index   stringCount + 1 byte offsets into the string blob
+ *   string blob
+ *   expressions    tag-prefixed nodes, children referenced by word offset
+ *   statements     (kind, expr, expr)
+ *   trie nodes     (parent, statement); node 0 is the root
+ *   tests          (leaf node, number of statements)
+ */
+struct CTCCorpusHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t stringCount;
+    uint32_t exprWords;
+    uint32_t stmtCount;
+    uint32_t nodeCount;
+    uint32_t testCount;
+    uint64_t stringIndexOffset;
+    uint64_t stringBlobOffset;
+    uint64_t exprOffset;
+    uint64_t stmtOffset;
+    uint64_t nodeOffset;
+    uint64_t testOffset;
+    uint64_t fileSize;
+};
+
+/**
+ * CTCCorpusWriter: builds a corpus in memory and writes it to a file
+ */
+class CTCCorpusWriter {
+private:
+    vector<string> strings;
+    unordered_map<string, uint32_t> stringIds;
+    vector<uint32_t> exprs;
+    map<vector<uint32_t>, uint32_t> exprIds;
+    vector<array<uint32_t, 3>> stmts;
+    map<array<uint32_t, 3>, uint32_t> stmtIds;
+    vector<pair<uint32_t, uint32_t>> nodes;
+    map<pair<uint32_t, uint32_t>, uint32_t> children;
+    vector<pair<uint32_t, uint32_t>> tests;
+    size_t statementsAdded;
+
+    uint32_t intern(const string& s);
+    uint32_t internExpr(const Expr& e);
+    uint32_t internStmt(const Stmt& s);
+
+public:
+    CTCCorpusWriter();
+
+    /**
+     * Add a CTC and return its test id. Throws runtime_error for statements or
+     * expressions a CTC cannot contain (symbolic values).
+     */
+    size_t add(const Program& ctc);
+
+    /**
+     * Write the corpus; throws runtime_error if the file cannot be written
+     */
+    void write(const string& path) const;
+
+    size_t size() const { return tests.size(); }
+    size_t getStatementsAdded() const { return statementsAdded; }
+    size_t getNodeCount() const { return nodes.size() - 1; }
+};
+
+/**
+ * CTCCorpus: read-only view of a corpus file through mmap
+ *
+ * get() decodes one CTC by walking from its leaf to the root; stream()
+ * decodes the CTCs in test-id order. Decoding only reads the mapping, so a
+ * corpus may be shared by threads.
+ */
+class CTCCorpus {
+private:
+    const char* data;
+    size_t mappedSize;
+    const CTCCorpusHeader* header;
+    const uint32_t* stringIndex;
+    const char* stringBlob;
+    const uint32_t* exprs;
+    const uint32_t* stmts;
+    const uint32_t* nodes;
+    const uint32_t* tests;
+
+    string str(uint32_t id) const;
+    unique_ptr<Expr> decodeExpr(uint32_t ref) const;
+    unique_ptr<Stmt> decodeStmt(uint32_t id) const;
+
+public:
+    /**
+     * Map a corpus file. Throws runtime_error if it cannot be opened or is not
+     * a corpus written on a machine with the same byte order.
+     */
+    explicit CTCCorpus(const string& path);
+    ~CTCCorpus();
+
+    CTCCorpus(const CTCCorpus&) = delete;
+    CTCCorpus& operator=(const CTCCorpus&) = delete;
+
+    size_t size() const { return header->testCount; }
+
+    /**
+     * Number of statements of a CTC, without decoding it
+     */
+    size_t length(size_t testId) const;
+
+    /**
+     * Decode the CTC with the given test id (throws out_of_range if none)
+     */
+    unique_ptr<Program> get(size_t testId) const;
+
+    /**
+     * Streaming iteration over all CTCs in test-id order
+     */
+    class Stream {
+    private:
+        const CTCCorpus& corpus;
+        size_t nextId;
+    public:
+        explicit Stream(const CTCCorpus& corpus) : corpus(corpus), nextId(0) {}
+        bool next(size_t& testId, unique_ptr<Program>& ctc);
+    };
+
+    Stream stream() const { return Stream(*this); }
+};
+
+#endif // CTCCORPUS_HH
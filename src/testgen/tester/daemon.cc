@@ -0,0 +1,298 @@
+#include "daemon.hh"
+#include "../language/clonevisitor.hh"
+#include "../language/printvisitor.hh"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static sockaddr_un socketAddress(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw runtime_error("Socket path too long: " + path);
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+// Test strings of a request: block names separated by spaces, test strings by ';'
+static vector<vector<string>> parseTestStrings(const string& text) {
+    vector<vector<string>> result(1);
+    string spaced;
+    for (char c : text) {
+        if (c == ';') {
+            spaced += " ; ";
+        } else {
+            spaced += c;
+        }
+    }
+    istringstream words(spaced);
+    string word;
+    while (words >> word) {
+        if (word == ";") {
+            result.emplace_back();
+        } else {
+            result.back().push_back(word);
+        }
+    }
+    vector<vector<string>> nonEmpty;
+    for (auto& ts : result) {
+        if (!ts.empty()) {
+            nonEmpty.push_back(std::move(ts));
+        }
+    }
+    return nonEmpty;
+}
+
+GenerationDaemon::GenerationDaemon(Campaign& campaign, const string& socketPath)
+    : campaign(campaign), socketPath(socketPath), listenFd(-1), z3(), solver(z3),
+      ctcBytes(0), governor(nullptr), ctcAccount(0), templateAccount(0),
+      stats{ 0, 0, 0, 0 }, stopping(false) {
+    campaign.setHybridSolver(&solver);
+}
+
+GenerationDaemon::~GenerationDaemon() {
+    campaign.setHybridSolver(nullptr);
+    if (governor) {
+        governor->removeCache(ctcAccount);
+        governor->removeCache(templateAccount);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
+
+void GenerationDaemon::start() {
+    sockaddr_un addr = socketAddress(socketPath);
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw runtime_error(string("socket() failed: ") + strerror(errno));
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        string error = strerror(errno);
+        close(listenFd);
+        listenFd = -1;
+        throw runtime_error("Cannot listen on " + socketPath + ": " + error);
+    }
+    cout << "[DAEMON] Listening on " << socketPath << endl;
+}
+
+bool GenerationDaemon::sendAll(int fd, const string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+void GenerationDaemon::setMemoryGovernor(MemoryGovernor* governor, double ctcShare,
+                                         double templateShare) {
+    this->governor = governor;
+    ctcAccount = governor->addCache("daemon CTC cache", ctcShare,
+                                    [this](size_t target) { return evictCTCs(target); });
+    templateAccount = governor->addCache("solver templates", templateShare,
+                                         [this](size_t target) { return z3.evictTemplates(target); });
+}
+
+size_t GenerationDaemon::evictCTCs(size_t maxBytes) {
+    while (ctcBytes > maxBytes && ctcRecent.size() > 1) {
+        auto it = ctcCache.find(ctcRecent.back());
+        ctcBytes -= it->second.bytes;
+        ctcCache.erase(it);
+        ctcRecent.pop_back();
+    }
+    return ctcBytes;
+}
+
+const Program& GenerationDaemon::getCTC(const vector<string>& testString) {
+    auto it = ctcCache.find(testString);
+    if (it != ctcCache.end()) {
+        stats.cacheHits++;
+        ctcRecent.splice(ctcRecent.begin(), ctcRecent, it->second.use);
+        return *it->second.ctc;
+    }
+    if (governor && !governor->admit()) {
+        throw runtime_error("memory budget exceeded, retry later");
+    }
+    stats.generated++;
+    unique_ptr<Program> ctc = campaign.generateCTC(testString);
+    size_t bytes = MemoryGovernor::approxBytes(*ctc);
+    ctcRecent.push_front(testString);
+    it = ctcCache.emplace(testString, CachedCTC{ std::move(ctc), ctcRecent.begin(), bytes }).first;
+    ctcBytes += bytes;
+    if (governor) {
+        // The new CTC is the most recent one and survives eviction
+        governor->update(ctcAccount, ctcBytes);
+        governor->update(templateAccount, z3.getTemplateBytes());
+    }
+    return *it->second.ctc;
+}
+
+string GenerationDaemon::escapeLine(const string& line) {
+    string escaped;
+    for (char c : line) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '\r') {
+            escaped += "\\r";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+string GenerationDaemon::unescapeLine(const string& line) {
+    string text;
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] != '\\' || i + 1 == line.size()) {
+            text += line[i];
+            continue;
+        }
+        char c = line[++i];
+        text += c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+    return text;
+}
+
+void GenerationDaemon::handle(const string& request, const function<void(const string&)>& emit) {
+    stats.requests++;
+    istringstream in(request);
+    string command;
+    in >> command;
+    string rest;
+    getline(in, rest);
+    // Statements and messages may contain newlines; END stays unescaped
+    auto send = [&emit](const string& line) { emit(escapeLine(line)); };
+
+    if (command == "GENERATE" || command == "REPLAY") {
+        vector<vector<string>> testStrings = parseTestStrings(rest);
+        if (testStrings.empty()) {
+            send("ERROR " + command + " needs at least one test string");
+            emit("END");
+            return;
+        }
+        for (size_t k = 0; k < testStrings.size(); k++) {
+            try {
+                const Program& ctc = getCTC(testStrings[k]);
+                if (command == "GENERATE") {
+                    send("CTC " + to_string(k) + " " + to_string(ctc.statements.size()));
+                    for (const auto& stmt : ctc.statements) {
+                        send(PrintVisitor::stmtToString(stmt.get()));
+                    }
+                    continue;
+                }
+                CloneVisitor cloner;
+                vector<unique_ptr<Stmt>> stmts;
+                for (const auto& stmt : ctc.statements) {
+                    stmts.push_back(cloner.cloneStmt(stmt.get()));
+                }
+                stats.replays++;
+                CampaignEntry entry = campaign.replayCTC(testStrings[k],
+                    make_unique<Program>(std::move(stmts)), k);
+                send("RESULT " + to_string(k) + " " + replayStatusToString(entry.result.status) +
+                     " +" + to_string(entry.newPoints) + " " + entry.result.message);
+            } catch (const exception& e) {
+                send("ERROR " + to_string(k) + " " + e.what());
+            }
+        }
+    } else if (command == "STATS") {
+        send("STATS requests=" + to_string(stats.requests) +
+             " generated=" + to_string(stats.generated) +
+             " hits=" + to_string(stats.cacheHits) +
+             " replays=" + to_string(stats.replays) +
+             " templates=" + to_string(z3.getTemplateCount()));
+    } else if (command == "SHUTDOWN") {
+        stopping = true;
+        send("BYE");
+    } else {
+        send("ERROR unknown request '" + command + "'");
+    }
+    emit("END");
+}
+
+void GenerationDaemon::serve() {
+    if (listenFd < 0) {
+        start();
+    }
+    stopping = false;
+    while (!stopping) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("accept() failed: ") + strerror(errno));
+        }
+        string buffer;
+        char chunk[4096];
+        bool open = true;
+        while (open && !stopping) {
+            size_t eol = buffer.find('\n');
+            if (eol == string::npos) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) break;
+                buffer.append(chunk, n);
+                continue;
+            }
+            string line = buffer.substr(0, eol);
+            buffer.erase(0, eol + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            handle(line, [&](const string& out) {
+                open = open && sendAll(fd, out + "\n");
+            });
+        }
+        close(fd);
+    }
+    cout << "[DAEMON] Shut down after " << stats.requests << " requests" << endl;
+}
+
+vector<string> GenerationDaemon::request(const string& socketPath, const string& line) {
+    sockaddr_un addr = socketAddress(socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        string error = strerror(errno);
+        if (fd >= 0) close(fd);
+        throw runtime_error("Cannot connect to " + socketPath + ": " + error);
+    }
+    if (!sendAll(fd, line + "\n")) {
+        close(fd);
+        throw runtime_error("Cannot send request to " + socketPath);
+    }
+
+    vector<string> lines;
+    string buffer;
+    char chunk[4096];
+    while (true) {
+        size_t eol = buffer.find('\n');
+        if (eol != string::npos) {
+            string out = buffer.substr(0, eol);
+            buffer.erase(0, eol + 1);
+            if (out == "END") break;
+            lines.push_back(unescapeLine(out));
+            continue;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            close(fd);
+            throw runtime_error("Daemon closed the connection before END");
+        }
+        buffer.append(chunk, n);
+    }
+    close(fd);
+    return lines;
+}
@@ -0,0 +1,133 @@
+#ifndef DAEMON_HH
+#define DAEMON_HH
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../see/hybridsolver.hh"
+#include "../see/z3solver.hh"
+#include "campaign.hh"
+#include "memorygovernor.hh"
+
+using namespace std;
+
+/**
+ * Counters of a daemon since it started
+ */
+struct DaemonStats {
+    size_t requests;
+    size_t generated;    // CTCs produced by symbolic execution
+    size_t cacheHits;    // CTCs served from the cache
+    size_t replays;
+};
+
+/**
+ * GenerationDaemon: long-running test generation service on a Unix domain
+ * socket, so repeated CI invocations do not pay for startup again.
+ *
+ * Everything that is expensive to rebuild stays in the process: the
+ * campaign (spec, symbol tables, coverage, native oracles if compiled), a
+ * hybrid solver whose Z3 fallback keeps its context and conjunct templates,
+ * and the CTCs of the test strings generated so far. Replays always run
+ * against a fresh SUT from the campaign's factory, so a changed SUT is seen
+ * by the next request.
+ *
+ * With a memory governor, the CTC cache and the solver's templates are
+ * bounded by their shares of the budget (least recently used entries go
+ * first), and a test string whose CTC is not cached is refused with an
+ * ERROR while the process is near the budget.
+ *
+ * Protocol: one request per line; test strings are block names separated by
+ * spaces, several test strings by ';'. Every response ends with "END".
+ * Backslashes, newlines and carriage returns inside a response line (e.g.
+ * in string literals of a CTC) are escaped as \\, \n and \r, so each
+ * response line is one line on the wire and never reads as END.
+ *   GENERATE ts; ts...   per test string "CTC <k> <n>" and its n statements,
+ *                        written as soon as that CTC is ready
+ *   REPLAY ts; ts...     per test string "RESULT <k> <status> +<new points> <message>"
+ *   STATS                "STATS requests=.. generated=.. hits=.. replays=.. templates=.."
+ *   SHUTDOWN             "BYE"; serve() returns
+ * A failing test string yields "ERROR <k> <message>", a malformed request
+ * "ERROR <message>". Connections are served one at a time, each for as
+ * many requests as the client sends.
+ */
+class GenerationDaemon {
+private:
+    Campaign& campaign;
+    string socketPath;
+    int listenFd;
+    Z3Solver z3;
+    HybridSolver solver;
+    struct CachedCTC {
+        unique_ptr<Program> ctc;
+        list<vector<string>>::iterator use;   // position in ctcRecent
+        size_t bytes;
+    };
+    map<vector<string>, CachedCTC> ctcCache;
+    list<vector<string>> ctcRecent;           // most recently used first
+    size_t ctcBytes;
+    MemoryGovernor* governor;
+    MemoryGovernor::CacheId ctcAccount;
+    MemoryGovernor::CacheId templateAccount;
+    DaemonStats stats;
+    bool stopping;
+
+    const Program& getCTC(const vector<string>& testString);
+    // Drop least recently used CTCs, never the most recent one, until at
+    // most maxBytes are held; returns the bytes held afterwards
+    size_t evictCTCs(size_t maxBytes);
+    static bool sendAll(int fd, const string& text);
+
+public:
+    GenerationDaemon(Campaign& campaign, const string& socketPath);
+    ~GenerationDaemon();
+
+    GenerationDaemon(const GenerationDaemon&) = delete;
+    GenerationDaemon& operator=(const GenerationDaemon&) = delete;
+
+    /**
+     * Bind and listen on the socket path (a stale socket file is replaced).
+     * Throws runtime_error on failure.
+     */
+    void start();
+
+    /**
+     * Accept connections and answer requests until SHUTDOWN
+     */
+    void serve();
+
+    /**
+     * Answer one request line; emit is called once per response line, in
+     * wire form
+     */
+    void handle(const string& request, const function<void(const string&)>& emit);
+
+    /**
+     * Bound the CTC cache and the solver templates by shares of the
+     * governor's budget and refuse new generations near the budget
+     */
+    void setMemoryGovernor(MemoryGovernor* governor, double ctcShare = 0.5,
+                           double templateShare = 0.25);
+
+    const DaemonStats& getStats() const { return stats; }
+    size_t getCachedCTCs() const { return ctcCache.size(); }
+
+    /**
+     * Client side: send one request and return the response lines (without
+     * the final END). Throws runtime_error if the daemon is not reachable.
+     */
+    static vector<string> request(const string& socketPath, const string& line);
+
+    /**
+     * Wire form of a response line and back (see the protocol above)
+     */
+    static string escapeLine(const string& line);
+    static string unescapeLine(const string& line);
+};
+
+#endif // DAEMON_HH
@@ -0,0 +1,75 @@
+#ifndef DDMIN_HH
+#define DDMIN_HH
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Delta debugging (ddmin, Zeller and Hildebrandt) over a sequence.
+ *
+ * Every round splits `current` into n chunks of (almost) equal size and
+ * tries each chunk, then, if n > 2, each complement. The first candidate
+ * that still has the property becomes `current` (n goes back to 2 after a
+ * chunk, down by one after a complement); if none has it, n is doubled
+ * until every element has been tried on its own. The result is 1-minimal:
+ * removing any single element loses the property.
+ *
+ * round(candidates) is called once per round with every candidate the round
+ * may try, before the first test(candidate), so callers can check them all
+ * at once (Shrinker replays them in parallel). test(candidate) must be true
+ * for candidates that keep the property; it is assumed to hold for the
+ * sequence passed in.
+ */
+template <typename T, typename Test, typename Round>
+vector<T> ddmin(vector<T> current, Test test, Round round) {
+    size_t n = 2;
+    while (current.size() >= 2) {
+        vector<vector<T>> subsets, complements;
+        size_t start = 0;
+        for (size_t c = 0; c < n; c++) {
+            size_t end = start + (current.size() - start) / (n - c);
+            subsets.push_back(vector<T>(current.begin() + start, current.begin() + end));
+            vector<T> complement(current.begin(), current.begin() + start);
+            complement.insert(complement.end(), current.begin() + end, current.end());
+            complements.push_back(complement);
+            start = end;
+        }
+
+        vector<vector<T>> candidates = subsets;
+        if (n > 2) {
+            candidates.insert(candidates.end(), complements.begin(), complements.end());
+        }
+        round(candidates);
+
+        bool reduced = false;
+        for (const auto& s : subsets) {
+            if (test(s)) {
+                current = s;
+                n = 2;
+                reduced = true;
+                break;
+            }
+        }
+        if (!reduced && n > 2) {
+            for (const auto& c : complements) {
+                if (test(c)) {
+                    current = c;
+                    n = max(n - 1, (size_t)2);
+                    reduced = true;
+                    break;
+                }
+            }
+        }
+        if (!reduced) {
+            if (n >= current.size()) {
+                break;
+            }
+            n = min(n * 2, current.size());
+        }
+    }
+    return current;
+}
+
+#endif // DDMIN_HH
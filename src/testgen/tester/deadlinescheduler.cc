@@ -0,0 +1,148 @@
+#include "deadlinescheduler.hh"
+#include "tester.hh"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+
+static double elapsedMs(chrono::steady_clock::time_point since) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+}
+
+static bool isConstant(const Expr& e) {
+    return e.exprType == ExprType::NUM || e.exprType == ExprType::STRING;
+}
+
+// Node count of a predicate. Products and quotients of two non-constant
+// terms leave linear arithmetic, which is where solving gets expensive.
+static double termCost(const Expr* e) {
+    if (!e) {
+        return 0;
+    }
+    if (e->exprType != ExprType::FUNCCALL) {
+        return 1;
+    }
+    const FuncCall& fc = dynamic_cast<const FuncCall&>(*e);
+    double cost = 1;
+    if ((fc.name == "Mul" || fc.name == "Div") && fc.args.size() == 2 &&
+        !isConstant(*fc.args[0]) && !isConstant(*fc.args[1])) {
+        cost = 8;
+    }
+    for (const auto& arg : fc.args) {
+        cost += termCost(arg.get());
+    }
+    return cost;
+}
+
+DeadlineScheduler::DeadlineScheduler(Campaign& campaign, vector<vector<string>> candidates,
+                                     double msPerUnit, double sliceFactor, double minSliceMs)
+    : campaign(campaign), candidates(candidates),
+      coverageScheduler(campaign.getCoverageMap(), std::move(candidates)),
+      done(this->candidates.size(), false), sliceFactor(sliceFactor), minSliceMs(minSliceMs) {
+    const CoverageMap& coverageMap = campaign.getCoverageMap();
+    const Spec* spec = coverageMap.getSpec();
+    for (size_t b = 0; b < coverageMap.blockCount(); b++) {
+        blockCost.push_back(staticCost(*spec->blocks[b]) * msPerUnit);
+    }
+}
+
+double DeadlineScheduler::staticCost(const API& block) {
+    double cost = 1 + block.call->call->args.size();
+    cost += termCost(block.pre.get());
+    cost += termCost(block.response.ResponseExpr.get());
+    return cost;
+}
+
+double DeadlineScheduler::estimateCost(const vector<string>& testString) const {
+    const CoverageMap& coverageMap = campaign.getCoverageMap();
+    double cost = 0;
+    for (const auto& name : testString) {
+        for (size_t b : coverageMap.blocksNamed(name)) {
+            cost += blockCost[b];
+        }
+    }
+    return cost;
+}
+
+void DeadlineScheduler::observe(const vector<string>& testString, double elapsed) {
+    double estimate = estimateCost(testString);
+    if (estimate <= 0) {
+        return;
+    }
+    // Move each involved block halfway towards the observed/estimated ratio
+    double factor = 0.5 + 0.5 * (elapsed / estimate);
+    set<size_t> blocks;
+    for (const auto& name : testString) {
+        for (size_t b : campaign.getCoverageMap().blocksNamed(name)) {
+            blocks.insert(b);
+        }
+    }
+    for (size_t b : blocks) {
+        blockCost[b] *= factor;
+    }
+}
+
+vector<CampaignEntry> DeadlineScheduler::run(double budgetMs) {
+    vector<CampaignEntry> entries;
+    auto start = chrono::steady_clock::now();
+
+    while (true) {
+        double left = budgetMs - elapsedMs(start);
+        if (left <= 0) {
+            break;
+        }
+
+        size_t best = candidates.size();
+        double bestValue = 0;
+        double bestEstimate = 0;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (done[i]) continue;
+            double gain = coverageScheduler.expectedGain(i, campaign.getCoverage());
+            double estimate = estimateCost(candidates[i]);
+            if (gain <= 0 || estimate > left) continue;
+            double value = gain / max(estimate, 1e-3);
+            if (value > bestValue ||
+                (value == bestValue && candidates[i].size() < candidates[best].size())) {
+                best = i;
+                bestValue = value;
+                bestEstimate = estimate;
+            }
+        }
+        if (best == candidates.size()) {
+            cout << "[DEADLINE] No candidate adds coverage within the remaining " << left << " ms" << endl;
+            break;
+        }
+        done[best] = true;
+
+        const vector<string>& testString = candidates[best];
+        double slice = min(left, max(minSliceMs, sliceFactor * bestEstimate));
+        auto taskStart = chrono::steady_clock::now();
+        try {
+            CoverageBitmap before = campaign.getCoverage();
+            CampaignEntry entry = campaign.runTestString(testString, entries.size(), slice);
+            double took = elapsedMs(taskStart);
+            observe(testString, took);
+            coverageScheduler.update(testString, before.newBits(entry.coverage));
+
+            cout << "[DEADLINE] test " << entries.size() << " (" << took << " ms, estimated "
+                 << bestEstimate << " ms) -> " << replayStatusToString(entry.result.status)
+                 << ", +" << entry.newPoints << " points" << endl;
+            entries.push_back(std::move(entry));
+        } catch (const DeadlineExceeded&) {
+            double took = elapsedMs(taskStart);
+            observe(testString, took);
+            coverageScheduler.update(testString, CoverageBitmap(campaign.getCoverageMap().size()));
+            preempted.push_back(testString);
+
+            cout << "[DEADLINE] Preempted after " << took << " ms (slice " << slice << " ms): ";
+            for (const auto& name : testString) {
+                cout << name << " ";
+            }
+            cout << endl;
+        }
+    }
+
+    cout << "[DEADLINE] " << entries.size() << " completed, " << preempted.size()
+         << " preempted in " << elapsedMs(start) << " ms of " << budgetMs << " ms" << endl;
+    return entries;
+}
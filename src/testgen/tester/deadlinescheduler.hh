@@ -0,0 +1,73 @@
+#ifndef DEADLINESCHEDULER_HH
+#define DEADLINESCHEDULER_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "campaign.hh"
+#include "coverage.hh"
+
+using namespace std;
+
+/**
+ * DeadlineScheduler: runs a campaign inside a wall-clock budget
+ *
+ * Every block has a cost estimate in milliseconds. It starts from a
+ * structural cost (staticCost: API arguments plus the size of the pre- and
+ * postcondition, nonlinear arithmetic weighted up) and is rescaled by the
+ * run times actually observed for test strings containing the block.
+ *
+ * run() repeatedly picks the candidate with the best expected coverage gain
+ * per estimated millisecond among those that still fit in the remaining
+ * budget, and runs it with a time slice of sliceFactor x its estimate. A
+ * candidate whose CTC generation overruns the slice is preempted: it is
+ * recorded in getPreempted(), its blocks' estimates go up, and the budget
+ * moves on to the next candidate. Replay is not preempted; it is cheap next
+ * to generation, but its time counts against the budget.
+ */
+class DeadlineScheduler {
+private:
+    Campaign& campaign;
+    vector<vector<string>> candidates;
+    CoverageScheduler coverageScheduler;   // gains and per-block hit rates
+    vector<bool> done;
+    vector<double> blockCost;              // estimated ms per occurrence
+    vector<vector<string>> preempted;
+    double sliceFactor;
+    double minSliceMs;
+
+    void observe(const vector<string>& testString, double elapsedMs);
+
+public:
+    /**
+     * @param msPerUnit   initial milliseconds per staticCost unit
+     * @param sliceFactor time slice as a multiple of the estimated cost
+     * @param minSliceMs  lower bound on a time slice
+     */
+    DeadlineScheduler(Campaign& campaign, vector<vector<string>> candidates,
+                      double msPerUnit = 1.0, double sliceFactor = 4.0, double minSliceMs = 50.0);
+
+    /**
+     * Structural cost of a block, in abstract units
+     */
+    static double staticCost(const API& block);
+
+    /**
+     * Estimated generation time of a test string in milliseconds
+     */
+    double estimateCost(const vector<string>& testString) const;
+
+    /**
+     * Run candidates until budgetMs of wall-clock time is used up, no
+     * candidate fits in the rest of it, or none is expected to add coverage.
+     * Returns the completed entries in execution order.
+     */
+    vector<CampaignEntry> run(double budgetMs);
+
+    const vector<vector<string>>& getPreempted() const { return preempted; }
+    double getBlockCost(size_t block) const { return blockCost[block]; }
+};
+
+#endif // DEADLINESCHEDULER_HH
@@ -0,0 +1,220 @@
+#include "differential.hh"
+#include "../language/clonevisitor.hh"
+#include "../language/printvisitor.hh"
+#include "../see/concreteevaluator.hh"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+static const char* sideName(int side) {
+    return side == 0 ? "reference" : "candidate";
+}
+
+static string describe(const Expr& value) {
+    return PrintVisitor::exprToString(&value);
+}
+
+/**
+ * Rendezvous of the two replays of one CTC. Side 0 is the reference SUT,
+ * side 1 the candidate.
+ */
+class Lockstep {
+private:
+    mutex m;
+    condition_variable cv;
+    vector<pair<size_t, unique_ptr<Expr>>> trace[2];   // API results per side
+    bool finished[2];
+    size_t compared;
+
+    void diverge(int stmtIndex, string referenceValue, string candidateValue, string message) {
+        if (diverged) return;
+        diverged = true;
+        this->stmtIndex = stmtIndex;
+        values[0] = std::move(referenceValue);
+        values[1] = std::move(candidateValue);
+        this->message = std::move(message);
+    }
+
+public:
+    bool diverged;
+    int stmtIndex;
+    string values[2];
+    string message;
+    int stoppedSide;   // side that ended before an API call the other made
+
+    Lockstep() : finished{ false, false }, compared(0), diverged(false), stmtIndex(-1),
+                 stoppedSide(-1) {}
+
+    void arrive(int side, size_t stmt, const Expr& value) {
+        CloneVisitor cloner;
+        unique_ptr<Expr> copy = cloner.cloneExpr(&value);
+
+        unique_lock<mutex> lock(m);
+        trace[side].emplace_back(stmt, std::move(copy));
+        size_t step = trace[side].size();
+        int other = 1 - side;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return trace[other].size() >= step || finished[other]; });
+
+        if (trace[other].size() < step) {
+            // The other SUT ended its replay before reaching this call
+            if (!diverged) {
+                stoppedSide = other;
+            }
+            string mine = describe(*trace[side].back().second);
+            diverge(stmt, side == 0 ? mine : "", side == 0 ? "" : mine,
+                    string(sideName(other)) + " stopped before the API call at statement " +
+                    to_string(stmt));
+            return;
+        }
+        if (compared < step) {
+            compared = step;
+            const auto& ref = trace[0][step - 1];
+            const auto& cand = trace[1][step - 1];
+            if (!ConcreteEvaluator::equal(*ref.second, *cand.second)) {
+                diverge(ref.first, describe(*ref.second), describe(*cand.second),
+                        "API results differ at statement " + to_string(ref.first));
+            }
+        }
+    }
+
+    void finish(int side) {
+        lock_guard<mutex> lock(m);
+        finished[side] = true;
+        cv.notify_all();
+    }
+};
+
+class LockstepObserver : public ReplayObserver {
+private:
+    Lockstep& lockstep;
+    int side;
+
+public:
+    LockstepObserver(Lockstep& lockstep, int side) : lockstep(lockstep), side(side) {}
+
+    void onAssign(size_t stmtIndex, const Assign& stmt, const Expr& value) override {
+        if (stmt.right->exprType != ExprType::FUNCCALL) return;
+        const FuncCall& fc = dynamic_cast<const FuncCall&>(*stmt.right);
+        if (ConcreteEvaluator::isBuiltin(fc.name)) return;
+        lockstep.arrive(side, stmtIndex, value);
+    }
+};
+
+DifferentialRunner::DifferentialRunner(ReplayRunner::FactoryMaker makeReference,
+                                       ReplayRunner::FactoryMaker makeCandidate,
+                                       unsigned int workers)
+    : makeReference(std::move(makeReference)), makeCandidate(std::move(makeCandidate)),
+      workers(workers), lastWallMs(0) {
+    // Every worker drives two replay threads
+    if (this->workers == 0) {
+        this->workers = thread::hardware_concurrency() / 2;
+    }
+    if (this->workers == 0) {
+        this->workers = 1;
+    }
+}
+
+DifferentialResult DifferentialRunner::compare(const Program& ctc, FunctionFactory& reference,
+                                               FunctionFactory& candidate, size_t testId) {
+    Lockstep lockstep;
+    LockstepObserver referenceObserver(lockstep, 0);
+    LockstepObserver candidateObserver(lockstep, 1);
+
+    DifferentialResult result;
+    result.testId = testId;
+
+    thread referenceThread([&]() {
+        result.reference = ReplayRunner::replay(ctc, reference, testId, &referenceObserver);
+        lockstep.finish(0);
+    });
+    result.candidate = ReplayRunner::replay(ctc, candidate, testId, &candidateObserver);
+    lockstep.finish(1);
+    referenceThread.join();
+
+    result.diverged = lockstep.diverged;
+    result.stmtIndex = lockstep.stmtIndex;
+    result.referenceValue = lockstep.values[0];
+    result.candidateValue = lockstep.values[1];
+    result.message = lockstep.message;
+
+    if (lockstep.stoppedSide >= 0) {
+        const ReplayResult& stopped = lockstep.stoppedSide == 0 ? result.reference : result.candidate;
+        string& value = lockstep.stoppedSide == 0 ? result.referenceValue : result.candidateValue;
+        value = "<" + replayStatusToString(stopped.status) +
+                (stopped.message.empty() ? "" : ": " + stopped.message) + ">";
+    } else if (!result.diverged && result.reference.status != result.candidate.status) {
+        result.diverged = true;
+        result.stmtIndex = max(result.reference.stmtIndex, result.candidate.stmtIndex);
+        result.referenceValue = replayStatusToString(result.reference.status);
+        result.candidateValue = replayStatusToString(result.candidate.status);
+        result.message = "verdicts differ";
+    }
+    return result;
+}
+
+void DifferentialRunner::work(const vector<const Program*>& ctcs,
+                              atomic<size_t>& next,
+                              vector<DifferentialResult>& results) {
+    unique_ptr<FunctionFactory> pristineReference = makeReference();
+    unique_ptr<FunctionFactory> pristineCandidate = makeCandidate();
+
+    for (size_t i = next.fetch_add(1); i < ctcs.size(); i = next.fetch_add(1)) {
+        unique_ptr<FunctionFactory> reference = pristineReference->snapshot();
+        if (!reference) {
+            reference = makeReference();
+        }
+        unique_ptr<FunctionFactory> candidate = pristineCandidate->snapshot();
+        if (!candidate) {
+            candidate = makeCandidate();
+        }
+        results[i] = compare(*ctcs[i], *reference, *candidate, i);
+    }
+}
+
+vector<DifferentialResult> DifferentialRunner::run(const vector<const Program*>& ctcs) {
+    auto start = chrono::steady_clock::now();
+    vector<DifferentialResult> results(ctcs.size());
+    atomic<size_t> next(0);
+
+    unsigned int n = workers;
+    if (n > ctcs.size()) {
+        n = ctcs.size();
+    }
+
+    vector<thread> pool;
+    for (unsigned int w = 0; w < n; w++) {
+        pool.emplace_back(&DifferentialRunner::work, this, cref(ctcs), ref(next), ref(results));
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    lastWallMs = elapsed.count();
+    return results;
+}
+
+vector<DifferentialResult> DifferentialRunner::run(const vector<unique_ptr<Program>>& ctcs) {
+    vector<const Program*> ptrs;
+    for (const auto& p : ctcs) {
+        ptrs.push_back(p.get());
+    }
+    return run(ptrs);
+}
+
+void DifferentialRunner::printReport(const vector<DifferentialResult>& results) {
+    size_t diverged = 0;
+    for (const auto& r : results) {
+        if (!r.diverged) {
+            continue;
+        }
+        diverged++;
+        cout << "  [DIFF] test " << r.testId << ": " << r.message << endl;
+        cout << "         reference: " << r.referenceValue << endl;
+        cout << "         candidate: " << r.candidateValue << endl;
+    }
+    cout << "[DIFF] " << diverged << "/" << results.size() << " CTCs diverged" << endl;
+}
@@ -0,0 +1,80 @@
+#ifndef DIFFERENTIAL_HH
+#define DIFFERENTIAL_HH
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../see/functionfactory.hh"
+#include "replay.hh"
+
+using namespace std;
+
+/**
+ * Outcome of replaying one CTC against a reference and a candidate SUT
+ *
+ * stmtIndex is the statement of the first divergence: an API call whose
+ * results differ, the call one SUT reached and the other did not (it
+ * stopped earlier), or, if all results agree, the statement that decided
+ * the differing verdicts (-1 if the verdicts agree as well).
+ */
+struct DifferentialResult {
+    size_t testId;
+    bool diverged;
+    int stmtIndex;
+    string referenceValue;
+    string candidateValue;
+    string message;
+    ReplayResult reference;
+    ReplayResult candidate;
+};
+
+/**
+ * DifferentialRunner: replays CTCs against two FunctionFactory
+ * implementations (e.g. the current and the upgraded SUT) and reports where
+ * their behaviour first differs.
+ *
+ * Each CTC is replayed on two threads, one per SUT, kept in lockstep at every
+ * API call: each side publishes the call's result and waits for the other
+ * side's result for the same call, and the pair is compared structurally
+ * (ConcreteEvaluator::equal). Builtin calls are not synchronized. CTCs are
+ * spread over `workers` such thread pairs, so both SUTs are exercised in a
+ * single pass over the corpus; every CTC gets isolated SUT instances as in
+ * ReplayRunner.
+ */
+class DifferentialRunner {
+private:
+    ReplayRunner::FactoryMaker makeReference;
+    ReplayRunner::FactoryMaker makeCandidate;
+    unsigned int workers;
+    double lastWallMs;
+
+    void work(const vector<const Program*>& ctcs,
+              atomic<size_t>& next,
+              vector<DifferentialResult>& results);
+
+public:
+    DifferentialRunner(ReplayRunner::FactoryMaker makeReference,
+                       ReplayRunner::FactoryMaker makeCandidate, unsigned int workers = 0);
+
+    /**
+     * Replay one CTC against both SUT instances in lockstep
+     */
+    static DifferentialResult compare(const Program& ctc, FunctionFactory& reference,
+                                      FunctionFactory& candidate, size_t testId = 0);
+
+    /**
+     * Compare all CTCs concurrently. Results are indexed like the input.
+     */
+    vector<DifferentialResult> run(const vector<const Program*>& ctcs);
+    vector<DifferentialResult> run(const vector<unique_ptr<Program>>& ctcs);
+
+    unsigned int getWorkers() const { return workers; }
+    double getLastWallMs() const { return lastWallMs; }
+
+    static void printReport(const vector<DifferentialResult>& results);
+};
+
+#endif // DIFFERENTIAL_HH
@@ -0,0 +1,331 @@
+#include "forkserver.hh"
+#include "../language/exprwalk.hh"
+#include "../language/symvar.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * CTCs of a group share their first `depth` statements, which have been
+ * executed, in prefixMs
+ */
+struct ForkServer::Group {
+    vector<size_t> members;
+    size_t depth;
+    double prefixMs;
+};
+
+/**
+ * Structural key of an expression: equal keys, equal expressions
+ */
+static string exprKey(const Expr& e) {
+    return foldExpr<string>(e, [](const Expr& node, vector<string>& children) {
+        string open, close = ")";
+        switch (node.exprType) {
+            case ExprType::NUM:
+                return to_string(dynamic_cast<const Num&>(node).value);
+            case ExprType::STRING: {
+                const string& value = dynamic_cast<const String&>(node).value;
+                return "\"" + to_string(value.size()) + ":" + value;
+            }
+            case ExprType::VAR:
+                return dynamic_cast<const Var&>(node).name;
+            case ExprType::SYMVAR:
+                return "$" + to_string(dynamic_cast<const SymVar&>(node).getNum());
+            case ExprType::FUNCCALL:
+                open = dynamic_cast<const FuncCall&>(node).name + "(";
+                break;
+            case ExprType::TUPLE:
+                open = "(";
+                break;
+            case ExprType::SET:
+                open = "{";
+                close = "}";
+                break;
+            case ExprType::MAP: {
+                const Map& map = dynamic_cast<const Map&>(node);
+                string s = "[";
+                for (size_t i = 0; i < children.size(); i++) {
+                    s += map.value[i].first->name + "->" + children[i] + ",";
+                }
+                return s + "]";
+            }
+            default:
+                // Never shared
+                return "?" + to_string(reinterpret_cast<uintptr_t>(&node));
+        }
+        for (const auto& child : children) {
+            open += child + ",";
+        }
+        return open + close;
+    });
+}
+
+static string stmtKey(const Stmt& stmt) {
+    switch (stmt.statementType) {
+        case StmtType::ASSIGN: {
+            const Assign& assign = dynamic_cast<const Assign&>(stmt);
+            return exprKey(*assign.left) + ":=" + exprKey(*assign.right);
+        }
+        case StmtType::ASSUME:
+            return "assume " + exprKey(*dynamic_cast<const Assume&>(stmt).expr);
+        case StmtType::ASSERT:
+            return "assert " + exprKey(*dynamic_cast<const Assert&>(stmt).expr);
+        default:
+            return "?" + to_string(reinterpret_cast<uintptr_t>(&stmt));
+    }
+}
+
+template <typename T>
+static void appendValue(string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T takeValue(const string& buf, size_t& pos) {
+    if (pos + sizeof(T) > buf.size()) {
+        throw runtime_error("Fork server: truncated results from child");
+    }
+    T value;
+    memcpy(&value, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+static void writeAll(int fd, const string& buf) {
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        done += n;
+    }
+}
+
+static string readAll(int fd) {
+    string buf;
+    char chunk[4096];
+    while (true) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return buf;
+        buf.append(chunk, n);
+    }
+}
+
+ForkServer::ForkServer(ReplayRunner::FactoryMaker makeFactory)
+    : makeFactory(std::move(makeFactory)), oracles(nullptr), ctcs(nullptr),
+      forks(0), statementsExecuted(0), lastWallMs(0) {}
+
+void ForkServer::runGroup(const Group& group, ReplayExecution& execution, const Emit& emit) {
+    vector<size_t> members = group.members;
+    size_t depth = group.depth;
+    double prefixMs = group.prefixMs;
+
+    while (true) {
+        // CTCs that end here passed
+        vector<size_t> open;
+        for (size_t m : members) {
+            if (keys[m].size() == depth) {
+                emit({ m, ReplayStatus::PASSED, -1, "", prefixMs });
+            } else {
+                open.push_back(m);
+            }
+        }
+        if (open.empty()) {
+            return;
+        }
+
+        // Branches by the next statement, in first-seen order
+        vector<vector<size_t>> branches;
+        map<string, size_t> branchOf;
+        for (size_t m : open) {
+            auto found = branchOf.emplace(keys[m][depth], branches.size());
+            if (found.second) {
+                branches.emplace_back();
+            }
+            branches[found.first->second].push_back(m);
+        }
+        for (size_t b = 0; b + 1 < branches.size(); b++) {
+            runChild({ branches[b], depth, prefixMs }, execution, emit);
+        }
+        open = branches.back();
+
+        // The next statement is shared by all of open: execute it once
+        auto start = chrono::steady_clock::now();
+        ReplayResult decided = { 0, ReplayStatus::PASSED, -1, "", 0 };
+        bool proceed = false;
+        statementsExecuted++;
+        try {
+            proceed = execution.step(depth, *(*ctcs)[open[0]]->statements[depth], decided);
+        } catch (const exception& e) {
+            decided.status = ReplayStatus::ERROR;
+            decided.message = e.what();
+        } catch (const char* e) {
+            decided.status = ReplayStatus::ERROR;
+            decided.message = e;
+        }
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        prefixMs += elapsed.count();
+        if (!proceed) {
+            for (size_t m : open) {
+                decided.testId = m;
+                decided.latencyMs = prefixMs;
+                emit(decided);
+            }
+            return;
+        }
+        members = open;
+        depth++;
+    }
+}
+
+// Records sent from a child to its parent
+static const char RECORD_RESULT = 'R';
+static const char RECORD_COUNTERS = 'C';
+
+void ForkServer::runChild(const Group& group, ReplayExecution& execution, const Emit& emit) {
+    // Output still buffered would be written by parent and child
+    cout.flush();
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw runtime_error(string("Fork server: pipe failed: ") + strerror(errno));
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw runtime_error(string("Fork server: fork failed: ") + strerror(errno));
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        int out = fds[1];
+        forks = 0;
+        statementsExecuted = 0;
+        int status = 0;
+        try {
+            runGroup(group, execution, [out](const ReplayResult& r) {
+                string buf(1, RECORD_RESULT);
+                appendValue<uint64_t>(buf, r.testId);
+                appendValue<uint8_t>(buf, uint8_t(r.status));
+                appendValue<int32_t>(buf, r.stmtIndex);
+                appendValue<double>(buf, r.latencyMs);
+                appendValue<uint32_t>(buf, r.message.size());
+                buf += r.message;
+                writeAll(out, buf);
+            });
+            string buf(1, RECORD_COUNTERS);
+            appendValue<uint64_t>(buf, forks);
+            appendValue<uint64_t>(buf, statementsExecuted);
+            writeAll(out, buf);
+        } catch (const exception& e) {
+            cout << "[FORK] child failed: " << e.what() << endl;
+            status = 1;
+        }
+        close(out);
+        cout.flush();
+        // No destructors or atexit handlers: they belong to the parent
+        _exit(status);
+    }
+
+    close(fds[1]);
+    forks++;
+    string buf = readAll(fds[0]);
+    close(fds[0]);
+    int wstatus = 0;
+    while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {
+    }
+
+    // Complete records; a dying child may leave a partial one at the end
+    set<size_t> reported;
+    size_t pos = 0;
+    try {
+        while (pos < buf.size()) {
+            char tag = buf[pos++];
+            if (tag == RECORD_COUNTERS) {
+                forks += takeValue<uint64_t>(buf, pos);
+                statementsExecuted += takeValue<uint64_t>(buf, pos);
+                continue;
+            }
+            ReplayResult r;
+            r.testId = takeValue<uint64_t>(buf, pos);
+            r.status = ReplayStatus(takeValue<uint8_t>(buf, pos));
+            r.stmtIndex = takeValue<int32_t>(buf, pos);
+            r.latencyMs = takeValue<double>(buf, pos);
+            uint32_t length = takeValue<uint32_t>(buf, pos);
+            if (pos + length > buf.size()) {
+                break;
+            }
+            r.message = buf.substr(pos, length);
+            pos += length;
+            reported.insert(r.testId);
+            emit(r);
+        }
+    } catch (const runtime_error&) {
+    }
+
+    if (reported.size() == group.members.size()) {
+        return;
+    }
+    // The child died, typically in the SUT: the CTCs it did not report are errors
+    string message = WIFSIGNALED(wstatus)
+        ? "SUT process killed by signal " + to_string(WTERMSIG(wstatus))
+        : "SUT process exited with status " + to_string(WEXITSTATUS(wstatus));
+    cout << "[FORK] " << message << " (" << group.members.size() - reported.size()
+         << " CTCs)" << endl;
+    for (size_t m : group.members) {
+        if (!reported.count(m)) {
+            emit({ m, ReplayStatus::ERROR, -1, message, group.prefixMs });
+        }
+    }
+}
+
+vector<ReplayResult> ForkServer::run(const vector<const Program*>& ctcs) {
+    auto start = chrono::steady_clock::now();
+    forks = 0;
+    statementsExecuted = 0;
+    this->ctcs = &ctcs;
+    keys.assign(ctcs.size(), {});
+    Group root{ {}, 0, 0 };
+    for (size_t i = 0; i < ctcs.size(); i++) {
+        for (const auto& stmt : ctcs[i]->statements) {
+            keys[i].push_back(stmtKey(*stmt));
+        }
+        root.members.push_back(i);
+    }
+
+    vector<ReplayResult> results(ctcs.size());
+    if (!ctcs.empty()) {
+        // The SUT is built here and first runs in the child
+        unique_ptr<FunctionFactory> sut = makeFactory();
+        ReplayExecution execution(*sut, nullptr, oracles);
+        runChild(root, execution, [&results](const ReplayResult& r) {
+            results[r.testId] = r;
+        });
+    }
+    this->ctcs = nullptr;
+    keys.clear();
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    lastWallMs = elapsed.count();
+    cout << "[FORK] " << ctcs.size() << " CTCs, " << forks << " forks, "
+         << statementsExecuted << " statements executed" << endl;
+    return results;
+}
+
+vector<ReplayResult> ForkServer::run(const vector<unique_ptr<Program>>& ctcs) {
+    vector<const Program*> ptrs;
+    for (const auto& p : ctcs) {
+        ptrs.push_back(p.get());
+    }
+    return run(ptrs);
+}
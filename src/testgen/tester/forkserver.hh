@@ -0,0 +1,77 @@
+#ifndef FORKSERVER_HH
+#define FORKSERVER_HH
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "replay.hh"
+
+using namespace std;
+
+/**
+ * ForkServer: replays CTCs that share statement prefixes, executing every
+ * shared prefix once.
+ *
+ * The CTCs are grouped by their statements. A group's common prefix is
+ * executed in the current process; where the group splits, the process forks
+ * once per branch and each child continues with its own suffixes, on a
+ * copy-on-write copy of the SUT state reached after the prefix. This snapshots
+ * in-process SUT state that FunctionFactory::snapshot cannot copy. The last
+ * branch needs the state no more and continues in the process itself.
+ *
+ * The calling process only collects results: the CTCs run in a forked child,
+ * and every process streams the results it decides to its parent over a
+ * pipe as soon as they are known. If a process dies (a crashing SUT), the CTCs
+ * it had not reported are ERROR and the others are unaffected.
+ *
+ * Children run one at a time, so the process tree is at most as deep as the
+ * number of branching points on one CTC. The server forks, so it must not be
+ * used while other threads are running.
+ */
+class ForkServer {
+private:
+    ReplayRunner::FactoryMaker makeFactory;
+    const OracleLibrary* oracles;
+    const vector<const Program*>* ctcs;   // CTCs of the current run
+    vector<vector<string>> keys;          // per CTC, a key per statement
+    size_t forks;
+    size_t statementsExecuted;
+    double lastWallMs;
+
+    struct Group;
+    typedef function<void(const ReplayResult&)> Emit;
+    void runGroup(const Group& group, ReplayExecution& execution, const Emit& emit);
+    void runChild(const Group& group, ReplayExecution& execution, const Emit& emit);
+
+public:
+    explicit ForkServer(ReplayRunner::FactoryMaker makeFactory);
+
+    /**
+     * Native spec predicates (nullptr = interpret all)
+     */
+    void setOracles(const OracleLibrary* library) { oracles = library; }
+
+    /**
+     * Replay all CTCs. Results are indexed like the input and match what
+     * ReplayRunner::replay reports for each CTC on a fresh SUT; latencyMs
+     * includes the CTC's share of its prefix.
+     */
+    vector<ReplayResult> run(const vector<const Program*>& ctcs);
+    vector<ReplayResult> run(const vector<unique_ptr<Program>>& ctcs);
+
+    /**
+     * Processes forked by the last run
+     */
+    size_t getForks() const { return forks; }
+
+    /**
+     * Statements executed by the last run, over all processes. Replaying the
+     * CTCs one by one executes the sum of their lengths.
+     */
+    size_t getStatementsExecuted() const { return statementsExecuted; }
+
+    double getLastWallMs() const { return lastWallMs; }
+};
+
+#endif // FORKSERVER_HH
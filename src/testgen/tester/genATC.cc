@@ -163,10 +163,10 @@ void ATCGenerator::extractPrimedVars(const unique_ptr<Expr>& expr, set<string>&
 /**
  * Remove prime notation from expression
  * - '(U) → U
- * - U (when U is in primedVars) → U_old
+ * - U (when U is primed) → its old version, e.g. U_old_2
  */
 unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
-                                                    const set<string>& primedVars,
+                                                    const map<string, string>& oldVersions,
                                                     bool insidePrime) {
     if (!expr) return nullptr;
 
@@ -176,9 +176,11 @@ unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
         if (insidePrime) {
             // Inside prime: '(U) → U
             return make_unique<Var>(var->name);
-        } else if (primedVars.find(var->name) != primedVars.end()) {
-            // Outside prime but variable has primed version: U → U_old
-            return make_unique<Var>(var->name + "_old");
+        }
+        auto old = oldVersions.find(var->name);
+        if (old != oldVersions.end()) {
+            // Outside prime but variable has primed version: U → U_old_k
+            return make_unique<Var>(old->second);
         }
         return make_unique<Var>(var->name);
     }
@@ -188,12 +190,12 @@ unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
         FuncCall* func = dynamic_cast<FuncCall*>(expr.get());
         if (func->name == "'" && func->args.size() > 0) {
             // Remove the prime operator
-            return removePrimeNotation(func->args[0], primedVars, true);
+            return removePrimeNotation(func->args[0], oldVersions, true);
         }
 
         vector<unique_ptr<Expr>> newArgs;
         for (const auto& arg : func->args) {
-            newArgs.push_back(removePrimeNotation(arg, primedVars, insidePrime));
+            newArgs.push_back(removePrimeNotation(arg, oldVersions, insidePrime));
         }
         return make_unique<FuncCall>(func->name, std::move(newArgs));
     }
@@ -215,7 +217,7 @@ unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
         Set* set = dynamic_cast<Set*>(expr.get());
         vector<unique_ptr<Expr>> newElements;
         for (const auto& elem : set->elements) {
-            newElements.push_back(removePrimeNotation(elem, primedVars, insidePrime));
+            newElements.push_back(removePrimeNotation(elem, oldVersions, insidePrime));
         }
         return make_unique<Set>(std::move(newElements));
     }
@@ -227,9 +229,9 @@ unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
         for (const auto& kv : map->value) {
             auto newKey = removePrimeNotation(
                 reinterpret_cast<const unique_ptr<Expr>&>(kv.first),
-                primedVars, insidePrime
+                oldVersions, insidePrime
             );
-            auto newVal = removePrimeNotation(kv.second, primedVars, insidePrime);
+            auto newVal = removePrimeNotation(kv.second, oldVersions, insidePrime);
             newValue.push_back(make_pair(
                 unique_ptr<Var>(dynamic_cast<Var*>(newKey.release())),
                 std::move(newVal)
@@ -243,7 +245,7 @@ unique_ptr<Expr> ATCGenerator::removePrimeNotation(const unique_ptr<Expr>& expr,
         Tuple* tuple = dynamic_cast<Tuple*>(expr.get());
         vector<unique_ptr<Expr>> newExprs;
         for (const auto& e : tuple->exprs) {
-            newExprs.push_back(removePrimeNotation(e, primedVars, insidePrime));
+            newExprs.push_back(removePrimeNotation(e, oldVersions, insidePrime));
         }
         return make_unique<Tuple>(std::move(newExprs));
     }
@@ -410,15 +412,17 @@ vector<unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec* spec,
         extractPrimedVars(block->response.ResponseExpr, primedVars);
     }
 
-    // Step 5: Create old variable assignments for primed variables
-    // For each primed variable U', create: U_old = U
+    // Step 5: Name the old state of primed variables
+    // For each primed variable U', create: U_old_k := U, where k numbers the
+    // versions of U in this ATC. Every version is bound exactly once, so it
+    // is a reference to the state before the call rather than a copy that a
+    // later block overwrites (the executors alias Var := Var bindings).
+    map<string, string> oldVersions;
     for (const auto& varName : primedVars) {
-        vector<unique_ptr<Expr>> eqArgs;
-        eqArgs.push_back(make_unique<Var>(varName + "_old"));
-        eqArgs.push_back(make_unique<Var>(varName));
-        auto eqCall = make_unique<FuncCall>("=", std::move(eqArgs));
+        string oldName = varName + "_old_" + to_string(++globalVersions[varName]);
+        oldVersions[varName] = oldName;
         blockStmts.push_back(make_unique<Assign>(
-            make_unique<Var>(varName + "_old"),
+            make_unique<Var>(oldName),
             make_unique<Var>(varName)
         ));
     }
@@ -457,7 +461,7 @@ vector<unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec* spec,
     // assert(post) where primes are removed
     if (block->response.ResponseExpr) {
         auto convertedPost = convertExpr(block->response.ResponseExpr, blockSymTable, suffix);
-        auto postWithoutPrimes = removePrimeNotation(convertedPost, primedVars);
+        auto postWithoutPrimes = removePrimeNotation(convertedPost, oldVersions);
         blockStmts.push_back(make_unique<Assert>(std::move(postWithoutPrimes)));
     }
 
@@ -471,6 +475,7 @@ vector<unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec* spec,
 Program ATCGenerator::generate(const Spec* spec,
                                SymbolTable* globalSymTable, vector<string> testString) {
     vector<unique_ptr<Stmt>> programStmts;
+    globalVersions.clear();
 
     // Step 1: Generate initialization block
     auto initStmts = genInit(spec);
@@ -30,6 +30,7 @@ class ATCGenerator {
 private:
     const Spec* spec;
     TypeMap typeMap;
+    map<string, unsigned int> globalVersions;   // versions of primed globals so far
     
     /**
      * Generate initialization block from spec.global
@@ -78,10 +79,10 @@ private:
     
     /**
      * Remove prime notation from expression
-     * Converts: U' → U, and unprimed globals → U_old
+     * Converts: U' → U, and unprimed globals → their old version (U_old_k)
      */
     unique_ptr<Expr> removePrimeNotation(const unique_ptr<Expr>& expr, 
-                                         const set<string>& primedVars, 
+                                         const map<string, string>& oldVersions, 
                                          bool insidePrime = false);
     
     /**
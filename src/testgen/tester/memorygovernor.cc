@@ -0,0 +1,179 @@
+#include "memorygovernor.hh"
+#include "../language/exprwalk.hh"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+// Allocation size assumed for one AST node
+static const size_t NODE_BYTES = 64;
+
+MemoryGovernor::MemoryGovernor(size_t budgetBytes, double highWater)
+    : budget(budgetBytes), highWater(highWater), throttled(0), residentProbe(residentBytes) {
+    if (budgetBytes == 0) {
+        throw runtime_error("Memory governor: the budget must not be 0");
+    }
+}
+
+MemoryGovernor::CacheId MemoryGovernor::addCache(const string& name, double share, Evictor evict) {
+    lock_guard<mutex> guard(lock);
+    accounts.push_back({ name, share, 0, std::move(evict), 0 });
+    return accounts.size() - 1;
+}
+
+void MemoryGovernor::removeCache(CacheId id) {
+    lock_guard<mutex> guard(lock);
+    Account& account = accounts.at(id);
+    account.bytes = 0;
+    account.evict = nullptr;
+}
+
+void MemoryGovernor::update(CacheId id, size_t bytes) {
+    Evictor evict;
+    size_t target;
+    {
+        lock_guard<mutex> guard(lock);
+        Account& account = accounts.at(id);
+        if (!account.evict) {
+            return;
+        }
+        account.bytes = bytes;
+        target = shareBytes(account);
+        if (bytes <= target) {
+            return;
+        }
+        evict = account.evict;
+    }
+    // Outside the lock: the evictor takes the cache's own lock, and caches
+    // may report while holding it
+    size_t after = evict(target);
+    lock_guard<mutex> guard(lock);
+    Account& account = accounts.at(id);
+    account.bytes = after;
+    if (after >= bytes) {
+        // Nothing left to evict (a cache may keep its newest entry)
+        return;
+    }
+    account.evictions++;
+    cout << "[MEMORY] " << account.name << ": evicted " << bytes - after
+         << " bytes, " << after << " held" << endl;
+}
+
+void MemoryGovernor::enforce() {
+    size_t count;
+    {
+        lock_guard<mutex> guard(lock);
+        count = accounts.size();
+    }
+    for (CacheId id = 0; id < count; id++) {
+        size_t bytes;
+        {
+            lock_guard<mutex> guard(lock);
+            bytes = accounts[id].bytes;
+        }
+        update(id, bytes);
+    }
+}
+
+size_t MemoryGovernor::trackedLocked() const {
+    size_t total = 0;
+    for (const auto& account : accounts) {
+        total += account.bytes;
+    }
+    return total;
+}
+
+bool MemoryGovernor::admit() {
+    enforce();
+    function<size_t()> probe;
+    {
+        lock_guard<mutex> guard(lock);
+        probe = residentProbe;
+    }
+    size_t resident = probe ? probe() : 0;
+    lock_guard<mutex> guard(lock);
+    size_t used = max(trackedLocked(), resident);
+    if (double(used) < highWater * budget) {
+        return true;
+    }
+    throttled++;
+    return false;
+}
+
+size_t MemoryGovernor::getBytes(CacheId id) const {
+    lock_guard<mutex> guard(lock);
+    return accounts.at(id).bytes;
+}
+
+size_t MemoryGovernor::getTrackedBytes() const {
+    lock_guard<mutex> guard(lock);
+    return trackedLocked();
+}
+
+size_t MemoryGovernor::getEvictions(CacheId id) const {
+    lock_guard<mutex> guard(lock);
+    return accounts.at(id).evictions;
+}
+
+size_t MemoryGovernor::getThrottled() const {
+    lock_guard<mutex> guard(lock);
+    return throttled;
+}
+
+void MemoryGovernor::printReport() const {
+    lock_guard<mutex> guard(lock);
+    cout << "[MEMORY] budget " << budget << " bytes, tracked " << trackedLocked()
+         << ", throttled " << throttled << " times" << endl;
+    for (const auto& account : accounts) {
+        cout << "  [MEMORY] " << account.name << ": " << account.bytes << " of "
+             << shareBytes(account) << " bytes, " << account.evictions << " evictions" << endl;
+    }
+}
+
+size_t MemoryGovernor::residentBytes() {
+    // Second field of statm: resident pages
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+void MemoryGovernor::setResidentProbe(function<size_t()> probe) {
+    lock_guard<mutex> guard(lock);
+    residentProbe = std::move(probe);
+}
+
+size_t MemoryGovernor::approxBytes(const Program& program) {
+    // Allocation sizes of the nodes plus the strings they own
+    size_t bytes = sizeof(Program) + program.statements.size() * (NODE_BYTES + sizeof(unique_ptr<Stmt>));
+    auto count = [&bytes](const Expr& e) {
+        walkExpr(e, [&bytes](const Expr& node) {
+            bytes += NODE_BYTES;
+            if (node.exprType == ExprType::VAR) {
+                bytes += dynamic_cast<const Var&>(node).name.size();
+            } else if (node.exprType == ExprType::STRING) {
+                bytes += dynamic_cast<const String&>(node).value.size();
+            } else if (node.exprType == ExprType::FUNCCALL) {
+                bytes += dynamic_cast<const FuncCall&>(node).name.size();
+            } else if (node.exprType == ExprType::MAP) {
+                bytes += dynamic_cast<const Map&>(node).value.size() * NODE_BYTES;
+            }
+            return WalkAction::DESCEND;
+        });
+    };
+    for (const auto& stmt : program.statements) {
+        if (stmt->statementType == StmtType::ASSIGN) {
+            const Assign& assign = dynamic_cast<const Assign&>(*stmt);
+            count(*assign.left);
+            count(*assign.right);
+        } else if (stmt->statementType == StmtType::ASSUME) {
+            count(*dynamic_cast<const Assume&>(*stmt).expr);
+        } else if (stmt->statementType == StmtType::ASSERT) {
+            count(*dynamic_cast<const Assert&>(*stmt).expr);
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,112 @@
+#ifndef MEMORYGOVERNOR_HH
+#define MEMORYGOVERNOR_HH
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+
+using namespace std;
+
+/**
+ * MemoryGovernor: keeps a long campaign within a memory budget.
+ *
+ * Caches register with a share of the budget and report the approximate
+ * bytes they hold. A cache over its share is asked to evict its least
+ * recently used entries down to the share. Before a new test string is
+ * admitted, admit() enforces every share and then checks the process against
+ * the budget, using the larger of the tracked bytes and the resident set
+ * size. Past the high-water mark, new test strings are held back (see
+ * Campaign::setMemoryGovernor and GenerationDaemon::setMemoryGovernor).
+ *
+ * All methods may be called from several threads.
+ */
+class MemoryGovernor {
+public:
+    typedef size_t CacheId;
+
+    /**
+     * Evicts least recently used entries until the cache holds at most
+     * `target` bytes; returns the bytes it holds afterwards
+     */
+    typedef function<size_t(size_t target)> Evictor;
+
+private:
+    struct Account {
+        string name;
+        double share;
+        size_t bytes;
+        Evictor evict;
+        size_t evictions;
+    };
+
+    mutable mutex lock;
+    vector<Account> accounts;
+    size_t budget;
+    double highWater;
+    size_t throttled;
+    function<size_t()> residentProbe;
+
+    size_t shareBytes(const Account& account) const { return size_t(account.share * budget); }
+    size_t trackedLocked() const;
+
+public:
+    /**
+     * budgetBytes: the process budget. New test strings are admitted while
+     * the process is below highWater * budgetBytes.
+     */
+    MemoryGovernor(size_t budgetBytes, double highWater = 0.9);
+
+    /**
+     * Register a cache allowed `share` of the budget (0..1)
+     */
+    CacheId addCache(const string& name, double share, Evictor evict);
+
+    /**
+     * Stop tracking a cache (before it is destroyed)
+     */
+    void removeCache(CacheId id);
+
+    /**
+     * The bytes a cache holds now; evicts if that is over its share
+     */
+    void update(CacheId id, size_t bytes);
+
+    /**
+     * Evict every cache down to its share
+     */
+    void enforce();
+
+    /**
+     * Enforce the shares and tell whether a new test string may start:
+     * false while the process is at or above the high-water mark. Every
+     * refusal is counted.
+     */
+    bool admit();
+
+    size_t getBudget() const { return budget; }
+    size_t getBytes(CacheId id) const;
+    size_t getTrackedBytes() const;
+    size_t getEvictions(CacheId id) const;
+    size_t getThrottled() const;
+    void printReport() const;
+
+    /**
+     * Resident set size of this process (0 if unknown)
+     */
+    static size_t residentBytes();
+
+    /**
+     * Replace the resident set size probe (tests)
+     */
+    void setResidentProbe(function<size_t()> probe);
+
+    /**
+     * Approximate heap footprint of a program's AST
+     */
+    static size_t approxBytes(const Program& program);
+};
+
+#endif // MEMORYGOVERNOR_HH
@@ -0,0 +1,70 @@
+#ifndef MPSCQUEUE_HH
+#define MPSCQUEUE_HH
+
+#include <atomic>
+#include <utility>
+
+using namespace std;
+
+/**
+ * MpscQueue: unbounded lock-free multi-producer, single-consumer queue
+ *
+ * Linked list with a stub node (Vyukov): push() is one atomic exchange on
+ * the head plus a release store, so producers never wait for each other or
+ * for the consumer. Items of one producer are popped in the order it pushed
+ * them; across producers the order is that of the exchanges.
+ *
+ * tryPop() may only be called from one thread. It can briefly report an
+ * empty queue while a push is between its two steps; consumers that know
+ * how many items to expect simply retry.
+ */
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        atomic<Node*> next;
+        T value;
+        Node() : next(nullptr), value() {}
+        explicit Node(T v) : next(nullptr), value(std::move(v)) {}
+    };
+
+    atomic<Node*> head;   // last pushed node, shared by producers
+    Node* tail;           // stub / last popped node, consumer only
+
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head.store(stub, memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        while (tail) {
+            Node* next = tail->next.load(memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head.exchange(node, memory_order_acq_rel);
+        prev->next.store(node, memory_order_release);
+    }
+
+    bool tryPop(T& out) {
+        Node* next = tail->next.load(memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+};
+
+#endif // MPSCQUEUE_HH
@@ -0,0 +1,146 @@
+#include "queryminimizer.hh"
+#include "../language/clonevisitor.hh"
+#include "../language/exprwalk.hh"
+#include "../language/printvisitor.hh"
+#include "ddmin.hh"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+// Boolean connectives whose operands are formulas themselves
+static bool isConnective(const string& name) {
+    return name == "And" || name == "Or" || name == "Not" || name == "Implies" ||
+           name == "and" || name == "or" || name == "not";
+}
+
+QueryMinimizer::QueryMinimizer(double slowMs, TypeMap* typeMap)
+    : solver(typeMap), slowMs(slowMs), solves(0) {
+    if (slowMs < 1) {
+        throw runtime_error("Query minimizer: slowMs must be at least 1");
+    }
+    solver.setTimeout((unsigned int)slowMs);
+}
+
+bool QueryMinimizer::isSlow(const vector<const Expr*>& conjuncts) {
+    if (conjuncts.empty()) {
+        return false;
+    }
+    CloneVisitor cloner;
+    unique_ptr<Expr> formula = cloner.cloneExpr(conjuncts.back());
+    for (size_t i = conjuncts.size() - 1; i-- > 0;) {
+        vector<unique_ptr<Expr>> args;
+        args.push_back(cloner.cloneExpr(conjuncts[i]));
+        args.push_back(std::move(formula));
+        formula = make_unique<FuncCall>("And", std::move(args));
+    }
+    solves++;
+    auto start = chrono::steady_clock::now();
+    solver.solve(std::move(formula));
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    // Z3 also gives up at once on theories it is incomplete for (nonlinear
+    // arithmetic, array lambdas); that is not slow
+    const string& reason = solver.getLastUnknownReason();
+    return reason == "timeout" || reason == "canceled" || elapsed.count() >= 0.9 * slowMs;
+}
+
+MinimizedQuery QueryMinimizer::minimize(const RecordedQuery& query) {
+    solves = 0;
+    vector<const Expr*> current;
+    vector<size_t> positions;
+    for (size_t i = 0; i < query.conjuncts.size(); i++) {
+        flattenAnd(static_cast<const Expr&>(*query.conjuncts[i]), current);
+        size_t position = i < query.positions.size() ? query.positions[i] : SIZE_MAX;
+        positions.resize(current.size(), position);
+    }
+
+    MinimizedQuery result;
+    result.slow = isSlow(current);
+    result.simplified = 0;
+    if (!result.slow) {
+        cout << "[QUERYMIN] The query is solved within " << slowMs << " ms, nothing to minimize" << endl;
+        result.solves = solves;
+        return result;
+    }
+    size_t original = current.size();
+
+    while (true) {
+        vector<size_t> all(current.size());
+        for (size_t i = 0; i < all.size(); i++) {
+            all[i] = i;
+        }
+        vector<size_t> kept = ddmin(all,
+            [&](const vector<size_t>& indices) {
+                vector<const Expr*> subset;
+                for (size_t i : indices) {
+                    subset.push_back(current[i]);
+                }
+                return isSlow(subset);
+            },
+            [&](const vector<vector<size_t>>& candidates) {
+                cout << "[QUERYMIN] " << candidates.size() << " candidates, " << solves
+                     << " solves so far" << endl;
+            });
+        vector<const Expr*> reduced;
+        vector<size_t> reducedPositions;
+        for (size_t i : kept) {
+            reduced.push_back(current[i]);
+            reducedPositions.push_back(positions[i]);
+        }
+        current = reduced;
+        positions = reducedPositions;
+
+        // Replace conjuncts by their operands while the query stays slow
+        bool changed = false;
+        for (size_t i = 0; i < current.size(); i++) {
+            bool replaced = true;
+            while (replaced && current[i]->exprType == ExprType::FUNCCALL) {
+                replaced = false;
+                const FuncCall& fc = dynamic_cast<const FuncCall&>(*current[i]);
+                if (!isConnective(fc.name)) {
+                    break;
+                }
+                for (const auto& arg : fc.args) {
+                    vector<const Expr*> trial = current;
+                    trial[i] = arg.get();
+                    if (isSlow(trial)) {
+                        current[i] = arg.get();
+                        result.simplified++;
+                        replaced = changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!changed) {
+            break;
+        }
+    }
+
+    CloneVisitor cloner;
+    for (size_t i = 0; i < current.size(); i++) {
+        result.conjuncts.push_back(cloner.cloneExpr(current[i]));
+        result.positions.push_back(positions[i]);
+        result.blocks.push_back(positions[i] < query.testString.size()
+                                    ? query.testString[positions[i]] : "init");
+    }
+    result.solves = solves;
+    cout << "[QUERYMIN] " << original << " -> " << current.size() << " conjuncts ("
+         << result.simplified << " simplified) in " << solves << " solves" << endl;
+    return result;
+}
+
+string QueryMinimizer::report(const MinimizedQuery& result) {
+    if (!result.slow) {
+        return "query is not slow\n";
+    }
+    ostringstream out;
+    for (size_t i = 0; i < result.conjuncts.size(); i++) {
+        out << PrintVisitor::exprToString(result.conjuncts[i].get()) << "    <- " << result.blocks[i];
+        if (result.positions[i] != SIZE_MAX) {
+            out << " (block " << result.positions[i] << ")";
+        }
+        out << "\n";
+    }
+    return out.str();
+}
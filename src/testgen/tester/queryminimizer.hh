@@ -0,0 +1,62 @@
+#ifndef QUERYMINIMIZER_HH
+#define QUERYMINIMIZER_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/typemap.hh"
+#include "../see/z3solver.hh"
+#include "tester.hh"
+
+using namespace std;
+
+/**
+ * Outcome of minimizing a slow query
+ */
+struct MinimizedQuery {
+    vector<unique_ptr<Expr>> conjuncts;  // smallest sub-formula found that is still slow
+    vector<size_t> positions;            // test-string position of each conjunct's block
+    vector<string> blocks;               // its block name, "init" if none
+    bool slow;                           // false if the whole query was not slow
+    size_t solves;                       // queries solved while minimizing
+    size_t simplified;                   // conjuncts replaced by one of their subterms
+};
+
+/**
+ * QueryMinimizer: finds which conjuncts make a path constraint slow to solve
+ *
+ * A conjunction is slow if Z3 times out on it after slowMs (or takes about
+ * that long anyway); an immediate "unknown" from an incomplete theory does
+ * not count. Minimization
+ * first runs delta debugging (ddmin) over the conjuncts of a recorded query,
+ * then tries to replace each remaining conjunct by one of its boolean
+ * operands (And, Or, Not, Implies) while the query stays slow, and repeats
+ * both until neither makes progress. Every conjunct kept is reported with the
+ * spec block that added it, so the result points at the predicates worth
+ * rewriting.
+ *
+ * Each check costs up to slowMs; a query over n conjuncts takes O(n^2)
+ * checks in the worst case and about O(k log n) when k conjuncts matter.
+ */
+class QueryMinimizer {
+private:
+    Z3Solver solver;
+    double slowMs;
+    size_t solves;
+
+    bool isSlow(const vector<const Expr*>& conjuncts);
+
+public:
+    QueryMinimizer(double slowMs, TypeMap* typeMap = nullptr);
+
+    MinimizedQuery minimize(const RecordedQuery& query);
+
+    /**
+     * The minimal sub-formula, one conjunct per line with its block
+     */
+    static string report(const MinimizedQuery& result);
+};
+
+#endif // QUERYMINIMIZER_HH
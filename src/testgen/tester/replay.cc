@@ -0,0 +1,242 @@
+#include "replay.hh"
+#include "ctccorpus.hh"
+#include "../see/concreteevaluator.hh"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+string replayStatusToString(ReplayStatus status) {
+    switch (status) {
+        case ReplayStatus::PASSED:
+            return "PASSED";
+        case ReplayStatus::FAILED:
+            return "FAILED";
+        case ReplayStatus::INFEASIBLE:
+            return "INFEASIBLE";
+        case ReplayStatus::ERROR:
+            return "ERROR";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+ReplayRunner::ReplayRunner(FactoryMaker makeFactory, unsigned int workers)
+    : makeFactory(std::move(makeFactory)), workers(workers), lastWallMs(0), oracles(nullptr) {
+    if (this->workers == 0) {
+        this->workers = thread::hardware_concurrency();
+    }
+    if (this->workers == 0) {
+        this->workers = 1;
+    }
+}
+
+/**
+ * Bind the value of an assignment to its left-hand side.
+ * Tuple left-hand sides are destructured element-wise.
+ */
+static void bindValue(const Expr& left, unique_ptr<Expr> value,
+                      ConcValEnv& env, vector<unique_ptr<Expr>>& store) {
+    if (left.exprType == ExprType::VAR) {
+        env.setValue(dynamic_cast<const Var&>(left).name, value.get());
+        store.push_back(std::move(value));
+        return;
+    }
+    if (left.exprType == ExprType::TUPLE && value->exprType == ExprType::TUPLE) {
+        const Tuple& lt = dynamic_cast<const Tuple&>(left);
+        Tuple& vt = dynamic_cast<Tuple&>(*value);
+        if (lt.exprs.size() == vt.exprs.size()) {
+            for (size_t i = 0; i < lt.exprs.size(); i++) {
+                bindValue(*lt.exprs[i],
+                          std::move(const_cast<unique_ptr<Expr>&>(vt.exprs[i])),
+                          env, store);
+            }
+            return;
+        }
+    }
+    throw runtime_error("Cannot bind value to assignment target");
+}
+
+ReplayExecution::ReplayExecution(FunctionFactory& sut, ReplayObserver* observer,
+                                 const OracleLibrary* oracles)
+    : evaluator(new ConcreteEvaluator(&sut)), env(nullptr), observer(observer) {
+    evaluator->setOracles(oracles);
+}
+
+ReplayExecution::~ReplayExecution() = default;
+
+bool ReplayExecution::step(size_t i, const Stmt& stmt, ReplayResult& result) {
+    if (stmt.statementType == StmtType::ASSIGN) {
+        const Assign& assign = dynamic_cast<const Assign&>(stmt);
+        if (assign.left->exprType == ExprType::VAR && assign.right->exprType == ExprType::VAR) {
+            // Var := Var (e.g. U_old_k := U) binds a reference: bound
+            // values are never mutated, so no copy is needed.
+            Expr* value = env.getValue(dynamic_cast<const Var&>(*assign.right).name);
+            if (value == nullptr) {
+                throw runtime_error("Unbound variable in concrete evaluation: " +
+                                    dynamic_cast<const Var&>(*assign.right).name);
+            }
+            if (observer) {
+                observer->onAssign(i, assign, *value);
+            }
+            env.setValue(dynamic_cast<const Var&>(*assign.left).name, value);
+            return true;
+        }
+        unique_ptr<Expr> value = evaluator->evaluate(*assign.right, env);
+        if (observer) {
+            observer->onAssign(i, assign, *value);
+        }
+        bindValue(*assign.left, std::move(value), env, store);
+    } else if (stmt.statementType == StmtType::ASSUME) {
+        const Assume& assume = dynamic_cast<const Assume&>(stmt);
+        if (observer) {
+            observer->onAssume(i, assume, *evaluator, env);
+        }
+        if (!evaluator->evaluateBool(*assume.expr, env)) {
+            result.status = ReplayStatus::INFEASIBLE;
+            result.stmtIndex = i;
+            result.message = "assume at statement " + to_string(i) + " does not hold";
+            return false;
+        }
+    } else if (stmt.statementType == StmtType::ASSERT) {
+        const Assert& asrt = dynamic_cast<const Assert&>(stmt);
+        if (observer) {
+            observer->onAssert(i, asrt, *evaluator, env);
+        }
+        if (!evaluator->evaluateBool(*asrt.expr, env)) {
+            result.status = ReplayStatus::FAILED;
+            result.stmtIndex = i;
+            result.message = "assert at statement " + to_string(i) + " failed";
+            return false;
+        }
+    }
+    return true;
+}
+
+ReplayResult ReplayRunner::replay(const Program& ctc, FunctionFactory& sut, size_t testId,
+                                  ReplayObserver* observer, const OracleLibrary* oracles) {
+    auto start = chrono::steady_clock::now();
+    ReplayResult result = { testId, ReplayStatus::PASSED, -1, "", 0 };
+
+    try {
+        ReplayExecution execution(sut, observer, oracles);
+        for (size_t i = 0; i < ctc.statements.size(); i++) {
+            if (!execution.step(i, *ctc.statements[i], result)) {
+                break;
+            }
+        }
+    } catch (const exception& e) {
+        result.status = ReplayStatus::ERROR;
+        result.message = e.what();
+    } catch (const char* e) {
+        result.status = ReplayStatus::ERROR;
+        result.message = e;
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    result.latencyMs = elapsed.count();
+    return result;
+}
+
+void ReplayRunner::work(size_t count, const CTCSource& source,
+                        atomic<size_t>& next,
+                        vector<ReplayResult>& results) {
+    // One pristine SUT per worker; every CTC gets its own copy of it.
+    unique_ptr<FunctionFactory> pristine = makeFactory();
+
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+        unique_ptr<FunctionFactory> sut = pristine->snapshot();
+        if (!sut) {
+            sut = makeFactory();
+        }
+        unique_ptr<Program> owned;
+        try {
+            const Program& ctc = source(i, owned);
+            results[i] = replay(ctc, *sut, i, nullptr, oracles);
+        } catch (const exception& e) {
+            results[i] = { i, ReplayStatus::ERROR, -1, e.what(), 0 };
+        }
+    }
+}
+
+vector<ReplayResult> ReplayRunner::runPool(size_t count, const CTCSource& source) {
+    auto start = chrono::steady_clock::now();
+    vector<ReplayResult> results(count);
+    atomic<size_t> next(0);
+
+    unsigned int n = workers;
+    if (n > count) {
+        n = count;
+    }
+
+    vector<thread> pool;
+    for (unsigned int w = 0; w < n; w++) {
+        pool.emplace_back(&ReplayRunner::work, this, count, cref(source), ref(next), ref(results));
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    lastWallMs = elapsed.count();
+    return results;
+}
+
+vector<ReplayResult> ReplayRunner::run(const vector<const Program*>& ctcs) {
+    return runPool(ctcs.size(), [&ctcs](size_t i, unique_ptr<Program>&) -> const Program& {
+        return *ctcs[i];
+    });
+}
+
+vector<ReplayResult> ReplayRunner::run(const CTCCorpus& corpus) {
+    // Each worker decodes its CTCs from the mapping just before replaying them
+    return runPool(corpus.size(), [&corpus](size_t i, unique_ptr<Program>& owned) -> const Program& {
+        owned = corpus.get(i);
+        return *owned;
+    });
+}
+
+vector<ReplayResult> ReplayRunner::run(const vector<unique_ptr<Program>>& ctcs) {
+    vector<const Program*> ptrs;
+    for (const auto& p : ctcs) {
+        ptrs.push_back(p.get());
+    }
+    return run(ptrs);
+}
+
+ReplaySummary ReplayRunner::summarize(const vector<ReplayResult>& results, double wallMs) {
+    ReplaySummary summary = { 0, 0, 0, 0, wallMs, 0, 0 };
+    double total = 0;
+    for (const auto& r : results) {
+        switch (r.status) {
+            case ReplayStatus::PASSED: summary.passed++; break;
+            case ReplayStatus::FAILED: summary.failed++; break;
+            case ReplayStatus::INFEASIBLE: summary.infeasible++; break;
+            case ReplayStatus::ERROR: summary.errors++; break;
+        }
+        total += r.latencyMs;
+        if (r.latencyMs > summary.maxLatencyMs) {
+            summary.maxLatencyMs = r.latencyMs;
+        }
+    }
+    if (!results.empty()) {
+        summary.meanLatencyMs = total / results.size();
+    }
+    return summary;
+}
+
+void ReplayRunner::printReport(const vector<ReplayResult>& results, const ReplaySummary& summary) {
+    cout << "\n[REPLAY] " << results.size() << " CTCs in " << summary.wallMs << " ms" << endl;
+    for (const auto& r : results) {
+        if (r.status == ReplayStatus::PASSED) {
+            continue;
+        }
+        cout << "  [REPLAY] test " << r.testId << ": " << replayStatusToString(r.status)
+             << " (" << r.latencyMs << " ms) " << r.message << endl;
+    }
+    cout << "[REPLAY] passed: " << summary.passed
+         << ", failed: " << summary.failed
+         << ", infeasible: " << summary.infeasible
+         << ", errors: " << summary.errors << endl;
+    cout << "[REPLAY] latency mean: " << summary.meanLatencyMs
+         << " ms, max: " << summary.maxLatencyMs << " ms" << endl;
+}
@@ -0,0 +1,164 @@
+#ifndef REPLAY_HH
+#define REPLAY_HH
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+#include "../see/functionfactory.hh"
+
+class ConcreteEvaluator;
+class CTCCorpus;
+class OracleLibrary;
+
+using namespace std;
+
+enum class ReplayStatus {
+    PASSED,      // every assert held
+    FAILED,      // an assert evaluated to false
+    INFEASIBLE,  // an assume evaluated to false (the CTC does not apply)
+    ERROR        // evaluation or SUT error
+};
+
+string replayStatusToString(ReplayStatus);
+
+/**
+ * Outcome of replaying one CTC
+ */
+struct ReplayResult {
+    size_t testId;
+    ReplayStatus status;
+    int stmtIndex;       // statement that decided the outcome, -1 if none
+    string message;
+    double latencyMs;    // wall time spent on this CTC
+};
+
+/**
+ * Aggregate numbers over one run of the replay runner
+ */
+struct ReplaySummary {
+    size_t passed;
+    size_t failed;
+    size_t infeasible;
+    size_t errors;
+    double wallMs;
+    double meanLatencyMs;
+    double maxLatencyMs;
+};
+
+/**
+ * Hook into a replay: called for every assume/assert before its verdict is
+ * taken, with the evaluator and the concrete environment at that point, and
+ * for every assignment with the value about to be bound.
+ */
+class ReplayObserver {
+public:
+    virtual ~ReplayObserver() = default;
+    virtual void onAssign(size_t stmtIndex, const Assign& stmt, const Expr& value) {}
+    virtual void onAssume(size_t stmtIndex, const Assume& stmt,
+                          ConcreteEvaluator& evaluator, ConcValEnv& env) {}
+    virtual void onAssert(size_t stmtIndex, const Assert& stmt,
+                          ConcreteEvaluator& evaluator, ConcValEnv& env) {}
+};
+
+/**
+ * A replay in progress: executes the statements of a CTC one at a time
+ * against a SUT, so that a replay can stop after a prefix and be continued
+ * (see ForkServer). ReplayRunner::replay runs a whole CTC with it.
+ */
+class ReplayExecution {
+private:
+    unique_ptr<ConcreteEvaluator> evaluator;
+    ConcValEnv env;
+    vector<unique_ptr<Expr>> store;  // owns every value bound in env
+    ReplayObserver* observer;
+
+public:
+    ReplayExecution(FunctionFactory& sut, ReplayObserver* observer = nullptr,
+                    const OracleLibrary* oracles = nullptr);
+    ~ReplayExecution();
+
+    ReplayExecution(const ReplayExecution&) = delete;
+    ReplayExecution& operator=(const ReplayExecution&) = delete;
+
+    /**
+     * Execute statement i of the CTC. Returns false if it decides the
+     * outcome (an assume or assert that does not hold), with status,
+     * stmtIndex and message set in result. Evaluation and SUT errors are
+     * thrown.
+     */
+    bool step(size_t i, const Stmt& stmt, ReplayResult& result);
+};
+
+/**
+ * ReplayRunner: executes finished Concrete Test Cases against the SUT and
+ * checks their assertions concretely.
+ *
+ * CTCs are distributed over a pool of worker threads. Every CTC runs against
+ * an isolated SUT: each worker builds one FunctionFactory and, per CTC, either
+ * restores a snapshot of it (FunctionFactory::snapshot) or, if the factory is
+ * not snapshotable, asks the FactoryMaker for a fresh instance.
+ *
+ * Statement semantics:
+ *   x := e      evaluate e (API calls go to the SUT) and bind x
+ *   assume(c)   c false -> INFEASIBLE, stop
+ *   assert(c)   c false -> FAILED, stop
+ */
+class ReplayRunner {
+public:
+    typedef function<unique_ptr<FunctionFactory>()> FactoryMaker;
+
+private:
+    FactoryMaker makeFactory;
+    unsigned int workers;
+    double lastWallMs;
+    const OracleLibrary* oracles;
+
+    // CTC i; may decode it into the given holder
+    typedef function<const Program&(size_t, unique_ptr<Program>&)> CTCSource;
+
+    void work(size_t count, const CTCSource& source,
+              atomic<size_t>& next,
+              vector<ReplayResult>& results);
+    vector<ReplayResult> runPool(size_t count, const CTCSource& source);
+
+public:
+    ReplayRunner(FactoryMaker makeFactory, unsigned int workers = 0);
+
+    /**
+     * Replay a single CTC against the given SUT instance. Assumes and
+     * asserts found in `oracles` are checked natively.
+     */
+    static ReplayResult replay(const Program& ctc, FunctionFactory& sut, size_t testId = 0,
+                               ReplayObserver* observer = nullptr,
+                               const OracleLibrary* oracles = nullptr);
+
+    /**
+     * Replay all CTCs concurrently. Results are indexed like the input.
+     */
+    vector<ReplayResult> run(const vector<const Program*>& ctcs);
+    vector<ReplayResult> run(const vector<unique_ptr<Program>>& ctcs);
+
+    /**
+     * Replay every CTC of a corpus file. Each worker decodes a CTC just
+     * before replaying it; results are indexed by test id.
+     */
+    vector<ReplayResult> run(const CTCCorpus& corpus);
+
+    unsigned int getWorkers() const { return workers; }
+
+    /**
+     * Native spec predicates used by run() (nullptr = interpret all)
+     */
+    void setOracles(const OracleLibrary* library) { oracles = library; }
+    double getLastWallMs() const { return lastWallMs; }
+
+    static ReplaySummary summarize(const vector<ReplayResult>& results, double wallMs);
+    static void printReport(const vector<ReplayResult>& results, const ReplaySummary& summary);
+};
+
+#endif // REPLAY_HH
@@ -0,0 +1,369 @@
+#include "resultstore.hh"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+static const char RESULTS_MAGIC[8] = { 'T', 'T', 'R', 'R', 'E', 'S', '0', '1' };
+static const uint32_t RESULTS_BYTE_ORDER = 0x01020304;
+
+template <typename T>
+static void writeValue(ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeString(ofstream& out, const string& s) {
+    writeValue<uint32_t>(out, s.size());
+    out.write(s.data(), s.size());
+}
+
+ResultsWriter::ResultsWriter(const string& path, const Campaign& campaign, size_t rowGroupSize)
+    : campaign(campaign), out(path, ios::binary | ios::trunc), path(path),
+      rowGroupSize(max<size_t>(1, rowGroupSize)), rows(0), totalRows(0), closed(false) {
+    if (!out) {
+        throw runtime_error("Results store: cannot write " + path);
+    }
+    out.write(RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    writeValue(out, RESULTS_BYTE_ORDER);
+}
+
+ResultsWriter::~ResultsWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+uint32_t ResultsWriter::intern(const string& s) {
+    auto found = dictionaryIds.find(s);
+    if (found != dictionaryIds.end()) {
+        return found->second;
+    }
+    uint32_t id = dictionary.size();
+    dictionary.push_back(s);
+    dictionaryIds.emplace(s, id);
+    return id;
+}
+
+ResultsColumn& ResultsWriter::column(const string& name, ResultsColumnType type) {
+    auto found = columns.find(name);
+    if (found == columns.end()) {
+        // Rows of this group written before the column appeared are null
+        ResultsColumn& col = columns[name];
+        col.type = type;
+        pad(col, rows);
+        columnOrder.push_back(name);
+        return col;
+    }
+    if (found->second.type != type) {
+        throw runtime_error("Results store: column " + name + " changed type");
+    }
+    return found->second;
+}
+
+void ResultsWriter::pad(ResultsColumn& col, size_t rows) {
+    col.present.resize(rows, 0);
+    if (col.type == ResultsColumnType::DOUBLE) {
+        col.doubles.resize(rows, 0);
+    } else if (col.type == ResultsColumnType::STRING) {
+        col.strings.resize(rows);
+    } else {
+        col.ints.resize(rows, 0);
+    }
+}
+
+void ResultsWriter::setInt(const string& name, int64_t value) {
+    ResultsColumn& col = column(name, ResultsColumnType::INT);
+    col.present.push_back(1);
+    col.ints.push_back(value);
+}
+
+void ResultsWriter::setDouble(const string& name, double value) {
+    ResultsColumn& col = column(name, ResultsColumnType::DOUBLE);
+    col.present.push_back(1);
+    col.doubles.push_back(value);
+}
+
+void ResultsWriter::setString(const string& name, const string& value) {
+    ResultsColumn& col = column(name, ResultsColumnType::DICT);
+    col.present.push_back(1);
+    col.ints.push_back(intern(value));
+}
+
+void ResultsWriter::setText(const string& name, const string& value) {
+    ResultsColumn& col = column(name, ResultsColumnType::STRING);
+    col.present.push_back(1);
+    col.strings.push_back(value);
+}
+
+void ResultsWriter::add(const CampaignEntry& entry) {
+    if (closed) {
+        throw runtime_error("Results store: " + path + " is closed");
+    }
+    const ReplayResult& result = entry.result;
+    setInt("testId", result.testId);
+    setString("status", replayStatusToString(result.status));
+    if (!result.message.empty()) {
+        setText("message", result.message);
+    }
+    setInt("length", entry.testString.size());
+    setDouble("generationMs", entry.generationMs);
+    setInt("iterations", entry.iterations);
+    setDouble("latencyMs", result.latencyMs);
+    setInt("newPoints", entry.newPoints);
+    for (size_t p = 0; p < entry.testString.size(); p++) {
+        setString("block" + to_string(p), entry.testString[p]);
+    }
+
+    if (entry.ctc) {
+        vector<size_t> positions = campaign.statementPositions(entry.testString, *entry.ctc);
+        size_t decider = campaign.blamePosition(entry);
+        if (decider == SIZE_MAX && result.status == ReplayStatus::FAILED &&
+            result.stmtIndex >= 0 && size_t(result.stmtIndex) < positions.size()) {
+            decider = positions[result.stmtIndex];
+        }
+        if (decider < entry.testString.size()) {
+            setString("decidingBlock", entry.testString[decider]);
+        }
+
+        // Inputs are the block statements x := n (or x := input() where
+        // generation got stuck, left null so later slots keep their number)
+        size_t slot = 0;
+        for (size_t i = 0; i < entry.ctc->statements.size(); i++) {
+            const Stmt& stmt = *entry.ctc->statements[i];
+            if (positions[i] == SIZE_MAX || stmt.statementType != StmtType::ASSIGN) continue;
+            const Expr& right = *dynamic_cast<const Assign&>(stmt).right;
+            if (right.exprType == ExprType::NUM) {
+                setInt("input" + to_string(slot++), dynamic_cast<const Num&>(right).value);
+            } else if (right.exprType == ExprType::FUNCCALL &&
+                       dynamic_cast<const FuncCall&>(right).name == "input") {
+                slot++;
+            }
+        }
+    }
+
+    rows++;
+    totalRows++;
+    for (auto& named : columns) {
+        pad(named.second, rows);
+    }
+    if (rows >= rowGroupSize) {
+        flush();
+    }
+}
+
+void ResultsWriter::add(const vector<CampaignEntry>& entries) {
+    for (const auto& entry : entries) {
+        add(entry);
+    }
+}
+
+void ResultsWriter::flush() {
+    if (rows == 0) {
+        return;
+    }
+    Directory group{ rows, uint64_t(out.tellp()), {} };
+    for (const auto& name : columnOrder) {
+        const ResultsColumn& col = columns.at(name);
+        group.columns.push_back({ name, { col.type, uint64_t(out.tellp()) } });
+        out.write(reinterpret_cast<const char*>(col.present.data()), rows);
+        if (col.type == ResultsColumnType::DOUBLE) {
+            out.write(reinterpret_cast<const char*>(col.doubles.data()), rows * sizeof(double));
+        } else if (col.type == ResultsColumnType::STRING) {
+            for (const auto& s : col.strings) {
+                writeString(out, s);
+            }
+        } else {
+            out.write(reinterpret_cast<const char*>(col.ints.data()), rows * sizeof(int64_t));
+        }
+    }
+    if (!out) {
+        throw runtime_error("Results store: cannot write " + path);
+    }
+    groups.push_back(std::move(group));
+    columns.clear();
+    columnOrder.clear();
+    rows = 0;
+}
+
+void ResultsWriter::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+    flush();
+
+    uint64_t footer = out.tellp();
+    writeValue<uint32_t>(out, dictionary.size());
+    for (const auto& s : dictionary) {
+        writeString(out, s);
+    }
+    writeValue<uint32_t>(out, groups.size());
+    for (const auto& group : groups) {
+        writeValue<uint64_t>(out, group.rows);
+        writeValue<uint64_t>(out, group.offset);
+        writeValue<uint32_t>(out, group.columns.size());
+        for (const auto& col : group.columns) {
+            writeString(out, col.first);
+            writeValue<uint8_t>(out, uint8_t(col.second.first));
+            writeValue<uint64_t>(out, col.second.second);
+        }
+    }
+    writeValue(out, footer);
+    out.write(RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    out.close();
+    if (!out) {
+        throw runtime_error("Results store: cannot write " + path);
+    }
+}
+
+template <typename T>
+static T readValue(ifstream& in, const string& path) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw runtime_error("Results store: " + path + " is truncated");
+    }
+    return value;
+}
+
+static string readString(ifstream& in, const string& path) {
+    string s(readValue<uint32_t>(in, path), '\0');
+    if (!in.read(&s[0], s.size())) {
+        throw runtime_error("Results store: " + path + " is truncated");
+    }
+    return s;
+}
+
+ResultsReader::ResultsReader(const string& path)
+    : in(path, ios::binary), path(path), totalRows(0) {
+    if (!in) {
+        throw runtime_error("Results store: cannot open " + path);
+    }
+    char magic[8];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, RESULTS_MAGIC, sizeof(magic)) != 0) {
+        throw runtime_error("Results store: " + path + " is not a results file");
+    }
+    if (readValue<uint32_t>(in, path) != RESULTS_BYTE_ORDER) {
+        throw runtime_error("Results store: " + path + " was written with another byte order");
+    }
+
+    // Trailer: footer offset and the magic again (missing if never closed)
+    in.seekg(-int64_t(sizeof(uint64_t) + sizeof(magic)), ios::end);
+    uint64_t footer = readValue<uint64_t>(in, path);
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, RESULTS_MAGIC, sizeof(magic)) != 0) {
+        throw runtime_error("Results store: " + path + " was not closed");
+    }
+
+    in.seekg(footer);
+    dictionary.resize(readValue<uint32_t>(in, path));
+    for (auto& s : dictionary) {
+        s = readString(in, path);
+    }
+    groups.resize(readValue<uint32_t>(in, path));
+    for (auto& group : groups) {
+        group.rows = readValue<uint64_t>(in, path);
+        readValue<uint64_t>(in, path);   // group offset, columns are addressed directly
+        uint32_t count = readValue<uint32_t>(in, path);
+        for (uint32_t c = 0; c < count; c++) {
+            string name = readString(in, path);
+            ResultsColumnType type = ResultsColumnType(readValue<uint8_t>(in, path));
+            group.columns[name] = { type, readValue<uint64_t>(in, path) };
+        }
+        totalRows += group.rows;
+    }
+}
+
+vector<string> ResultsReader::getColumns() const {
+    vector<string> names;
+    for (const auto& group : groups) {
+        for (const auto& col : group.columns) {
+            if (find(names.begin(), names.end(), col.first) == names.end()) {
+                names.push_back(col.first);
+            }
+        }
+    }
+    return names;
+}
+
+ResultsColumn ResultsReader::read(size_t group, const string& name) const {
+    const Group& g = groups.at(group);
+    ResultsColumn col;
+    col.present.assign(g.rows, 0);
+    auto found = g.columns.find(name);
+    if (found == g.columns.end()) {
+        col.type = ResultsColumnType::INT;
+        col.ints.assign(g.rows, 0);
+        return col;
+    }
+    col.type = found->second.first;
+    in.clear();
+    in.seekg(found->second.second);
+    in.read(reinterpret_cast<char*>(col.present.data()), g.rows);
+    if (col.type == ResultsColumnType::DOUBLE) {
+        col.doubles.resize(g.rows);
+        in.read(reinterpret_cast<char*>(col.doubles.data()), g.rows * sizeof(double));
+    } else if (col.type == ResultsColumnType::STRING) {
+        col.strings.resize(g.rows);
+        for (auto& s : col.strings) {
+            s = readString(in, path);
+        }
+    } else {
+        col.ints.resize(g.rows);
+        in.read(reinterpret_cast<char*>(col.ints.data()), g.rows * sizeof(int64_t));
+    }
+    if (!in) {
+        throw runtime_error("Results store: " + path + " is truncated");
+    }
+    return col;
+}
+
+void ResultsReader::scan(const vector<string>& names,
+                         const function<void(const vector<ResultsColumn>&, size_t)>& visit) const {
+    for (size_t g = 0; g < groups.size(); g++) {
+        vector<ResultsColumn> cols;
+        for (const auto& name : names) {
+            cols.push_back(read(g, name));
+        }
+        visit(cols, groups[g].rows);
+    }
+}
+
+map<string, ResultsStats> ResultsReader::aggregate(const string& column, const string& key) const {
+    map<string, ResultsStats> stats;
+    vector<string> names = { column };
+    if (!key.empty()) {
+        names.push_back(key);
+    }
+    scan(names, [&](const vector<ResultsColumn>& cols, size_t rows) {
+        if (cols[0].type == ResultsColumnType::STRING) {
+            throw runtime_error("Results store: column " + column + " is not numeric");
+        }
+        for (size_t r = 0; r < rows; r++) {
+            if (!cols[0].present[r]) continue;
+            string k;
+            if (cols.size() > 1 && cols[1].present[r]) {
+                if (cols[1].type == ResultsColumnType::DICT) {
+                    k = lookup(cols[1].ints[r]);
+                } else if (cols[1].type == ResultsColumnType::STRING) {
+                    k = cols[1].strings[r];
+                } else {
+                    ostringstream os;
+                    os << cols[1].value(r);
+                    k = os.str();
+                }
+            }
+            double v = cols[0].value(r);
+            auto found = stats.find(k);
+            if (found == stats.end()) {
+                stats[k] = { 1, v, v, v };
+            } else {
+                ResultsStats& s = found->second;
+                s.count++;
+                s.sum += v;
+                s.min = min(s.min, v);
+                s.max = max(s.max, v);
+            }
+        }
+    });
+    return stats;
+}
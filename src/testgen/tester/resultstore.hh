@@ -0,0 +1,194 @@
+#ifndef RESULTSTORE_HH
+#define RESULTSTORE_HH
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "campaign.hh"
+
+using namespace std;
+
+/**
+ * Columnar store for campaign results.
+ *
+ * One row per executed test string, one column per metric:
+ *   testId, status, decidingBlock   (status and block names as dictionary
+ *                                     ids)
+ *   message      error message (plain strings: free text would grow the
+ *                dictionary, which is kept until the footer, with every row)
+ *   length, generationMs, iterations, latencyMs, newPoints
+ *   block<p>     block name at test-string position p (dictionary id)
+ *   input<k>     k-th input value the CTC was concretized with
+ * Columns that do not apply to a row (block5 of a 3-block test string) are
+ * null. decidingBlock is the block of the statement that decided the outcome
+ * (failed assert, failed assume, input generation got stuck on), null if the
+ * test passed.
+ *
+ * Rows are buffered and written in row groups; every group stores its
+ * columns one after the other, so a reader only reads the columns it asks
+ * for, one group at a time. File layout (native byte order):
+ *   "TTRRES01", byte-order mark
+ *   row groups    per column: name, type, presence bytes, values (STRING
+ *                 values as length and bytes)
+ *   footer        dictionary, per group its row count, offset and column
+ *                 directory (name, type, offset)
+ *   footer offset, "TTRRES01"
+ */
+enum class ResultsColumnType : uint8_t { INT, DOUBLE, DICT, STRING };
+
+/**
+ * The values of one column in one row group. DICT and INT values are in
+ * ints, DOUBLE values in doubles, STRING values in strings; present[i] is 0
+ * for a null. value() is for the numeric types only.
+ */
+struct ResultsColumn {
+    ResultsColumnType type;
+    vector<uint8_t> present;
+    vector<int64_t> ints;
+    vector<double> doubles;
+    vector<string> strings;
+
+    double value(size_t row) const {
+        return type == ResultsColumnType::DOUBLE ? doubles[row] : double(ints[row]);
+    }
+};
+
+/**
+ * ResultsWriter: appends campaign entries to a results file
+ */
+class ResultsWriter {
+private:
+    struct Directory {
+        size_t rows;
+        uint64_t offset;
+        vector<pair<string, pair<ResultsColumnType, uint64_t>>> columns;
+    };
+
+    const Campaign& campaign;
+    ofstream out;
+    string path;
+    size_t rowGroupSize;
+    size_t rows;                         // rows in the current group
+    size_t totalRows;
+    vector<string> columnOrder;          // current group, first-seen order
+    map<string, ResultsColumn> columns;
+    vector<string> dictionary;
+    unordered_map<string, uint32_t> dictionaryIds;
+    vector<Directory> groups;
+    bool closed;
+
+    uint32_t intern(const string& s);
+    ResultsColumn& column(const string& name, ResultsColumnType type);
+    void setInt(const string& name, int64_t value);
+    void setDouble(const string& name, double value);
+    void setString(const string& name, const string& value);
+    void setText(const string& name, const string& value);
+    void pad(ResultsColumn& col, size_t rows);
+    void flush();
+
+public:
+    /**
+     * Create the file; throws runtime_error if it cannot be written. The
+     * campaign maps CTC statements to the blocks of their test strings.
+     */
+    ResultsWriter(const string& path, const Campaign& campaign, size_t rowGroupSize = 65536);
+    ~ResultsWriter();
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+    void add(const CampaignEntry& entry);
+    void add(const vector<CampaignEntry>& entries);
+
+    /**
+     * Write the last row group and the footer. Called by the destructor if
+     * not called before.
+     */
+    void close();
+
+    size_t size() const { return totalRows; }
+    size_t getRowGroups() const { return groups.size(); }
+};
+
+/**
+ * count, sum, min and max of a column over a set of rows (nulls skipped)
+ */
+struct ResultsStats {
+    size_t count;
+    double sum;
+    double min;
+    double max;
+
+    double mean() const { return count ? sum / count : 0; }
+};
+
+/**
+ * ResultsReader: reads a results file column by column.
+ *
+ * Opening reads the footer only; read() and scan() load the requested
+ * columns of one row group at a time, so memory use is bounded by the row
+ * group size whatever the number of rows.
+ */
+class ResultsReader {
+private:
+    struct Group {
+        size_t rows;
+        map<string, pair<ResultsColumnType, uint64_t>> columns;
+    };
+
+    mutable ifstream in;
+    string path;
+    vector<string> dictionary;
+    vector<Group> groups;
+    size_t totalRows;
+
+public:
+    /**
+     * Throws runtime_error if the file cannot be opened or is not a results
+     * file written with this byte order
+     */
+    explicit ResultsReader(const string& path);
+
+    size_t size() const { return totalRows; }
+    size_t getRowGroups() const { return groups.size(); }
+    size_t getRows(size_t group) const { return groups.at(group).rows; }
+
+    /**
+     * Names of all columns, in any row group
+     */
+    vector<string> getColumns() const;
+
+    /**
+     * String of a dictionary id
+     */
+    const string& lookup(int64_t id) const { return dictionary.at(size_t(id)); }
+    size_t getDictionarySize() const { return dictionary.size(); }
+
+    /**
+     * One column of one row group; a column the group does not have is all
+     * null
+     */
+    ResultsColumn read(size_t group, const string& name) const;
+
+    /**
+     * Call visit(columns, rows) for every row group, with the requested
+     * columns in the order given
+     */
+    void scan(const vector<string>& names,
+              const function<void(const vector<ResultsColumn>&, size_t)>& visit) const;
+
+    /**
+     * Statistics of a numeric column, over all rows or per value of the key
+     * column (dictionary columns by their string, others by their number;
+     * rows with a null key are grouped under ""); throws runtime_error for
+     * a STRING column
+     */
+    map<string, ResultsStats> aggregate(const string& column, const string& key = "") const;
+};
+
+#endif // RESULTSTORE_HH
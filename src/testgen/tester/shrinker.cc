@@ -0,0 +1,95 @@
+#include "shrinker.hh"
+#include "../language/clonevisitor.hh"
+#include "ddmin.hh"
+#include <iostream>
+
+Shrinker::Shrinker(const Spec* spec, SymbolTable* globalSymTable, TypeMap typeMap,
+                   ReplayRunner::FactoryMaker makeFactory, unsigned int workers)
+    : campaign(spec, globalSymTable, std::move(typeMap), makeFactory),
+      runner(makeFactory, workers), generated(0), cacheHits(0) {}
+
+const Program& Shrinker::getCTC(const vector<string>& testString) {
+    auto it = ctcCache.find(testString);
+    if (it == ctcCache.end()) {
+        generated++;
+        it = ctcCache.emplace(testString, campaign.generateCTC(testString)).first;
+    }
+    return *it->second;
+}
+
+void Shrinker::evaluate(const vector<vector<string>>& candidates) {
+    vector<vector<string>> pending;
+    vector<const Program*> ctcs;
+    for (const auto& ts : candidates) {
+        if (verdictCache.count(ts)) {
+            cacheHits++;
+            continue;
+        }
+        bool queued = false;
+        for (const auto& p : pending) {
+            queued = queued || (p == ts);
+        }
+        if (queued) {
+            continue;
+        }
+        // Generation runs symbolic execution and stays sequential. A
+        // candidate that cannot be generated does not reproduce the failure.
+        try {
+            ctcs.push_back(&getCTC(ts));
+        } catch (const exception& e) {
+            cout << "[SHRINK] Generation failed: " << e.what() << endl;
+            verdictCache[ts] = { 0, ReplayStatus::ERROR, -1,
+                                 string("generation failed: ") + e.what(), 0 };
+            continue;
+        }
+        pending.push_back(ts);
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    vector<ReplayResult> results = runner.run(ctcs);
+    for (size_t i = 0; i < pending.size(); i++) {
+        verdictCache[pending[i]] = results[i];
+    }
+}
+
+bool Shrinker::fails(const vector<string>& testString) const {
+    auto it = verdictCache.find(testString);
+    return it != verdictCache.end() && it->second.status == ReplayStatus::FAILED;
+}
+
+ShrinkResult Shrinker::shrink(const vector<string>& testString) {
+    evaluate({ testString });
+    if (!fails(testString)) {
+        throw runtime_error("Shrinker: test string does not fail");
+    }
+
+    size_t rounds = 1;
+    vector<string> current = ddmin(testString,
+        [this](const vector<string>& candidate) { return fails(candidate); },
+        [&](const vector<vector<string>>& candidates) {
+            // One parallel replay per round
+            evaluate(candidates);
+            rounds++;
+            cout << "[SHRINK] round " << rounds << ": " << candidates.size() << " candidates" << endl;
+        });
+
+    ShrinkResult result;
+    result.testString = current;
+    CloneVisitor cloner;
+    vector<unique_ptr<Stmt>> stmts;
+    for (const auto& s : getCTC(current).statements) {
+        stmts.push_back(cloner.cloneStmt(s.get()));
+    }
+    result.ctc = make_unique<Program>(std::move(stmts));
+    result.result = verdictCache[current];
+    result.rounds = rounds;
+    result.generated = generated;
+    result.cacheHits = cacheHits;
+
+    cout << "[SHRINK] " << testString.size() << " -> " << current.size() << " blocks in "
+         << rounds << " rounds (" << generated << " CTCs generated, "
+         << cacheHits << " cache hits)" << endl;
+    return result;
+}
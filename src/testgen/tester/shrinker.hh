@@ -0,0 +1,75 @@
+#ifndef SHRINKER_HH
+#define SHRINKER_HH
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+#include "../language/typemap.hh"
+#include "campaign.hh"
+#include "replay.hh"
+
+using namespace std;
+
+/**
+ * Outcome of shrinking a failing test string
+ */
+struct ShrinkResult {
+    vector<string> testString;   // smallest failing test string found
+    unique_ptr<Program> ctc;     // its CTC
+    ReplayResult result;         // its (failing) replay verdict
+    size_t rounds;               // replay rounds
+    size_t generated;            // CTCs generated (cache misses)
+    size_t cacheHits;            // candidates answered from the cache
+};
+
+/**
+ * Shrinker: delta debugging (ddmin, see ddmin.hh) over the blocks of a
+ * failing test string
+ *
+ * Every round splits the current test string into n chunks and tries each
+ * chunk and each complement. Candidates are regenerated through
+ * genATC/generateCTC and replayed together on a ReplayRunner, so a round
+ * costs one parallel replay. The first failing chunk (then complement)
+ * becomes the new test string; if none fails, n is doubled until every
+ * block has been tried on its own. The result is 1-minimal: removing any
+ * single block makes the test pass.
+ *
+ * Generated CTCs and verdicts are cached per test string, so candidates
+ * that recur across rounds are neither regenerated nor replayed again.
+ * A candidate whose generation throws (a SUT error during symbolic
+ * execution, a deadline) gets an ERROR verdict and counts as passing.
+ */
+class Shrinker {
+private:
+    Campaign campaign;   // used for CTC generation only
+    ReplayRunner runner;
+    map<vector<string>, unique_ptr<Program>> ctcCache;
+    map<vector<string>, ReplayResult> verdictCache;
+    size_t generated;
+    size_t cacheHits;
+
+    const Program& getCTC(const vector<string>& testString);
+
+    /**
+     * Replay all candidates that are not cached yet in one parallel run
+     */
+    void evaluate(const vector<vector<string>>& candidates);
+
+    bool fails(const vector<string>& testString) const;
+
+public:
+    Shrinker(const Spec* spec, SymbolTable* globalSymTable, TypeMap typeMap,
+             ReplayRunner::FactoryMaker makeFactory, unsigned int workers = 0);
+
+    /**
+     * Shrink a test string whose CTC fails an assert.
+     * Throws runtime_error if the given test string does not fail.
+     */
+    ShrinkResult shrink(const vector<string>& testString);
+};
+
+#endif // SHRINKER_HH
@@ -0,0 +1,108 @@
+#include "suiteminimizer.hh"
+#include <algorithm>
+#include <iostream>
+
+MinimizedSuite SuiteMinimizer::minimize(const vector<CoverageBitmap>& coverage,
+                                        const vector<double>& cost) {
+    size_t n = coverage.size();
+    if (!cost.empty() && cost.size() != n) {
+        throw runtime_error("SuiteMinimizer: cost and coverage sizes differ");
+    }
+    size_t bits = 0;
+    for (const auto& c : coverage) {
+        bits = max(bits, c.size());
+    }
+
+    MinimizedSuite suite = { {}, {}, 0 };
+    CoverageBitmap covered(bits);
+    vector<bool> picked(n, false);
+
+    // Step 1: greedy cover
+    while (true) {
+        size_t best = n;
+        size_t bestGain = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (picked[i]) continue;
+            size_t gain = covered.countNew(coverage[i]);
+            if (gain == 0) continue;
+            if (gain > bestGain ||
+                (gain == bestGain && !cost.empty() && cost[i] < cost[best])) {
+                best = i;
+                bestGain = gain;
+            }
+        }
+        if (best == n) {
+            break;
+        }
+        picked[best] = true;
+        covered.merge(coverage[best]);
+        suite.kept.push_back(best);
+    }
+    suite.coveredPoints = covered.count();
+
+    // Step 2: drop kept tests made redundant by later picks
+    for (size_t k = suite.kept.size(); k-- > 0;) {
+        CoverageBitmap others(bits);
+        for (size_t j = 0; j < suite.kept.size(); j++) {
+            if (j != k) others.merge(coverage[suite.kept[j]]);
+        }
+        if (others.countNew(coverage[suite.kept[k]]) == 0) {
+            suite.kept.erase(suite.kept.begin() + k);
+        }
+    }
+
+    // Dropped-test mapping: kept tests, in pick order, that supply its points
+    for (size_t i = 0; i < n; i++) {
+        if (find(suite.kept.begin(), suite.kept.end(), i) != suite.kept.end()) {
+            continue;
+        }
+        vector<size_t>& coveredBy = suite.dropped[i];
+        CoverageBitmap remaining = CoverageBitmap(bits).newBits(coverage[i]);
+        for (size_t k : suite.kept) {
+            if (remaining.count() == 0) break;
+            CoverageBitmap keptBits(bits);
+            keptBits.merge(coverage[k]);
+            if (keptBits.countNew(remaining) < remaining.count()) {
+                coveredBy.push_back(k);
+                remaining = keptBits.newBits(remaining);
+            }
+        }
+    }
+    return suite;
+}
+
+MinimizedSuite SuiteMinimizer::minimize(const vector<CampaignEntry>& entries) {
+    vector<CoverageBitmap> coverage;
+    vector<double> cost;
+    for (const auto& e : entries) {
+        coverage.push_back(e.coverage);
+        cost.push_back(e.result.latencyMs);
+    }
+    return minimize(coverage, cost);
+}
+
+vector<CampaignEntry> SuiteMinimizer::reduce(vector<CampaignEntry>& entries,
+                                             const MinimizedSuite& suite) {
+    vector<size_t> order = suite.kept;
+    sort(order.begin(), order.end());
+    vector<CampaignEntry> reduced;
+    for (size_t i : order) {
+        reduced.push_back(std::move(entries[i]));
+    }
+    return reduced;
+}
+
+void SuiteMinimizer::printReport(const MinimizedSuite& suite, size_t total) {
+    cout << "[MINIMIZE] kept " << suite.kept.size() << " of " << total
+         << " tests (" << suite.coveredPoints << " points)" << endl;
+    for (const auto& d : suite.dropped) {
+        cout << "  [MINIMIZE] dropped test " << d.first << " -> covered by";
+        if (d.second.empty()) {
+            cout << " nothing (no coverage)";
+        }
+        for (size_t k : d.second) {
+            cout << " " << k;
+        }
+        cout << endl;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef SUITEMINIMIZER_HH
+#define SUITEMINIMIZER_HH
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "campaign.hh"
+#include "coverage.hh"
+
+using namespace std;
+
+/**
+ * Result of minimizing a test suite
+ *
+ * kept:     indices of the retained tests, in the order they were picked
+ * dropped:  for every dropped test, the kept tests whose coverage includes
+ *           its points (an empty list means the test covered nothing)
+ */
+struct MinimizedSuite {
+    vector<size_t> kept;
+    map<size_t, vector<size_t>> dropped;
+    size_t coveredPoints;
+};
+
+/**
+ * SuiteMinimizer: post-processing stage that removes redundant CTCs
+ *
+ * Greedy set cover over the per-test coverage bitmaps:
+ *   1. repeatedly keep the test adding the most uncovered points (ties go to
+ *      the cheaper test, then to the earlier one) until nothing new is left
+ *   2. drop kept tests, last picked first, whose points are all covered by
+ *      the other kept tests
+ * The union of the kept tests' coverage equals the union over the whole suite.
+ */
+class SuiteMinimizer {
+public:
+    /**
+     * @param coverage  coverage bitmap per test
+     * @param cost      cost per test (e.g. replay latency); empty = uniform
+     */
+    static MinimizedSuite minimize(const vector<CoverageBitmap>& coverage,
+                                   const vector<double>& cost = {});
+
+    /**
+     * Minimize a campaign's entries by their coverage and replay latency
+     */
+    static MinimizedSuite minimize(const vector<CampaignEntry>& entries);
+
+    /**
+     * Move the kept entries out of a campaign, in the original order
+     */
+    static vector<CampaignEntry> reduce(vector<CampaignEntry>& entries,
+                                        const MinimizedSuite& suite);
+
+    static void printReport(const MinimizedSuite& suite, size_t total);
+};
+
+#endif // SUITEMINIMIZER_HH
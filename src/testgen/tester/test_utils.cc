@@ -1,4 +1,5 @@
 #include "test_utils.hh"
+#include "../apps/app1/app1.hh"
 
 string TestUtils::exprToString(Expr* expr) {
     if (!expr) return "null";
@@ -65,6 +66,20 @@ string TestUtils::exprToString(Expr* expr) {
     return "Unknown";
 }
 
+string TestUtils::stmtToString(const Stmt& stmt) {
+    if (stmt.statementType == StmtType::ASSIGN) {
+        const Assign& assign = dynamic_cast<const Assign&>(stmt);
+        return exprToString(assign.left.get()) + " := " + exprToString(assign.right.get());
+    }
+    else if (stmt.statementType == StmtType::ASSUME) {
+        return "assume(" + exprToString(dynamic_cast<const Assume&>(stmt).expr.get()) + ")";
+    }
+    else if (stmt.statementType == StmtType::ASSERT) {
+        return "assert(" + exprToString(dynamic_cast<const Assert&>(stmt).expr.get()) + ")";
+    }
+    return "?";
+}
+
 unique_ptr<FuncCall> TestUtils::makeBinOp(string op, unique_ptr<Expr> left, unique_ptr<Expr> right) {
     vector<unique_ptr<Expr>> args;
     args.push_back(std::move(left));
@@ -129,3 +144,76 @@ bool TestUtils::solveAndDisplay(SEE& see, map<string, int>& modelOut) {
     
     return result.isSat;
 }
+
+/*
+Sample spec of the campaign tests:
+    API f2:  r := f2()          Post: r = 0
+    API set: r := set_y(v)      Pre: v > 5       Post: r = v
+    API bad: r := f1(v, v)      Pre: v < 0 AND v > 0   (never feasible)
+*/
+unique_ptr<Spec> TestUtils::makeSampleSpec() {
+    vector<unique_ptr<Decl>> globals;
+    globals.push_back(make_unique<Decl>("y", make_unique<TypeConst>("int")));
+    vector<unique_ptr<Init>> inits;
+    inits.push_back(make_unique<Init>("y", make_unique<Num>(0)));
+    vector<unique_ptr<APIFuncDecl>> functions;
+    vector<unique_ptr<API>> blocks;
+
+    {
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f2", vector<unique_ptr<Expr>>{}),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(nullptr, std::move(apiCall),
+            Response(makeBinOp("Eq", make_unique<Var>("r"), make_unique<Num>(0))), "f2"));
+    }
+    {
+        vector<unique_ptr<Expr>> callArgs;
+        callArgs.push_back(make_unique<Var>("v"));
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("set_y", std::move(callArgs)),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(5)),
+            std::move(apiCall),
+            Response(makeBinOp("Eq", make_unique<Var>("r"), make_unique<Var>("v"))), "set"));
+    }
+    {
+        vector<unique_ptr<Expr>> callArgs;
+        callArgs.push_back(make_unique<Var>("v"));
+        callArgs.push_back(make_unique<Var>("v"));
+        auto apiCall = make_unique<APIcall>(
+            make_unique<FuncCall>("f1", std::move(callArgs)),
+            Response(make_unique<Var>("r")));
+        blocks.push_back(make_unique<API>(
+            makeBinOp("And",
+                makeBinOp("Lt", make_unique<Var>("v"), make_unique<Num>(0)),
+                makeBinOp("Gt", make_unique<Var>("v"), make_unique<Num>(0))),
+            std::move(apiCall), Response(nullptr), "bad"));
+    }
+
+    return make_unique<Spec>(std::move(globals), std::move(inits),
+                             std::move(functions), std::move(blocks));
+}
+
+SymbolTable* TestUtils::makeSampleSymbolTables() {
+    auto* globalTable = new SymbolTable(nullptr);
+    globalTable->addChild(new SymbolTable(globalTable));
+    auto* setTable = new SymbolTable(globalTable);
+    setTable->addMapping(new string("v"), nullptr);
+    globalTable->addChild(setTable);
+    auto* badTable = new SymbolTable(globalTable);
+    badTable->addMapping(new string("v"), nullptr);
+    globalTable->addChild(badTable);
+    return globalTable;
+}
+
+void TestUtils::deleteSampleSymbolTables(SymbolTable* globalTable) {
+    for (size_t i = 0; i < globalTable->getChildCount(); i++) {
+        delete globalTable->getChild(i);
+    }
+    delete globalTable;
+}
+
+unique_ptr<FunctionFactory> TestUtils::makeSampleFactory() {
+    return unique_ptr<FunctionFactory>(new App1FunctionFactory());
+}
@@ -7,6 +7,7 @@
 #include <vector>
 #include "../language/ast.hh"
 #include "../language/env.hh"
+#include "../see/functionfactory.hh"
 #include "../see/see.hh"
 #include "../see/z3solver.hh"
 
@@ -20,6 +21,9 @@ class TestUtils {
 public:
     // Helper function to print expressions recursively
     static string exprToString(Expr* expr);
+
+    // One-line form of a statement: x := e, assume(e) or assert(e)
+    static string stmtToString(const Stmt& stmt);
     
     // Helper function to create a binary operation function call (e.g., Add, Mul, Eq)
     static unique_ptr<FuncCall> makeBinOp(string op, unique_ptr<Expr> left, unique_ptr<Expr> right);
@@ -41,6 +45,17 @@ public:
     
     // Helper to solve constraints and display results (returns isSat status)
     static bool solveAndDisplay(SEE& see, map<string, int>& modelOut);
+
+    // Spec shared by the campaign tests: blocks f2, set (v > 5) and bad
+    // (never feasible) over App1
+    static unique_ptr<Spec> makeSampleSpec();
+
+    // Symbol tables of makeSampleSpec, one child per block
+    static SymbolTable* makeSampleSymbolTables();
+    static void deleteSampleSymbolTables(SymbolTable* globalTable);
+
+    // Fresh App1 factory, usable as a ReplayRunner::FactoryMaker
+    static unique_ptr<FunctionFactory> makeSampleFactory();
 };
 
 #endif // TEST_UTILS_HH
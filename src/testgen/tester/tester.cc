@@ -1,9 +1,52 @@
 #include "tester.hh"
 #include "../language/clonevisitor.hh"
+#include "../see/concreteevaluator.hh"
 #include <iostream>
 
 void Tester::generateTest() {}
 
+void Tester::checkDeadline() const {
+    if(hasDeadline && chrono::steady_clock::now() >= deadline) {
+        throw DeadlineExceeded("CTC generation exceeded its deadline");
+    }
+}
+
+unsigned int Tester::remainingMs() const {
+    auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+    // Clamp before narrowing: a negative count would wrap to ~49 days
+    return left.count() <= 0 ? 1 : (unsigned int)left.count();
+}
+
+int Tester::inputValue(const Result& result, unsigned int num) {
+    auto entry = result.model.find("X" + to_string(num));
+    if(entry == result.model.end()) {
+        return 0;
+    }
+    if(entry->second->type != ResultType::INT) {
+        throw runtime_error("Input X" + to_string(num) +
+                            " has a non-integer value; only integer inputs are supported");
+    }
+    return dynamic_cast<const IntResultValue*>(entry->second.get())->value;
+}
+
+void Tester::recordIfSlow(chrono::steady_clock::time_point start) {
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    if(slowQueryMs <= 0 || elapsed.count() < slowQueryMs) {
+        return;
+    }
+    cout << ">>> generateCTC: Slow query (" << elapsed.count() << " ms, "
+         << pathConstraints.size() << " conjuncts) recorded" << endl;
+    RecordedQuery query;
+    CloneVisitor cloner;
+    const vector<size_t>& origins = see.getConstraintOrigins();
+    for(size_t i = 0; i < pathConstraints.size(); i++) {
+        query.conjuncts.push_back(cloner.cloneExpr(pathConstraints[i]));
+        query.statements.push_back(i < origins.size() ? origins[i] : SIZE_MAX);
+    }
+    query.solveMs = elapsed.count();
+    slowQueries.push_back(std::move(query));
+}
+
 // Check if a statement is an Input statement (x := input())
 bool isInputStmt(const Stmt& stmt) {
     if(stmt.statementType == StmtType::ASSIGN) {
@@ -46,6 +89,14 @@ unique_ptr<Program> Tester::generateCTC(unique_ptr<Program> atc, vector<Expr*> C
         return atc;
     }
     
+    checkDeadline();
+    if(oneShot && ConcreteVals.empty()) {
+        unique_ptr<Program> ctc = generateCTCOneShot(*atc);
+        if(ctc) {
+            return ctc;
+        }
+        cout << ">>> generateCTC: One-shot failed, solving once per API call" << endl;
+    }
     cout << ">>> generateCTC: Program is abstract, needs concretization" << endl;
     cout << ">>> generateCTC: Concrete values provided: " << ConcreteVals.size() << endl;
     
@@ -70,19 +121,29 @@ unique_ptr<Program> Tester::generateCTC(unique_ptr<Program> atc, vector<Expr*> C
     
     // Solve the path constraints to get new concrete values using class member
     cout << "\n>>> generateCTC: STEP 3 - Solving path constraints with Z3" << endl;
-    Result result = solver.solve(std::move(pathConstraint));
+    unsigned int timeoutMs = 0;
+    if(hasDeadline) {
+        checkDeadline();
+        timeoutMs = remainingMs();
+        solver.setTimeout(timeoutMs);
+    }
+    iterations++;
+    auto solveStart = chrono::steady_clock::now();
+    Result result = hybridSolver ? hybridSolver->solve(pathConstraints, timeoutMs)
+                                 : solver.solve(std::move(pathConstraint));
+    recordIfSlow(solveStart);
+    checkDeadline();
     
     // Extract concrete values from the solver result
     vector<Expr*> newConcreteVals;
     if(result.isSat) {
-        cout << ">>> generateCTC: SAT - Extracting " << result.model.size() << " concrete values" << endl;
-        // Extract values from the model in order (X0, X1, X2, ...)
-        for(const auto& entry : result.model) {
-            if(entry.second->type == ResultType::INT) {
-                const IntResultValue* intVal = dynamic_cast<const IntResultValue*>(entry.second.get());
-                cout << "    " << entry.first << " = " << intVal->value << endl;
-                newConcreteVals.push_back(new Num(intVal->value));
-            }
+        cout << ">>> generateCTC: SAT - Extracting " << see.getInputSymVars().size() << " concrete values" << endl;
+        // One value per input() executed, in program order. Inputs that do not
+        // occur in the path constraint are unconstrained and get 0.
+        for(unsigned int num : see.getInputSymVars()) {
+            int value = inputValue(result, num);
+            cout << "    X" << num << " = " << value << endl;
+            newConcreteVals.push_back(new Num(value));
         }
     } else {
         cout << ">>> generateCTC: UNSAT - No solution found, cannot continue" << endl;
@@ -100,6 +161,90 @@ unique_ptr<Program> Tester::generateCTC(unique_ptr<Program> atc, vector<Expr*> C
     return generateCTC(std::move(rewritten), newConcreteVals, ve);
 }
 
+// One-shot generation: with API calls modeled, symbolic execution runs
+// through the whole test string and a single query fixes every input. The
+// rewritten program is then run for real; it is a CTC if all its assumes hold
+// on the actual API results.
+unique_ptr<Program> Tester::generateCTCOneShot(const Program& atc) {
+    cout << "\n>>> generateCTC: ONE-SHOT - Solving the whole test string with modeled API calls" << endl;
+    CloneVisitor cloner;
+    vector<unique_ptr<Stmt>> stmts;
+    for(const auto& stmt : atc.statements) {
+        stmts.push_back(cloner.cloneStmt(stmt.get()));
+    }
+    unique_ptr<Program> modeled = make_unique<Program>(std::move(stmts));
+
+    SymbolTable st(nullptr);
+    see.setModelAPIs(true);
+    try {
+        see.execute(*modeled, st);
+    } catch(const exception& e) {
+        see.setModelAPIs(false);
+        cout << ">>> generateCTC: ONE-SHOT - Symbolic execution failed: " << e.what() << endl;
+        return nullptr;
+    }
+    see.setModelAPIs(false);
+    pathConstraints = see.getPathConstraint();
+
+    unsigned int timeoutMs = 0;
+    if(hasDeadline) {
+        checkDeadline();
+        timeoutMs = remainingMs();
+        solver.setTimeout(timeoutMs);
+    }
+    iterations++;
+    vector<Expr*> values;
+    try {
+        auto solveStart = chrono::steady_clock::now();
+        Result result = hybridSolver ? hybridSolver->solve(pathConstraints, timeoutMs)
+                                     : solver.solve(see.computePathConstraint());
+        recordIfSlow(solveStart);
+        if(!result.isSat) {
+            cout << ">>> generateCTC: ONE-SHOT - UNSAT under the model" << endl;
+            return nullptr;
+        }
+        for(unsigned int num : see.getInputSymVars()) {
+            values.push_back(new Num(inputValue(result, num)));
+        }
+    } catch(const exception& e) {
+        // Typically a postcondition the solver cannot express
+        cout << ">>> generateCTC: ONE-SHOT - Cannot solve the model: " << e.what() << endl;
+        return nullptr;
+    }
+    checkDeadline();
+
+    unique_ptr<Program> ctc = rewriteATC(modeled, values);
+    if(isAbstract(*ctc)) {
+        return nullptr;
+    }
+
+    // Validate the prediction against the SUT
+    cout << "\n>>> generateCTC: ONE-SHOT - Validating with the concrete run" << endl;
+    bool confirmed = true;
+    try {
+        SymbolTable concreteSt(nullptr);
+        see.execute(*ctc, concreteSt);
+        ConcreteEvaluator evaluator;
+        ConcValEnv env;
+        for(Expr* constraint : see.getPathConstraint()) {
+            if(!evaluator.evaluateBool(*constraint, env)) {
+                cout << ">>> generateCTC: ONE-SHOT - Diverged: an assume does not hold on the API results" << endl;
+                confirmed = false;
+                break;
+            }
+        }
+    } catch(const exception& e) {
+        cout << ">>> generateCTC: ONE-SHOT - Diverged: " << e.what() << endl;
+        confirmed = false;
+    }
+    if(!confirmed) {
+        divergences++;
+        return nullptr;
+    }
+    cout << ">>> generateCTC: ONE-SHOT - Prediction confirmed" << endl;
+    return ctc;
+}
+
 // Generate Abstract Test Case from specification
 unique_ptr<Program> Tester::generateATC(unique_ptr<Spec> spec, vector<string> ts) {
     vector<unique_ptr<Stmt>> stmts;
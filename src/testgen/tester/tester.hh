@@ -1,7 +1,9 @@
 #ifndef TESTER_HH
 #define TESTER_HH
 
+#include <chrono>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -9,17 +11,91 @@
 #include "../language/env.hh"
 #include "../see/see.hh"
 #include "../see/z3solver.hh"
+#include "../see/hybridsolver.hh"
 using namespace std;
+
+// Thrown by Tester::generateCTC when it runs past the deadline set with
+// Tester::setDeadline
+class DeadlineExceeded : public runtime_error {
+    public:
+        DeadlineExceeded(const string& what) : runtime_error(what) {}
+};
+
+// A path constraint that took long to solve, as its conjuncts (see
+// Tester::setSlowQueryThreshold and QueryMinimizer)
+struct RecordedQuery {
+    vector<string> testString;              // filled in by Campaign
+    vector<unique_ptr<Expr>> conjuncts;
+    vector<size_t> statements;              // ATC statement that added each conjunct
+    vector<size_t> positions;               // test-string position of its block, SIZE_MAX for init (Campaign)
+    double solveMs;
+};
+
 class Tester {
     private:
         SEE see;
         Z3Solver solver;
+        const HybridSolver* hybridSolver;
         vector<Expr*> pathConstraints;
+        bool hasDeadline;
+        chrono::steady_clock::time_point deadline;
+        size_t iterations;
+        bool oneShot;
+        size_t divergences;
+        double slowQueryMs;
+        vector<RecordedQuery> slowQueries;
         
         unique_ptr<Program> generateATC(unique_ptr<Spec>, vector<string>);
+        void checkDeadline() const;
+        // Milliseconds left until the deadline, at least 1
+        unsigned int remainingMs() const;
+        // Solve the whole test string once with modeled API calls; nullptr
+        // if there is no solution or the SUT diverges from the model
+        unique_ptr<Program> generateCTCOneShot(const Program&);
+        // Record the current path constraint if solving it took at least
+        // slowQueryMs since start
+        void recordIfSlow(chrono::steady_clock::time_point start);
+        // Value the model gives input() SymVar X<num>, 0 if the model has
+        // none (the input is unconstrained). Inputs are integers: the CTC
+        // language has no list literals, so a list (or any other
+        // non-integer) value throws runtime_error.
+        static int inputValue(const Result& result, unsigned int num);
     public:
-        Tester(FunctionFactory* functionFactory) : see(functionFactory), solver(), pathConstraints() {}
+        Tester(FunctionFactory* functionFactory) : see(functionFactory), solver(), hybridSolver(nullptr), pathConstraints(), hasDeadline(false), iterations(0), oneShot(false), divergences(0), slowQueryMs(0) {}
         void generateTest();
+
+        // Stop generateCTC with DeadlineExceeded once the deadline has passed.
+        // Checked between iterations; Z3 queries are cut off at the deadline.
+        void setDeadline(chrono::steady_clock::time_point d) { deadline = d; hasDeadline = true; }
+        void clearDeadline() { hasDeadline = false; }
+
+        // Try random inputs before solving (see HybridSolver); nullptr = always solve
+        void setHybridSolver(const HybridSolver* hs) { hybridSolver = hs; }
+
+        // Solve with list inputs of at most maxLength elements first (see
+        // Z3Solver::setListBound)
+        void setListBound(size_t maxLength) { solver.setListBound(maxLength); }
+
+        // Concretize symbolic values larger than maxNodes (see SEE::setTermBudget)
+        void setTermBudget(size_t maxNodes) { see.setTermBudget(maxNodes, &solver); }
+
+        // Solve for all inputs of a test string at once, before any SUT call,
+        // with API results modeled by their postconditions (see
+        // SEE::setModelAPIs). The concrete run checks the prediction; if an
+        // assume fails on the real results, generateCTC falls back to
+        // solving once per API call.
+        void setOneShot(bool on) { oneShot = on; }
+
+        // Path constraints solved by generateCTC so far
+        size_t getIterations() const { return iterations; }
+
+        // One-shot predictions the SUT did not confirm
+        size_t getDivergences() const { return divergences; }
+
+        // Keep a copy of every path constraint that takes at least ms to
+        // solve (0 = record none), for QueryMinimizer
+        void setSlowQueryThreshold(double ms) { slowQueryMs = ms; }
+        vector<RecordedQuery>& getSlowQueries() { return slowQueries; }
         
         // Public methods for testing
         unique_ptr<Program> generateCTC(unique_ptr<Program>, vector<Expr*> ConcreteVals, ValueEnvironment* ve);
@@ -0,0 +1,534 @@
+#include "testset.hh"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+
+static bool isEmptyRange(const TestSetExpr& e) {
+    return e.minLength() > e.maxLength();
+}
+
+// ============================================================================
+// Streams
+// ============================================================================
+
+class SingleStream : public TestSetStream {
+private:
+    const vector<string>& value;
+    bool done;
+
+public:
+    SingleStream(const vector<string>& value) : value(value), done(false) {}
+
+    bool next(vector<string>& out) override {
+        if (done) return false;
+        done = true;
+        out = value;
+        return true;
+    }
+};
+
+// Elements of an inner stream that satisfy a predicate
+class FilterStream : public TestSetStream {
+private:
+    unique_ptr<TestSetStream> inner;
+    function<bool(const vector<string>&)> keep;
+
+public:
+    FilterStream(unique_ptr<TestSetStream> inner, function<bool(const vector<string>&)> keep)
+        : inner(std::move(inner)), keep(std::move(keep)) {}
+
+    bool next(vector<string>& out) override {
+        while (inner->next(out)) {
+            if (keep(out)) return true;
+        }
+        return false;
+    }
+};
+
+class UnionStream : public TestSetStream {
+private:
+    const TestSetExpr& a;
+    const TestSetExpr& b;
+    unique_ptr<TestSetStream> first;
+    unique_ptr<TestSetStream> second;
+
+public:
+    UnionStream(const TestSetExpr& a, const TestSetExpr& b) : a(a), b(b), first(a.stream()) {}
+
+    bool next(vector<string>& out) override {
+        if (first) {
+            if (first->next(out)) return true;
+            first.reset();
+            second = b.stream();
+        }
+        while (second->next(out)) {
+            if (!a.contains(out)) return true;
+        }
+        return false;
+    }
+};
+
+// ============================================================================
+// Expressions
+// ============================================================================
+
+class LiteralSet : public TestSetExpr {
+private:
+    vector<string> value;
+
+public:
+    LiteralSet(vector<string> value) : value(std::move(value)) {}
+
+    unique_ptr<TestSetStream> stream() const override {
+        return make_unique<SingleStream>(value);
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return end - begin == value.size() && equal(value.begin(), value.end(), ts.begin() + begin);
+    }
+    size_t minLength() const override { return value.size(); }
+    size_t maxLength() const override { return value.size(); }
+};
+
+class UnionSet : public TestSetExpr {
+private:
+    shared_ptr<const TestSetExpr> a, b;
+    size_t minLen, maxLen;
+
+public:
+    UnionSet(shared_ptr<const TestSetExpr> a, shared_ptr<const TestSetExpr> b)
+        : a(std::move(a)), b(std::move(b)) {
+        if (isEmptyRange(*this->a)) {
+            minLen = this->b->minLength();
+            maxLen = this->b->maxLength();
+        } else if (isEmptyRange(*this->b)) {
+            minLen = this->a->minLength();
+            maxLen = this->a->maxLength();
+        } else {
+            minLen = min(this->a->minLength(), this->b->minLength());
+            maxLen = max(this->a->maxLength(), this->b->maxLength());
+        }
+    }
+
+    unique_ptr<TestSetStream> stream() const override {
+        return make_unique<UnionStream>(*a, *b);
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return a->contains(ts, begin, end) || b->contains(ts, begin, end);
+    }
+    size_t minLength() const override { return minLen; }
+    size_t maxLength() const override { return maxLen; }
+};
+
+class IntersectionSet : public TestSetExpr {
+private:
+    shared_ptr<const TestSetExpr> a, b;
+    size_t minLen, maxLen;
+
+public:
+    IntersectionSet(shared_ptr<const TestSetExpr> a, shared_ptr<const TestSetExpr> b)
+        : a(std::move(a)), b(std::move(b)),
+          minLen(max(this->a->minLength(), this->b->minLength())),
+          maxLen(min(this->a->maxLength(), this->b->maxLength())) {}
+
+    unique_ptr<TestSetStream> stream() const override {
+        const TestSetExpr& other = *b;
+        return make_unique<FilterStream>(a->stream(),
+            [&other](const vector<string>& ts) { return other.contains(ts); });
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return a->contains(ts, begin, end) && b->contains(ts, begin, end);
+    }
+    size_t minLength() const override { return minLen; }
+    size_t maxLength() const override { return maxLen; }
+};
+
+class DifferenceSet : public TestSetExpr {
+private:
+    shared_ptr<const TestSetExpr> a, b;
+
+public:
+    DifferenceSet(shared_ptr<const TestSetExpr> a, shared_ptr<const TestSetExpr> b)
+        : a(std::move(a)), b(std::move(b)) {}
+
+    unique_ptr<TestSetStream> stream() const override {
+        const TestSetExpr& other = *b;
+        return make_unique<FilterStream>(a->stream(),
+            [&other](const vector<string>& ts) { return !other.contains(ts); });
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return a->contains(ts, begin, end) && !b->contains(ts, begin, end);
+    }
+    size_t minLength() const override { return a->minLength(); }
+    size_t maxLength() const override { return a->maxLength(); }
+};
+
+class ProductSet : public TestSetExpr {
+private:
+    shared_ptr<const TestSetExpr> a, b;
+    size_t minLen, maxLen;   // cached: expressions are immutable
+
+    class Stream : public TestSetStream {
+    private:
+        const ProductSet& set;
+        unique_ptr<TestSetStream> left;
+        unique_ptr<TestSetStream> right;
+        vector<string> x, y;
+
+    public:
+        Stream(const ProductSet& set) : set(set), left(set.a->stream()) {}
+
+        bool next(vector<string>& out) override {
+            while (true) {
+                if (!right) {
+                    if (!left->next(x)) return false;
+                    right = set.b->stream();
+                }
+                if (!right->next(y)) {
+                    right.reset();
+                    continue;
+                }
+                out = x;
+                out.insert(out.end(), y.begin(), y.end());
+                // Emit each concatenation for its shortest split only
+                if (set.firstSplit(out, 0, out.size()) == x.size()) {
+                    return true;
+                }
+            }
+        }
+    };
+
+public:
+    ProductSet(shared_ptr<const TestSetExpr> a, shared_ptr<const TestSetExpr> b)
+        : a(std::move(a)), b(std::move(b)) {
+        if (isEmptyRange(*this->a) || isEmptyRange(*this->b)) {
+            minLen = 1;
+            maxLen = 0;
+        } else {
+            minLen = this->a->minLength() + this->b->minLength();
+            maxLen = this->a->maxLength() + this->b->maxLength();
+        }
+    }
+
+    /**
+     * Shortest k with ts[begin, begin+k) in a and ts[begin+k, end) in b,
+     * SIZE_MAX if there is none
+     */
+    size_t firstSplit(const vector<string>& ts, size_t begin, size_t end) const {
+        if (isEmptyRange(*a) || isEmptyRange(*b)) {
+            return SIZE_MAX;
+        }
+        size_t n = end - begin;
+        size_t lo = a->minLength();
+        if (n > b->maxLength()) {
+            lo = max(lo, n - b->maxLength());
+        }
+        if (n < b->minLength()) {
+            return SIZE_MAX;
+        }
+        size_t hi = min(a->maxLength(), n - b->minLength());
+        for (size_t k = lo; k <= hi; k++) {
+            if (a->contains(ts, begin, begin + k) && b->contains(ts, begin + k, end)) {
+                return k;
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    unique_ptr<TestSetStream> stream() const override {
+        return make_unique<Stream>(*this);
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return firstSplit(ts, begin, end) != SIZE_MAX;
+    }
+    size_t minLength() const override { return minLen; }
+    size_t maxLength() const override { return maxLen; }
+};
+
+class UniqueSet : public TestSetExpr {
+private:
+    shared_ptr<const TestSetExpr> a;
+    unsigned int limit;
+
+    static bool withinLimit(const vector<string>& ts, size_t begin, size_t end, unsigned int limit) {
+        unordered_map<string, unsigned int> counts;
+        for (size_t i = begin; i < end; i++) {
+            if (++counts[ts[i]] > limit) return false;
+        }
+        return true;
+    }
+
+public:
+    UniqueSet(shared_ptr<const TestSetExpr> a, unsigned int limit) : a(std::move(a)), limit(limit) {}
+
+    unique_ptr<TestSetStream> stream() const override {
+        unsigned int n = limit;
+        return make_unique<FilterStream>(a->stream(),
+            [n](const vector<string>& ts) { return withinLimit(ts, 0, ts.size(), n); });
+    }
+    bool contains(const vector<string>& ts, size_t begin, size_t end) const override {
+        return withinLimit(ts, begin, end, limit) && a->contains(ts, begin, end);
+    }
+    size_t minLength() const override { return a->minLength(); }
+    size_t maxLength() const override { return a->maxLength(); }
+};
+
+vector<vector<string>> TestSetExpr::take(size_t limit) const {
+    vector<vector<string>> result;
+    unique_ptr<TestSetStream> s = stream();
+    vector<string> ts;
+    while (result.size() < limit && s->next(ts)) {
+        result.push_back(ts);
+    }
+    return result;
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::literal(vector<string> testString) {
+    return make_shared<LiteralSet>(std::move(testString));
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::setUnion(shared_ptr<const TestSetExpr> a,
+                                                    shared_ptr<const TestSetExpr> b) {
+    return make_shared<UnionSet>(std::move(a), std::move(b));
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::intersection(shared_ptr<const TestSetExpr> a,
+                                                        shared_ptr<const TestSetExpr> b) {
+    return make_shared<IntersectionSet>(std::move(a), std::move(b));
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::difference(shared_ptr<const TestSetExpr> a,
+                                                      shared_ptr<const TestSetExpr> b) {
+    return make_shared<DifferenceSet>(std::move(a), std::move(b));
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::product(shared_ptr<const TestSetExpr> a,
+                                                   shared_ptr<const TestSetExpr> b) {
+    return make_shared<ProductSet>(std::move(a), std::move(b));
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::power(shared_ptr<const TestSetExpr> a, unsigned int n) {
+    if (n == 0) {
+        return literal({});
+    }
+    shared_ptr<const TestSetExpr> result = a;
+    for (unsigned int i = 1; i < n; i++) {
+        result = product(a, result);
+    }
+    return result;
+}
+
+shared_ptr<const TestSetExpr> TestSetExpr::unique(shared_ptr<const TestSetExpr> a, unsigned int n) {
+    return make_shared<UniqueSet>(std::move(a), n);
+}
+
+// ============================================================================
+// TestSetParser Implementation
+// ============================================================================
+
+struct TestSetToken {
+    enum Kind { IDENT, INT, STRING, SYMBOL, END } kind;
+    string text;
+    int line;
+};
+
+class TestSetProgram {
+private:
+    vector<TestSetToken> tokens;
+    size_t pos;
+    map<string, shared_ptr<const TestSetExpr>>& named;
+
+    [[noreturn]] void fail(const string& what) const {
+        const TestSetToken& t = tokens[pos];
+        throw runtime_error("Test set line " + to_string(t.line) + ": " + what +
+                            (t.kind == TestSetToken::END ? " at end of input" : " near '" + t.text + "'"));
+    }
+
+    const TestSetToken& peek() const { return tokens[pos]; }
+    bool isSymbol(const string& s) const { return peek().kind == TestSetToken::SYMBOL && peek().text == s; }
+    bool isKeyword(const string& s) const { return peek().kind == TestSetToken::IDENT && peek().text == s; }
+
+    void expect(const string& s) {
+        if (!isSymbol(s)) fail("expected '" + s + "'");
+        pos++;
+    }
+
+    unsigned int integer() {
+        if (peek().kind != TestSetToken::INT) fail("expected an integer");
+        return stoul(tokens[pos++].text);
+    }
+
+    void skipParens() {
+        expect("(");
+        int depth = 1;
+        while (depth > 0) {
+            if (peek().kind == TestSetToken::END) fail("unbalanced '('");
+            if (isSymbol("(")) depth++;
+            if (isSymbol(")")) depth--;
+            pos++;
+        }
+    }
+
+    // { name(args) -> (results); ... ASSUME c; ASSERT c; }
+    shared_ptr<const TestSetExpr> literal() {
+        expect("{");
+        vector<string> blocks;
+        while (!isSymbol("}")) {
+            if (isKeyword("ASSUME") || isKeyword("ASSERT")) {
+                while (!isSymbol(";")) {
+                    if (peek().kind == TestSetToken::END || isSymbol("}")) fail("expected ';'");
+                    pos++;
+                }
+                pos++;
+                continue;
+            }
+            if (peek().kind != TestSetToken::IDENT) fail("expected an API name");
+            blocks.push_back(tokens[pos++].text);
+            if (isSymbol("(")) {
+                skipParens();
+                if (isSymbol("->")) {
+                    pos++;
+                    skipParens();
+                }
+            }
+            if (isSymbol(";")) pos++;
+        }
+        pos++;
+        return TestSetExpr::literal(std::move(blocks));
+    }
+
+    shared_ptr<const TestSetExpr> primary() {
+        if (isSymbol("(")) {
+            pos++;
+            shared_ptr<const TestSetExpr> e = unionExpr();
+            expect(")");
+            return e;
+        }
+        if (isSymbol("{")) {
+            return literal();
+        }
+        if (peek().kind == TestSetToken::IDENT) {
+            auto it = named.find(peek().text);
+            if (it == named.end()) fail("undefined test set");
+            pos++;
+            return it->second;
+        }
+        fail("expected a test set");
+    }
+
+    shared_ptr<const TestSetExpr> powerExpr() {
+        shared_ptr<const TestSetExpr> e = primary();
+        while (isSymbol("^")) {
+            pos++;
+            e = TestSetExpr::power(e, integer());
+        }
+        return e;
+    }
+
+    shared_ptr<const TestSetExpr> productExpr() {
+        shared_ptr<const TestSetExpr> e = powerExpr();
+        while (isSymbol("*")) {
+            pos++;
+            e = TestSetExpr::product(e, powerExpr());
+        }
+        return e;
+    }
+
+    shared_ptr<const TestSetExpr> intersectionExpr() {
+        shared_ptr<const TestSetExpr> e = productExpr();
+        while (isSymbol("&") || isSymbol("/")) {
+            bool inter = isSymbol("&");
+            pos++;
+            shared_ptr<const TestSetExpr> rhs = productExpr();
+            e = inter ? TestSetExpr::intersection(e, rhs) : TestSetExpr::difference(e, rhs);
+        }
+        return e;
+    }
+
+    shared_ptr<const TestSetExpr> unionExpr() {
+        shared_ptr<const TestSetExpr> e = intersectionExpr();
+        while (isSymbol("|")) {
+            pos++;
+            e = TestSetExpr::setUnion(e, intersectionExpr());
+        }
+        return e;
+    }
+
+public:
+    TestSetProgram(vector<TestSetToken> tokens, map<string, shared_ptr<const TestSetExpr>>& named)
+        : tokens(std::move(tokens)), pos(0), named(named) {}
+
+    shared_ptr<const TestSetExpr> program() {
+        while (!isKeyword("RETURN")) {
+            if (peek().kind != TestSetToken::IDENT) fail("expected a test set definition or RETURN");
+            string name = tokens[pos++].text;
+            expect("=");
+            shared_ptr<const TestSetExpr> e = unionExpr();
+            if (isKeyword("WHERE")) {
+                pos++;
+                if (!isKeyword("UNIQUE")) fail("expected UNIQUE");
+                pos++;
+                expect("(");
+                e = TestSetExpr::unique(e, integer());
+                expect(")");
+            }
+            expect(";");
+            named[name] = e;
+        }
+        pos++;
+        shared_ptr<const TestSetExpr> result = unionExpr();
+        expect(";");
+        if (peek().kind != TestSetToken::END) fail("unexpected input after RETURN");
+        return result;
+    }
+};
+
+static vector<TestSetToken> tokenize(const string& text) {
+    vector<TestSetToken> tokens;
+    int line = 1;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '\n') {
+            line++;
+            i++;
+        } else if (isspace((unsigned char)c)) {
+            i++;
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            size_t j = i;
+            while (j < text.size() && (isalnum((unsigned char)text[j]) || text[j] == '_')) j++;
+            tokens.push_back({ TestSetToken::IDENT, text.substr(i, j - i), line });
+            i = j;
+        } else if (isdigit((unsigned char)c)) {
+            size_t j = i;
+            while (j < text.size() && isdigit((unsigned char)text[j])) j++;
+            tokens.push_back({ TestSetToken::INT, text.substr(i, j - i), line });
+            i = j;
+        } else if (c == '"') {
+            size_t j = text.find('"', i + 1);
+            if (j == string::npos) {
+                throw runtime_error("Test set line " + to_string(line) + ": unterminated string");
+            }
+            tokens.push_back({ TestSetToken::STRING, text.substr(i + 1, j - i - 1), line });
+            i = j + 1;
+        } else {
+            static const vector<string> twoChar = { "->", "==", "!=", "&&" };
+            string sym(1, c);
+            for (const auto& s : twoChar) {
+                if (text.compare(i, 2, s) == 0) sym = s;
+            }
+            tokens.push_back({ TestSetToken::SYMBOL, sym, line });
+            i += sym.size();
+        }
+    }
+    tokens.push_back({ TestSetToken::END, "", line });
+    return tokens;
+}
+
+shared_ptr<const TestSetExpr> TestSetParser::parse(
+        const string& program, map<string, shared_ptr<const TestSetExpr>>* named) {
+    map<string, shared_ptr<const TestSetExpr>> local;
+    TestSetProgram parser(tokenize(program), named ? *named : local);
+    return parser.program();
+}
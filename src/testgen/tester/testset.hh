@@ -0,0 +1,108 @@
+#ifndef TESTSET_HH
+#define TESTSET_HH
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Pull-based enumeration of the test strings of a test set. Every test
+ * string is produced once.
+ */
+class TestSetStream {
+public:
+    virtual ~TestSetStream() = default;
+
+    /**
+     * Store the next test string in out; false once the set is exhausted
+     */
+    virtual bool next(vector<string>& out) = 0;
+};
+
+/**
+ * TestSetExpr: a test set built with the operators of the test-set
+ * language (src/ocaml/grammar.txt), evaluated lazily.
+ *
+ * Nothing is materialized: stream() enumerates the set on demand and
+ * contains() decides membership structurally (a product tries every split
+ * point, bounded by the operands' length ranges). Set semantics come from
+ * membership rather than from remembering what was emitted:
+ *   a | b        stream a, then the elements of b not in a
+ *   a & b        elements of a that are in b
+ *   a / b        elements of a that are not in b
+ *   a * b        concatenations x ++ y, emitted only for their shortest
+ *                split, so a test string reachable in several ways appears once
+ *   a ^ n        a * a * ... * a (n >= 1), a ^ 0 = { [] }
+ *   UNIQUE(n)    test strings in which no block occurs more than n times
+ *                (block counts kept in a hash map per test string)
+ * Operands are shared, so named sets can be reused in several expressions.
+ */
+class TestSetExpr {
+public:
+    virtual ~TestSetExpr() = default;
+
+    /**
+     * Fresh enumeration of the set; it refers to this expression, which
+     * must outlive it
+     */
+    virtual unique_ptr<TestSetStream> stream() const = 0;
+
+    /**
+     * Is ts[begin, end) an element of the set?
+     */
+    virtual bool contains(const vector<string>& ts, size_t begin, size_t end) const = 0;
+    bool contains(const vector<string>& ts) const { return contains(ts, 0, ts.size()); }
+
+    /**
+     * Bounds on the length of the set's test strings (min > max: empty set)
+     */
+    virtual size_t minLength() const = 0;
+    virtual size_t maxLength() const = 0;
+
+    /**
+     * Pull up to limit test strings into a vector (e.g. as campaign candidates)
+     */
+    vector<vector<string>> take(size_t limit) const;
+
+    static shared_ptr<const TestSetExpr> literal(vector<string> testString);
+    static shared_ptr<const TestSetExpr> setUnion(shared_ptr<const TestSetExpr> a,
+                                                  shared_ptr<const TestSetExpr> b);
+    static shared_ptr<const TestSetExpr> intersection(shared_ptr<const TestSetExpr> a,
+                                                      shared_ptr<const TestSetExpr> b);
+    static shared_ptr<const TestSetExpr> difference(shared_ptr<const TestSetExpr> a,
+                                                    shared_ptr<const TestSetExpr> b);
+    static shared_ptr<const TestSetExpr> product(shared_ptr<const TestSetExpr> a,
+                                                 shared_ptr<const TestSetExpr> b);
+    static shared_ptr<const TestSetExpr> power(shared_ptr<const TestSetExpr> a, unsigned int n);
+    static shared_ptr<const TestSetExpr> unique(shared_ptr<const TestSetExpr> a, unsigned int n);
+};
+
+/**
+ * TestSetParser: parses a test-set program
+ *
+ *     u = {api_a} | {api_b} | {api_c};
+ *     fixed = {api_1(int a) -> (int r); api_2(int b) -> (string s);};
+ *     result = (u ^ 2 * fixed * u ^ 2) WHERE UNIQUE(1);
+ *     RETURN result;
+ *
+ * A literal {...} is one test string: the block names of its API calls, in
+ * order. Argument lists and ASSUME/ASSERT clauses are accepted and skipped,
+ * since the spec's blocks carry the pre- and postconditions. Precedence,
+ * loosest first: |, then & and /, then *, then ^. Errors are reported with
+ * runtime_error.
+ */
+class TestSetParser {
+public:
+    /**
+     * Parse a program and return its RETURN expression. Named test sets are
+     * stored in `named` if given.
+     */
+    static shared_ptr<const TestSetExpr> parse(
+        const string& program,
+        map<string, shared_ptr<const TestSetExpr>>* named = nullptr);
+};
+
+#endif // TESTSET_HH
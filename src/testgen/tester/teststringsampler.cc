@@ -0,0 +1,94 @@
+#include "teststringsampler.hh"
+#include <stdexcept>
+
+TestStringSampler::TestStringSampler(const Spec* spec, unsigned int seed, double coverageBonus)
+    : coverageBonus(coverageBonus), rng(seed) {
+    for (const auto& block : spec->blocks) {
+        if (stateIndex.find(block->name) == stateIndex.end()) {
+            stateIndex[block->name] = names.size();
+            names.push_back(block->name);
+        }
+    }
+    if (names.empty()) {
+        throw runtime_error("TestStringSampler: spec has no API blocks");
+    }
+    transitions.assign(names.size() + 1, vector<Transition>(names.size()));
+}
+
+size_t TestStringSampler::state(const string& name) const {
+    if (name.empty()) {
+        return start();
+    }
+    auto it = stateIndex.find(name);
+    if (it == stateIndex.end()) {
+        throw runtime_error("TestStringSampler: unknown block " + name);
+    }
+    return it->second;
+}
+
+double TestStringSampler::weight(size_t from, size_t to) const {
+    const Transition& t = transitions[from][to];
+    double feasibility = (t.feasible + 1) / (t.feasible + t.infeasible + 2);
+    double coverageRate = t.coverage / (t.feasible + t.infeasible + 1);
+    return feasibility * (1 + coverageBonus * coverageRate);
+}
+
+vector<string> TestStringSampler::sample(size_t length) {
+    vector<string> testString;
+    vector<double> weights(names.size());
+    size_t current = start();
+    for (size_t k = 0; k < length; k++) {
+        for (size_t to = 0; to < names.size(); to++) {
+            weights[to] = weight(current, to);
+        }
+        discrete_distribution<size_t> next(weights.begin(), weights.end());
+        current = next(rng);
+        testString.push_back(names[current]);
+    }
+    return testString;
+}
+
+void TestStringSampler::record(const vector<string>& testString, bool feasible,
+                               size_t newPoints, size_t blamed) {
+    if (testString.empty()) {
+        return;
+    }
+    double share = 1.0 / testString.size();
+    size_t from = start();
+    for (size_t k = 0; k < testString.size(); k++) {
+        size_t to = state(testString[k]);
+        Transition& t = transitions[from][to];
+        if (feasible) {
+            t.feasible += 1;
+            if (newPoints > 0) t.coverage += 1;
+        } else if (blamed == SIZE_MAX) {
+            t.infeasible += share;
+        } else if (k < blamed) {
+            t.feasible += 1;
+        } else if (k == blamed) {
+            t.infeasible += 1;
+        }
+        from = to;
+    }
+}
+
+double TestStringSampler::transitionProbability(const string& from, const string& to) const {
+    size_t f = state(from);
+    double total = 0;
+    for (size_t b = 0; b < names.size(); b++) {
+        total += weight(f, b);
+    }
+    return weight(f, state(to)) / total;
+}
+
+double TestStringSampler::feasibility(const vector<string>& testString) const {
+    double p = 1;
+    size_t from = start();
+    for (const auto& name : testString) {
+        size_t to = state(name);
+        const Transition& t = transitions[from][to];
+        p *= (t.feasible + 1) / (t.feasible + t.infeasible + 2);
+        from = to;
+    }
+    return p;
+}
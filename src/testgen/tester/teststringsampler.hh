@@ -0,0 +1,78 @@
+#ifndef TESTSTRINGSAMPLER_HH
+#define TESTSTRINGSAMPLER_HH
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+
+using namespace std;
+
+/**
+ * TestStringSampler: Markov chain over the API blocks of a spec
+ *
+ * States are the distinct block names plus a start state. Every transition
+ * a -> b keeps three counters, learned from executed test strings:
+ *   feasible     runs in which the transition was part of a feasible prefix
+ *   infeasible   runs in which the transition was blamed for infeasibility
+ *   coverage     feasible runs that also produced new coverage
+ * The weight of a -> b is its estimated feasibility (Laplace smoothed)
+ * boosted by its coverage rate:
+ *   w(a, b) = (f + 1) / (f + i + 2) * (1 + coverageBonus * c / (f + i + 1))
+ * and sample() walks the chain with probabilities proportional to w.
+ * All counters start at 0, i.e. the untrained chain is uniform.
+ */
+class TestStringSampler {
+private:
+    struct Transition {
+        double feasible = 0;
+        double infeasible = 0;
+        double coverage = 0;
+    };
+
+    vector<string> names;
+    map<string, size_t> stateIndex;
+    vector<vector<Transition>> transitions;  // [from][to], from == names.size() is start
+    double coverageBonus;
+    mt19937 rng;
+
+    size_t start() const { return names.size(); }
+    size_t state(const string& name) const;
+    double weight(size_t from, size_t to) const;
+
+public:
+    TestStringSampler(const Spec* spec, unsigned int seed = 0, double coverageBonus = 1.0);
+
+    /**
+     * Draw a test string of the given length
+     */
+    vector<string> sample(size_t length);
+
+    /**
+     * Learn from an executed test string.
+     *
+     * @param feasible   the CTC could be generated and its assumes held
+     * @param newPoints  coverage points the test string added
+     * @param blamed     position of the block that made it infeasible, if
+     *                   known; otherwise every transition shares the blame
+     */
+    void record(const vector<string>& testString, bool feasible, size_t newPoints,
+                size_t blamed = SIZE_MAX);
+
+    /**
+     * Probability of stepping from `from` to `to` ("" is the start state)
+     */
+    double transitionProbability(const string& from, const string& to) const;
+
+    /**
+     * Estimated probability that every transition of a test string is feasible
+     */
+    double feasibility(const vector<string>& testString) const;
+
+    const vector<string>& getBlockNames() const { return names; }
+};
+
+#endif // TESTSTRINGSAMPLER_HH